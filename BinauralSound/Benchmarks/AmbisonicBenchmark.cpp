@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    AmbisonicBenchmark.cpp
+
+    Compares per-object rendering (BinauralScene) with the third order
+    ambisonic bus (AmbisonicScene) over the number of sources, static and
+    moving, and prints the number of sources from which the bus is the
+    cheaper of the two.
+
+    usage: ambisonic_benchmark [--quick] [--json file] [--time seconds]
+                               [--rate sampleRate] [--block blockSize]
+                               [--head-tracking]
+
+    --head-tracking turns the listener's head in every block, which makes
+    the ambisonic scene rotate its decoder in every control block.
+
+  ==============================================================================
+*/
+
+#include "AmbisonicScene.h"
+#include "BenchmarkReport.h"
+#include "BenchmarkSignals.h"
+#include "BinauralScene.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+    constexpr int minBlocks = 32;
+
+    /** Runs either scene type, they share the source interface. */
+    template <typename Scene>
+    BenchmarkReport::Result run (const BenchmarkReport::Config& config, double minSeconds, bool headTracking)
+    {
+        const int numSources = config.numSources;
+
+        Scene scene;
+        scene.prepare (config.sampleRate, config.blockSize, numSources);
+
+        std::mt19937 rng (1);
+        std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+
+        std::vector<std::vector<float>> inputs (numSources, std::vector<float> (config.blockSize));
+        std::vector<const float*> inputPointers;
+
+        for (int s = 0; s < numSources; ++s)
+        {
+            for (auto& x : inputs[s])
+                x = noise (rng);
+
+            inputPointers.push_back (inputs[s].data());
+            scene.setSourcePosition (s, -89.0f + 178.0f * s / numSources, 45.0f * (s % 3 - 1));
+        }
+
+        std::vector<float> outL (config.blockSize), outR (config.blockSize);
+
+        return BenchmarkReport::measure (config, minSeconds, minBlocks, [&] (int blockIndex)
+        {
+            const double time = static_cast<double> (blockIndex) * config.blockSize / config.sampleRate;
+
+            if (config.moving)
+                for (int s = 0; s < numSources; ++s)
+                    scene.setSourcePosition (s, BenchmarkSignals::movingAzimuth (time, s), BenchmarkSignals::movingElevation (time, s));
+
+            // Only the ambisonic scene can turn the whole field; for the
+            // objects the head tracker would move every source instead
+            if (headTracking)
+            {
+                if constexpr (std::is_same<Scene, AmbisonicScene>::value)
+                    scene.setHeadOrientation ({ static_cast<float> (45.0 * std::sin (2.0 * BenchmarkSignals::pi * time)), 10.0f, 0.0f });
+                else if (! config.moving)
+                    for (int s = 0; s < numSources; ++s)
+                        scene.setSourcePosition (s, BenchmarkSignals::movingAzimuth (time, s), BenchmarkSignals::movingElevation (time, s));
+            }
+
+            scene.process (inputPointers.data(), outL.data(), outR.data(), config.blockSize);
+        });
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    bool quick = false;
+    bool headTracking = false;
+    std::string jsonPath;
+    double minSeconds = 0.1;
+    double sampleRate = 48000;
+    int blockSize = 128;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp (argv[i], "--quick") == 0)                      quick = true;
+        else if (std::strcmp (argv[i], "--json") == 0 && i + 1 < argc)   jsonPath = argv[++i];
+        else if (std::strcmp (argv[i], "--time") == 0 && i + 1 < argc)   minSeconds = std::atof (argv[++i]);
+        else if (std::strcmp (argv[i], "--rate") == 0 && i + 1 < argc)   sampleRate = std::atof (argv[++i]);
+        else if (std::strcmp (argv[i], "--block") == 0 && i + 1 < argc)  blockSize = std::atoi (argv[++i]);
+        else if (std::strcmp (argv[i], "--head-tracking") == 0)          headTracking = true;
+        else
+        {
+            std::printf ("usage: ambisonic_benchmark [--quick] [--json file] [--time seconds] [--rate sampleRate] [--block blockSize] [--head-tracking]\n");
+            return 1;
+        }
+    }
+
+    const std::vector<int> sourceCounts = quick ? std::vector<int> { 1, 8, 16, 32, 64, 128 }
+                                                : std::vector<int> { 1, 2, 4, 8, 12, 16, 24, 32, 48, 64, 96, 128, 256, 512 };
+
+    std::printf ("%d virtual speakers, order %d, %d channels%s\n\n", Ambisonics::numVirtualSpeakers, Ambisonics::order,
+                 Ambisonics::numChannels, headTracking ? ", head tracking" : "");
+
+    BenchmarkReport::printHeader();
+
+    std::vector<BenchmarkReport::Result> results;
+
+    for (bool moving : { false, true })
+    {
+        int crossover = 0;
+
+        for (int numSources : sourceCounts)
+        {
+            const auto objects = run<BinauralScene> ({ "scene", sampleRate, blockSize, numSources, moving }, minSeconds, headTracking);
+            const auto ambisonic = run<AmbisonicScene> ({ "ambisonic", sampleRate, blockSize, numSources, moving }, minSeconds, headTracking);
+
+            BenchmarkReport::printRow (objects);
+            BenchmarkReport::printRow (ambisonic);
+
+            if (crossover == 0 && ambisonic.nsPerSample < objects.nsPerSample)
+                crossover = numSources;
+
+            results.push_back (objects);
+            results.push_back (ambisonic);
+        }
+
+        if (crossover > 0)
+            std::printf ("%s sources: the ambisonic bus is cheaper from %d sources on\n\n", moving ? "moving" : "static", crossover);
+        else
+            std::printf ("%s sources: per-object rendering was cheaper for every count\n\n", moving ? "moving" : "static");
+    }
+
+    if (! jsonPath.empty())
+    {
+        if (! BenchmarkReport::writeJson (jsonPath, "ambisonic_benchmark", { { "head_tracking", headTracking ? "true" : "false" } }, results))
+        {
+            std::fprintf (stderr, "cannot write %s\n", jsonPath.c_str());
+            return 1;
+        }
+
+        std::printf ("wrote %d results to %s\n", static_cast<int> (results.size()), jsonPath.c_str());
+    }
+
+    return 0;
+}
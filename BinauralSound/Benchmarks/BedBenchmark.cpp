@@ -0,0 +1,172 @@
+/*
+  ==============================================================================
+
+    BedBenchmark.cpp
+
+    Compares the surround bed virtualiser with what it replaces: one
+    BinauralEngine per speaker channel at the same position, their outputs
+    added up. Prints the ratio of the two for 5.1, 7.1 and 7.1.4.
+
+    usage: bed_benchmark [--quick] [--json file] [--time seconds]
+                         [--rate sampleRate] [--block blockSize]
+
+  ==============================================================================
+*/
+
+#include "Ambisonics.h"
+#include "BedVirtualiser.h"
+#include "BenchmarkReport.h"
+#include "BinauralEngine.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr double pi = 3.14159265358979323846;
+    constexpr int minBlocks = 32;
+
+    std::vector<std::vector<float>> makeInputs (int numChannels, int blockSize)
+    {
+        std::mt19937 rng (1);
+        std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+
+        std::vector<std::vector<float>> inputs (numChannels, std::vector<float> (blockSize));
+
+        for (auto& channel : inputs)
+            for (auto& x : channel)
+                x = noise (rng);
+
+        return inputs;
+    }
+
+    BenchmarkReport::Result runBed (const BenchmarkReport::Config& config, double minSeconds, BedVirtualiser::Layout layout)
+    {
+        BedVirtualiser bed;
+        bed.prepare (config.sampleRate, config.blockSize, BedVirtualiser::getLayoutSpeakers (layout));
+
+        const auto inputs = makeInputs (config.numSources, config.blockSize);
+        std::vector<const float*> inputPointers;
+
+        for (const auto& channel : inputs)
+            inputPointers.push_back (channel.data());
+
+        std::vector<float> outL (config.blockSize), outR (config.blockSize);
+
+        return BenchmarkReport::measure (config, minSeconds, minBlocks, [&] (int)
+        {
+            bed.process (inputPointers.data(), outL.data(), outR.data(), config.blockSize);
+        });
+    }
+
+    /** One engine per speaker, as the plugin would need one instance per
+        channel without the virtualiser.
+    */
+    BenchmarkReport::Result runEngines (const BenchmarkReport::Config& config, double minSeconds, BedVirtualiser::Layout layout)
+    {
+        const auto speakers = BedVirtualiser::getLayoutSpeakers (layout);
+        std::vector<BinauralEngine> engines (speakers.size());
+
+        for (size_t channel = 0; channel < speakers.size(); ++channel)
+        {
+            const double azimuth = speakers[channel].azimuth * pi / 180;
+            const double elevation = speakers[channel].elevation * pi / 180;
+
+            float modelAzimuth, modelElevation;
+            Ambisonics::toInterauralPolar (static_cast<float> (std::cos (elevation) * std::cos (azimuth)),
+                                           static_cast<float> (std::cos (elevation) * std::sin (azimuth)),
+                                           static_cast<float> (std::sin (elevation)), modelAzimuth, modelElevation);
+
+            engines[channel].prepare (config.sampleRate, config.blockSize);
+            engines[channel].setAzimuth (modelAzimuth);
+            engines[channel].setElevation (modelElevation);
+        }
+
+        const auto inputs = makeInputs (config.numSources, config.blockSize);
+        std::vector<float> outL (config.blockSize), outR (config.blockSize);
+        std::vector<float> engineL (config.blockSize), engineR (config.blockSize);
+
+        return BenchmarkReport::measure (config, minSeconds, minBlocks, [&] (int)
+        {
+            std::fill (outL.begin(), outL.end(), 0.0f);
+            std::fill (outR.begin(), outR.end(), 0.0f);
+
+            for (size_t channel = 0; channel < engines.size(); ++channel)
+            {
+                engines[channel].process (inputs[channel].data(), engineL.data(), engineR.data(), config.blockSize);
+
+                for (int i = 0; i < config.blockSize; ++i)
+                {
+                    outL[i] += engineL[i];
+                    outR[i] += engineR[i];
+                }
+            }
+        });
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    bool quick = false;
+    std::string jsonPath;
+    double minSeconds = 0.2;
+    double sampleRate = 48000;
+    int blockSize = 128;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp (argv[i], "--quick") == 0)                      quick = true;
+        else if (std::strcmp (argv[i], "--json") == 0 && i + 1 < argc)   jsonPath = argv[++i];
+        else if (std::strcmp (argv[i], "--time") == 0 && i + 1 < argc)   minSeconds = std::atof (argv[++i]);
+        else if (std::strcmp (argv[i], "--rate") == 0 && i + 1 < argc)   sampleRate = std::atof (argv[++i]);
+        else if (std::strcmp (argv[i], "--block") == 0 && i + 1 < argc)  blockSize = std::atoi (argv[++i]);
+        else
+        {
+            std::printf ("usage: bed_benchmark [--quick] [--json file] [--time seconds] [--rate sampleRate] [--block blockSize]\n");
+            return 1;
+        }
+    }
+
+    if (quick)
+        minSeconds = 0.05;
+
+    BenchmarkReport::printHeader();
+
+    std::vector<BenchmarkReport::Result> results;
+
+    for (auto layout : { BedVirtualiser::Layout::surround51, BedVirtualiser::Layout::surround71, BedVirtualiser::Layout::surround714 })
+    {
+        const int numChannels = static_cast<int> (BedVirtualiser::getLayoutSpeakers (layout).size());
+        const std::string name = BedVirtualiser::getName (layout);
+
+        const auto bed = runBed ({ "bed " + name, sampleRate, blockSize, numChannels, false }, minSeconds, layout);
+        const auto engines = runEngines ({ "engines " + name, sampleRate, blockSize, numChannels, false }, minSeconds, layout);
+
+        BenchmarkReport::printRow (bed);
+        BenchmarkReport::printRow (engines);
+        std::printf ("%s: the bed takes %.0f%% of the time of %d engines\n\n", name.c_str(),
+                     100.0 * bed.nsPerSample / engines.nsPerSample, numChannels);
+
+        results.push_back (bed);
+        results.push_back (engines);
+    }
+
+    if (! jsonPath.empty())
+    {
+        if (! BenchmarkReport::writeJson (jsonPath, "bed_benchmark", {}, results))
+        {
+            std::fprintf (stderr, "cannot write %s\n", jsonPath.c_str());
+            return 1;
+        }
+
+        std::printf ("wrote %d results to %s\n", static_cast<int> (results.size()), jsonPath.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+/*
+  ==============================================================================
+
+    BenchmarkReport.h
+
+    Block timing statistics and JSON output shared by the render and
+    processor benchmarks.
+
+    Every measured configuration times each processed block on its own, so
+    the report holds the distribution of block times (which is what decides
+    dropouts) rather than only the average throughput. The JSON file lists
+    one object per configuration and is meant to be diffed between releases.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace BenchmarkReport
+{
+    //==============================================================================
+    struct Config
+    {
+        std::string target; // what was measured, e.g. "engine" or "scene"
+        double sampleRate = 48000;
+        int blockSize = 128;
+        int numSources = 1;
+        bool moving = false;
+    };
+
+    struct Result
+    {
+        Config config;
+
+        int numBlocks = 0;
+        double nsPerSample = 0;       // mean, per output sample
+        double nsPerSourceSample = 0;
+        double p50 = 0, p90 = 0, p99 = 0, max = 0; // block times in microseconds
+        double realtimeFactor = 0;    // audio time / mean processing time
+        double headroom = 0;          // 1 - p99 / block period; negative when p99 misses the deadline
+    };
+
+    //==============================================================================
+    /** Runs processBlock() repeatedly, after a few warm-up blocks, until at
+        least minSeconds of wall time and minBlocks blocks have been measured.
+        processBlock (int blockIndex) renders one block of config.blockSize.
+    */
+    template <typename ProcessBlock>
+    Result measure (const Config& config, double minSeconds, int minBlocks, ProcessBlock&& processBlock)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        const int numWarmUpBlocks = 8;
+        int blockIndex = 0;
+
+        for (; blockIndex < numWarmUpBlocks; ++blockIndex)
+            processBlock (blockIndex);
+
+        std::vector<double> blockTimes;
+        blockTimes.reserve (static_cast<size_t> (minBlocks) * 4);
+
+        double total = 0;
+
+        while (total < minSeconds || static_cast<int> (blockTimes.size()) < minBlocks)
+        {
+            const auto start = Clock::now();
+            processBlock (blockIndex++);
+            const double elapsed = std::chrono::duration<double> (Clock::now() - start).count();
+
+            blockTimes.push_back (elapsed);
+            total += elapsed;
+        }
+
+        std::sort (blockTimes.begin(), blockTimes.end());
+
+        auto percentile = [&blockTimes] (double p)
+        {
+            const auto index = static_cast<size_t> (p * (blockTimes.size() - 1) + 0.5);
+            return blockTimes[index] * 1e6;
+        };
+
+        const double numSamples = static_cast<double> (blockTimes.size()) * config.blockSize;
+        const double blockPeriod = config.blockSize / config.sampleRate;
+
+        Result result;
+        result.config = config;
+        result.numBlocks = static_cast<int> (blockTimes.size());
+        result.nsPerSample = total * 1e9 / numSamples;
+        result.nsPerSourceSample = result.nsPerSample / config.numSources;
+        result.p50 = percentile (0.5);
+        result.p90 = percentile (0.9);
+        result.p99 = percentile (0.99);
+        result.max = blockTimes.back() * 1e6;
+        result.realtimeFactor = numSamples / config.sampleRate / total;
+        result.headroom = 1.0 - result.p99 * 1e-6 / blockPeriod;
+        return result;
+    }
+
+    //==============================================================================
+    inline void printHeader()
+    {
+        std::printf ("%-18s %7s %6s %7s %6s %10s %10s %9s %9s %9s %9s %11s %9s\n",
+                     "target", "rate", "block", "sources", "motion", "ns/sample", "ns/src-smp",
+                     "p50 us", "p90 us", "p99 us", "max us", "realtime x", "headroom");
+    }
+
+    inline void printRow (const Result& r)
+    {
+        std::printf ("%-18s %7.0f %6d %7d %6s %10.1f %10.2f %9.1f %9.1f %9.1f %9.1f %11.1f %8.1f%%\n",
+                     r.config.target.c_str(), r.config.sampleRate, r.config.blockSize, r.config.numSources,
+                     r.config.moving ? "moving" : "static", r.nsPerSample, r.nsPerSourceSample,
+                     r.p50, r.p90, r.p99, r.max, r.realtimeFactor, 100.0 * r.headroom);
+        std::fflush (stdout);
+    }
+
+    //==============================================================================
+    /** Writes the results as JSON. info is a list of extra top-level string
+        fields, e.g. the name of the SIMD kernel in use.
+    */
+    inline bool writeJson (const std::string& path, const std::string& benchmark,
+                           const std::vector<std::pair<std::string, std::string>>& info,
+                           const std::vector<Result>& results)
+    {
+        FILE* file = std::fopen (path.c_str(), "w");
+
+        if (file == nullptr)
+            return false;
+
+        std::fprintf (file, "{\n  \"benchmark\": \"%s\",\n", benchmark.c_str());
+
+        for (auto& field : info)
+            std::fprintf (file, "  \"%s\": \"%s\",\n", field.first.c_str(), field.second.c_str());
+
+        std::fprintf (file, "  \"results\": [\n");
+
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            auto& r = results[i];
+
+            std::fprintf (file, "    { \"target\": \"%s\", \"sample_rate\": %.0f, \"block_size\": %d, \"sources\": %d, \"moving\": %s, "
+                                "\"blocks\": %d, \"ns_per_sample\": %.3f, \"ns_per_source_sample\": %.4f, "
+                                "\"block_us\": { \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f }, "
+                                "\"realtime_factor\": %.3f, \"headroom\": %.5f }%s\n",
+                          r.config.target.c_str(), r.config.sampleRate, r.config.blockSize, r.config.numSources,
+                          r.config.moving ? "true" : "false", r.numBlocks, r.nsPerSample, r.nsPerSourceSample,
+                          r.p50, r.p90, r.p99, r.max, r.realtimeFactor, r.headroom,
+                          i + 1 < results.size() ? "," : "");
+        }
+
+        std::fprintf (file, "  ]\n}\n");
+
+        return std::fclose (file) == 0;
+    }
+}
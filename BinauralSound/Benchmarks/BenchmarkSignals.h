@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    BenchmarkSignals.h
+
+    Test signals shared by the benchmarks: source trajectories, noise
+    inputs and synthetic impulse response sets, so every benchmark renders
+    the same material and their numbers can be compared.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "BinauralEngine.h"
+#include "HrirSet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace BenchmarkSignals
+{
+    constexpr double pi = 3.14159265358979323846;
+
+    //==============================================================================
+    // Positions swept by moving sources, fast enough that every control
+    // block lands on a different set of coefficients
+    inline float movingAzimuth (double time, int source)       { return static_cast<float> (80.0 * std::sin (2.0 * pi * 0.5 * time + source)); }
+    inline float movingElevation (double time, int source)     { return static_cast<float> (30.0 * std::cos (2.0 * pi * 0.3 * time + source)); }
+
+    /** Uniform noise in [-0.5, 0.5]. */
+    inline std::vector<float> makeNoise (int numSamples, unsigned seed)
+    {
+        std::mt19937 rng (seed);
+        std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+
+        std::vector<float> samples (numSamples);
+        for (auto& x : samples)
+            x = noise (rng);
+
+        return samples;
+    }
+
+    //==============================================================================
+    /** An HrirSet of the given directions, fill (index, left, right) writes
+        length samples of each ear's response for the direction at index.
+    */
+    template <typename Fill>
+    std::shared_ptr<const HrirSet> makeHrirSet (double sampleRate, int length, std::vector<HrirSet::Direction> directions, Fill&& fill)
+    {
+        std::vector<float> impulseResponses (directions.size() * 2 * static_cast<size_t> (length));
+
+        for (size_t m = 0; m < directions.size(); ++m)
+        {
+            float* left = impulseResponses.data() + m * 2 * static_cast<size_t> (length);
+            fill (static_cast<int> (m), left, left + length);
+        }
+
+        return std::make_shared<const HrirSet> (sampleRate, length, std::move (directions), std::move (impulseResponses));
+    }
+
+    /** Noise decaying by 60 dB over the length, like a room's tail, for
+        numDirections directions around the horizontal plane.
+    */
+    inline std::shared_ptr<const HrirSet> makeRoomResponses (double sampleRate, int length, int numDirections)
+    {
+        std::mt19937 rng (1);
+        std::normal_distribution<float> noise (0.0f, 0.1f);
+
+        std::vector<HrirSet::Direction> directions;
+
+        for (int m = 0; m < numDirections; ++m)
+            directions.push_back ({ 0.0f, 360.0f * m / numDirections - 180.0f });
+
+        return makeHrirSet (sampleRate, length, std::move (directions), [&] (int, float* left, float* right)
+        {
+            for (auto* ear : { left, right })
+                for (int n = 0; n < length; ++n)
+                    ear[n] = noise (rng) * std::pow (10.0f, -3.0f * n / length);
+        });
+    }
+
+    /** Impulse responses of the model itself on a gridStep degree grid, as a
+        stand-in for a measured set.
+    */
+    inline std::shared_ptr<const HrirSet> makeModelHrirs (double sampleRate, int length, int gridStep)
+    {
+        BinauralEngine engine;
+        engine.setSmoothingTime (0);
+        engine.prepare (sampleRate, length);
+
+        std::vector<HrirSet::Direction> directions;
+
+        for (int azimuth = -90; azimuth <= 90; azimuth += gridStep)
+            for (int elevation = -180; elevation < 180; elevation += gridStep)
+                directions.push_back ({ static_cast<float> (azimuth), static_cast<float> (elevation) });
+
+        std::vector<float> impulse (length);
+
+        return makeHrirSet (sampleRate, length, directions, [&] (int index, float* left, float* right)
+        {
+            engine.setAzimuth (directions[index].azimuth);
+            engine.setElevation (directions[index].elevation);
+            engine.reset();
+
+            std::fill (impulse.begin(), impulse.end(), 0.0f);
+            impulse[0] = 1.0f;
+
+            engine.process (impulse.data(), left, right, length);
+        });
+    }
+}
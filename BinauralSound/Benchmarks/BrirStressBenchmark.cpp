@@ -0,0 +1,248 @@
+/*
+  ==============================================================================
+
+    BrirStressBenchmark.cpp
+
+    Runs BrirConvolver instances in real time, 64 sample blocks paced by the
+    clock like an audio callback, with the tails on the shared
+    ConvolutionThreadPool, and checks that no tail block misses its
+    deadline. Also reports the audio thread's time per block for each
+    response length, which should not grow with it.
+
+    usage: brir_stress_benchmark [--quick] [--json file] [--time seconds]
+                                 [--instances n] [--load threads]
+
+    --time is the audio time run per response length (default 5 s, 1 s with
+    --quick), --instances the number of convolvers processed in every
+    callback (default 4). --load starts that many threads that only spin,
+    competing with the pool for the cores.
+
+    The responses are decaying noise, 8 directions around the listener; the
+    measurement changes every 100 ms so the tails mix several of them.
+    Exits with 1 if any tail block missed its deadline, counting the blocks
+    still in flight when the measured time ends.
+
+  ==============================================================================
+*/
+
+#include "BenchmarkReport.h"
+#include "BenchmarkSignals.h"
+#include "BrirConvolver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr double sampleRate = 48000;
+    constexpr int blockSize = 64;
+    constexpr int numDirections = 8;
+    constexpr double measurementPeriod = 0.1; // [s]
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Run
+    {
+        BenchmarkReport::Result result;
+        int64_t missedDeadlines = 0;
+        int overruns = 0; // callbacks that took longer than a block
+    };
+
+    Run runPaced (double length, double seconds, int numInstances, const std::shared_ptr<ConvolutionThreadPool>& pool)
+    {
+        auto filters = std::make_shared<const BrirFilters> (BenchmarkSignals::makeRoomResponses (sampleRate, static_cast<int> (length * sampleRate), numDirections), sampleRate);
+
+        std::vector<std::unique_ptr<BrirConvolver>> convolvers;
+        for (int i = 0; i < numInstances; ++i)
+            convolvers.push_back (std::make_unique<BrirConvolver> (filters, pool));
+
+        std::mt19937 rng (2);
+        std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+
+        std::vector<float> input (blockSize), outL (blockSize), outR (blockSize);
+        for (auto& x : input)
+            x = noise (rng);
+
+        const int numBlocks = static_cast<int> (seconds * sampleRate / blockSize);
+        const int blocksPerMeasurement = static_cast<int> (measurementPeriod * sampleRate / blockSize);
+        const auto period = std::chrono::duration_cast<Clock::duration> (std::chrono::duration<double> (blockSize / sampleRate));
+
+        std::vector<double> blockTimes;
+        blockTimes.reserve (numBlocks);
+
+        Run run;
+        double total = 0;
+        auto next = Clock::now();
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int i = 0; i < numInstances; ++i)
+                convolvers[i]->setMeasurement ((block / blocksPerMeasurement + i) % numDirections);
+
+            const auto start = Clock::now();
+
+            for (auto& convolver : convolvers)
+            {
+                std::fill (outL.begin(), outL.end(), 0.0f);
+                std::fill (outR.begin(), outR.end(), 0.0f);
+                convolver->process (input.data(), outL.data(), outR.data(), blockSize);
+            }
+
+            const auto end = Clock::now();
+            const double elapsed = std::chrono::duration<double> (end - start).count();
+
+            blockTimes.push_back (elapsed);
+            total += elapsed;
+
+            // Like a sound card: the next callback comes a block period
+            // later, however long this one took
+            next += period;
+
+            if (end > next)
+                ++run.overruns;
+
+            std::this_thread::sleep_until (next);
+        }
+
+        // Keep the callbacks coming, untimed, until the tail blocks posted
+        // last are due, so a miss at the very end still fails the run
+        int longestPartition = 0;
+        for (auto& segment : filters->getSegments())
+            longestPartition = std::max (longestPartition, segment.partitionSize);
+
+        for (int block = 0; block <= longestPartition / blockSize; ++block)
+        {
+            for (auto& convolver : convolvers)
+                convolver->process (input.data(), outL.data(), outR.data(), blockSize);
+
+            next += period;
+            std::this_thread::sleep_until (next);
+        }
+
+        for (auto& convolver : convolvers)
+            run.missedDeadlines += convolver->getMissedDeadlines();
+
+        std::sort (blockTimes.begin(), blockTimes.end());
+
+        auto percentile = [&blockTimes] (double p)
+        {
+            return blockTimes[static_cast<size_t> (p * (blockTimes.size() - 1) + 0.5)] * 1e6;
+        };
+
+        char target[32];
+        std::snprintf (target, sizeof (target), "brir %.2fs", length);
+
+        auto& r = run.result;
+        r.config = { target, sampleRate, blockSize, numInstances, true };
+        r.numBlocks = numBlocks;
+        r.nsPerSample = total * 1e9 / (static_cast<double> (numBlocks) * blockSize);
+        r.nsPerSourceSample = r.nsPerSample / numInstances;
+        r.p50 = percentile (0.5);
+        r.p90 = percentile (0.9);
+        r.p99 = percentile (0.99);
+        r.max = blockTimes.back() * 1e6;
+        r.realtimeFactor = numBlocks * blockSize / sampleRate / total;
+        r.headroom = 1.0 - r.p99 * 1e-6 * sampleRate / blockSize;
+        return run;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    bool quick = false;
+    std::string jsonPath;
+    double seconds = 0;
+    int numInstances = 4;
+    int numLoadThreads = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp (argv[i], "--quick") == 0)                          quick = true;
+        else if (std::strcmp (argv[i], "--json") == 0 && i + 1 < argc)       jsonPath = argv[++i];
+        else if (std::strcmp (argv[i], "--time") == 0 && i + 1 < argc)       seconds = std::atof (argv[++i]);
+        else if (std::strcmp (argv[i], "--instances") == 0 && i + 1 < argc)  numInstances = std::max (1, std::atoi (argv[++i]));
+        else if (std::strcmp (argv[i], "--load") == 0 && i + 1 < argc)       numLoadThreads = std::max (0, std::atoi (argv[++i]));
+        else
+        {
+            std::printf ("usage: brir_stress_benchmark [--quick] [--json file] [--time seconds] [--instances n] [--load threads]\n");
+            return 1;
+        }
+    }
+
+    if (seconds <= 0)
+        seconds = quick ? 1.0 : 5.0;
+
+    const std::vector<double> lengths = quick ? std::vector<double> { 0.5, 3.0 }
+                                              : std::vector<double> { 0.25, 0.5, 1.0, 2.0, 3.0 };
+
+    // Background load competing with the pool
+    std::atomic<bool> stopLoad { false };
+    std::vector<std::thread> load;
+
+    for (int i = 0; i < numLoadThreads; ++i)
+        load.emplace_back ([&stopLoad]
+        {
+            volatile double x = 0;
+            while (! stopLoad.load (std::memory_order_relaxed))
+                x = x + 1;
+        });
+
+    auto pool = ConvolutionThreadPool::getShared();
+
+    std::printf ("%d instances, %d pool threads, %d load threads, %.1f s per length\n\n",
+                 numInstances, pool->getNumThreads(), numLoadThreads, seconds);
+
+    BenchmarkReport::printHeader();
+
+    std::vector<BenchmarkReport::Result> results;
+    int64_t totalMissed = 0;
+
+    for (double length : lengths)
+    {
+        const Run run = runPaced (length, seconds, numInstances, pool);
+
+        results.push_back (run.result);
+        totalMissed += run.missedDeadlines;
+
+        BenchmarkReport::printRow (run.result);
+        std::printf ("    missed tail deadlines: %lld, callback overruns: %d\n",
+                     static_cast<long long> (run.missedDeadlines), run.overruns);
+    }
+
+    stopLoad = true;
+    for (auto& thread : load)
+        thread.join();
+
+    if (! jsonPath.empty())
+    {
+        const std::vector<std::pair<std::string, std::string>> info { { "missed_deadlines", std::to_string (totalMissed) } };
+
+        if (! BenchmarkReport::writeJson (jsonPath, "brir_stress_benchmark", info, results))
+        {
+            std::fprintf (stderr, "cannot write %s\n", jsonPath.c_str());
+            return 1;
+        }
+
+        std::printf ("\nwrote %d results to %s\n", static_cast<int> (results.size()), jsonPath.c_str());
+    }
+
+    if (totalMissed > 0)
+    {
+        std::printf ("\nFAILED: %lld tail blocks missed their deadline\n", static_cast<long long> (totalMissed));
+        return 1;
+    }
+
+    std::printf ("\nno missed deadlines\n");
+    return 0;
+}
@@ -0,0 +1,233 @@
+/*
+  ==============================================================================
+
+    DetailBenchmark.cpp
+
+    Measures what BinauralScene's level of detail saves. Every source of a
+    scene of moving sources is first forced to each SceneKernels::Detail in
+    turn, which gives the cost of each level relative to the full model
+    (BinauralScene::kDetailCost), and then a mixed scene is rendered with
+    the default thresholds: sources spread over 80 dB of gain, every fourth
+    run of 8 silent, with and without a CPU budget. Each row prints the time
+    saved against level of detail off, the saving the scene's
+    DetailCounters estimate, and how the source-samples were split over
+    the levels.
+
+    Forcing every source to the full model must give the same output as
+    level of detail off, to the bit; the benchmark fails otherwise.
+
+    usage: detail_benchmark [--quick] [--json file] [--time seconds]
+                            [--rate sampleRate] [--block blockSize]
+                            [--sources numSources]
+
+  ==============================================================================
+*/
+
+#include "BenchmarkReport.h"
+#include "BenchmarkSignals.h"
+#include "BinauralScene.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr int minBlocks = 64;
+
+    enum class Case
+    {
+        off,
+        full,
+        reduced,
+        panned,
+        silent,
+        mixed,
+        budget
+    };
+
+    const char* getName (Case c)
+    {
+        switch (c)
+        {
+            case Case::off:     return "lod off";
+            case Case::full:    return "lod full";
+            case Case::reduced: return "lod reduced";
+            case Case::panned:  return "lod panned";
+            case Case::silent:  return "lod silent";
+            case Case::mixed:   return "lod mixed";
+            case Case::budget:  return "lod budget";
+        }
+
+        return "";
+    }
+
+    struct Setup
+    {
+        Setup (const BenchmarkReport::Config& config, Case c)
+            : numSources (config.numSources), blockSize (config.blockSize), sampleRate (config.sampleRate)
+        {
+            scene.prepare (sampleRate, blockSize, numSources);
+            scene.setLevelOfDetail (c != Case::off);
+
+            // Thresholds out of reach force every source to one level
+            if (c == Case::full)        scene.setDetailThresholds (-400.0f, -400.0f);
+            if (c == Case::reduced)     scene.setDetailThresholds (400.0f, -400.0f);
+            if (c == Case::panned)      scene.setDetailThresholds (400.0f, 400.0f);
+            if (c == Case::budget)      scene.setCpuBudget (0.25f * numSources);
+
+            std::mt19937 rng (1);
+            std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+
+            inputs.assign (numSources, std::vector<float> (blockSize));
+
+            for (int s = 0; s < numSources; ++s)
+            {
+                const bool silent = c == Case::silent || ((c == Case::mixed || c == Case::budget) && (s / 8) % 4 == 3);
+
+                for (auto& x : inputs[s])
+                    x = silent ? 0.0f : noise (rng);
+
+                inputPointers.push_back (inputs[s].data());
+
+                if (c == Case::mixed || c == Case::budget)
+                    scene.setSourceGain (s, -80.0f * static_cast<float> (s) / numSources);
+            }
+
+            outL.assign (blockSize, 0.0f);
+            outR.assign (blockSize, 0.0f);
+        }
+
+        void processBlock (int blockIndex)
+        {
+            const double time = static_cast<double> (blockIndex) * blockSize / sampleRate;
+
+            for (int s = 0; s < numSources; ++s)
+                scene.setSourcePosition (s, BenchmarkSignals::movingAzimuth (time, s), BenchmarkSignals::movingElevation (time, s));
+
+            scene.process (inputPointers.data(), outL.data(), outR.data(), blockSize);
+        }
+
+        int numSources, blockSize;
+        double sampleRate;
+
+        BinauralScene scene;
+
+        std::vector<std::vector<float>> inputs;
+        std::vector<const float*> inputPointers;
+        std::vector<float> outL, outR;
+    };
+
+    /** Both ears of the first numBlocks blocks. */
+    std::vector<float> renderPassage (const BenchmarkReport::Config& config, Case c, int numBlocks)
+    {
+        Setup setup (config, c);
+        std::vector<float> passage;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            setup.processBlock (block);
+            passage.insert (passage.end(), setup.outL.begin(), setup.outL.end());
+            passage.insert (passage.end(), setup.outR.begin(), setup.outR.end());
+        }
+
+        return passage;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    bool quick = false;
+    std::string jsonPath;
+    double minSeconds = 0.3;
+    double sampleRate = 48000;
+    int blockSize = 128;
+    int numSources = 256;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp (argv[i], "--quick") == 0)                          quick = true;
+        else if (std::strcmp (argv[i], "--json") == 0 && i + 1 < argc)       jsonPath = argv[++i];
+        else if (std::strcmp (argv[i], "--time") == 0 && i + 1 < argc)       minSeconds = std::atof (argv[++i]);
+        else if (std::strcmp (argv[i], "--rate") == 0 && i + 1 < argc)       sampleRate = std::atof (argv[++i]);
+        else if (std::strcmp (argv[i], "--block") == 0 && i + 1 < argc)      blockSize = std::atoi (argv[++i]);
+        else if (std::strcmp (argv[i], "--sources") == 0 && i + 1 < argc)    numSources = std::max (1, std::atoi (argv[++i]));
+        else
+        {
+            std::printf ("usage: detail_benchmark [--quick] [--json file] [--time seconds] [--rate sampleRate] [--block blockSize]\n"
+                         "                        [--sources numSources]\n");
+            return 1;
+        }
+    }
+
+    if (quick)
+    {
+        minSeconds = 0.1;
+        numSources = std::min (numSources, 64);
+    }
+
+    const auto makeConfig = [&] (Case c) { return BenchmarkReport::Config { getName (c), sampleRate, blockSize, numSources, true }; };
+
+    const bool identical = renderPassage (makeConfig (Case::full), Case::full, 64) == renderPassage (makeConfig (Case::off), Case::off, 64);
+
+    std::printf ("every source at the full model: output %s\n\n", identical ? "identical to level of detail off" : "DIFFERS from level of detail off");
+
+    if (! identical)
+        return 1;
+
+    BenchmarkReport::printHeader();
+
+    std::vector<BenchmarkReport::Result> results;
+    std::vector<std::string> summaries;
+    double off = 0;
+
+    for (Case c : { Case::off, Case::full, Case::reduced, Case::panned, Case::silent, Case::mixed, Case::budget })
+    {
+        const auto config = makeConfig (c);
+
+        Setup setup (config, c);
+        const auto result = BenchmarkReport::measure (config, minSeconds, minBlocks, [&setup] (int blockIndex) { setup.processBlock (blockIndex); });
+
+        BenchmarkReport::printRow (result);
+        results.push_back (result);
+
+        if (c == Case::off)
+            off = result.nsPerSample;
+
+        const auto& counters = setup.scene.getDetailCounters();
+        double total = 0;
+
+        for (auto count : counters.sourceSamples)
+            total += static_cast<double> (count);
+
+        char summary[256];
+        std::snprintf (summary, sizeof (summary), "%-12s cost %.2f, saved %5.1f%% measured, %5.1f%% counted; full %4.1f%%, reduced %4.1f%%, panned %4.1f%%, skipped %4.1f%%",
+                       getName (c), result.nsPerSample / off, 100.0 * (1.0 - result.nsPerSample / off), 100.0 * counters.getSavedFraction(),
+                       100.0 * counters.sourceSamples[0] / total, 100.0 * counters.sourceSamples[1] / total,
+                       100.0 * counters.sourceSamples[2] / total, 100.0 * counters.sourceSamples[3] / total);
+        summaries.push_back (summary);
+    }
+
+    std::printf ("\n");
+
+    for (auto& summary : summaries)
+        std::printf ("%s\n", summary.c_str());
+
+    if (! jsonPath.empty())
+    {
+        if (! BenchmarkReport::writeJson (jsonPath, "detail_benchmark", { { "kernel", SceneKernels::getName (SceneKernels::detectSimdLevel()) } }, results))
+        {
+            std::fprintf (stderr, "cannot write %s\n", jsonPath.c_str());
+            return 1;
+        }
+
+        std::printf ("wrote %d results to %s\n", static_cast<int> (results.size()), jsonPath.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    KernelBenchmark.cpp
+
+    Compares the scalar, SSE4.1 and AVX2 scene kernels. Levels the CPU does
+    not support are skipped.
+
+    usage: kernel_benchmark [sampleRate] [blockSize] [seconds]
+
+  ==============================================================================
+*/
+
+#include "BinauralScene.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+    double runScene (SceneKernels::SimdLevel level, int numSources, double sampleRate, int blockSize, int numBlocks)
+    {
+        BinauralScene scene;
+        scene.prepare (sampleRate, blockSize, numSources);
+        scene.setSimdLevel (level);
+
+        std::mt19937 rng (1);
+        std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+
+        std::vector<std::vector<float>> inputs (numSources, std::vector<float> (blockSize));
+        std::vector<const float*> inputPointers;
+
+        for (auto& input : inputs)
+        {
+            for (auto& x : input)
+                x = noise (rng);
+
+            inputPointers.push_back (input.data());
+        }
+
+        std::vector<float> outL (blockSize), outR (blockSize);
+
+        const auto startTime = std::chrono::steady_clock::now();
+
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            // Moving sources, so the ramps and fractional taps are exercised
+            for (int s = 0; s < numSources; ++s)
+                scene.setSourcePosition (s, 80.0f * std::sin (0.01f * b + s), 30.0f * std::cos (0.007f * b + s));
+
+            scene.process (inputPointers.data(), outL.data(), outR.data(), blockSize);
+        }
+
+        const double elapsed = std::chrono::duration<double> (std::chrono::steady_clock::now() - startTime).count();
+
+        return elapsed * 1e9 / (static_cast<double> (numBlocks) * blockSize * numSources);
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    using SceneKernels::SimdLevel;
+
+    const double sampleRate = argc > 1 ? std::atof (argv[1]) : 48000.0;
+    const int blockSize     = argc > 2 ? std::atoi (argv[2]) : 128;
+    const double seconds    = argc > 3 ? std::atof (argv[3]) : 1.0;
+
+    const int numBlocks = static_cast<int> (seconds * sampleRate / blockSize);
+    const auto supported = SceneKernels::detectSimdLevel();
+
+    std::printf ("sample rate %.0f Hz, block size %d, CPU supports %s\n\n", sampleRate, blockSize, SceneKernels::getName (supported));
+    std::printf ("%8s %8s %18s %9s\n", "sources", "kernel", "ns/source-sample", "speedup");
+
+    for (int numSources : { 8, 64, 256 })
+    {
+        const double scalar = runScene (SimdLevel::scalar, numSources, sampleRate, blockSize, numBlocks);
+
+        for (auto level : { SimdLevel::scalar, SimdLevel::sse41, SimdLevel::avx2 })
+        {
+            if (level > supported)
+                continue;
+
+            const double ns = level == SimdLevel::scalar ? scalar
+                                                          : runScene (level, numSources, sampleRate, blockSize, numBlocks);
+
+            std::printf ("%8d %8s %18.2f %8.2fx\n", numSources, SceneKernels::getName (level), ns, scalar / ns);
+        }
+    }
+
+    return 0;
+}
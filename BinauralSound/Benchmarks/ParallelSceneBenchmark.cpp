@@ -0,0 +1,204 @@
+/*
+  ==============================================================================
+
+    ParallelSceneBenchmark.cpp
+
+    Measures how BinauralScene scales over a SceneThreadPool, from the
+    audio thread alone up to one thread per core, for large scenes of
+    moving sources. For every thread count it prints the speed-up over one
+    thread and the block time distribution against the block period (p99,
+    max and the headroom left at p99), which is what decides dropouts. It
+    also renders a short passage with every thread count and checks that
+    the output is the same to the bit.
+
+    usage: parallel_scene_benchmark [--quick] [--json file] [--time seconds]
+                                    [--rate sampleRate] [--block blockSize]
+                                    [--threads maxThreads] [--culled]
+
+    --culled makes every third group of sources inaudible, so the groups
+    cost very different amounts and the threads have to steal to balance.
+
+  ==============================================================================
+*/
+
+#include "BenchmarkReport.h"
+#include "BenchmarkSignals.h"
+#include "BinauralScene.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr int minBlocks = 64;
+
+    struct Options
+    {
+        bool culled = false;
+    };
+
+    /** A scene of moving sources, on numThreads threads with the caller. */
+    struct Setup
+    {
+        Setup (const BenchmarkReport::Config& config, int numThreads, const Options& options)
+            : numSources (config.numSources), blockSize (config.blockSize), sampleRate (config.sampleRate)
+        {
+            scene.prepare (sampleRate, blockSize, numSources);
+
+            if (numThreads > 1)
+            {
+                pool = std::make_shared<SceneThreadPool> (numThreads - 1);
+                scene.setThreadPool (pool);
+            }
+
+            std::mt19937 rng (1);
+            std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+
+            inputs.assign (numSources, std::vector<float> (blockSize));
+
+            for (int s = 0; s < numSources; ++s)
+            {
+                for (auto& x : inputs[s])
+                    x = noise (rng);
+
+                inputPointers.push_back (inputs[s].data());
+
+                if (options.culled && (s / BinauralScene::kSourcesPerTask) % 3 == 0)
+                    scene.setSourceGain (s, -200.0f);
+            }
+
+            outL.assign (blockSize, 0.0f);
+            outR.assign (blockSize, 0.0f);
+        }
+
+        void processBlock (int blockIndex)
+        {
+            const double time = static_cast<double> (blockIndex) * blockSize / sampleRate;
+
+            for (int s = 0; s < numSources; ++s)
+                scene.setSourcePosition (s, BenchmarkSignals::movingAzimuth (time, s), BenchmarkSignals::movingElevation (time, s));
+
+            scene.process (inputPointers.data(), outL.data(), outR.data(), blockSize);
+        }
+
+        int numSources, blockSize;
+        double sampleRate;
+
+        BinauralScene scene;
+        std::shared_ptr<SceneThreadPool> pool;
+
+        std::vector<std::vector<float>> inputs;
+        std::vector<const float*> inputPointers;
+        std::vector<float> outL, outR;
+    };
+
+    /** Both ears of the first numBlocks blocks. */
+    std::vector<float> renderPassage (const BenchmarkReport::Config& config, int numThreads, const Options& options, int numBlocks)
+    {
+        Setup setup (config, numThreads, options);
+        std::vector<float> passage;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            setup.processBlock (block);
+            passage.insert (passage.end(), setup.outL.begin(), setup.outL.end());
+            passage.insert (passage.end(), setup.outR.begin(), setup.outR.end());
+        }
+
+        return passage;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    bool quick = false;
+    std::string jsonPath;
+    double minSeconds = 0.5;
+    double sampleRate = 48000;
+    int blockSize = 128;
+    int maxThreads = SceneThreadPool::getDefaultNumWorkers() + 1;
+    Options options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp (argv[i], "--quick") == 0)                          quick = true;
+        else if (std::strcmp (argv[i], "--json") == 0 && i + 1 < argc)       jsonPath = argv[++i];
+        else if (std::strcmp (argv[i], "--time") == 0 && i + 1 < argc)       minSeconds = std::atof (argv[++i]);
+        else if (std::strcmp (argv[i], "--rate") == 0 && i + 1 < argc)       sampleRate = std::atof (argv[++i]);
+        else if (std::strcmp (argv[i], "--block") == 0 && i + 1 < argc)      blockSize = std::atoi (argv[++i]);
+        else if (std::strcmp (argv[i], "--threads") == 0 && i + 1 < argc)    maxThreads = std::max (1, std::atoi (argv[++i]));
+        else if (std::strcmp (argv[i], "--culled") == 0)                     options.culled = true;
+        else
+        {
+            std::printf ("usage: parallel_scene_benchmark [--quick] [--json file] [--time seconds] [--rate sampleRate] [--block blockSize]\n"
+                         "                                [--threads maxThreads] [--culled]\n");
+            return 1;
+        }
+    }
+
+    if (quick)
+        minSeconds = 0.1;
+
+    const std::vector<int> sourceCounts = quick ? std::vector<int> { 256, 512 } : std::vector<int> { 128, 256, 512, 1024 };
+
+    std::printf ("%d hardware threads, %d sources per task%s\n\n", static_cast<int> (std::thread::hardware_concurrency()),
+                 BinauralScene::kSourcesPerTask, options.culled ? ", every third group culled" : "");
+
+    std::vector<BenchmarkReport::Result> results;
+
+    for (int numSources : sourceCounts)
+    {
+        BenchmarkReport::printHeader();
+
+        const std::vector<float> reference = renderPassage ({ "scene", sampleRate, blockSize, numSources, true }, 1, options, 32);
+        double singleThread = 0;
+
+        for (int numThreads = 1; numThreads <= maxThreads; ++numThreads)
+        {
+            const BenchmarkReport::Config config { "scene x" + std::to_string (numThreads), sampleRate, blockSize, numSources, true };
+
+            Setup setup (config, numThreads, options);
+            const auto result = BenchmarkReport::measure (config, minSeconds, minBlocks, [&setup] (int blockIndex) { setup.processBlock (blockIndex); });
+
+            BenchmarkReport::printRow (result);
+            results.push_back (result);
+
+            if (numThreads == 1)
+                singleThread = result.nsPerSample;
+
+            const bool identical = renderPassage (config, numThreads, options, 32) == reference;
+            const double stolenPerBlock = setup.pool != nullptr ? static_cast<double> (setup.pool->getNumStolenTasks()) / result.numBlocks : 0.0;
+
+            std::printf ("    speed-up %.2f, %.1f tasks stolen per block, %d of %d workers real-time, output %s\n",
+                         singleThread / result.nsPerSample, stolenPerBlock,
+                         setup.pool != nullptr ? setup.pool->getNumRealtimeWorkers() : 0, numThreads - 1,
+                         identical ? "identical to 1 thread" : "DIFFERS from 1 thread");
+
+            if (! identical)
+                return 1;
+        }
+
+        std::printf ("\n");
+    }
+
+    if (! jsonPath.empty())
+    {
+        if (! BenchmarkReport::writeJson (jsonPath, "parallel_scene_benchmark", { { "culled", options.culled ? "true" : "false" } }, results))
+        {
+            std::fprintf (stderr, "cannot write %s\n", jsonPath.c_str());
+            return 1;
+        }
+
+        std::printf ("wrote %d results to %s\n", static_cast<int> (results.size()), jsonPath.c_str());
+    }
+
+    return 0;
+}
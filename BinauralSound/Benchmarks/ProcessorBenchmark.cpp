@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    ProcessorBenchmark.cpp
+
+    Drives BinauralSoundAudioProcessor::processBlock directly, the same way
+    a host would, over block sizes, sample rates and static or moving
+    sources. Needs JUCE; see CMakeLists.txt.
+
+    usage: processor_benchmark [--quick] [--json file] [--time seconds]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+#include "BenchmarkReport.h"
+#include "PluginProcessor.h"
+
+#include <cmath>
+#include <cstring>
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    bool quick = false;
+    std::string jsonPath;
+    double minSeconds = 0.1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp (argv[i], "--quick") == 0)                      quick = true;
+        else if (std::strcmp (argv[i], "--json") == 0 && i + 1 < argc)   jsonPath = argv[++i];
+        else if (std::strcmp (argv[i], "--time") == 0 && i + 1 < argc)   minSeconds = std::atof (argv[++i]);
+        else
+        {
+            std::printf ("usage: processor_benchmark [--quick] [--json file] [--time seconds]\n");
+            return 1;
+        }
+    }
+
+    const std::vector<double> sampleRates = quick ? std::vector<double> { 48000, 96000 }
+                                                  : std::vector<double> { 44100, 48000, 96000, 192000 };
+    const std::vector<int> blockSizes = quick ? std::vector<int> { 64, 512, 4096 }
+                                              : std::vector<int> { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+
+    BenchmarkReport::printHeader();
+
+    std::vector<BenchmarkReport::Result> results;
+    juce::Random random (1);
+
+    for (double sampleRate : sampleRates)
+    {
+        for (int blockSize : blockSizes)
+        {
+            for (bool moving : { false, true })
+            {
+                BinauralSoundAudioProcessor processor;
+                processor.setPlayConfigDetails (2, 2, sampleRate, blockSize);
+                processor.prepareToPlay (sampleRate, blockSize);
+
+                juce::AudioBuffer<float> noise (1, blockSize);
+                for (int i = 0; i < blockSize; ++i)
+                    noise.setSample (0, i, random.nextFloat() - 0.5f);
+
+                juce::AudioBuffer<float> buffer (2, blockSize);
+                juce::MidiBuffer midi;
+
+                auto* azimuth = processor.apvts.getParameter ("AZIMUTH");
+                auto* elevation = processor.apvts.getParameter ("ELEVATION");
+
+                const BenchmarkReport::Config config { "plugin", sampleRate, blockSize, 1, moving };
+
+                results.push_back (BenchmarkReport::measure (config, minSeconds, 32, [&] (int blockIndex)
+                {
+                    if (moving)
+                    {
+                        // Host automation
+                        const double time = static_cast<double> (blockIndex) * blockSize / sampleRate;
+                        azimuth->setValueNotifyingHost (azimuth->convertTo0to1 (static_cast<float> (80.0 * std::sin (juce::MathConstants<double>::twoPi * 0.5 * time))));
+                        elevation->setValueNotifyingHost (elevation->convertTo0to1 (static_cast<float> (30.0 * std::cos (juce::MathConstants<double>::twoPi * 0.3 * time))));
+                    }
+
+                    // Hosts hand over a fresh input every block
+                    buffer.copyFrom (0, 0, noise, 0, 0, blockSize);
+                    buffer.copyFrom (1, 0, noise, 0, 0, blockSize);
+
+                    processor.processBlock (buffer, midi);
+                }));
+
+                BenchmarkReport::printRow (results.back());
+
+                processor.releaseResources();
+            }
+        }
+    }
+
+    if (! jsonPath.empty())
+    {
+        if (! BenchmarkReport::writeJson (jsonPath, "processor_benchmark", {}, results))
+        {
+            std::fprintf (stderr, "cannot write %s\n", jsonPath.c_str());
+            return 1;
+        }
+
+        std::printf ("\nwrote %d results to %s\n", static_cast<int> (results.size()), jsonPath.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,278 @@
+/*
+  ==============================================================================
+
+    RenderBenchmark.cpp
+
+    Sweeps BinauralEngine and BinauralScene over block sizes, sample rates,
+    static and moving sources and (for the scene) source counts, and reports
+    per-block timing percentiles and realtime headroom.
+
+    usage: render_benchmark [--quick] [--json file] [--time seconds]
+                            [--target engine|scene] [--reverb] [--reflections]
+                            [--hrir] [--hrir-file file]
+                            [--interpolation linear|lagrange4|sinc8|sinc16]
+                            [--no-room-echo] [--double] [--double-filters]
+
+    --quick runs a reduced grid for a fast sanity check. --time is the
+    minimum wall time spent on each configuration (default 0.1 s).
+    --reverb switches the late reverb bus on; its cost should not depend on
+    the number of sources. --reflections renders 24 early reflections per
+    source in the default shoebox room.
+
+    --hrir renders the engine's direct sound by HRIR convolution instead of
+    the model, to compare the cost of the two paths; the scene is skipped,
+    it only has the model. The HRIRs are the model's own impulse responses
+    on a 10 degree grid, 5.3 ms long (256 taps at 48 kHz, like typical
+    measured sets), unless --hrir-file gives a set to load.
+
+    --interpolation sets the engine's fractional delay interpolator (see
+    Interpolation.h); the scene is skipped for anything but linear, it
+    only has that one. --no-room-echo renders the engine without the
+    model's room echo, which is then compiled out of its inner loop; the
+    scene is skipped as well.
+
+    --double runs the engine's double precision process(), as for a 64 bit
+    host, and --double-filters its float process() with double precision
+    filters (BinauralEngine::setDoublePrecisionFilters()). Both only apply
+    to the engine.
+
+  ==============================================================================
+*/
+
+#include "BenchmarkReport.h"
+#include "BenchmarkSignals.h"
+#include "BinauralEngine.h"
+#include "BinauralScene.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr int minBlocks = 32;
+
+    constexpr double hrirLength = 256.0 / 48000.0; // [s]
+    constexpr int hrirGridStep = 10; // [deg]
+
+    //==============================================================================
+    constexpr float reverbWet = 0.3f;
+
+    struct Options
+    {
+        bool reverb = false;
+        bool reflections = false;
+        bool hrir = false;
+        std::shared_ptr<const HrirSet> hrirFile; // instead of the model's responses
+        Interpolation::Kind interpolation = Interpolation::Kind::linear;
+        bool roomEcho = true;
+        bool doubleSamples = false;
+        bool doubleFilters = false;
+
+        std::string label (const char* target) const
+        {
+            const bool linear = interpolation == Interpolation::Kind::linear;
+
+            return std::string (target) + (hrir ? "+hrir" : "") + (reverb ? "+reverb" : "") + (reflections ? "+refl" : "")
+                 + (linear ? "" : std::string ("+") + Interpolation::getName (interpolation)) + (roomEcho ? "" : "-echo")
+                 + (doubleSamples ? "+double" : doubleFilters ? "+dfilters" : "");
+        }
+
+        /** HRIR filters for the engine at this rate, built once per rate. */
+        std::shared_ptr<const HrirFilters> getHrirs (double sampleRate) const
+        {
+            auto& filters = hrirFilters[sampleRate];
+
+            if (filters == nullptr)
+            {
+                // The model's own responses stand in for a measured set
+                auto hrirs = hrirFile != nullptr ? hrirFile
+                                                 : BenchmarkSignals::makeModelHrirs (sampleRate, static_cast<int> (std::round (hrirLength * sampleRate)), hrirGridStep);
+
+                filters = std::make_shared<const HrirFilters> (std::move (hrirs), sampleRate, BinauralEngine::hrirPartitionSize, BinauralEngine::maxHrirLength);
+            }
+
+            return filters;
+        }
+
+        mutable std::map<double, std::shared_ptr<const HrirFilters>> hrirFilters;
+    };
+
+    template <typename SampleType>
+    BenchmarkReport::Result runEngine (const BenchmarkReport::Config& config, double minSeconds, const Options& options)
+    {
+        BinauralEngine engine;
+        engine.setInterpolation (options.interpolation);
+        engine.setRoomEcho (options.roomEcho);
+        engine.setDoublePrecisionFilters (options.doubleFilters);
+        engine.prepare (config.sampleRate, config.blockSize);
+        engine.setAzimuth (30.0f);
+        engine.setElevation (10.0f);
+        engine.setReverbWet (options.reverb ? reverbWet : 0.0f);
+        engine.setEarlyReflections (options.reflections);
+
+        if (options.hrir)
+        {
+            engine.setHrirs (options.getHrirs (config.sampleRate));
+            engine.setRenderingMode (BinauralEngine::RenderingMode::hrir);
+        }
+
+        const auto noise = BenchmarkSignals::makeNoise (config.blockSize, 1);
+        const std::vector<SampleType> input (noise.begin(), noise.end());
+        std::vector<SampleType> outL (config.blockSize), outR (config.blockSize);
+
+        return BenchmarkReport::measure (config, minSeconds, minBlocks, [&] (int blockIndex)
+        {
+            if (config.moving)
+            {
+                const double time = static_cast<double> (blockIndex) * config.blockSize / config.sampleRate;
+                engine.setAzimuth (BenchmarkSignals::movingAzimuth (time, 0));
+                engine.setElevation (BenchmarkSignals::movingElevation (time, 0));
+            }
+
+            engine.process (input.data(), outL.data(), outR.data(), config.blockSize);
+        });
+    }
+
+    BenchmarkReport::Result runScene (const BenchmarkReport::Config& config, double minSeconds, const Options& options)
+    {
+        const int numSources = config.numSources;
+
+        BinauralScene scene;
+        scene.prepare (config.sampleRate, config.blockSize, numSources);
+        scene.setReverbWet (options.reverb ? reverbWet : 0.0f);
+        scene.setEarlyReflections (options.reflections);
+
+        std::vector<std::vector<float>> inputs;
+        std::vector<const float*> inputPointers;
+
+        for (int s = 0; s < numSources; ++s)
+        {
+            inputs.push_back (BenchmarkSignals::makeNoise (config.blockSize, static_cast<unsigned> (s + 1)));
+            inputPointers.push_back (inputs.back().data());
+            scene.setSourcePosition (s, -89.0f + 178.0f * s / numSources, 45.0f * (s % 3 - 1));
+        }
+
+        std::vector<float> outL (config.blockSize), outR (config.blockSize);
+
+        return BenchmarkReport::measure (config, minSeconds, minBlocks, [&] (int blockIndex)
+        {
+            if (config.moving)
+            {
+                const double time = static_cast<double> (blockIndex) * config.blockSize / config.sampleRate;
+
+                for (int s = 0; s < numSources; ++s)
+                    scene.setSourcePosition (s, BenchmarkSignals::movingAzimuth (time, s), BenchmarkSignals::movingElevation (time, s));
+            }
+
+            scene.process (inputPointers.data(), outL.data(), outR.data(), config.blockSize);
+        });
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    bool quick = false;
+    Options options;
+    std::string jsonPath;
+    std::string targetFilter;
+    double minSeconds = 0.1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp (argv[i], "--quick") == 0)                      quick = true;
+        else if (std::strcmp (argv[i], "--json") == 0 && i + 1 < argc)   jsonPath = argv[++i];
+        else if (std::strcmp (argv[i], "--time") == 0 && i + 1 < argc)   minSeconds = std::atof (argv[++i]);
+        else if (std::strcmp (argv[i], "--target") == 0 && i + 1 < argc) targetFilter = argv[++i];
+        else if (std::strcmp (argv[i], "--reverb") == 0)                 options.reverb = true;
+        else if (std::strcmp (argv[i], "--reflections") == 0)            options.reflections = true;
+        else if (std::strcmp (argv[i], "--hrir") == 0)                   options.hrir = true;
+        else if (std::strcmp (argv[i], "--interpolation") == 0 && i + 1 < argc && Interpolation::fromName (argv[i + 1], options.interpolation))
+            ++i;
+        else if (std::strcmp (argv[i], "--no-room-echo") == 0)           options.roomEcho = false;
+        else if (std::strcmp (argv[i], "--double") == 0)                 options.doubleSamples = true;
+        else if (std::strcmp (argv[i], "--double-filters") == 0)         options.doubleFilters = true;
+        else if (std::strcmp (argv[i], "--hrir-file") == 0 && i + 1 < argc)
+        {
+            std::string error;
+            options.hrirFile = HrirSet::load (argv[++i], error);
+            options.hrir = true;
+
+            if (options.hrirFile == nullptr)
+            {
+                std::fprintf (stderr, "%s\n", error.c_str());
+                return 1;
+            }
+        }
+        else
+        {
+            std::printf ("usage: render_benchmark [--quick] [--json file] [--time seconds] [--target engine|scene] [--reverb] [--reflections] [--hrir] [--hrir-file file]\n"
+                         "                        [--interpolation linear|lagrange4|sinc8|sinc16] [--no-room-echo] [--double] [--double-filters]\n");
+            return 1;
+        }
+    }
+
+    // Only the engine has the HRIR path, the other interpolators, the lean model and double precision
+    if (options.hrir || options.interpolation != Interpolation::Kind::linear || ! options.roomEcho || options.doubleSamples || options.doubleFilters)
+        targetFilter = "engine";
+
+    const std::vector<double> sampleRates = quick ? std::vector<double> { 48000, 96000 }
+                                                  : std::vector<double> { 44100, 48000, 96000, 192000 };
+    const std::vector<int> blockSizes = quick ? std::vector<int> { 64, 512, 4096 }
+                                              : std::vector<int> { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    const std::vector<int> sourceCounts = quick ? std::vector<int> { 1, 16, 128, 512 }
+                                                : std::vector<int> { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512 };
+
+    const char* simd = SceneKernels::getName (SceneKernels::detectSimdLevel());
+    std::printf ("scene kernel: %s, at least %.2f s and %d blocks per configuration\n\n", simd, minSeconds, minBlocks);
+
+    BenchmarkReport::printHeader();
+
+    std::vector<BenchmarkReport::Result> results;
+
+    for (double sampleRate : sampleRates)
+    {
+        for (int blockSize : blockSizes)
+        {
+            for (bool moving : { false, true })
+            {
+                if (targetFilter.empty() || targetFilter == "engine")
+                {
+                    const BenchmarkReport::Config config { options.label ("engine"), sampleRate, blockSize, 1, moving };
+
+                    results.push_back (options.doubleSamples ? runEngine<double> (config, minSeconds, options)
+                                                             : runEngine<float> (config, minSeconds, options));
+                    BenchmarkReport::printRow (results.back());
+                }
+
+                if (targetFilter.empty() || targetFilter == "scene")
+                {
+                    for (int numSources : sourceCounts)
+                    {
+                        results.push_back (runScene ({ options.label ("scene"), sampleRate, blockSize, numSources, moving }, minSeconds, options));
+                        BenchmarkReport::printRow (results.back());
+                    }
+                }
+            }
+        }
+    }
+
+    if (! jsonPath.empty())
+    {
+        if (! BenchmarkReport::writeJson (jsonPath, "render_benchmark", { { "simd", simd } }, results))
+        {
+            std::fprintf (stderr, "cannot write %s\n", jsonPath.c_str());
+            return 1;
+        }
+
+        std::printf ("\nwrote %d results to %s\n", static_cast<int> (results.size()), jsonPath.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    SceneBenchmark.cpp
+
+    Measures how BinauralScene throughput scales with the number of sources.
+
+    usage: scene_benchmark [sampleRate] [blockSize] [seconds]
+
+  ==============================================================================
+*/
+
+#include "BinauralScene.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+int main (int argc, char* argv[])
+{
+    const double sampleRate = argc > 1 ? std::atof (argv[1]) : 48000.0;
+    const int blockSize     = argc > 2 ? std::atoi (argv[2]) : 128;
+    const double seconds    = argc > 3 ? std::atof (argv[3]) : 2.0;
+
+    const int numBlocks = static_cast<int> (seconds * sampleRate / blockSize);
+
+    std::printf ("sample rate %.0f Hz, block size %d, %.1f s of audio per run\n\n", sampleRate, blockSize, seconds);
+    std::printf ("%8s %14s %18s %12s %12s\n", "sources", "ns/sample", "ns/source-sample", "realtime x", "memory KB");
+
+    std::mt19937 rng (1);
+    std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+
+    for (int numSources : { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512 })
+    {
+        BinauralScene scene;
+        scene.prepare (sampleRate, blockSize, numSources);
+
+        std::vector<std::vector<float>> inputs (numSources, std::vector<float> (blockSize));
+        std::vector<const float*> inputPointers;
+
+        for (int s = 0; s < numSources; ++s)
+        {
+            for (auto& x : inputs[s])
+                x = noise (rng);
+
+            inputPointers.push_back (inputs[s].data());
+            scene.setSourcePosition (s, -89.0f + 178.0f * s / numSources, 45.0f * (s % 3 - 1));
+        }
+
+        std::vector<float> outL (blockSize), outR (blockSize);
+
+        const auto startTime = std::chrono::steady_clock::now();
+
+        for (int b = 0; b < numBlocks; ++b)
+            scene.process (inputPointers.data(), outL.data(), outR.data(), blockSize);
+
+        const double elapsed = std::chrono::duration<double> (std::chrono::steady_clock::now() - startTime).count();
+        const double numSamples = static_cast<double> (numBlocks) * blockSize;
+        const double nsPerSample = elapsed * 1e9 / numSamples;
+
+        std::printf ("%8d %14.1f %18.2f %12.1f %12.1f\n", numSources, nsPerSample, nsPerSample / numSources,
+                     numSamples / sampleRate / elapsed, scene.getMemoryFootprint() / 1024.0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,375 @@
+/*
+  ==============================================================================
+
+    AmbisonicDecoder.cpp
+
+  ==============================================================================
+*/
+
+#include "AmbisonicDecoder.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "BinauralEngine.h"
+#include "BrownDudaModel.h"
+
+namespace
+{
+    int log2 (int powerOfTwo)
+    {
+        int order = 0;
+        while ((1 << order) < powerOfTwo)
+            ++order;
+        return order;
+    }
+
+    int nextPowerOfTwo (int n)
+    {
+        int size = 1;
+        while (size < n)
+            size *= 2;
+        return size;
+    }
+
+    void setIdentity (std::vector<float>& matrix, int size)
+    {
+        std::fill (matrix.begin(), matrix.end(), 0.0f);
+
+        for (int i = 0; i < size; ++i)
+            matrix[static_cast<size_t> (i) * size + i] = 1.0f;
+    }
+}
+
+//==============================================================================
+int AmbisonicDecoder::getOrderForChannels (int numChannels)
+{
+    for (int order = 1; order <= Ambisonics::order; ++order)
+        if (Ambisonics::getNumChannels(order) == numChannels)
+            return order;
+
+    return 0;
+}
+
+void AmbisonicDecoder::prepare (double sampleRate, int maxBlock, int fieldOrderToUse)
+{
+    gSampleRate = sampleRate;
+    fieldOrder = std::clamp (fieldOrderToUse, 1, Ambisonics::order);
+    numChannels = Ambisonics::getNumChannels(fieldOrder);
+    numBins = partitionSize + 1;
+    modelLatency = BrownDudaModel::initialLatency(static_cast<float> (sampleRate));
+
+    fft = std::make_unique<Fft> (log2(2 * partitionSize));
+
+    computeFilters(sampleRate);
+
+    inputBlock.assign(static_cast<size_t> (numChannels) * partitionSize, 0.0f);
+
+    for (auto& ear : output)
+        ear.assign(partitionSize, 0.0f);
+
+    fieldBlock.assign(static_cast<size_t> (numChannels) * 2 * partitionSize, 0.0f);
+    fdl.assign(static_cast<size_t> (numChannels) * numPartitions * 2 * numBins, 0.0f);
+    accumulator.assign(2 * 2 * numBins, 0.0f);
+    timeBlock.assign(2 * partitionSize, 0.0f);
+
+    rotation_current.assign(static_cast<size_t> (numChannels) * numChannels, 0.0f);
+    rotation_target.assign(static_cast<size_t> (numChannels) * numChannels, 0.0f);
+
+    // The model reads its room echo tau_Ke behind its initial latency, and
+    // the convolution delays everything else by one partition
+    const float echoDelay = BrownDudaModel::tau_Ke * static_cast<float> (sampleRate);
+    echoDelay_floor = partitionSize + modelLatency + static_cast<int> (std::floor(echoDelay));
+    echoDelay_frac = echoDelay - std::floor(echoDelay);
+
+    echoLine.assign(nextPowerOfTwo(echoDelay_floor + 2), 0.0f);
+    echoMask = static_cast<int> (echoLine.size()) - 1;
+
+    reverb.prepare(sampleRate);
+    reverbSend.assign(maxBlock, 0.0f);
+
+    setSmoothingTime(gSmoothingTime);
+
+    reset();
+}
+
+void AmbisonicDecoder::computeFilters (double sampleRate)
+{
+    // The model's impulse response of every speaker, up to where the room
+    // echo starts
+    const int length = modelLatency + static_cast<int> (std::ceil(directLength * sampleRate));
+    numPartitions = (length + partitionSize - 1) / partitionSize;
+
+    BinauralEngine model;
+    model.setSmoothingTime(0);
+    model.prepare(sampleRate, length);
+
+    const auto& speakers = Ambisonics::getVirtualSpeakers();
+
+    std::vector<float> filters (static_cast<size_t> (numChannels) * 2 * length, 0.0f); // [channel][ear][length]
+    std::vector<float> impulse (length, 0.0f), left (length), right (length);
+    float gains[Ambisonics::numChannels];
+    float omniGain = 0;
+
+    for (auto& speaker : speakers)
+    {
+        float azimuth, elevation;
+        Ambisonics::toInterauralPolar(speaker.x, speaker.y, speaker.z, azimuth, elevation);
+
+        model.setAzimuth(azimuth);
+        model.setElevation(elevation);
+        model.reset();
+
+        std::fill (impulse.begin(), impulse.end(), 0.0f);
+        impulse[0] = 1.0f;
+        model.process(impulse.data(), left.data(), right.data(), length);
+
+        // Fold the decoder into the filters: every channel feeds this speaker
+        // with its decoding gain
+        Ambisonics::getDecoderGains(speaker, speaker.x, speaker.y, speaker.z, gains, fieldOrder);
+        omniGain += gains[0];
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            float* const filterL = filters.data() + static_cast<size_t> (channel) * 2 * length;
+            float* const filterR = filterL + length;
+
+            for (int i = 0; i < length; ++i)
+            {
+                filterL[i] += gains[channel] * left[i];
+                filterR[i] += gains[channel] * right[i];
+            }
+        }
+    }
+
+    // The higher orders sum to 0 over the speakers, so only the omni channel has an echo
+    echoGain = BrownDudaModel::roomEchoGain() * omniGain;
+
+    // Folds the 1 / 2P of the inverse transform into the filters
+    const float scale = 1.0f / fft->getSize();
+
+    spectra.assign(static_cast<size_t> (numChannels) * 2 * numPartitions * 2 * numBins, 0.0f);
+    std::vector<float> padded (2 * partitionSize);
+
+    for (int filter = 0; filter < numChannels * 2; ++filter)
+    {
+        const float* const ir = filters.data() + static_cast<size_t> (filter) * length;
+
+        for (int k = 0; k < numPartitions; ++k)
+        {
+            std::fill (padded.begin(), padded.end(), 0.0f);
+
+            const int start = k * partitionSize;
+            const int count = std::min (partitionSize, length - start);
+
+            for (int i = 0; i < count; ++i)
+                padded[i] = ir[start + i] * scale;
+
+            float* const spectrum = spectra.data() + (static_cast<size_t> (filter) * numPartitions + k) * 2 * numBins;
+            fft->forward(padded.data(), spectrum, spectrum + numBins);
+        }
+    }
+}
+
+void AmbisonicDecoder::reset()
+{
+    std::fill (inputBlock.begin(), inputBlock.end(), 0.0f);
+
+    for (auto& ear : output)
+        std::fill (ear.begin(), ear.end(), 0.0f);
+
+    std::fill (fieldBlock.begin(), fieldBlock.end(), 0.0f);
+    std::fill (fdl.begin(), fdl.end(), 0.0f);
+    std::fill (echoLine.begin(), echoLine.end(), 0.0f);
+
+    inputFill = 0;
+    fdlPosition = 0;
+    echoWritePointer = 0;
+
+    setIdentity(rotation_current, numChannels);
+    setIdentity(rotation_target, numChannels);
+    rotationOrientation = {};
+
+    reverb.reset();
+    started = false;
+}
+
+void AmbisonicDecoder::setSmoothingTime (double seconds)
+{
+    gSmoothingTime = std::max (0.0, seconds);
+
+    volume_smoothed.setRampLength(static_cast<int> (std::round (gSmoothingTime * gSampleRate)));
+    reverb.setSmoothingTime(gSmoothingTime);
+}
+
+size_t AmbisonicDecoder::getMemoryFootprint() const
+{
+    size_t floats = spectra.capacity() + inputBlock.capacity() + fieldBlock.capacity() + fdl.capacity()
+                  + accumulator.capacity() + timeBlock.capacity() + rotation_current.capacity() + rotation_target.capacity()
+                  + echoLine.capacity() + reverbSend.capacity();
+
+    for (auto& ear : output)
+        floats += ear.capacity();
+
+    return sizeof (*this) + floats * sizeof (float) + reverb.getMemoryFootprint() - sizeof (reverb);
+}
+
+//==============================================================================
+void AmbisonicDecoder::process (const float* const* inputs, float* outputL, float* outputR, int n)
+{
+    // Start from the parameters themselves after prepare() / reset()
+    if (! started)
+    {
+        volume_smoothed.setCurrentAndTarget(gVolume_param);
+        headOrientation_current = headOrientation_target;
+        started = true;
+    }
+
+    headOrientation_start = headOrientation_current;
+
+    const float gain_start = std::pow(10.0f, volume_smoothed.getCurrentValue() / 20);
+    const float gain_end = std::pow(10.0f, volume_smoothed.getNext(gVolume_param, n) / 20);
+    const float gain_inc = (gain_end - gain_start) / n;
+
+    // Only collect the reverb send while the reverb is on
+    float* const send = reverb.isActive() ? reverbSend.data() : nullptr;
+
+    for (int done = 0; done < n;)
+    {
+        const int count = std::min (n - done, partitionSize - inputFill);
+
+        // Read every channel before writing the outputs, they may alias
+        for (int channel = 0; channel < numChannels; ++channel)
+            std::copy (inputs[channel] + done, inputs[channel] + done + count,
+                       inputBlock.begin() + static_cast<ptrdiff_t> (channel) * partitionSize + inputFill);
+
+        const float* const omni = inputBlock.data() + inputFill;
+
+        for (int i = 0; i < count; ++i)
+        {
+            // Room echo, the same for both ears
+            echoLine[echoWritePointer] = omni[i];
+
+            const float echo = echoGain * ((1 - echoDelay_frac) * echoLine[(echoWritePointer - echoDelay_floor) & echoMask]
+                                           + echoDelay_frac * echoLine[(echoWritePointer - echoDelay_floor - 1) & echoMask]);
+
+            echoWritePointer = (echoWritePointer + 1) & echoMask;
+
+            const float gain = gain_start + gain_inc * (done + i + 1);
+
+            outputL[done + i] = (output[0][inputFill + i] + echo) * gain;
+            outputR[done + i] = (output[1][inputFill + i] + echo) * gain;
+
+            if (send != nullptr)
+                send[done + i] = echo * gain;
+        }
+
+        inputFill += count;
+        done += count;
+
+        if (inputFill == partitionSize)
+        {
+            processPartition(static_cast<float> (done) / n);
+            inputFill = 0;
+        }
+    }
+
+    headOrientation_current = headOrientation_target;
+
+    reverb.process(send, outputL, outputR, n);
+}
+
+void AmbisonicDecoder::processPartition (float t)
+{
+    // Rotate the block into the head's frame, ramping to the orientation at its end
+    const auto head = HeadOrientation::interpolate(headOrientation_start, headOrientation_target, t);
+
+    if (head.yaw != rotationOrientation.yaw || head.pitch != rotationOrientation.pitch || head.roll != rotationOrientation.roll)
+    {
+        Ambisonics::getRotation(head.getHeadRelativeMatrix(), fieldOrder, rotation_target.data());
+        rotationOrientation = head;
+    }
+
+    const bool rotating = ! (rotationOrientation.isIdentity() && rotation_current == rotation_target);
+    const float ramp = 1.0f / partitionSize;
+
+    for (int row = 0; row < numChannels; ++row)
+    {
+        float* const out = fieldBlock.data() + static_cast<size_t> (row) * 2 * partitionSize + partitionSize;
+
+        if (! rotating)
+        {
+            std::copy (inputBlock.begin() + static_cast<ptrdiff_t> (row) * partitionSize,
+                       inputBlock.begin() + static_cast<ptrdiff_t> (row + 1) * partitionSize, out);
+            continue;
+        }
+
+        std::fill (out, out + partitionSize, 0.0f);
+
+        // Only channels of the same order mix
+        const int order = Ambisonics::channelOrder(row);
+
+        for (int column = order * order; column < (order + 1) * (order + 1); ++column)
+        {
+            const float* const in = inputBlock.data() + static_cast<size_t> (column) * partitionSize;
+            const float g = rotation_current[static_cast<size_t> (row) * numChannels + column];
+            const float dg = (rotation_target[static_cast<size_t> (row) * numChannels + column] - g) * ramp;
+
+            for (int i = 0; i < partitionSize; ++i)
+                out[i] += (g + dg * (i + 1)) * in[i];
+        }
+    }
+
+    rotation_current = rotation_target;
+
+    // Every channel's newest spectrum into the delay line, from its last two blocks
+    fdlPosition = (fdlPosition + 1) % numPartitions;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        float* const block = fieldBlock.data() + static_cast<size_t> (channel) * 2 * partitionSize;
+        float* const xr = fdl.data() + (static_cast<size_t> (channel) * numPartitions + fdlPosition) * 2 * numBins;
+
+        fft->forward(block, xr, xr + numBins);
+        std::copy (block + partitionSize, block + 2 * partitionSize, block);
+    }
+
+    // All channels and partitions into one spectrum per ear
+    float* const reL = accumulator.data();
+    float* const imL = reL + numBins;
+    float* const reR = imL + numBins;
+    float* const imR = reR + numBins;
+
+    std::fill (accumulator.begin(), accumulator.end(), 0.0f);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        for (int k = 0; k < numPartitions; ++k)
+        {
+            const int slot = (fdlPosition - k + numPartitions) % numPartitions;
+
+            const float* const xr = fdl.data() + (static_cast<size_t> (channel) * numPartitions + slot) * 2 * numBins;
+            const float* const xi = xr + numBins;
+            const float* const hrL = spectra.data() + ((static_cast<size_t> (channel) * 2 * numPartitions) + k) * 2 * numBins;
+            const float* const hiL = hrL + numBins;
+            const float* const hrR = hrL + static_cast<size_t> (numPartitions) * 2 * numBins;
+            const float* const hiR = hrR + numBins;
+
+            for (int b = 0; b < numBins; ++b)
+            {
+                reL[b] += xr[b]*hrL[b] - xi[b]*hiL[b];
+                imL[b] += xr[b]*hiL[b] + xi[b]*hrL[b];
+                reR[b] += xr[b]*hrR[b] - xi[b]*hiR[b];
+                imR[b] += xr[b]*hiR[b] + xi[b]*hrR[b];
+            }
+        }
+    }
+
+    // Overlap-save: the second half of the circular convolution is valid
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        const float* const re = accumulator.data() + channel * 2 * numBins;
+        fft->inverse(re, re + numBins, timeBlock.data());
+        std::copy (timeBlock.begin() + partitionSize, timeBlock.end(), output[channel].begin());
+    }
+}
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    AmbisonicDecoder.h
+
+    Binaural rendering of a B-format recording of first to third order
+    (AmbiX: ACN channel order, SN3D normalisation).
+
+    The field is decoded to the 26 virtual speakers of Ambisonics.h, and
+    every speaker is heard through the Brown-Duda model from its direction.
+    None of that changes while playing, so prepare() renders the model's
+    impulse response for every speaker once and folds the decoder into
+    them: every input channel gets one filter per ear, the sum of the
+    speakers' responses weighted by their decoding gains. process() then
+    convolves all channels in one pass, uniformly partitioned in the
+    frequency domain like HrirConvolver: one forward transform per channel
+    and block, the products of all channels and partitions summed into one
+    spectrum per ear, and one inverse transform per ear. The cost does not
+    depend on the number of speakers.
+
+    The model's room echo is the same for every direction and both ears,
+    so it only depends on the omnidirectional channel and is a plain
+    delay rather than part of the filters; it also feeds the late reverb.
+
+    Head tracking rotates the field before the filters, which keeps the
+    filters fixed. The rotation is interpolated across every block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "Ambisonics.h"
+#include "FdnReverb.h"
+#include "Fft.h"
+#include "HeadOrientation.h"
+#include "ParameterSmoother.h"
+
+//==============================================================================
+/**
+*/
+class AmbisonicDecoder
+{
+public:
+    //==============================================================================
+    AmbisonicDecoder() = default;
+
+    //==============================================================================
+    /** Computes the filters for this sample rate and field order (1 to
+        Ambisonics::order) and allocates everything else. Must be called
+        before process(), and never from the audio thread.
+    */
+    void prepare (double sampleRate, int maxBlock, int fieldOrder);
+
+    /** Clears the input, the delay lines and the reverb. */
+    void reset();
+
+    /** Renders n samples of the getNumChannels() input channels into
+        outL / outR, which are overwritten. The inputs may alias the
+        outputs, e.g. the first two channels of a host buffer.
+    */
+    void process (const float* const* inputs, float* outL, float* outR, int n);
+
+    //==============================================================================
+    /** Field order of a B-format layout with this many channels, or 0 if
+        there is none up to Ambisonics::order.
+    */
+    static int getOrderForChannels (int numChannels);
+
+    int getOrder() const                { return fieldOrder; }
+    int getNumChannels() const          { return Ambisonics::getNumChannels(fieldOrder); }
+
+    /** Output level, glides over the smoothing time. */
+    void setVolume (float dB)           { gVolume_param = dB; }
+    float getVolume() const             { return gVolume_param; }
+
+    void setSmoothingTime (double seconds);
+
+    /** Listener head orientation. The field is counter-rotated by it,
+        moving from the previous orientation to this one over the next
+        process() call, like BinauralEngine::setHeadOrientation().
+    */
+    void setHeadOrientation (const HeadOrientation& orientation)    { headOrientation_target = orientation; }
+    const HeadOrientation& getHeadOrientation() const               { return headOrientation_target; }
+
+    /** Late reverb, fed by the room echo. */
+    void setReverbSize (float size)         { reverb.setSize(size); } // 0 to 1
+    void setReverbDecayTime (float seconds) { reverb.setDecayTime(seconds); }
+    void setReverbWet (float wet)           { reverb.setWet(wet); } // linear gain
+
+    /** Samples from the input to the output: the model's initial latency
+        plus one partition.
+    */
+    int getLatency() const              { return partitionSize + modelLatency; }
+
+    /** Bytes used by this instance, including its filters. */
+    size_t getMemoryFootprint() const;
+
+    /** Partition size of the convolution. */
+    static constexpr int partitionSize = 64;
+
+    /** Length of the filters after the model's initial latency. The head
+        shadow filter has decayed to below -150 dB by then.
+    */
+    static constexpr double directLength = 0.004; // [s]
+
+private:
+    //==============================================================================
+    void computeFilters (double sampleRate);
+    void processPartition (float t);
+
+    //==============================================================================
+    int fieldOrder = 0;
+    int numChannels = 0;
+    int numBins = 0;
+    int numPartitions = 0;
+    int modelLatency = 0;
+
+    std::unique_ptr<Fft> fft;
+    std::vector<float> spectra; // [channel][ear][partition][re | im]
+
+    // Time domain: the current input block, and both ears' output of the last one
+    std::vector<float> inputBlock; // [channel][P]
+    int inputFill = 0;
+    std::vector<float> output[2]; // [P] per ear
+
+    // The rotated field's last two blocks, and its frequency domain delay line
+    std::vector<float> fieldBlock; // [channel][previous P | current P]
+    std::vector<float> fdl; // [channel][partition][re | im]
+    int fdlPosition = 0;
+    std::vector<float> accumulator; // [ear][re | im]
+    std::vector<float> timeBlock; // [2P]
+
+    // Head tracking. The rotation is evaluated at the end of every block.
+    HeadOrientation headOrientation_start, headOrientation_current, headOrientation_target;
+    HeadOrientation rotationOrientation; // rotation_target is for this one
+    std::vector<float> rotation_current, rotation_target; // [channel][channel]
+
+    // Room echo of the omnidirectional channel
+    std::vector<float> echoLine;
+    int echoMask = 0;
+    int echoWritePointer = 0;
+    int echoDelay_floor = 0;
+    float echoDelay_frac = 0;
+    float echoGain = 0;
+
+    FdnReverb reverb;
+    std::vector<float> reverbSend;
+
+    // Level
+    float gVolume_param = 0.0f;
+    ParameterSmoother volume_smoothed;
+    double gSmoothingTime = 0.05; // [s]
+    double gSampleRate = 44100.0;
+    bool started = false; // jump to the parameters on the first block after prepare() / reset()
+};
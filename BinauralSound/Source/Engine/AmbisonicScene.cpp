@@ -0,0 +1,258 @@
+/*
+  ==============================================================================
+
+    AmbisonicScene.cpp
+
+  ==============================================================================
+*/
+
+#include "AmbisonicScene.h"
+
+#include <algorithm>
+#include <cmath>
+
+//==============================================================================
+void AmbisonicScene::prepare (double sampleRate, int maxBlock, int numSourcesToUse, float maxDistance)
+{
+    gMaxBlock = maxBlock;
+    numSources = numSourcesToUse;
+    gMaxDistance = std::max (maxDistance, DistanceModel::referenceDistance);
+
+    gAzimuth_param.assign(numSources, 0.0f);
+    gElevation_param.assign(numSources, 0.0f);
+    gVolume_param.assign(numSources, 0.0f);
+    gDistance_param.assign(numSources, DistanceModel::referenceDistance);
+
+    // Straight ahead, where every source starts
+    azimuth_encoded.assign(numSources, 0.0f);
+    elevation_encoded.assign(numSources, 0.0f);
+    x.assign(numSources, 1.0f);
+    y.assign(numSources, 0.0f);
+    z.assign(numSources, 0.0f);
+
+    gain_target.assign(numSources, 1.0f);
+
+    for (int channel = 0; channel < Ambisonics::numChannels; ++channel)
+    {
+        encoder[channel].assign(numSources, 0.0f);
+        encoder_target[channel].assign(numSources, 0.0f);
+    }
+
+    bus.assign(static_cast<size_t> (Ambisonics::numChannels) * kControlBlockSize, 0.0f);
+
+    // The virtual speakers, fixed around the head
+    const auto& layout = Ambisonics::getVirtualSpeakers();
+
+    decoder.prepare(sampleRate, maxBlock, Ambisonics::numVirtualSpeakers);
+
+    for (int k = 0; k < Ambisonics::numVirtualSpeakers; ++k)
+    {
+        float azimuth, elevation;
+        Ambisonics::toInterauralPolar(layout[k].x, layout[k].y, layout[k].z, azimuth, elevation);
+        decoder.setSourcePosition(k, azimuth, elevation);
+    }
+
+    speakers.assign(static_cast<size_t> (Ambisonics::numVirtualSpeakers) * maxBlock, 0.0f);
+    speakers.shrink_to_fit();
+
+    for (int k = 0; k < Ambisonics::numVirtualSpeakers; ++k)
+        speakerPointers[k] = speakers.data() + static_cast<size_t> (k) * maxBlock;
+
+    updateDecoder({});
+    decoderGains = decoderGains_target;
+
+    reset();
+}
+
+void AmbisonicScene::reset()
+{
+    decoder.reset();
+    coefficientsValid = false;
+}
+
+//==============================================================================
+void AmbisonicScene::setSourcePosition (int source, float azimuth, float elevation)
+{
+    gAzimuth_param[source] = azimuth;
+    gElevation_param[source] = elevation;
+}
+
+void AmbisonicScene::setSourceGain (int source, float dB)
+{
+    gVolume_param[source] = dB;
+}
+
+void AmbisonicScene::setSourceDistance (int source, float metres)
+{
+    gDistance_param[source] = metres;
+}
+
+size_t AmbisonicScene::getMemoryFootprint() const
+{
+    size_t floats = gAzimuth_param.capacity() + gElevation_param.capacity() + gVolume_param.capacity() + gDistance_param.capacity()
+                  + azimuth_encoded.capacity() + elevation_encoded.capacity() + x.capacity() + y.capacity() + z.capacity()
+                  + gain_target.capacity() + bus.capacity() + speakers.capacity();
+
+    for (int channel = 0; channel < Ambisonics::numChannels; ++channel)
+        floats += encoder[channel].capacity() + encoder_target[channel].capacity();
+
+    return sizeof (*this) + floats * sizeof (float) + decoder.getMemoryFootprint() - sizeof (decoder);
+}
+
+//==============================================================================
+void AmbisonicScene::updateEncoders()
+{
+    for (int s = 0; s < numSources; ++s)
+    {
+        const float distance = DistanceModel::clampDistance(gDistance_param[s], gMaxDistance);
+        gain_target[s] = std::pow(10.0f,(gVolume_param[s]/20)) * DistanceModel::distanceGain(distance);
+
+        // The only trigonometry per source, so only when it moved
+        if (gAzimuth_param[s] != azimuth_encoded[s] || gElevation_param[s] != elevation_encoded[s])
+        {
+            Ambisonics::toCartesian(gAzimuth_param[s], gElevation_param[s], x[s], y[s], z[s]);
+            azimuth_encoded[s] = gAzimuth_param[s];
+            elevation_encoded[s] = gElevation_param[s];
+        }
+    }
+
+    std::array<float*, Ambisonics::numChannels> harmonics;
+    for (int channel = 0; channel < Ambisonics::numChannels; ++channel)
+        harmonics[channel] = encoder_target[channel].data();
+
+    Ambisonics::evaluate(x.data(), y.data(), z.data(), harmonics.data(), numSources);
+
+    for (auto& gains : encoder_target)
+        for (int s = 0; s < numSources; ++s)
+            gains[s] *= gain_target[s];
+
+    if (! coefficientsValid)
+    {
+        encoder = encoder_target;
+        decoderGains = decoderGains_target;
+        coefficientsValid = true;
+    }
+}
+
+void AmbisonicScene::updateDecoder (const HeadOrientation& head)
+{
+    decoderOrientation = head;
+
+    const auto m = head.getHeadRelativeMatrix();
+    const auto& layout = Ambisonics::getVirtualSpeakers();
+
+    for (int k = 0; k < Ambisonics::numVirtualSpeakers; ++k)
+    {
+        // The direction in the room a speaker plays: its place around the
+        // head, turned back by the inverse (transposed) head rotation
+        const auto& speaker = layout[k];
+        const float roomX = m[0][0]*speaker.x + m[1][0]*speaker.y + m[2][0]*speaker.z;
+        const float roomY = m[0][1]*speaker.x + m[1][1]*speaker.y + m[2][1]*speaker.z;
+        const float roomZ = m[0][2]*speaker.x + m[1][2]*speaker.y + m[2][2]*speaker.z;
+
+        Ambisonics::getDecoderGains(speaker, roomX, roomY, roomZ, decoderGains_target[k].data());
+    }
+}
+
+//==============================================================================
+void AmbisonicScene::encode (const float* const* inputs, int start, int numSamples)
+{
+    std::fill (bus.begin(), bus.end(), 0.0f);
+
+    const float ramp = 1.0f / numSamples;
+    numRenderedSources = 0;
+
+    for (int s = 0; s < numSources; ++s)
+    {
+        // The omni channel is the source's gain
+        const bool isAudible = std::abs (encoder[0][s]) >= DistanceModel::inaudibleGain
+                            || std::abs (encoder_target[0][s]) >= DistanceModel::inaudibleGain;
+
+        if (isAudible)
+        {
+            const float* in = inputs[s] + start;
+
+            for (int channel = 0; channel < Ambisonics::numChannels; ++channel)
+            {
+                float* out = bus.data() + channel * kControlBlockSize;
+                const float g = encoder[channel][s];
+                const float dg = (encoder_target[channel][s] - g) * ramp;
+
+                if (dg == 0)
+                {
+                    for (int i = 0; i < numSamples; ++i)
+                        out[i] += g * in[i];
+                }
+                else
+                {
+                    for (int i = 0; i < numSamples; ++i)
+                        out[i] += (g + dg * (i + 1)) * in[i];
+                }
+            }
+
+            ++numRenderedSources;
+        }
+
+        for (int channel = 0; channel < Ambisonics::numChannels; ++channel)
+            encoder[channel][s] = encoder_target[channel][s];
+    }
+}
+
+void AmbisonicScene::decode (int start, int numSamples)
+{
+    const float ramp = 1.0f / numSamples;
+
+    for (int k = 0; k < Ambisonics::numVirtualSpeakers; ++k)
+    {
+        float* out = speakers.data() + static_cast<size_t> (k) * gMaxBlock + start;
+        std::fill (out, out + numSamples, 0.0f);
+
+        for (int channel = 0; channel < Ambisonics::numChannels; ++channel)
+        {
+            const float* in = bus.data() + channel * kControlBlockSize;
+            const float g = decoderGains[k][channel];
+            const float dg = (decoderGains_target[k][channel] - g) * ramp;
+
+            if (dg == 0)
+            {
+                for (int i = 0; i < numSamples; ++i)
+                    out[i] += g * in[i];
+            }
+            else
+            {
+                for (int i = 0; i < numSamples; ++i)
+                    out[i] += (g + dg * (i + 1)) * in[i];
+            }
+        }
+    }
+
+    decoderGains = decoderGains_target;
+}
+
+//==============================================================================
+void AmbisonicScene::process (const float* const* inputs, float* outputL, float* outputR, int n)
+{
+    // Start from the new orientation after prepare() / reset(), like the gains
+    const HeadOrientation headOrientation_start = coefficientsValid ? headOrientation_current : headOrientation_target;
+
+    for (int start = 0; start < n; start += kControlBlockSize)
+    {
+        const int numSamples = std::min (kControlBlockSize, n - start);
+
+        // Rotating the field is a new decoder, so only when the head moved
+        const float t = static_cast<float> (start + numSamples) / n;
+        const auto head = HeadOrientation::interpolate(headOrientation_start, headOrientation_target, t);
+
+        if (head.yaw != decoderOrientation.yaw || head.pitch != decoderOrientation.pitch || head.roll != decoderOrientation.roll)
+            updateDecoder(head);
+
+        updateEncoders();
+        encode(inputs, start, numSamples);
+        decode(start, numSamples);
+    }
+
+    headOrientation_current = headOrientation_target;
+
+    // One Brown-Duda chain per speaker, whatever the number of sources
+    decoder.process(speakerPointers.data(), outputL, outputR, n);
+}
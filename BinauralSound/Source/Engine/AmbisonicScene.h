@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    AmbisonicScene.h
+
+    Renders N mono sources like BinauralScene, but through a third order
+    ambisonic bus: every source is encoded into the bus with one gain per
+    channel, and the bus is decoded once per block to 26 virtual
+    loudspeakers around the head, which are rendered through the
+    Brown-Duda chain by a BinauralScene (see Ambisonics.h).
+
+    A source then costs 16 multiply-adds per sample instead of the whole
+    chain, so large scenes get cheaper, but the decoder costs as much as
+    a few dozen sources whatever is playing, and the spatial resolution is
+    that of third order: a source is spread over neighbouring speakers
+    rather than rendered at its exact position.
+    ambisonic_benchmark measures where the two cross over.
+
+    Head tracking rotates the whole sound field by rotating the decoder,
+    which costs nothing per source. The source distance only sets its 1/r
+    gain; the propagation delay and air absorption would need a delay line
+    per source, which is what the bus avoids. The late reverb is fed by
+    the speakers' room echo, and there are no early reflections.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "Ambisonics.h"
+#include "BinauralScene.h"
+#include "DistanceModel.h"
+#include "HeadOrientation.h"
+
+//==============================================================================
+/**
+*/
+class AmbisonicScene
+{
+public:
+    //==============================================================================
+    AmbisonicScene() = default;
+
+    //==============================================================================
+    /** Allocates the bus and the state of numSources sources. Must be called
+        before process(), and never from the audio thread. Distances are
+        clamped to maxDistance.
+    */
+    void prepare (double sampleRate, int maxBlock, int numSources,
+                  float maxDistance = DistanceModel::referenceDistance);
+
+    /** Clears the decoder's delay lines and filter states. */
+    void reset();
+
+    /** Renders n samples of every source and sums them into outL / outR.
+        inputs must hold getNumSources() mono buffers of at least n samples.
+        The outputs are overwritten and must not alias any of the inputs.
+    */
+    void process (const float* const* inputs, float* outL, float* outR, int n);
+
+    //==============================================================================
+    int getNumSources() const           { return numSources; }
+
+    void setSourcePosition (int source, float azimuth, float elevation);
+    void setSourceGain (int source, float dB);
+
+    /** Distance in metres, clamped to [1, maxDistance]. Only sets the 1/r gain. */
+    void setSourceDistance (int source, float metres);
+
+    float getSourceAzimuth (int source) const       { return gAzimuth_param[source]; }
+    float getSourceElevation (int source) const     { return gElevation_param[source]; }
+    float getSourceGain (int source) const          { return gVolume_param[source]; }
+    float getSourceDistance (int source) const      { return gDistance_param[source]; }
+
+    /** Sources encoded in the last control block; the others were below
+        DistanceModel::inaudibleGain and skipped.
+    */
+    int getNumRenderedSources() const               { return numRenderedSources; }
+
+    /** Listener head orientation. The sound field is counter-rotated by it,
+        moving from the previous orientation to this one over the next
+        process() call, like BinauralEngine::setHeadOrientation().
+    */
+    void setHeadOrientation (const HeadOrientation& orientation)    { headOrientation_target = orientation; }
+    const HeadOrientation& getHeadOrientation() const               { return headOrientation_target; }
+
+    /** Late reverb, fed by the room echo of the virtual speakers. */
+    void setReverbSize (float size)                 { decoder.setReverbSize(size); } // 0 to 1
+    void setReverbDecayTime (float seconds)         { decoder.setReverbDecayTime(seconds); }
+    void setReverbWet (float wet)                   { decoder.setReverbWet(wet); } // linear gain
+
+    float getReverbSize() const                     { return decoder.getReverbSize(); }
+    float getReverbDecayTime() const                { return decoder.getReverbDecayTime(); }
+    float getReverbWet() const                      { return decoder.getReverbWet(); }
+
+    /** Kernel of the virtual speakers' BinauralScene. */
+    void setSimdLevel (SceneKernels::SimdLevel level)   { decoder.setSimdLevel(level); }
+    SceneKernels::SimdLevel getSimdLevel() const        { return decoder.getSimdLevel(); }
+
+    double getSampleRate() const        { return decoder.getSampleRate(); }
+    int getMaximumBlockSize() const     { return gMaxBlock; }
+
+    /** Bytes used by this scene, including the bus and the decoder but not
+        the shared CoefficientTable.
+    */
+    size_t getMemoryFootprint() const;
+
+    //==============================================================================
+    /** Samples between two updates of the encoding and decoding gains, the
+        same as in BinauralScene. Gains are ramped linearly across it.
+    */
+    static constexpr int kControlBlockSize = BinauralScene::kControlBlockSize;
+
+private:
+    //==============================================================================
+    void updateEncoders();
+    void updateDecoder (const HeadOrientation& head);
+
+    void encode (const float* const* inputs, int start, int numSamples);
+    void decode (int start, int numSamples);
+
+    //==============================================================================
+    // AUDIO PARAMS
+    int numSources = 0;
+
+    std::vector<float> gAzimuth_param;
+    std::vector<float> gElevation_param;
+    std::vector<float> gVolume_param;
+    std::vector<float> gDistance_param;
+
+    float gMaxDistance = DistanceModel::referenceDistance;
+    int gMaxBlock = 0;
+
+    HeadOrientation headOrientation_current, headOrientation_target;
+
+
+    //==============================================================================
+    // ENCODER
+    // Per source: its direction, recomputed only when it moves, and its
+    // gain into every channel, [channel][source]. Current gains are where
+    // the last ramp ended, targets are set at the start of every control
+    // block.
+    std::vector<float> azimuth_encoded, elevation_encoded; // angles x, y, z were computed for
+    std::vector<float> x, y, z;
+    std::vector<float> gain_target;
+    std::array<std::vector<float>, Ambisonics::numChannels> encoder, encoder_target;
+    bool coefficientsValid = false; // jump straight to the targets after prepare() / reset()
+
+    int numRenderedSources = 0;
+
+    std::vector<float> bus; // [channel][kControlBlockSize]
+
+
+    //==============================================================================
+    // DECODER
+    // Gains from the bus to every virtual speaker, for the head orientation
+    // at the end of the last control block, and the speaker signals of the
+    // whole block, which the BinauralScene renders.
+    std::array<std::array<float, Ambisonics::numChannels>, Ambisonics::numVirtualSpeakers> decoderGains, decoderGains_target;
+    HeadOrientation decoderOrientation; // decoderGains_target is for this one
+
+    std::vector<float> speakers; // [speaker][maxBlock]
+    std::array<const float*, Ambisonics::numVirtualSpeakers> speakerPointers;
+
+    BinauralScene decoder;
+};
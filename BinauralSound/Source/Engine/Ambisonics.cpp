@@ -0,0 +1,230 @@
+/*
+  ==============================================================================
+
+    Ambisonics.cpp
+
+  ==============================================================================
+*/
+
+#include "Ambisonics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr float float_Pi = 3.14159265358979323846f;
+    constexpr float toRadians = float_Pi/180;
+    constexpr float toDegrees = 180/float_Pi;
+
+    // SN3D normalisation factors of the second and third order
+    const float sqrt3 = std::sqrt(3.0f);
+    const float sqrt15 = std::sqrt(15.0f);
+    const float sqrt5_8 = std::sqrt(5.0f/8);
+    const float sqrt3_8 = std::sqrt(3.0f/8);
+
+    /** Max-rE weights of a decoder of some order, P_n (cos (137.9 deg / (order + 1.51)))
+        for each order n up to it and 0 above.
+    */
+    std::array<float, Ambisonics::order + 1> makeMaxReWeights (int decoderOrder)
+    {
+        const float c = std::cos(137.9f * toRadians / (decoderOrder + 1.51f));
+        const std::array<float, Ambisonics::order + 1> weights { 1.0f, c, (3*c*c - 1)/2, (5*c*c*c - 3*c)/2 };
+
+        std::array<float, Ambisonics::order + 1> result {};
+        std::copy (weights.begin(), weights.begin() + decoderOrder + 1, result.begin());
+        return result;
+    }
+
+    std::array<Ambisonics::VirtualSpeaker, Ambisonics::numVirtualSpeakers> makeLebedevGrid()
+    {
+        std::array<Ambisonics::VirtualSpeaker, Ambisonics::numVirtualSpeakers> grid;
+        int i = 0;
+
+        // Octahedron vertices
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            for (float sign : { 1.0f, -1.0f })
+            {
+                float p[3] = { 0, 0, 0 };
+                p[axis] = sign;
+                grid[i++] = { p[0], p[1], p[2], 1.0f/21 };
+            }
+        }
+
+        // Edge midpoints
+        const float a = 1/std::sqrt(2.0f);
+
+        for (int zeroAxis = 0; zeroAxis < 3; ++zeroAxis)
+        {
+            for (float s1 : { a, -a })
+            {
+                for (float s2 : { a, -a })
+                {
+                    float p[3];
+                    p[zeroAxis] = 0;
+                    p[(zeroAxis + 1) % 3] = s1;
+                    p[(zeroAxis + 2) % 3] = s2;
+                    grid[i++] = { p[0], p[1], p[2], 4.0f/105 };
+                }
+            }
+        }
+
+        // Cube vertices
+        const float b = 1/std::sqrt(3.0f);
+
+        for (float sx : { b, -b })
+            for (float sy : { b, -b })
+                for (float sz : { b, -b })
+                    grid[i++] = { sx, sy, sz, 9.0f/280 };
+
+        return grid;
+    }
+}
+
+//==============================================================================
+void Ambisonics::toCartesian (float azimuth, float elevation, float& x, float& y, float& z)
+{
+    const float theta = azimuth * toRadians;
+    const float phi = elevation * toRadians;
+
+    x = std::cos(theta) * std::cos(phi);
+    y = -std::sin(theta);
+    z = std::cos(theta) * std::sin(phi);
+}
+
+void Ambisonics::toInterauralPolar (float x, float y, float z, float& azimuth, float& elevation)
+{
+    azimuth = std::asin(std::clamp(-y, -1.0f, 1.0f)) * toDegrees;
+    elevation = std::atan2(z, x) * toDegrees;
+}
+
+//==============================================================================
+void Ambisonics::evaluate (float x, float y, float z, float* h)
+{
+    float* out[numChannels];
+    for (int c = 0; c < numChannels; ++c)
+        out[c] = h + c;
+
+    evaluate(&x, &y, &z, out, 1);
+}
+
+void Ambisonics::evaluate (const float* x, const float* y, const float* z, float* const* h, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        const float xx = x[i]*x[i], yy = y[i]*y[i], zz = z[i]*z[i];
+
+        h[0][i] = 1.0f;
+
+        h[1][i] = y[i];
+        h[2][i] = z[i];
+        h[3][i] = x[i];
+
+        h[4][i] = sqrt3 * x[i]*y[i];
+        h[5][i] = sqrt3 * y[i]*z[i];
+        h[6][i] = (3*zz - 1) / 2;
+        h[7][i] = sqrt3 * x[i]*z[i];
+        h[8][i] = sqrt3 / 2 * (xx - yy);
+
+        h[9][i] = sqrt5_8 * y[i] * (3*xx - yy);
+        h[10][i] = sqrt15 * x[i]*y[i]*z[i];
+        h[11][i] = sqrt3_8 * y[i] * (5*zz - 1);
+        h[12][i] = z[i] * (5*zz - 3) / 2;
+        h[13][i] = sqrt3_8 * x[i] * (5*zz - 1);
+        h[14][i] = sqrt15 / 2 * z[i] * (xx - yy);
+        h[15][i] = sqrt5_8 * x[i] * (xx - 3*yy);
+    }
+}
+
+//==============================================================================
+const std::array<Ambisonics::VirtualSpeaker, Ambisonics::numVirtualSpeakers>& Ambisonics::getVirtualSpeakers()
+{
+    static const auto grid = makeLebedevGrid();
+    return grid;
+}
+
+namespace
+{
+    /** Gains of a speaker in sampling the field at (x, y, z): with SN3D the
+        harmonics of order n integrate to 1 / (2n + 1) over the sphere, which
+        the weights undo. A source's speaker gains then sum to 1.
+    */
+    void getSamplingGains (const Ambisonics::VirtualSpeaker& speaker, float x, float y, float z, float* gains, int decoderOrder)
+    {
+        static const std::array<std::array<float, Ambisonics::order + 1>, Ambisonics::order + 1> maxRe
+            { makeMaxReWeights(0), makeMaxReWeights(1), makeMaxReWeights(2), makeMaxReWeights(3) };
+
+        float harmonics[Ambisonics::numChannels];
+        Ambisonics::evaluate(x, y, z, harmonics);
+
+        for (int c = 0; c < Ambisonics::getNumChannels(decoderOrder); ++c)
+        {
+            const int n = Ambisonics::channelOrder(c);
+            gains[c] = harmonics[c] * speaker.weight * (2*n + 1) * maxRe[decoderOrder][n];
+        }
+    }
+
+    /** The speakers are heard through different ITDs, so above a few hundred
+        Hz they add up in power rather than in amplitude, which would leave
+        the sum about 6 dB down. Scales their power, averaged over all source
+        directions, to 1 instead; it varies by less than 0.5 dB between them.
+    */
+    float makeDiffuseFieldScale (int decoderOrder)
+    {
+        double power = 0;
+
+        for (auto& speaker : Ambisonics::getVirtualSpeakers())
+        {
+            float gains[Ambisonics::numChannels];
+            getSamplingGains(speaker, speaker.x, speaker.y, speaker.z, gains, decoderOrder);
+
+            for (int c = 0; c < Ambisonics::getNumChannels(decoderOrder); ++c)
+                power += gains[c] * gains[c] / (2 * Ambisonics::channelOrder(c) + 1);
+        }
+
+        return static_cast<float> (1 / std::sqrt(power));
+    }
+}
+
+void Ambisonics::getDecoderGains (const VirtualSpeaker& speaker, float x, float y, float z, float* gains, int decoderOrder)
+{
+    static const std::array<float, order + 1> scales
+        { makeDiffuseFieldScale(0), makeDiffuseFieldScale(1), makeDiffuseFieldScale(2), makeDiffuseFieldScale(3) };
+
+    getSamplingGains(speaker, x, y, z, gains, decoderOrder);
+
+    for (int c = 0; c < getNumChannels(decoderOrder); ++c)
+        gains[c] *= scales[decoderOrder];
+}
+
+//==============================================================================
+void Ambisonics::getRotation (const HeadOrientation::Matrix& m, int fieldOrder, float* rotation)
+{
+    const int size = getNumChannels(fieldOrder);
+    std::fill (rotation, rotation + size * size, 0.0f);
+
+    // Projects the rotated harmonics back onto the harmonics, with the
+    // Lebedev grid as quadrature. The products are of degree 6 at most, which
+    // it integrates exactly, so this is the exact rotation.
+    for (auto& speaker : getVirtualSpeakers())
+    {
+        const float roomX = m[0][0]*speaker.x + m[1][0]*speaker.y + m[2][0]*speaker.z;
+        const float roomY = m[0][1]*speaker.x + m[1][1]*speaker.y + m[2][1]*speaker.z;
+        const float roomZ = m[0][2]*speaker.x + m[1][2]*speaker.y + m[2][2]*speaker.z;
+
+        float head[numChannels], room[numChannels];
+        evaluate(speaker.x, speaker.y, speaker.z, head);
+        evaluate(roomX, roomY, roomZ, room);
+
+        for (int row = 0; row < size; ++row)
+        {
+            const int n = channelOrder(row);
+            const float weight = speaker.weight * (2*n + 1) * head[row];
+
+            // Rotations never mix orders
+            for (int column = n*n; column < (n + 1)*(n + 1); ++column)
+                rotation[row * size + column] += weight * room[column];
+        }
+    }
+}
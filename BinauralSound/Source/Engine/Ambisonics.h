@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    Ambisonics.h
+
+    Third order ambisonics: the spherical harmonics a source is encoded
+    with, and the virtual loudspeakers the sound field is decoded to.
+
+    Channels are in ACN order with SN3D normalisation (AmbiX), in the
+    coordinates HeadOrientation uses: x to the front, y to the left, z up.
+    The harmonics are evaluated as polynomials of the unit direction, so
+    encoding needs no trigonometry.
+
+    The decoder samples the field at the 26 points of a Lebedev grid, which
+    integrates every product of two third order harmonics exactly, so a
+    source keeps its level wherever it is. Each order is weighted for
+    maximum energy vector (max-rE), which narrows the spread of a source
+    over the loudspeakers, and the gains are scaled so that the speakers'
+    power adds up to the source's (diffuse-field normalisation).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+
+#include "HeadOrientation.h"
+
+//==============================================================================
+namespace Ambisonics
+{
+    //==============================================================================
+    constexpr int order = 3;
+    constexpr int numChannels = (order + 1) * (order + 1);
+
+    /** Channels of a field up to some order. */
+    constexpr int getNumChannels (int fieldOrder)   { return (fieldOrder + 1) * (fieldOrder + 1); }
+
+    /** Order of an ACN channel. */
+    constexpr int channelOrder (int channel)
+    {
+        return channel < 1 ? 0 : channel < 4 ? 1 : channel < 9 ? 2 : 3;
+    }
+
+    /** Unit vector of a direction in the model's interaural-polar angles
+        (see HeadOrientation.h), and back.
+    */
+    void toCartesian (float azimuth, float elevation, float& x, float& y, float& z);
+    void toInterauralPolar (float x, float y, float z, float& azimuth, float& elevation);
+
+    /** The numChannels harmonics of a unit vector, the gains a source from
+        that direction is encoded with.
+    */
+    void evaluate (float x, float y, float z, float* harmonics);
+
+    /** The same for n unit vectors at once, into harmonics[channel][i].
+        Loops over the sources innermost, so it vectorises.
+    */
+    void evaluate (const float* x, const float* y, const float* z, float* const* harmonics, int n);
+
+    //==============================================================================
+    struct VirtualSpeaker
+    {
+        float x, y, z;
+        float weight; // quadrature weight, all of them sum to 1
+    };
+
+    constexpr int numVirtualSpeakers = 26;
+
+    const std::array<VirtualSpeaker, numVirtualSpeakers>& getVirtualSpeakers();
+
+    /** Decoding gains of one speaker: speaker = sum of gains[c] * channel c.
+        (x, y, z) is where the speaker is in the sound field, which differs
+        from its place around the head when the field is rotated. A decoder
+        for a field of a lower order only fills its getNumChannels (decoderOrder)
+        gains, with the weights of that order.
+    */
+    void getDecoderGains (const VirtualSpeaker& speaker, float x, float y, float z, float* gains,
+                          int decoderOrder = order);
+
+    //==============================================================================
+    /** The matrix that turns a field recorded in the room into the field
+        around the listener's head, given HeadOrientation::getHeadRelativeMatrix():
+        rotated channel i = sum of rotation[i * size + j] * channel j, with
+        size = getNumChannels (fieldOrder). Only channels of the same order
+        mix, the others are 0.
+    */
+    void getRotation (const HeadOrientation::Matrix& headRelative, int fieldOrder, float* rotation);
+}
@@ -0,0 +1,376 @@
+/*
+  ==============================================================================
+
+    BedVirtualiser.cpp
+
+  ==============================================================================
+*/
+
+#include "BedVirtualiser.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Ambisonics.h"
+#include "BrownDudaModel.h"
+
+namespace
+{
+    constexpr double pi = 3.14159265358979323846;
+
+    int nextPowerOfTwo (int n)
+    {
+        int size = 1;
+        while (size < n)
+            size *= 2;
+        return size;
+    }
+
+    /** Adds weight at a delay to a response, growing it as needed. */
+    void addTap (std::vector<double>& response, int delay, double weight)
+    {
+        if (delay >= static_cast<int> (response.size()))
+            response.resize(delay + 1, 0.0);
+
+        response[delay] += weight;
+    }
+}
+
+//==============================================================================
+std::vector<BedVirtualiser::Channel> BedVirtualiser::getLayoutChannels (Layout layout)
+{
+    switch (layout)
+    {
+        case Layout::surround51:
+            return { Channel::left, Channel::right, Channel::centre, Channel::lfe,
+                     Channel::leftSurround, Channel::rightSurround };
+
+        case Layout::surround71:
+            return { Channel::left, Channel::right, Channel::centre, Channel::lfe,
+                     Channel::leftSurroundSide, Channel::rightSurroundSide, Channel::leftSurroundRear, Channel::rightSurroundRear };
+
+        case Layout::surround714:
+            return { Channel::left, Channel::right, Channel::centre, Channel::lfe,
+                     Channel::leftSurroundSide, Channel::rightSurroundSide, Channel::leftSurroundRear, Channel::rightSurroundRear,
+                     Channel::topFrontLeft, Channel::topFrontRight, Channel::topRearLeft, Channel::topRearRight };
+    }
+
+    return {};
+}
+
+BedVirtualiser::Speaker BedVirtualiser::getSpeaker (Channel channel, bool layoutHasRears)
+{
+    // 5.1 has its surrounds behind the listener, 7.1 has side and rear pairs
+    const float surround = layoutHasRears ? 90.0f : 110.0f;
+
+    switch (channel)
+    {
+        case Channel::left:                 return { 30, 0 };
+        case Channel::right:                return { -30, 0 };
+        case Channel::centre:               return { 0, 0 };
+        case Channel::lfe:                  return { 0, 0, true };
+        case Channel::leftSurround:         return { surround, 0 };
+        case Channel::rightSurround:        return { -surround, 0 };
+        case Channel::leftSurroundSide:     return { 90, 0 };
+        case Channel::rightSurroundSide:    return { -90, 0 };
+        case Channel::leftSurroundRear:     return { 135, 0 };
+        case Channel::rightSurroundRear:    return { -135, 0 };
+        case Channel::topFrontLeft:         return { 45, 45 };
+        case Channel::topFrontRight:        return { -45, 45 };
+        case Channel::topRearLeft:          return { 135, 45 };
+        case Channel::topRearRight:         return { -135, 45 };
+    }
+
+    return {};
+}
+
+std::vector<BedVirtualiser::Speaker> BedVirtualiser::getLayoutSpeakers (Layout layout)
+{
+    const bool hasRears = layout != Layout::surround51;
+    std::vector<Speaker> speakers;
+
+    for (auto channel : getLayoutChannels(layout))
+        speakers.push_back(getSpeaker(channel, hasRears));
+
+    return speakers;
+}
+
+const char* BedVirtualiser::getName (Layout layout)
+{
+    switch (layout)
+    {
+        case Layout::surround51:    return "5.1";
+        case Layout::surround71:    return "7.1";
+        case Layout::surround714:   return "7.1.4";
+    }
+
+    return "";
+}
+
+//==============================================================================
+void BedVirtualiser::prepare (double sampleRate, int maxBlock, std::vector<Speaker> speakersToUse)
+{
+    gSampleRate = sampleRate;
+    speakers = std::move (speakersToUse);
+    modelLatency = BrownDudaModel::initialLatency(static_cast<float> (sampleRate));
+    a1_head_shadow = BrownDudaModel::headShadowPole(static_cast<float> (sampleRate));
+
+    computeFilters();
+
+    historySize = maxDelay + maxBlock;
+    history.assign(static_cast<size_t> (getNumChannels()) * historySize, 0.0f);
+
+    for (auto& ear : accumulator)
+        ear.assign(maxBlock, 0.0f);
+
+    // The model reads its room echo tau_Ke behind its initial latency. The
+    // whole block is written before it is read, so the line holds one more.
+    const float echoDelay = BrownDudaModel::tau_Ke * static_cast<float> (sampleRate);
+    echoDelay_floor = modelLatency + static_cast<int> (std::floor(echoDelay));
+    echoDelay_frac = echoDelay - std::floor(echoDelay);
+    echoGain = BrownDudaModel::roomEchoGain();
+
+    echoLine.assign(nextPowerOfTwo(echoDelay_floor + 2 + maxBlock), 0.0f);
+    echoMask = static_cast<int> (echoLine.size()) - 1;
+
+    reverb.prepare(sampleRate);
+    reverbSend.assign(maxBlock, 0.0f);
+
+    setSmoothingTime(gSmoothingTime);
+
+    reset();
+}
+
+void BedVirtualiser::computeFilters()
+{
+    const float sampleRate = static_cast<float> (gSampleRate);
+    const int numChannels = getNumChannels();
+
+    // BinauralEngine reads the ITD modelLatency behind the input, and the
+    // pinna taps as far again behind the head shadow filter's output
+    const int base = 2 * modelLatency;
+
+    std::vector<std::vector<double>> responses (2 * numChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto& speaker = speakers[channel];
+
+        if (speaker.lfe)
+        {
+            // A plain delay to where the direct sound is, with the zero that
+            // cancels the head shadow feedback applied after the sum
+            for (int ear = 0; ear < 2; ++ear)
+            {
+                addTap(responses[channel * 2 + ear], base, 1.0);
+                addTap(responses[channel * 2 + ear], base + 1, a1_head_shadow);
+            }
+
+            continue;
+        }
+
+        // The model's interaural-polar angles of the speaker
+        const double azimuth_rad = speaker.azimuth * pi / 180;
+        const double elevation_rad = speaker.elevation * pi / 180;
+
+        float azimuth, elevation;
+        Ambisonics::toInterauralPolar(static_cast<float> (std::cos(elevation_rad) * std::cos(azimuth_rad)),
+                                      static_cast<float> (std::cos(elevation_rad) * std::sin(azimuth_rad)),
+                                      static_cast<float> (std::sin(elevation_rad)), azimuth, elevation);
+
+        for (int ear = 0; ear < 2; ++ear)
+        {
+            const auto coeffs = BrownDudaModel::computeEarCoefficients(azimuth, elevation, ear, sampleRate);
+            auto& response = responses[channel * 2 + ear];
+
+            // The ITD read, linearly interpolated, through the head shadow
+            // filter's feed forward taps b0 + b1 z^-1
+            const float itd_floor = std::floor(coeffs.delSamples);
+            const double itd_frac = coeffs.delSamples - itd_floor;
+            const double direct[3] = { (1 - itd_frac) * coeffs.b0,
+                                       itd_frac * coeffs.b0 + (1 - itd_frac) * coeffs.b1,
+                                       itd_frac * coeffs.b1 };
+
+            // Then every pinna tap, linearly interpolated as well
+            for (int iEvent = 0; iEvent < BrownDudaModel::numPinnaEvents; iEvent++)
+            {
+                const float tau_floor = std::floor(coeffs.tau[iEvent]);
+                const double tau_frac = coeffs.tau[iEvent] - tau_floor;
+                const double rho = BrownDudaModel::rho_k[iEvent];
+
+                for (int i = 0; i < 3; ++i)
+                {
+                    const int delay = base + static_cast<int> (itd_floor) + static_cast<int> (tau_floor) + i;
+
+                    addTap(response, delay, rho * (1 - tau_frac) * direct[i]);
+                    addTap(response, delay + 1, rho * tau_frac * direct[i]);
+                }
+            }
+        }
+    }
+
+    // Trim every response to its taps, and give them all the longest one's length
+    std::vector<int> first (2 * numChannels), last (2 * numChannels);
+    filterLength = 1;
+
+    for (int filter = 0; filter < 2 * numChannels; ++filter)
+    {
+        const auto& response = responses[filter];
+
+        first[filter] = static_cast<int> (response.size()) - 1;
+        last[filter] = 0;
+
+        for (int i = 0; i < static_cast<int> (response.size()); ++i)
+        {
+            if (response[i] != 0)
+            {
+                first[filter] = std::min (first[filter], i);
+                last[filter] = i;
+            }
+        }
+
+        if (last[filter] < first[filter])
+            last[filter] = first[filter];
+
+        filterLength = std::max (filterLength, last[filter] - first[filter] + 1);
+    }
+
+    filters.assign(static_cast<size_t> (2 * numChannels) * filterLength, 0.0f);
+    filterOffsets.assign(2 * numChannels, 0);
+    maxDelay = 0;
+
+    for (int filter = 0; filter < 2 * numChannels; ++filter)
+    {
+        filterOffsets[filter] = first[filter];
+        maxDelay = std::max (maxDelay, first[filter] + filterLength - 1);
+
+        for (int i = first[filter]; i <= last[filter]; ++i)
+            filters[static_cast<size_t> (filter) * filterLength + (i - first[filter])] = static_cast<float> (responses[filter][i]);
+    }
+}
+
+void BedVirtualiser::reset()
+{
+    std::fill (history.begin(), history.end(), 0.0f);
+    std::fill (echoLine.begin(), echoLine.end(), 0.0f);
+
+    headShadow_prev[0] = 0.0f;
+    headShadow_prev[1] = 0.0f;
+    echoWritePointer = 0;
+
+    reverb.reset();
+    started = false;
+}
+
+void BedVirtualiser::setSmoothingTime (double seconds)
+{
+    gSmoothingTime = std::max (0.0, seconds);
+
+    volume_smoothed.setRampLength(static_cast<int> (std::round (gSmoothingTime * gSampleRate)));
+    reverb.setSmoothingTime(gSmoothingTime);
+}
+
+size_t BedVirtualiser::getMemoryFootprint() const
+{
+    const size_t floats = filters.capacity() + history.capacity() + accumulator[0].capacity() + accumulator[1].capacity()
+                        + echoLine.capacity() + reverbSend.capacity();
+
+    return sizeof (*this) + floats * sizeof (float) + filterOffsets.capacity() * sizeof (int)
+         + speakers.capacity() * sizeof (Speaker) + reverb.getMemoryFootprint() - sizeof (reverb);
+}
+
+//==============================================================================
+void BedVirtualiser::process (const float* const* inputs, float* outputL, float* outputR, int n)
+{
+    // Start from the parameters themselves after prepare() / reset()
+    if (! started)
+    {
+        volume_smoothed.setCurrentAndTarget(gVolume_param);
+        started = true;
+    }
+
+    const float gain_start = std::pow(10.0f, volume_smoothed.getCurrentValue() / 20);
+    const float gain_end = std::pow(10.0f, volume_smoothed.getNext(gVolume_param, n) / 20);
+    const float gain_inc = (gain_end - gain_start) / n;
+
+    // Only collect the reverb send while the reverb is on
+    float* const send = reverb.isActive() ? reverbSend.data() : nullptr;
+
+    const int numChannels = getNumChannels();
+
+    // Read every channel before writing the outputs, they may alias. The
+    // room echo takes the sum of all of them but the LFE.
+    for (int i = 0; i < n; ++i)
+        echoLine[(echoWritePointer + i) & echoMask] = 0.0f;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        float* const block = history.data() + static_cast<size_t> (channel) * historySize + maxDelay;
+        std::copy (inputs[channel], inputs[channel] + n, block);
+
+        if (! speakers[channel].lfe)
+            for (int i = 0; i < n; ++i)
+                echoLine[(echoWritePointer + i) & echoMask] += block[i];
+    }
+
+    for (int ear = 0; ear < 2; ++ear)
+    {
+        float* const sum = accumulator[ear].data();
+        std::fill (sum, sum + n, 0.0f);
+
+        // Every channel's filter, one tap at a time over the whole block
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const int filter = channel * 2 + ear;
+            const float* const h = filters.data() + static_cast<size_t> (filter) * filterLength;
+            const float* const x = history.data() + static_cast<size_t> (channel) * historySize + maxDelay - filterOffsets[filter];
+
+            for (int j = 0; j < filterLength; ++j)
+            {
+                const float h_j = h[j];
+                const float* const x_j = x - j;
+
+                for (int i = 0; i < n; ++i)
+                    sum[i] += h_j * x_j[i];
+            }
+        }
+
+        // The head shadow filter's feedback, once for all channels
+        float y = headShadow_prev[ear];
+
+        for (int i = 0; i < n; ++i)
+        {
+            y = sum[i] - a1_head_shadow * y;
+            sum[i] = y;
+        }
+
+        headShadow_prev[ear] = y;
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        // Room echo, the same for both ears
+        const int echoPointer = echoWritePointer + i - echoDelay_floor;
+        const float echo = echoGain * ((1 - echoDelay_frac) * echoLine[echoPointer & echoMask]
+                                       + echoDelay_frac * echoLine[(echoPointer - 1) & echoMask]);
+
+        const float gain = gain_start + gain_inc * (i + 1);
+
+        outputL[i] = (accumulator[0][i] + echo) * gain;
+        outputR[i] = (accumulator[1][i] + echo) * gain;
+
+        if (send != nullptr)
+            send[i] = echo * gain;
+    }
+
+    echoWritePointer = (echoWritePointer + n) & echoMask;
+
+    // Keep the last maxDelay samples of every channel for the next block
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        float* const line = history.data() + static_cast<size_t> (channel) * historySize;
+        std::copy (line + n, line + n + maxDelay, line);
+    }
+
+    reverb.process(send, outputL, outputR, n);
+}
@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+
+    BedVirtualiser.h
+
+    Binaural rendering of a channel based surround mix (5.1, 7.1, 7.1.4):
+    every speaker channel is heard through the Brown-Duda model from its
+    standard position, and the LFE channel goes to both ears unchanged.
+
+    The speakers never move, so the model is a fixed linear filter for each
+    of them, and prepare() works it out once. For every channel and ear, the
+    ITD delay, the head shadow filter's feed forward half and the 5 pinna
+    taps are folded into one short FIR of about 20 taps. The head shadow
+    pole is the same for every direction, so its feedback half is applied
+    once per ear, to the sum of all channels. The room echo does not depend
+    on direction either and is one delay of the channels' sum, which also
+    feeds the late reverb. process() is then a batched FIR over all
+    channels, which vectorises over the samples of the block, and two
+    one-pole filters. Each channel only keeps the few dozen samples its
+    filters reach back, and nothing runs at control rate. It takes about a
+    third of the time of one BinauralEngine per speaker (bed_benchmark).
+
+    The output matches that of those engines at the same positions, added
+    up, to within float rounding (90 dB or more below the signal). The
+    speakers are fixed to the head: head tracking does not apply.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "FdnReverb.h"
+#include "ParameterSmoother.h"
+
+//==============================================================================
+/**
+*/
+class BedVirtualiser
+{
+public:
+    //==============================================================================
+    /** Where a speaker is, in the usual surround convention: azimuth in
+        degrees counter-clockwise from the front (left is positive) and
+        elevation in degrees above the horizontal plane.
+    */
+    struct Speaker
+    {
+        float azimuth = 0;
+        float elevation = 0;
+        bool lfe = false; // no position: straight to both ears
+    };
+
+    enum class Layout
+    {
+        surround51,
+        surround71,
+        surround714
+    };
+
+    /** The speaker channels a bed can hold. */
+    enum class Channel
+    {
+        left,
+        right,
+        centre,
+        lfe,
+        leftSurround,
+        rightSurround,
+        leftSurroundSide,
+        rightSurroundSide,
+        leftSurroundRear,
+        rightSurroundRear,
+        topFrontLeft,
+        topFrontRight,
+        topRearLeft,
+        topRearRight
+    };
+
+    /** The channels of a standard layout in ITU / SMPTE order: L R C LFE
+        Ls Rs for 5.1, L R C LFE Lss Rss Lrs Rrs for 7.1, then Ltf Rtf Ltr
+        Rtr for 7.1.4.
+    */
+    static std::vector<Channel> getLayoutChannels (Layout layout);
+
+    /** The standard position of a channel. Angles follow ITU-R BS.775 for
+        5.1 (surrounds at 110 degrees) and BS.2051 for 7.1 (sides at 90,
+        rears at 135), with the height speakers at 45 degrees up. A layout
+        with rear channels has its plain surrounds at the sides.
+    */
+    static Speaker getSpeaker (Channel channel, bool layoutHasRears);
+
+    /** The speakers of a standard layout, in getLayoutChannels() order. */
+    static std::vector<Speaker> getLayoutSpeakers (Layout layout);
+
+    static const char* getName (Layout layout);
+
+    //==============================================================================
+    BedVirtualiser() = default;
+
+    //==============================================================================
+    /** Computes the filters of these speakers at this sample rate and
+        allocates everything else. Must be called before process(), and
+        never from the audio thread.
+    */
+    void prepare (double sampleRate, int maxBlock, std::vector<Speaker> speakersToUse);
+
+    /** Clears the inputs, the filter states and the reverb. */
+    void reset();
+
+    /** Renders n samples of the getNumChannels() input channels into
+        outL / outR, which are overwritten. The inputs may alias the
+        outputs, e.g. the first two channels of a host buffer. n must not
+        exceed the maxBlock passed to prepare().
+    */
+    void process (const float* const* inputs, float* outL, float* outR, int n);
+
+    //==============================================================================
+    int getNumChannels() const                      { return static_cast<int> (speakers.size()); }
+    const std::vector<Speaker>& getSpeakers() const { return speakers; }
+
+    /** Output level, glides over the smoothing time. */
+    void setVolume (float dB)                       { gVolume_param = dB; }
+    float getVolume() const                         { return gVolume_param; }
+
+    void setSmoothingTime (double seconds);
+
+    /** Late reverb, fed by the room echo. */
+    void setReverbSize (float size)                 { reverb.setSize(size); } // 0 to 1
+    void setReverbDecayTime (float seconds)         { reverb.setDecayTime(seconds); }
+    void setReverbWet (float wet)                   { reverb.setWet(wet); } // linear gain
+
+    /** Samples from the input to the output, the model's initial latency
+        like BinauralEngine::getLatency().
+    */
+    int getLatency() const                          { return modelLatency; }
+
+    /** Taps of the longest of the folded filters. */
+    int getFilterLength() const                     { return filterLength; }
+
+    /** Bytes used by this instance, including its filters. */
+    size_t getMemoryFootprint() const;
+
+private:
+    //==============================================================================
+    void computeFilters();
+
+    //==============================================================================
+    std::vector<Speaker> speakers;
+    double gSampleRate = 44100.0;
+    int modelLatency = 16;
+
+    // One FIR per channel and ear, all filterLength long: filters[(channel * 2 + ear) * filterLength + j]
+    // is the weight of the input filterOffsets[channel * 2 + ear] + j samples ago
+    std::vector<float> filters;
+    std::vector<int> filterOffsets;
+    int filterLength = 0;
+    int maxDelay = 0; // the oldest sample any filter reads
+
+    // The last maxDelay samples of every channel, then the current block
+    std::vector<float> history; // [channel][maxDelay + maxBlock]
+    int historySize = 0;
+
+    std::vector<float> accumulator[2]; // [maxBlock] per ear
+    float a1_head_shadow = 0; // head shadow feedback, the same for every speaker
+    float headShadow_prev[2] = {};
+
+    // Room echo of all channels but the LFE
+    std::vector<float> echoLine;
+    int echoMask = 0;
+    int echoWritePointer = 0;
+    int echoDelay_floor = 0;
+    float echoDelay_frac = 0;
+    float echoGain = 0;
+
+    FdnReverb reverb;
+    std::vector<float> reverbSend;
+
+    // Level
+    float gVolume_param = 0.0f;
+    ParameterSmoother volume_smoothed;
+    double gSmoothingTime = 0.05; // [s]
+    bool started = false; // jump to the parameters on the first block after prepare() / reset()
+};
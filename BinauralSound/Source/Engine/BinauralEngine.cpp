@@ -0,0 +1,681 @@
+/*
+  ==============================================================================
+
+    BinauralEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "BinauralEngine.h"
+
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+
+//==============================================================================
+void BinauralEngine::prepare (double sampleRate, int maxBlock, float maxDistance)
+{
+    gSampleRate = static_cast<float> (sampleRate);
+    gMaxBlock = maxBlock;
+    gMaxDistance = std::max (maxDistance, DistanceModel::referenceDistance);
+
+    // Longer interpolators read further ahead, which can add latency
+    activeInterpolation = interpolation;
+    const int interpolationTaps = Interpolation::getNumTaps(activeInterpolation);
+
+    gInitLatency = BrownDudaModel::initialLatency(gSampleRate, interpolationTaps);
+    gPinnaLatency = BrownDudaModel::initialLatency(gSampleRate);
+
+    // Resizing buffers to the longest delay they have to hold
+    BUFFER_SIZE = BrownDudaModel::inputLineSize(gSampleRate, DistanceModel::propagationDelay(gMaxDistance, gSampleRate), interpolationTaps);
+    BUFFER_MASK = BUFFER_SIZE - 1;
+    PINNA_BUFFER_SIZE = BrownDudaModel::pinnaLineSize(gSampleRate, interpolationTaps);
+    PINNA_BUFFER_MASK = PINNA_BUFFER_SIZE - 1;
+
+    gDelayBuffer.assign(BUFFER_SIZE,0);
+    gDelayBuffer.shrink_to_fit();
+
+    for (auto& line : gDelayBuffer_head_shaddow)
+    {
+        line.assign(PINNA_BUFFER_SIZE,0);
+        line.shrink_to_fit();
+    }
+
+    // Position dependent coefficients, shared with every instance at this sample rate
+    coefficientTable = CoefficientTable::getShared(gSampleRate);
+
+    // Head shadow filter: the pole does not move with the source
+    a1_head_shadow = BrownDudaModel::headShadowPole(gSampleRate);
+    a1_head_shadow_double = BrownDudaModel::headShadowPole(sampleRate);
+
+    // Room model
+    Ke_ampl = BrownDudaModel::roomEchoGain();
+
+    tau_Ke_delay = BrownDudaModel::tau_Ke*gSampleRate;
+
+    airAbsorption.prepare(gSampleRate, gMaxDistance);
+
+    reflections.prepare(coefficientTable, a1_head_shadow, gPinnaLatency, static_cast<float> (BUFFER_SIZE - gInitLatency - 2));
+
+    reverb.prepare(sampleRate);
+    reverbSend.assign(maxBlock, 0.0f);
+    reverbSend.shrink_to_fit();
+
+    for (auto& buffer : auxBuffer)
+    {
+        buffer.assign(maxBlock, 0.0f);
+        buffer.shrink_to_fit();
+    }
+
+    // HRIRs are resampled for one rate, keep them only if it has not changed
+    auto filters = convolver.getFilters();
+    convolver.prepare(hrirPartitionSize, maxHrirLength / hrirPartitionSize);
+
+    if (filters != nullptr && filters->getSampleRate() != sampleRate)
+        convolver.setFilters(nullptr);
+
+    if (brirConvolver != nullptr && brirConvolver->getFilters()->getSampleRate() != sampleRate)
+        brirConvolver.reset();
+
+    setSmoothingTime(gSmoothingTime);
+
+    reset();
+}
+
+void BinauralEngine::setSmoothingTime (double seconds)
+{
+    gSmoothingTime = std::max (0.0, seconds);
+
+    const int rampLength = static_cast<int> (std::round (gSmoothingTime * gSampleRate));
+
+    for (auto* smoother : { &azimuth_smoothed, &elevation_smoothed, &volume_smoothed, &distance_smoothed })
+        smoother->setRampLength(rampLength);
+
+    reverb.setSmoothingTime(gSmoothingTime);
+}
+
+void BinauralEngine::reset()
+{
+    std::fill (gDelayBuffer.begin(), gDelayBuffer.end(), 0.0f);
+
+    for (auto& line : gDelayBuffer_head_shaddow)
+        std::fill (line.begin(), line.end(), 0.0f);
+
+    gWritePointer = 0;
+
+    outVal_prev.fill(0.0);
+    outVal_head_shadow_prev.fill(0.0);
+    airState = 0.0;
+
+    reflections.reset();
+    reverb.reset();
+    convolver.reset();
+
+    if (brirConvolver != nullptr)
+        brirConvolver->reset();
+
+    brirRingOut = 0;
+    activeMode = RenderingMode::structural;
+    silent = false;
+    coefficientsValid = false;
+}
+
+size_t BinauralEngine::getMemoryFootprint() const
+{
+    size_t bytes = sizeof (*this) + gDelayBuffer.capacity() * sizeof (float);
+
+    for (auto& line : gDelayBuffer_head_shaddow)
+        bytes += line.capacity() * sizeof (float);
+
+    bytes += reverbSend.capacity() * sizeof (float);
+
+    for (auto& buffer : auxBuffer)
+        bytes += buffer.capacity() * sizeof (float);
+
+    bytes += reflections.getMemoryFootprint() - sizeof (reflections);
+    bytes += reverb.getMemoryFootprint() - sizeof (reverb);
+    bytes += convolver.getMemoryFootprint() - sizeof (convolver);
+
+    if (brirConvolver != nullptr)
+        bytes += brirConvolver->getMemoryFootprint();
+
+    return bytes;
+}
+
+bool BinauralEngine::setHrirs (std::shared_ptr<const HrirFilters> filters)
+{
+    if (filters != nullptr && filters->getSampleRate() != gSampleRate)
+        return false;
+
+    return convolver.setFilters(std::move (filters));
+}
+
+bool BinauralEngine::setBrirs (std::shared_ptr<BrirConvolver> newConvolver)
+{
+    if (newConvolver != nullptr && newConvolver->getFilters()->getSampleRate() != gSampleRate)
+        return false;
+
+    // A new convolver starts from silence, there is nothing to ring out
+    if (newConvolver != brirConvolver)
+        brirRingOut = 0;
+
+    brirConvolver = std::move (newConvolver);
+    return true;
+}
+
+int BinauralEngine::getLatency() const
+{
+    if (renderingMode == RenderingMode::hrir && convolver.getFilters() != nullptr)
+        return convolver.getLatency();
+
+    if (renderingMode == RenderingMode::brir && brirConvolver != nullptr)
+        return 0;
+
+    return gInitLatency;
+}
+
+//==============================================================================
+namespace
+{
+    /** One fractional delay read across a control block, ramped from its
+        current to its target value. A delay that does not move works out
+        its whole part and interpolation kernel once for the block instead
+        of on every sample.
+    */
+    template <typename Interpolator, bool moving>
+    class DelayTap
+    {
+    public:
+        void start (float current, float target, float ramp)
+        {
+            delay = current;
+            delay_inc = (target - current) * ramp;
+
+            if constexpr (! moving)
+            {
+                const float delay_floor = std::floor(delay);
+                whole = static_cast<int>(delay_floor);
+                kernel = Interpolator::getKernel(delay - delay_floor);
+            }
+        }
+
+        /** The next sample; pointer is where the line is read without the delay. */
+        float read (const float* line, int mask, int pointer)
+        {
+            if constexpr (moving)
+            {
+                delay += delay_inc;
+                const float delay_floor = std::floor(delay);
+
+                return Interpolator::read(line, mask, pointer - static_cast<int>(delay_floor), delay - delay_floor);
+            }
+            else
+            {
+                return Interpolator::apply(line, mask, pointer - whole, kernel);
+            }
+        }
+
+    private:
+        float delay = 0, delay_inc = 0;
+        int whole = 0;
+        typename Interpolator::Kernel kernel {};
+    };
+}
+
+//==============================================================================
+template <typename Interpolator, typename State, typename SampleType>
+void BinauralEngine::renderBlock (const SampleType* in_buffer, SampleType* outputL, SampleType* outputR, float* auxL, float* auxR,
+                                  float* send, int start, int numSamples, RenderingMode mode)
+{
+    if (mode == RenderingMode::structural)
+    {
+        // Most blocks of a static source do not move any delay
+        bool moving = roomDelay_current != roomDelay_target;
+
+        for (int channel = 0; channel < 2; ++channel)
+            moving = moving || coeffs_current[channel].delSamples != coeffs_target[channel].delSamples
+                            || coeffs_current[channel].tau != coeffs_target[channel].tau;
+
+        if (roomEcho)
+        {
+            if (moving)
+                renderModel<Interpolator, State, true, true> (in_buffer, outputL, outputR, send, start, numSamples);
+            else
+                renderModel<Interpolator, State, true, false> (in_buffer, outputL, outputR, send, start, numSamples);
+        }
+        else
+        {
+            if (moving)
+                renderModel<Interpolator, State, false, true> (in_buffer, outputL, outputR, send, start, numSamples);
+            else
+                renderModel<Interpolator, State, false, false> (in_buffer, outputL, outputR, send, start, numSamples);
+        }
+
+        return;
+    }
+
+    const bool renderRoomEcho = roomEcho && mode != RenderingMode::brir; // a BRIR holds the whole room
+
+    const State ramp = State (1) / numSamples;
+
+    State gain = gain_current;
+    const State gain_inc = (gain_target - gain) * ramp;
+
+    float roomDelay = roomDelay_current;
+    const float roomDelay_inc = (roomDelay_target - roomDelay_current) * static_cast<float> (ramp);
+
+    State airPole = airPole_current;
+    const State airPole_inc = (airPole_target - airPole) * ramp;
+    State air = static_cast<State> (airState);
+
+    // The HRIRs hold the ITD, head shadow and pinna, so the direct
+    // sound only needs the propagation delay before the convolver.
+    // Read it without the initial latency, there are no negative delays,
+    // and so linearly: there are no samples ahead of the write position
+    // for a longer kernel. BRIRs hold the room as well.
+    float directDelay = directDelay_current;
+    const float directDelay_inc = (directDelay_target - directDelay_current) * static_cast<float> (ramp);
+
+    for (int i = start; i < start + numSamples; ++i)
+    {
+        // Air absorption, then populate buffer. Read the input before writing either output, it may alias outputL
+        airPole += airPole_inc;
+        air = (1-airPole)*static_cast<State> (in_buffer[i]) + airPole*air;
+
+        gDelayBuffer[gWritePointer] = static_cast<float> (air);
+
+        const int gReadPointer = gWritePointer - gInitLatency;
+
+        gain += gain_inc;
+
+        // Room model, the same for both ears
+        roomDelay += roomDelay_inc;
+        float roomDelay_floor = std::floor(roomDelay);
+        float room_frac_part = roomDelay - roomDelay_floor;
+
+        const State outVal_room = renderRoomEcho ? Ke_ampl * Interpolator::read(gDelayBuffer.data(), BUFFER_MASK, gReadPointer - static_cast<int>(roomDelay_floor), room_frac_part) : 0.0f;
+
+        if (send != nullptr)
+            send[i] = static_cast<float> (outVal_room * gain);
+
+        directDelay += directDelay_inc;
+        float directDelay_floor = std::floor(directDelay);
+        float direct_frac_part = directDelay - directDelay_floor;
+
+        int outPointer_direct = (gWritePointer - 1 - static_cast<int>(directDelay_floor)) & BUFFER_MASK;
+        int outPointer_direct_frac = (gWritePointer - static_cast<int>(directDelay_floor)) & BUFFER_MASK;
+
+        hrirInput[i - start] = static_cast<float> (gain) * (direct_frac_part*gDelayBuffer[outPointer_direct] + (1-direct_frac_part)*gDelayBuffer[outPointer_direct_frac]);
+
+        outputL[i] = static_cast<SampleType> (outVal_room * gain);
+        outputR[i] = static_cast<SampleType> (outVal_room * gain);
+
+        // update gWritePointer
+        gWritePointer = (gWritePointer + 1) & BUFFER_MASK;
+    }
+
+    airState = air;
+
+    if (mode == RenderingMode::hrir)
+        convolver.process(hrirInput.data(), auxL + start, auxR + start, numSamples);
+    else
+        brirConvolver->process(hrirInput.data(), auxL + start, auxR + start, numSamples);
+}
+
+template <typename Interpolator, typename State, bool withRoomEcho, bool moving, typename SampleType>
+void BinauralEngine::renderModel (const SampleType* in_buffer, SampleType* outputL, SampleType* outputR, float* send, int start, int numSamples)
+{
+    using BrownDudaModel::rho_k;
+    constexpr int numEars = 2;
+    constexpr int numEvents = BrownDudaModel::numPinnaEvents;
+
+    const State ramp = State (1) / numSamples;
+    const float delayRamp = static_cast<float> (ramp);
+
+    State gain = gain_current;
+    const State gain_inc = (gain_target - gain) * ramp;
+
+    State airPole = airPole_current;
+    const State airPole_inc = (airPole_target - airPole) * ramp;
+
+    // The filter states in this block's precision, in registers rather than members
+    const State a1 = std::is_same<State, double>::value ? static_cast<State> (a1_head_shadow_double) : static_cast<State> (a1_head_shadow);
+    State air = static_cast<State> (airState);
+    State prev[numEars], prev_head_shadow[numEars];
+
+    DelayTap<Interpolator, moving> echoTap;
+
+    if constexpr (withRoomEcho)
+        echoTap.start(roomDelay_current, roomDelay_target, delayRamp);
+    else if (send != nullptr)
+        std::fill (send + start, send + start + numSamples, 0.0f);
+
+    // Ramps for both ears
+    DelayTap<Interpolator, moving> itd[numEars], pinna[numEars][numEvents];
+    State b0[numEars], b0_inc[numEars], b1[numEars], b1_inc[numEars];
+
+    for (int channel = 0; channel < numEars; ++channel)
+    {
+        auto& current = coeffs_current[channel];
+        auto& target = coeffs_target[channel];
+
+        itd[channel].start(current.delSamples, target.delSamples, delayRamp);
+
+        b0[channel] = current.b0;
+        b1[channel] = current.b1;
+        b0_inc[channel] = (target.b0 - b0[channel]) * ramp;
+        b1_inc[channel] = (target.b1 - b1[channel]) * ramp;
+
+        prev[channel] = static_cast<State> (outVal_prev[channel]);
+        prev_head_shadow[channel] = static_cast<State> (outVal_head_shadow_prev[channel]);
+
+        for (int iEvent = 0; iEvent < numEvents; iEvent++)
+            pinna[channel][iEvent].start(current.tau[iEvent], target.tau[iEvent], delayRamp);
+    }
+
+    for (int i = start; i < start + numSamples; ++i)
+    {
+        // Air absorption, then populate buffer. Read the input before writing either output, it may alias outputL
+        airPole += airPole_inc;
+        air = (1-airPole)*static_cast<State> (in_buffer[i]) + airPole*air;
+
+        gDelayBuffer[gWritePointer] = static_cast<float> (air);
+
+        const int gReadPointer = gWritePointer - gInitLatency;
+
+        gain += gain_inc;
+
+        // Room model, the same for both ears
+        State outVal_room = 0;
+
+        if constexpr (withRoomEcho)
+        {
+            outVal_room = Ke_ampl * echoTap.read(gDelayBuffer.data(), BUFFER_MASK, gReadPointer);
+
+            if (send != nullptr)
+                send[i] = static_cast<float> (outVal_room * gain);
+        }
+
+        State out[numEars];
+
+        for (int channel = 0; channel < numEars; ++channel)
+        {
+            // Read from delay line
+            const State outVal = itd[channel].read(gDelayBuffer.data(), BUFFER_MASK, gReadPointer);
+
+            // HEAD SHADOW FILTER
+            b0[channel] += b0_inc[channel];
+            b1[channel] += b1_inc[channel];
+
+            const State outVal_head_shadow = b0[channel] * outVal + b1[channel] * prev[channel] - a1 * prev_head_shadow[channel];
+
+            prev[channel] = outVal;
+            prev_head_shadow[channel] = outVal_head_shadow;
+
+            // PINNA MODEL
+            // Write to delayLine
+            auto& line = gDelayBuffer_head_shaddow[channel];
+            line[gWritePointer & PINNA_BUFFER_MASK] = static_cast<float> (outVal_head_shadow);
+
+            State outVal_post_pinnae = 0;
+            for (int iEvent = 0; iEvent < numEvents; iEvent++)
+                outVal_post_pinnae += rho_k[iEvent] * pinna[channel][iEvent].read(line.data(), PINNA_BUFFER_MASK, gWritePointer - gPinnaLatency);
+
+            if constexpr (withRoomEcho)
+                out[channel] = (outVal_post_pinnae + outVal_room) * gain;
+            else
+                out[channel] = outVal_post_pinnae * gain;
+        }
+
+        outputL[i] = static_cast<SampleType> (out[0]);
+        outputR[i] = static_cast<SampleType> (out[1]);
+
+        // update gWritePointer
+        gWritePointer = (gWritePointer + 1) & BUFFER_MASK;
+    }
+
+    airState = air;
+
+    for (int channel = 0; channel < numEars; ++channel)
+    {
+        outVal_prev[channel] = prev[channel];
+        outVal_head_shadow_prev[channel] = prev_head_shadow[channel];
+    }
+}
+
+template <typename State, typename SampleType>
+void BinauralEngine::renderControlBlock (const SampleType* in_buffer, SampleType* outputL, SampleType* outputR, float* auxL, float* auxR,
+                                         float* send, int start, int numSamples, RenderingMode mode)
+{
+    switch (activeInterpolation)
+    {
+        case Interpolation::Kind::linear:       renderBlock<Interpolation::Linear, State> (in_buffer, outputL, outputR, auxL, auxR, send, start, numSamples, mode); break;
+        case Interpolation::Kind::lagrange4:    renderBlock<Interpolation::Lagrange4, State> (in_buffer, outputL, outputR, auxL, auxR, send, start, numSamples, mode); break;
+        case Interpolation::Kind::sinc8:        renderBlock<Interpolation::Sinc8, State> (in_buffer, outputL, outputR, auxL, auxR, send, start, numSamples, mode); break;
+        case Interpolation::Kind::sinc16:       renderBlock<Interpolation::Sinc16, State> (in_buffer, outputL, outputR, auxL, auxR, send, start, numSamples, mode); break;
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void BinauralEngine::processSamples (const SampleType* in_buffer, SampleType* outputL, SampleType* outputR, int n)
+{
+    constexpr bool doubleSamples = std::is_same<SampleType, double>::value;
+
+    // The convolvers, reflections and reverb only render in float. They add
+    // to the output directly, or to the aux buffers for a double output.
+    float* auxL = nullptr;
+    float* auxR = nullptr;
+
+    if constexpr (doubleSamples)
+    {
+        auxL = auxBuffer[0].data();
+        auxR = auxBuffer[1].data();
+        std::fill (auxL, auxL + n, 0.0f);
+        std::fill (auxR, auxR + n, 0.0f);
+    }
+    else
+    {
+        auxL = outputL;
+        auxR = outputR;
+    }
+
+    // Start from the new orientation after prepare() / reset(), like the coefficients
+    const HeadOrientation headOrientation_start = coefficientsValid ? headOrientation_current : headOrientation_target;
+    const bool headTracking = ! (headOrientation_start.isIdentity() && headOrientation_target.isIdentity());
+
+    // Only collect the reverb send while the reverb is on
+    float* const send = reverb.isActive() ? reverbSend.data() : nullptr;
+
+    // Modes without their filters fall back to the model
+    RenderingMode mode = RenderingMode::structural;
+
+    if (renderingMode == RenderingMode::hrir && convolver.getFilters() != nullptr)
+        mode = RenderingMode::hrir;
+    else if (renderingMode == RenderingMode::brir && brirConvolver != nullptr)
+        mode = RenderingMode::brir;
+
+    if (mode != activeMode)
+    {
+        // The path switched to still holds what it rendered before the last
+        // switch. The BRIR convolver's does not: it rang out to silence.
+        if (mode == RenderingMode::hrir)
+        {
+            convolver.reset();
+        }
+        else if (mode == RenderingMode::structural)
+        {
+            for (auto& line : gDelayBuffer_head_shaddow)
+                std::fill (line.begin(), line.end(), 0.0f);
+
+            outVal_prev.fill(0.0);
+            outVal_head_shadow_prev.fill(0.0);
+        }
+
+        brirRingOut = activeMode == RenderingMode::brir ? brirConvolver->getTailLength() : 0;
+        activeMode = mode;
+    }
+
+    const bool modelRoom = mode != RenderingMode::brir; // a BRIR holds the whole room
+
+    for (int start = 0; start < n; start += kControlBlockSize)
+    {
+        const int numSamples = std::min (kControlBlockSize, n - start);
+
+        if (! coefficientsValid)
+        {
+            azimuth_smoothed.setCurrentAndTarget(gAzimuth_param);
+            elevation_smoothed.setCurrentAndTarget(gElevation_param);
+            volume_smoothed.setCurrentAndTarget(gVolume_param);
+            distance_smoothed.setCurrentAndTarget(gDistance_param);
+        }
+
+        // Parameter values at the end of this control block
+        float azimuth = azimuth_smoothed.getNext(gAzimuth_param, numSamples);
+        float elevation = elevation_smoothed.getNext(gElevation_param, numSamples);
+        const float volume = volume_smoothed.getNext(gVolume_param, numSamples);
+        const float distance = DistanceModel::clampDistance(distance_smoothed.getNext(gDistance_param, numSamples), gMaxDistance);
+
+        // Where the source is relative to the listener's head
+        const float roomAzimuth = azimuth, roomElevation = elevation;
+        HeadOrientation head;
+
+        if (headTracking)
+        {
+            const float t = static_cast<float> (start + numSamples) / n;
+            head = HeadOrientation::interpolate(headOrientation_start, headOrientation_target, t);
+            head.toHeadRelative(azimuth, elevation);
+        }
+
+        // Control rate: evaluate the model once, then ramp towards it
+        const float propagationDelay = DistanceModel::propagationDelay(distance, gSampleRate);
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            coeffs_target[channel] = coefficientTable->lookup(azimuth, elevation, channel);
+            coeffs_target[channel].delSamples += propagationDelay;
+        }
+
+        const float volumeGain = std::pow(10.0f,(volume/20));
+
+        gain_target = volumeGain * DistanceModel::distanceGain(distance);
+        roomDelay_target = tau_Ke_delay + propagationDelay;
+        airPole_target = airAbsorption.lookup(distance);
+        directDelay_target = propagationDelay;
+
+        if (mode == RenderingMode::hrir)
+            convolver.setMeasurement(convolver.getFilters()->findNearest(azimuth, elevation));
+        else if (mode == RenderingMode::brir)
+            brirConvolver->setMeasurement(brirConvolver->getFilters()->findNearest(azimuth, elevation));
+
+        if (modelRoom && (earlyReflections || reflections.isActive()))
+            reflections.update(earlyReflections ? &room : nullptr, roomAzimuth, roomElevation, distance, head, volumeGain);
+
+        if (! coefficientsValid)
+        {
+            coeffs_current = coeffs_target;
+            gain_current = gain_target;
+            roomDelay_current = roomDelay_target;
+            airPole_current = airPole_target;
+            directDelay_current = directDelay_target;
+            coefficientsValid = true;
+        }
+
+        // Too quiet or too far away to be heard: skip the whole chain. Not
+        // with a BRIR, whose tail is still ringing long after that.
+        if (modelRoom && gain_current < DistanceModel::inaudibleGain && gain_target < DistanceModel::inaudibleGain)
+        {
+            std::fill (outputL + start, outputL + start + numSamples, SampleType (0));
+            std::fill (outputR + start, outputR + start + numSamples, SampleType (0));
+
+            if (send != nullptr)
+                std::fill (send + start, send + start + numSamples, 0.0f);
+
+            gWritePointer = (gWritePointer + numSamples) & BUFFER_MASK;
+
+            coeffs_current = coeffs_target;
+            gain_current = gain_target;
+            roomDelay_current = roomDelay_target;
+            airPole_current = airPole_target;
+            directDelay_current = directDelay_target;
+            reflections.land();
+            silent = true;
+            continue;
+        }
+
+        if (silent)
+        {
+            // Nothing was written while the source was skipped, so there is
+            // nothing to glide from either
+            coeffs_current = coeffs_target;
+            roomDelay_current = roomDelay_target;
+            airPole_current = airPole_target;
+            directDelay_current = directDelay_target;
+
+            std::fill (gDelayBuffer.begin(), gDelayBuffer.end(), 0.0f);
+            for (auto& line : gDelayBuffer_head_shaddow)
+                std::fill (line.begin(), line.end(), 0.0f);
+
+            outVal_prev.fill(0.0);
+            outVal_head_shadow_prev.fill(0.0);
+            airState = 0.0;
+            convolver.reset();
+            silent = false;
+        }
+
+        const int blockWritePointer = gWritePointer;
+
+        if constexpr (doubleSamples)
+            renderControlBlock<double> (in_buffer, outputL, outputR, auxL, auxR, send, start, numSamples, mode);
+        else if (doublePrecisionFilters)
+            renderControlBlock<double> (in_buffer, outputL, outputR, auxL, auxR, send, start, numSamples, mode);
+        else
+            renderControlBlock<float> (in_buffer, outputL, outputR, auxL, auxR, send, start, numSamples, mode);
+
+        // Early reflections, all taps at once now that the block is in the line
+        if (modelRoom)
+            reflections.render(gDelayBuffer.data(), BUFFER_SIZE, blockWritePointer - gInitLatency, auxL + start, auxR + start, numSamples);
+
+        // Land exactly on the targets so rounding in the ramps never accumulates
+        coeffs_current = coeffs_target;
+        gain_current = gain_target;
+        roomDelay_current = roomDelay_target;
+        airPole_current = airPole_target;
+        directDelay_current = directDelay_target;
+    }
+
+    headOrientation_current = headOrientation_target;
+
+    // The room response keeps ringing after leaving the brir mode
+    if (brirRingOut > 0 && brirConvolver != nullptr)
+    {
+        hrirInput.fill(0.0f);
+
+        for (int start = 0; start < n; start += kControlBlockSize)
+            brirConvolver->process(hrirInput.data(), auxL + start, auxR + start, std::min (kControlBlockSize, n - start));
+
+        brirRingOut = std::max (0, brirRingOut - n);
+    }
+
+    // One reverb for the whole block, it does nothing while it is off
+    reverb.process(send, auxL, auxR, n);
+
+    if constexpr (doubleSamples)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            outputL[i] += auxL[i];
+            outputR[i] += auxR[i];
+        }
+    }
+}
+
+void BinauralEngine::process (const float* in_buffer, float* outputL, float* outputR, int n)
+{
+    processSamples(in_buffer, outputL, outputR, n);
+}
+
+void BinauralEngine::process (const double* in_buffer, double* outputL, double* outputR, int n)
+{
+    processSamples(in_buffer, outputL, outputR, n);
+}
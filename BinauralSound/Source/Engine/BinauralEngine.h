@@ -0,0 +1,369 @@
+/*
+  ==============================================================================
+
+    BinauralEngine.h
+
+    Brown-Duda structural binaural renderer (ITD delay, head-shadow filter,
+    5-tap pinna model and room echo) for a single mono source, with
+    propagation delay, 1/r gain and air absorption for its distance. The
+    room echo also feeds a late reverb (FdnReverb), and a shoebox room can
+    add early reflections (EarlyReflections); both are off by default.
+
+    The direct sound can also be rendered by convolution with measured HRIRs
+    (HrirConvolver) instead of the model, for listening tests that need the
+    accuracy. Everything else stays the same in that mode. For room presets
+    it can instead be convolved with binaural room impulse responses of a
+    few seconds (BrirConvolver), which then replace the room echo, early
+    reflections and reverb send.
+
+    This file has no JUCE dependency so the renderer can be built, embedded
+    and profiled on its own. The plugin is a thin wrapper around it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "BrirConvolver.h"
+#include "BrownDudaModel.h"
+#include "CoefficientTable.h"
+#include "DistanceModel.h"
+#include "EarlyReflections.h"
+#include "FdnReverb.h"
+#include "HeadOrientation.h"
+#include "HrirConvolver.h"
+#include "Interpolation.h"
+#include "ParameterSmoother.h"
+
+//==============================================================================
+/**
+*/
+class BinauralEngine
+{
+public:
+    //==============================================================================
+    BinauralEngine() = default;
+
+    //==============================================================================
+    /** Allocates the delay lines. Must be called before process(), and never
+        from the audio thread. The lines are sized for sources up to
+        maxDistance metres away; the default only leaves room for the model's
+        1 m sphere.
+    */
+    void prepare (double sampleRate, int maxBlock, float maxDistance = DistanceModel::referenceDistance);
+
+    /** Clears delay lines and filter states without reallocating. With a
+        BRIR convolver set it waits for its worker threads, see
+        BrirConvolver::reset(), so not for the audio thread then.
+    */
+    void reset();
+
+    /** Renders n samples of the mono input into the two ear signals.
+        n must not exceed the maxBlock passed to prepare(). The input may
+        alias outL (in-place processing of a host buffer), but not outR.
+
+        Position and volume are smoothed towards the values last set, see
+        setSmoothingTime(), and read once every kControlBlockSize samples;
+        the resulting delays and gains are ramped linearly in between. The
+        position dependent coefficients come from a shared CoefficientTable.
+        For a static source on a whole degree the output is bit-identical to
+        evaluating the model on every sample, in between grid points it is
+        within the table's interpolation error (~1e-3 samples of delay).
+        After a parameter change the output only differs during the
+        following ramp, where the old per-sample code jumped to the new
+        position on the first sample of the block.
+    */
+    void process (const float* in, float* outL, float* outR, int n);
+
+    /** The same for a host running in double precision. The model's filter
+        states and coefficient ramps then run in double as well, as with
+        setDoublePrecisionFilters(). The delay lines, convolvers, early
+        reflections and reverb stay in float: the first three have no
+        feedback, and the reverb's rounding stays far below its own diffuse
+        tail.
+    */
+    void process (const double* in, double* outL, double* outR, int n);
+
+    //==============================================================================
+    // Source position and level. These set targets; process() glides to
+    // them over the smoothing time.
+    void setAzimuth (float degrees)     { gAzimuth_param = degrees; }
+    void setElevation (float degrees)   { gElevation_param = degrees; }
+    void setVolume (float dB)           { gVolume_param = dB; }
+    void setDistance (float metres)     { gDistance_param = metres; } // clamped to [1, maxDistance]
+
+    float getAzimuth() const            { return gAzimuth_param; }
+    float getElevation() const          { return gElevation_param; }
+    float getVolume() const             { return gVolume_param; }
+    float getDistance() const           { return gDistance_param; }
+
+    /** True if the last control block was skipped because the source was
+        below DistanceModel::inaudibleGain.
+    */
+    bool isSilent() const               { return silent; }
+
+    /** Listener head orientation, e.g. from a head tracker. The source
+        position is counter-rotated by it. It is not smoothed: the next
+        process() call moves from the previous orientation to this one,
+        interpolating once per control block, and reaches it on its last
+        sample.
+    */
+    void setHeadOrientation (const HeadOrientation& orientation)    { headOrientation_target = orientation; }
+    const HeadOrientation& getHeadOrientation() const               { return headOrientation_target; }
+
+    /** Late reverb, fed by the room echo. A wet level of 0 (the default)
+        switches it off and costs nothing.
+    */
+    void setReverbSize (float size)         { reverb.setSize(size); } // 0 to 1
+    void setReverbDecayTime (float seconds) { reverb.setDecayTime(seconds); }
+    void setReverbWet (float wet)           { reverb.setWet(wet); } // linear gain
+
+    float getReverbSize() const             { return reverb.getSize(); }
+    float getReverbDecayTime() const        { return reverb.getDecayTime(); }
+    float getReverbWet() const              { return reverb.getWet(); }
+
+    /** First and second order reflections off the walls of a shoebox room.
+        The source position is taken relative to the listener in the room,
+        before the head orientation is applied. Reflections are recomputed
+        only when the source, the room or the head moves.
+    */
+    void setEarlyReflections (bool shouldRender)    { earlyReflections = shouldRender; }
+    void setRoom (const ShoeboxRoom& newRoom)       { room = newRoom; }
+
+    bool getEarlyReflections() const                { return earlyReflections; }
+    const ShoeboxRoom& getRoom() const              { return room; }
+
+    /** The model's room echo, on by default. Switched off, the echo is
+        compiled out of the renderer, which saves its delay read, and the
+        late reverb gets no input.
+    */
+    void setRoomEcho (bool shouldRender)            { roomEcho = shouldRender; }
+    bool getRoomEcho() const                        { return roomEcho; }
+
+    /** Interpolation of the model's fractional delay reads: ITD, pinna taps
+        and room echo (see Interpolation.h). Longer kernels keep the top
+        octave of moving sources but read further ahead, which can add a
+        few samples of latency and longer lines, so this takes effect on the
+        next prepare(). getLatency() changes with it from then on, and
+        whoever reported the latency to a host has to report it again after
+        that prepare(), as the plugin's prepareToPlay() does. Linear is the
+        default and renders as before.
+    */
+    void setInterpolation (Interpolation::Kind kind)    { interpolation = kind; }
+    Interpolation::Kind getInterpolation() const        { return interpolation; }
+
+    /** Runs the air absorption and head shadow filters, and the ramps of
+        their coefficients, in double precision with float input and output.
+        Both are one pole filters whose pole moves towards 1 as the sample
+        rate rises, so at 192 kHz float rounding in their feedback makes up
+        most of the model's noise floor. Takes effect on the next process()
+        call; off by default, which renders as before. A double precision
+        process() always uses it.
+    */
+    void setDoublePrecisionFilters (bool shouldUseDouble)   { doublePrecisionFilters = shouldUseDouble; }
+    bool getDoublePrecisionFilters() const                  { return doublePrecisionFilters; }
+
+    //==============================================================================
+    /** How the direct sound is rendered. */
+    enum class RenderingMode
+    {
+        structural, // Brown-Duda model
+        hrir,       // convolution with the measured HRIRs given to setHrirs()
+        brir        // convolution with the room responses given to setBrirs()
+    };
+
+    /** Takes effect on the next process() call, without a crossfade. The hrir
+        and brir modes render with the model until filters have been set.
+        Leaving the brir mode lets the room response ring out.
+    */
+    void setRenderingMode (RenderingMode newMode)   { renderingMode = newMode; }
+    RenderingMode getRenderingMode() const          { return renderingMode; }
+
+    /** HRIRs for RenderingMode::hrir, made for this engine's sample rate with
+        hrirPartitionSize and at most maxHrirLength samples. Returns false
+        and keeps the previous ones if they do not fit; nullptr removes them.
+        Safe to call from the audio thread as long as the previous filters
+        are still held elsewhere, so they are not freed there. prepare()
+        drops filters made for another sample rate.
+    */
+    bool setHrirs (std::shared_ptr<const HrirFilters> filters);
+    const std::shared_ptr<const HrirFilters>& getHrirs() const  { return convolver.getFilters(); }
+
+    /** Convolver for RenderingMode::brir, made with BrirFilters for this
+        engine's sample rate. Returns false and keeps the previous one if the
+        rate does not match; nullptr removes it. The engine only uses it from
+        process(), but it is not shared: give every engine its own. Safe to
+        call from the audio thread as long as the previous convolver is still
+        held elsewhere. prepare() drops a convolver made for another rate.
+    */
+    bool setBrirs (std::shared_ptr<BrirConvolver> newConvolver);
+    const std::shared_ptr<BrirConvolver>& getBrirs() const      { return brirConvolver; }
+
+    /** Partition size of the HRIR convolution, and with it its latency. */
+    static constexpr int hrirPartitionSize = 64;
+
+    /** Longest HRIR the convolver is prepared for, at the engine's rate. */
+    static constexpr int maxHrirLength = 2048;
+
+    /** Samples before the first direct sound of an input can come out:
+        the model's initial latency, the convolver's in hrir mode, and none
+        in brir mode.
+    */
+    int getLatency() const;
+
+    /** Time process() takes to glide to a new position, volume or reverb
+        setting. 0 jumps
+        to it within one control block. Takes effect on the next change.
+    */
+    void setSmoothingTime (double seconds);
+    double getSmoothingTime() const     { return gSmoothingTime; }
+
+    double getSampleRate() const        { return gSampleRate; }
+    int getMaximumBlockSize() const     { return gMaxBlock; }
+
+    /** Bytes used by this instance, including its delay lines and BRIR
+        convolver but not the CoefficientTable or filters shared with other
+        instances.
+    */
+    size_t getMemoryFootprint() const;
+
+    //==============================================================================
+    /** Number of samples between two evaluations of the position dependent
+        coefficients. Delays and gains are ramped linearly across it.
+    */
+    static constexpr int kControlBlockSize = 32;
+
+private:
+    //==============================================================================
+    /** process() for either sample type. Whatever renders in float (the
+        convolvers, reflections and reverb) adds to auxL / auxR, which are
+        the outputs themselves for float and auxBuffer for double.
+    */
+    template <typename SampleType>
+    void processSamples (const SampleType* in, SampleType* outL, SampleType* outR, int n);
+
+    /** Renders one control block with the active interpolator, its filters
+        in State precision (float or double).
+    */
+    template <typename State, typename SampleType>
+    void renderControlBlock (const SampleType* in, SampleType* outL, SampleType* outR, float* auxL, float* auxR,
+                             float* send, int start, int numSamples, RenderingMode mode);
+
+    /** Renders one control block with the model or the convolvers, reading
+        the delay lines with the Interpolator.
+    */
+    template <typename Interpolator, typename State, typename SampleType>
+    void renderBlock (const SampleType* in, SampleType* outL, SampleType* outR, float* auxL, float* auxR,
+                      float* send, int start, int numSamples, RenderingMode mode);
+
+    /** The model's inner loop, specialised at compile time for the
+        interpolator, the room echo, and whether any delay moves in this
+        control block; a static one computes its interpolation kernel once.
+        Both ears and all pinna taps are compile-time constants, so the
+        compiler unrolls their loops.
+    */
+    template <typename Interpolator, typename State, bool withRoomEcho, bool moving, typename SampleType>
+    void renderModel (const SampleType* in, SampleType* outL, SampleType* outR, float* send, int start, int numSamples);
+
+    //==============================================================================
+    // BUFFER STUFF
+    // Both ears read the same mono input, so it is only stored once. All lines
+    // advance together and share one write position; reads happen
+    // gInitLatency samples behind it.
+    // Sizes are powers of two derived from the longest delay read at the
+    // current sample rate, see BrownDudaModel::inputLineSize().
+    int BUFFER_SIZE = 0; // size of the input delay buffer
+    int BUFFER_MASK = 0;
+    int PINNA_BUFFER_SIZE = 0; // size of the head shadow delay buffers
+    int PINNA_BUFFER_MASK = 0;
+
+    int gInitLatency = 16; // initial latency to account for negative delays.
+    int gPinnaLatency = 16; // the same for the pinna taps, which have none: always the linear interpolator's
+
+    Interpolation::Kind interpolation = Interpolation::Kind::linear; // applied by the next prepare()
+    Interpolation::Kind activeInterpolation = Interpolation::Kind::linear; // the lines are sized for this one
+
+    std::vector<float> gDelayBuffer; // delay buffer from input
+    std::array<std::vector<float>, 2> gDelayBuffer_head_shaddow; // delay buffers loaded from head shadow model, one per ear
+    int gWritePointer = 0; // write position of all delay buffers
+
+
+    //==============================================================================
+    // AUDIO PARAMS
+    float gAzimuth_param = 0.0f;
+    float gElevation_param = 0.0f;
+    float gVolume_param = 0.0f;
+    float gDistance_param = DistanceModel::referenceDistance;
+    float gMaxDistance = DistanceModel::referenceDistance;
+
+    // Smoothed on the audio thread, so the parameters follow the same ramp
+    // whether they come from the GUI, host automation or a trajectory
+    ParameterSmoother azimuth_smoothed, elevation_smoothed, volume_smoothed, distance_smoothed;
+    double gSmoothingTime = 0.05; // [s]
+
+    HeadOrientation headOrientation_current, headOrientation_target;
+
+    float gSampleRate = 44100.0f;
+    int gMaxBlock = 0;
+
+
+    //==============================================================================
+    // CONTROL RATE
+    // Everything that only depends on the source position is computed once per
+    // control block instead of once per sample, then ramped towards.
+    std::shared_ptr<const CoefficientTable> coefficientTable;
+    std::array<BrownDudaModel::EarCoefficients, 2> coeffs_current, coeffs_target;
+    float gain_current = 1, gain_target = 1;
+    bool coefficientsValid = false; // jump straight to the targets after prepare() / reset()
+
+    float a1_head_shadow; // head shadow filter feedback coefficient, only depends on the sample rate
+    double a1_head_shadow_double; // the same for double precision filters
+    bool doublePrecisionFilters = false;
+
+    // Room model: the echo is delayed by the propagation delay as well
+    bool roomEcho = true;
+    float Ke_ampl;
+    float tau_Ke_delay; // [samples]
+    float roomDelay_current = 0, roomDelay_target = 0;
+
+    // Distance
+    DistanceModel::AirAbsorptionTable airAbsorption;
+    float airPole_current = 0, airPole_target = 0;
+    double airState = 0; // air absorption low pass state
+
+    // Early reflections
+    ShoeboxRoom room;
+    bool earlyReflections = false;
+    EarlyReflections reflections;
+
+    // Measured HRIRs instead of the model for the direct sound; only the
+    // propagation delay is read from the input line, the HRIRs hold the rest
+    RenderingMode renderingMode = RenderingMode::structural;
+    HrirConvolver convolver;
+    std::array<float, kControlBlockSize> hrirInput; // direct sound of one control block
+    float directDelay_current = 0, directDelay_target = 0; // [samples]
+
+    // Room responses instead of the model's direct sound and room. They keep
+    // ringing for tailLength samples after the mode is left.
+    std::shared_ptr<BrirConvolver> brirConvolver;
+    int brirRingOut = 0; // [samples] of tail left to render outside the brir mode
+
+    RenderingMode activeMode = RenderingMode::structural; // what the last block was rendered with
+
+    // Late reverb
+    FdnReverb reverb;
+    std::vector<float> reverbSend; // room echo of this block, the reverb input
+
+    bool silent = false; // skipped the last control block, the lines are stale
+
+    // Filter states, kept in double so either precision can continue from
+    // them; float filters round trip through them exactly
+    std::array<double, 2> outVal_prev, outVal_head_shadow_prev;
+
+    // What renders in float while process() runs in double, added to its output at the end
+    std::array<std::vector<float>, 2> auxBuffer;
+};
@@ -0,0 +1,754 @@
+/*
+  ==============================================================================
+
+    BinauralScene.cpp
+
+  ==============================================================================
+*/
+
+#include "BinauralScene.h"
+
+#include <cmath>
+#include <algorithm>
+
+//==============================================================================
+void BinauralScene::prepare (double sampleRate, int maxBlock, int numSourcesToUse, float maxDistance)
+{
+    gSampleRate = static_cast<float> (sampleRate);
+    gMaxBlock = maxBlock;
+    numSources = numSourcesToUse;
+    gMaxDistance = std::max (maxDistance, DistanceModel::referenceDistance);
+    gInitLatency = BrownDudaModel::initialLatency(gSampleRate);
+
+    coefficientTable = CoefficientTable::getShared(gSampleRate);
+
+    // Room model
+    a1_head_shadow = BrownDudaModel::headShadowPole(gSampleRate);
+    Ke_ampl = BrownDudaModel::roomEchoGain();
+
+    tau_Ke_delay = BrownDudaModel::tau_Ke*gSampleRate;
+
+    airAbsorption.prepare(gSampleRate, gMaxDistance);
+
+    lineSize = BrownDudaModel::inputLineSize(gSampleRate, DistanceModel::propagationDelay(gMaxDistance, gSampleRate));
+    lineMask = lineSize - 1;
+    pinnaLineSize = BrownDudaModel::pinnaLineSize(gSampleRate);
+    pinnaLineMask = pinnaLineSize - 1;
+
+    gDelayBuffer.assign(static_cast<size_t> (numSources) * lineSize, 0.0f);
+    gDelayBuffer_head_shaddow.assign(static_cast<size_t> (2 * numSources) * pinnaLineSize, 0.0f);
+    gDelayBuffer.shrink_to_fit();
+    gDelayBuffer_head_shaddow.shrink_to_fit();
+
+    gAzimuth_param.assign(numSources, 0.0f);
+    gElevation_param.assign(numSources, 0.0f);
+    gVolume_param.assign(numSources, 0.0f);
+    gDistance_param.assign(numSources, DistanceModel::referenceDistance);
+
+    for (auto& ear : ears)
+    {
+        for (auto* v : { &ear.delSamples, &ear.delSamples_target, &ear.b0, &ear.b0_target, &ear.b1, &ear.b1_target,
+                         &ear.outVal_prev, &ear.outVal_head_shadow_prev })
+            v->assign(numSources, 0.0f);
+
+        for (int iEvent = 0; iEvent < BrownDudaModel::numPinnaEvents; iEvent++)
+        {
+            ear.tau[iEvent].assign(numSources, 0.0f);
+            ear.tau_target[iEvent].assign(numSources, 0.0f);
+        }
+    }
+
+    gain.assign(numSources, 1.0f);
+    gain_target.assign(numSources, 1.0f);
+
+    for (auto* v : { &roomDelay, &roomDelay_target, &airPole, &airPole_target, &airState })
+        v->assign(numSources, 0.0f);
+
+    audible.assign(numSources, 1);
+
+    detail.assign(numSources, SceneKernels::Detail::full);
+    detailFrom.assign(numSources, SceneKernels::Detail::full);
+    detailFadePosition.assign(numSources, 0);
+    detailLevel.assign(numSources, 0.0f);
+    silentSamples.assign(numSources, 0);
+    detailOrder.assign(numSources, 0);
+    chunkLevel.assign(numSources, 0.0f);
+
+    reflections.assign(numSources, EarlyReflections());
+    for (auto& source : reflections)
+        source.prepare(coefficientTable, a1_head_shadow, gInitLatency, static_cast<float> (lineSize - gInitLatency - 2));
+
+    reverb.prepare(sampleRate);
+    reverbSend.assign(maxBlock, 0.0f);
+    reverbSend.shrink_to_fit();
+
+    numTasks = (numSources + kSourcesPerTask - 1) / kSourcesPerTask;
+    partialBuses.assign(static_cast<size_t> (std::max (0, numTasks - 1)) * 3 * maxBlock, 0.0f);
+    partialBuses.shrink_to_fit();
+    numRenderedPerTask.assign(numTasks, 0);
+    detailSamplesPerTask.assign(numTasks, {});
+    detailCounters = {};
+
+    reset();
+}
+
+void BinauralScene::reset()
+{
+    std::fill (gDelayBuffer.begin(), gDelayBuffer.end(), 0.0f);
+    std::fill (gDelayBuffer_head_shaddow.begin(), gDelayBuffer_head_shaddow.end(), 0.0f);
+    gWritePointer = 0;
+
+    for (auto& ear : ears)
+    {
+        std::fill (ear.outVal_prev.begin(), ear.outVal_prev.end(), 0.0f);
+        std::fill (ear.outVal_head_shadow_prev.begin(), ear.outVal_head_shadow_prev.end(), 0.0f);
+    }
+
+    std::fill (airState.begin(), airState.end(), 0.0f);
+    std::fill (audible.begin(), audible.end(), 1);
+
+    std::fill (detail.begin(), detail.end(), SceneKernels::Detail::full);
+    std::fill (detailFrom.begin(), detailFrom.end(), SceneKernels::Detail::full);
+    std::fill (detailLevel.begin(), detailLevel.end(), 0.0f);
+    std::fill (silentSamples.begin(), silentSamples.end(), 0);
+    detailSettled = true;
+
+    for (auto& source : reflections)
+        source.reset();
+
+    reverb.reset();
+
+    coefficientsValid = false;
+}
+
+//==============================================================================
+void BinauralScene::setSourcePosition (int source, float azimuth, float elevation)
+{
+    gAzimuth_param[source] = azimuth;
+    gElevation_param[source] = elevation;
+}
+
+void BinauralScene::setSourceGain (int source, float dB)
+{
+    gVolume_param[source] = dB;
+}
+
+void BinauralScene::setSourceDistance (int source, float metres)
+{
+    gDistance_param[source] = metres;
+}
+
+void BinauralScene::setDetailThresholds (float fullAbove, float reducedAbove)
+{
+    fullAboveDb = fullAbove;
+    reducedAboveDb = std::min (reducedAbove, fullAbove);
+}
+
+//==============================================================================
+void BinauralScene::updateCoefficients (int firstSource, int endSource, bool jumpToTargets)
+{
+    for (int s = firstSource; s < endSource; ++s)
+    {
+        const float distance = DistanceModel::clampDistance(gDistance_param[s], gMaxDistance);
+
+        const float volumeGain = std::pow(10.0f,(gVolume_param[s]/20));
+
+        gain_target[s] = volumeGain * DistanceModel::distanceGain(distance);
+
+        // Nothing else matters for a source that is not going to be rendered
+        if (! jumpToTargets && ((gain[s] < DistanceModel::inaudibleGain && gain_target[s] < DistanceModel::inaudibleGain)
+                                  || detail[s] == SceneKernels::Detail::skipped))
+            continue;
+
+        const float propagationDelay = DistanceModel::propagationDelay(distance, gSampleRate);
+
+        roomDelay_target[s] = tau_Ke_delay + propagationDelay;
+        airPole_target[s] = airAbsorption.lookup(distance);
+
+        if (earlyReflections || reflections[s].isActive())
+            reflections[s].update(earlyReflections ? &room : nullptr, gAzimuth_param[s], gElevation_param[s], distance, {}, volumeGain);
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            const auto coeffs = coefficientTable->lookup(gAzimuth_param[s], gElevation_param[s], channel);
+            auto& ear = ears[channel];
+
+            ear.delSamples_target[s] = coeffs.delSamples + propagationDelay;
+            ear.b0_target[s] = coeffs.b0;
+            ear.b1_target[s] = coeffs.b1;
+
+            for (int iEvent = 0; iEvent < BrownDudaModel::numPinnaEvents; iEvent++)
+                ear.tau_target[iEvent][s] = coeffs.tau[iEvent];
+        }
+
+        if (jumpToTargets)
+        {
+            for (auto& ear : ears)
+            {
+                ear.delSamples[s] = ear.delSamples_target[s];
+                ear.b0[s] = ear.b0_target[s];
+                ear.b1[s] = ear.b1_target[s];
+                for (int iEvent = 0; iEvent < BrownDudaModel::numPinnaEvents; iEvent++)
+                    ear.tau[iEvent][s] = ear.tau_target[iEvent][s];
+            }
+
+            gain[s] = gain_target[s];
+            roomDelay[s] = roomDelay_target[s];
+            airPole[s] = airPole_target[s];
+        }
+    }
+}
+
+bool BinauralScene::updateAudibility (int s)
+{
+    const bool isAudible = detail[s] != SceneKernels::Detail::skipped
+                            && (gain[s] >= DistanceModel::inaudibleGain || gain_target[s] >= DistanceModel::inaudibleGain);
+
+    if (! isAudible)
+    {
+        // Keep the ramps where the kernel would have left them
+        for (auto& ear : ears)
+        {
+            ear.delSamples[s] = ear.delSamples_target[s];
+            ear.b0[s] = ear.b0_target[s];
+            ear.b1[s] = ear.b1_target[s];
+            for (int iEvent = 0; iEvent < BrownDudaModel::numPinnaEvents; iEvent++)
+                ear.tau[iEvent][s] = ear.tau_target[iEvent][s];
+        }
+
+        gain[s] = gain_target[s];
+        roomDelay[s] = roomDelay_target[s];
+        airPole[s] = airPole_target[s];
+        reflections[s].land();
+    }
+    else if (! audible[s])
+    {
+        // Its lines stopped being written when it was skipped, and its
+        // coefficients stopped being updated. Nothing to glide from.
+        clearSource(s);
+
+        for (auto& ear : ears)
+        {
+            ear.delSamples[s] = ear.delSamples_target[s];
+            ear.b0[s] = ear.b0_target[s];
+            ear.b1[s] = ear.b1_target[s];
+            for (int iEvent = 0; iEvent < BrownDudaModel::numPinnaEvents; iEvent++)
+                ear.tau[iEvent][s] = ear.tau_target[iEvent][s];
+        }
+
+        roomDelay[s] = roomDelay_target[s];
+        airPole[s] = airPole_target[s];
+    }
+
+    audible[s] = isAudible;
+    return isAudible;
+}
+
+void BinauralScene::clearSource (int s)
+{
+    auto inputLine = gDelayBuffer.begin() + static_cast<ptrdiff_t> (s) * lineSize;
+    std::fill (inputLine, inputLine + lineSize, 0.0f);
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto line = gDelayBuffer_head_shaddow.begin() + (static_cast<ptrdiff_t> (channel) * numSources + s) * pinnaLineSize;
+        std::fill (line, line + pinnaLineSize, 0.0f);
+
+        ears[channel].outVal_prev[s] = 0.0f;
+        ears[channel].outVal_head_shadow_prev[s] = 0.0f;
+    }
+
+    airState[s] = 0.0f;
+}
+
+void BinauralScene::warmHeadShadow (int s)
+{
+    // The input line holds the history the filter missed: run it over as
+    // much of that as the pinna reads, so a crossfade back to the pinna
+    // does not start from an empty line. Starting from rest a whole pinna
+    // line back leaves the pole's transient far below the signal.
+    const float* const inputLine = gDelayBuffer.data() + static_cast<size_t> (s) * lineSize;
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto& ear = ears[channel];
+        float* const line = gDelayBuffer_head_shaddow.data() + (static_cast<size_t> (channel) * numSources + s) * pinnaLineSize;
+
+        // The ITD is read behind the initial latency, as in the kernels
+        const float delay = ear.delSamples[s];
+        const int delay_floor = static_cast<int> (std::floor(delay)) + gInitLatency;
+        const float frac_part = delay - std::floor(delay);
+        const int length = std::min (pinnaLineSize, lineSize - delay_floor - 2);
+
+        float prev = 0.0f, prev_head_shadow = 0.0f;
+
+        for (int position = gWritePointer - length; position < gWritePointer; ++position)
+        {
+            const float outVal = frac_part * inputLine[(position - 1 - delay_floor) & lineMask]
+                               + (1 - frac_part) * inputLine[(position - delay_floor) & lineMask];
+            const float outVal_head_shadow = ear.b0[s] * outVal + ear.b1[s] * prev - a1_head_shadow * prev_head_shadow;
+
+            prev = outVal;
+            prev_head_shadow = outVal_head_shadow;
+            line[position & pinnaLineMask] = outVal_head_shadow;
+        }
+
+        ear.outVal_prev[s] = prev;
+        ear.outVal_head_shadow_prev[s] = prev_head_shadow;
+    }
+}
+
+namespace
+{
+    template <typename T>
+    size_t getHeapBytes (const std::vector<T>& v)
+    {
+        return v.capacity() * sizeof (T);
+    }
+}
+
+size_t BinauralScene::getMemoryFootprint() const
+{
+    size_t bytes = sizeof (*this) + getHeapBytes (gDelayBuffer) + getHeapBytes (gDelayBuffer_head_shaddow)
+                 + getHeapBytes (gAzimuth_param) + getHeapBytes (gElevation_param) + getHeapBytes (gVolume_param) + getHeapBytes (gDistance_param)
+                 + getHeapBytes (gain) + getHeapBytes (gain_target) + getHeapBytes (roomDelay) + getHeapBytes (roomDelay_target)
+                 + getHeapBytes (airPole) + getHeapBytes (airPole_target) + getHeapBytes (airState) + getHeapBytes (audible)
+                 + getHeapBytes (reverbSend) + getHeapBytes (partialBuses) + getHeapBytes (numRenderedPerTask)
+                 + getHeapBytes (detail) + getHeapBytes (detailFrom) + getHeapBytes (detailFadePosition) + getHeapBytes (detailLevel)
+                 + getHeapBytes (silentSamples) + getHeapBytes (detailOrder) + getHeapBytes (chunkLevel) + getHeapBytes (detailSamplesPerTask);
+
+    for (auto& ear : ears)
+    {
+        for (auto* v : { &ear.delSamples, &ear.delSamples_target, &ear.b0, &ear.b0_target, &ear.b1, &ear.b1_target,
+                         &ear.outVal_prev, &ear.outVal_head_shadow_prev })
+            bytes += getHeapBytes (*v);
+
+        for (int iEvent = 0; iEvent < BrownDudaModel::numPinnaEvents; iEvent++)
+            bytes += getHeapBytes (ear.tau[iEvent]) + getHeapBytes (ear.tau_target[iEvent]);
+    }
+
+    // Unused capacity of the reflections is counted at its size only
+    bytes += (reflections.capacity() - reflections.size()) * sizeof (EarlyReflections);
+
+    for (auto& r : reflections)
+        bytes += r.getMemoryFootprint();
+
+    return bytes + reverb.getMemoryFootprint() - sizeof (reverb);
+}
+
+//==============================================================================
+void BinauralScene::setSimdLevel (SceneKernels::SimdLevel level)
+{
+    simdLevel = std::min (level, SceneKernels::detectSimdLevel());
+    kernel = SceneKernels::getKernel(simdLevel);
+    detailKernel = SceneKernels::getDetailKernel(simdLevel);
+}
+
+//==============================================================================
+void BinauralScene::process (const float* const* inputs, float* outputL, float* outputR, int n)
+{
+    // Only collect the reverb send while the reverb is on
+    float* const send = reverb.isActive() ? reverbSend.data() : nullptr;
+
+    blockInputs = inputs;
+    blockOutputL = outputL;
+    blockOutputR = outputR;
+    blockSend = send;
+    blockSize = n;
+
+    if (levelOfDetail || ! detailSettled)
+        chooseDetail(inputs, n);
+
+    if (threadPool != nullptr && numTasks > 1)
+    {
+        blockJob.scene = this;
+        threadPool->run(blockJob, numTasks);
+    }
+    else
+    {
+        for (int task = 0; task < numTasks; ++task)
+            renderTask(task);
+    }
+
+    if (numTasks == 0)
+    {
+        std::fill (outputL, outputL + n, 0.0f);
+        std::fill (outputR, outputR + n, 0.0f);
+
+        if (send != nullptr)
+            std::fill (send, send + n, 0.0f);
+    }
+
+    // The other groups' buses, always in the same order, so the sum does
+    // not depend on which thread finished first
+    for (int task = 1; task < numTasks; ++task)
+    {
+        const float* const bus = partialBuses.data() + static_cast<size_t> (task - 1) * 3 * gMaxBlock;
+
+        for (int i = 0; i < n; ++i)
+        {
+            outputL[i] += bus[i];
+            outputR[i] += bus[gMaxBlock + i];
+        }
+
+        if (send != nullptr)
+            for (int i = 0; i < n; ++i)
+                send[i] += bus[2 * gMaxBlock + i];
+    }
+
+    numRenderedSources = 0;
+
+    for (int task = 0; task < numTasks; ++task)
+    {
+        numRenderedSources += numRenderedPerTask[task];
+
+        for (size_t level = 0; level < detailCounters.sourceSamples.size(); ++level)
+            detailCounters.sourceSamples[level] += detailSamplesPerTask[task][level];
+    }
+
+    gWritePointer = (gWritePointer + n) & lineMask;
+    coefficientsValid = true;
+
+    // One reverb for all sources, it does nothing while it is off
+    reverb.process(send, outputL, outputR, n);
+}
+
+void BinauralScene::renderTask (int task)
+{
+    float* outputL = blockOutputL;
+    float* outputR = blockOutputR;
+    float* send = blockSend;
+
+    // The first group renders straight into the outputs
+    if (task > 0)
+    {
+        float* const bus = partialBuses.data() + static_cast<size_t> (task - 1) * 3 * gMaxBlock;
+
+        outputL = bus;
+        outputR = bus + gMaxBlock;
+        send = send != nullptr ? bus + 2 * gMaxBlock : nullptr;
+    }
+
+    std::fill (outputL, outputL + blockSize, 0.0f);
+    std::fill (outputR, outputR + blockSize, 0.0f);
+
+    if (send != nullptr)
+        std::fill (send, send + blockSize, 0.0f);
+
+    const int firstSource = task * kSourcesPerTask;
+    const int endSource = std::min (firstSource + kSourcesPerTask, numSources);
+
+    detailSamplesPerTask[task] = {};
+    numRenderedPerTask[task] = renderSources(firstSource, endSource, blockInputs, outputL, outputR, send, blockSize, detailSamplesPerTask[task]);
+}
+
+int BinauralScene::renderSources (int firstSource, int endSource, const float* const* inputs,
+                                  float* outputL, float* outputR, float* send, int n,
+                                  std::array<uint64_t, 4>& detailSamples)
+{
+    using SceneKernels::Detail;
+
+    SceneKernels::Args args;
+    args.inputs = inputs;
+    args.outputL = outputL;
+    args.outputR = outputR;
+
+    args.inputLines = gDelayBuffer.data();
+    args.headShadowLines = gDelayBuffer_head_shaddow.data();
+    args.numSources = numSources;
+    args.lineSize = lineSize;
+    args.lineMask = lineMask;
+    args.pinnaLineSize = pinnaLineSize;
+    args.pinnaLineMask = pinnaLineMask;
+    args.initLatency = gInitLatency;
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto& ear = ears[channel];
+        auto& view = args.ears[channel];
+
+        view.delSamples = ear.delSamples.data();
+        view.delSamples_target = ear.delSamples_target.data();
+        view.b0 = ear.b0.data();
+        view.b0_target = ear.b0_target.data();
+        view.b1 = ear.b1.data();
+        view.b1_target = ear.b1_target.data();
+
+        for (int iEvent = 0; iEvent < BrownDudaModel::numPinnaEvents; iEvent++)
+        {
+            view.tau[iEvent] = ear.tau[iEvent].data();
+            view.tau_target[iEvent] = ear.tau_target[iEvent].data();
+        }
+
+        view.outVal_prev = ear.outVal_prev.data();
+        view.outVal_head_shadow_prev = ear.outVal_head_shadow_prev.data();
+    }
+
+    args.gain = gain.data();
+    args.gain_target = gain_target.data();
+    args.roomDelay = roomDelay.data();
+    args.roomDelay_target = roomDelay_target.data();
+    args.airPole = airPole.data();
+    args.airPole_target = airPole_target.data();
+    args.airState = airState.data();
+
+    args.a1_head_shadow = a1_head_shadow;
+    args.Ke_ampl = Ke_ampl;
+    args.reverbSend = send;
+
+    // Every source only touches its own state, so the groups need no locking
+    int writePointer = gWritePointer;
+    bool jumpToTargets = ! coefficientsValid;
+    int numRendered = 0;
+
+    for (int start = 0; start < n; start += kControlBlockSize)
+    {
+        const int numSamples = std::min (kControlBlockSize, n - start);
+
+        updateCoefficients(firstSource, endSource, jumpToTargets);
+        jumpToTargets = false;
+
+        args.start = start;
+        args.numSamples = numSamples;
+        args.ramp = 1.0f / numSamples;
+        args.writePointer = writePointer;
+
+        // Render runs of audible sources at the same level of detail, so the
+        // SIMD kernels still see contiguous groups. Crossfades go one by one.
+        numRendered = 0;
+        int runStart = firstSource;
+        Detail runDetail = Detail::full;
+
+        auto renderRun = [&] (int runEnd)
+        {
+            if (runEnd <= runStart)
+                return;
+
+            if (runDetail == Detail::full)
+                kernel(args, runStart, runEnd - runStart);
+            else
+                detailKernel(args, runStart, runEnd - runStart, runDetail);
+        };
+
+        for (int s = firstSource; s < endSource; ++s)
+        {
+            const Detail from = detailFrom[s];
+            const Detail to = detail[s];
+
+            if (! updateAudibility(s))
+            {
+                detailSamples[static_cast<size_t> (Detail::skipped)] += static_cast<uint64_t> (numSamples);
+                detailFrom[s] = to; // it comes back with clean lines, nothing to fade from
+
+                renderRun(s);
+                runStart = s + 1;
+                continue;
+            }
+
+            ++numRendered;
+            detailSamples[static_cast<size_t> (std::min (from, to))] += static_cast<uint64_t> (numSamples);
+
+            if (from == to)
+            {
+                if (to != runDetail)
+                {
+                    renderRun(s);
+                    runStart = s;
+                    runDetail = to;
+                }
+
+                continue;
+            }
+
+            renderRun(s);
+            runStart = s + 1;
+
+            SceneKernels::renderDetail(args, s, from, to, static_cast<float> (detailFadePosition[s]) / kDetailFadeLength, 1.0f / kDetailFadeLength);
+
+            detailFadePosition[s] += numSamples;
+            if (detailFadePosition[s] >= kDetailFadeLength)
+                detailFrom[s] = to;
+        }
+
+        renderRun(endSource);
+
+        // Early reflections, all taps of a source at once now that the block is in its line
+        for (int s = firstSource; s < endSource; ++s)
+        {
+            if (audible[s] && reflections[s].isActive())
+                reflections[s].render(gDelayBuffer.data() + static_cast<size_t> (s) * lineSize, lineSize, writePointer - gInitLatency,
+                                      outputL + start, outputR + start, numSamples);
+        }
+
+        writePointer = (writePointer + numSamples) & lineMask;
+    }
+
+    return numRendered;
+}
+
+//==============================================================================
+void BinauralScene::chooseDetail (const float* const* inputs, int n)
+{
+    using SceneKernels::Detail;
+
+    if (n <= 0)
+        return;
+
+    const float fullAbove = std::pow(10.0f, fullAboveDb / 20);
+    const float reducedAbove = std::pow(10.0f, reducedAboveDb / 20);
+    const float release = std::pow(10.0f, -60.0f * n / gSampleRate / 20);
+
+    // A silent source is skipped once everything it wrote has left its lines
+    const int tailLength = lineSize + pinnaLineSize;
+
+    // A SIMD register of sources costs the same however many of its lanes
+    // are needed, so all the sources in one get the same level: that of
+    // the loudest. Registers never straddle two groups.
+    const int lanes = SceneKernels::getNumLanes(simdLevel);
+    const int numChunks = (numSources + lanes - 1) / lanes;
+
+    float cost = 0;
+
+    for (int chunk = 0; chunk < numChunks; ++chunk)
+    {
+        const int first = chunk * lanes;
+        const int end = std::min (first + lanes, numSources);
+
+        Detail wanted = Detail::skipped;
+        bool fading = false;
+
+        for (int s = first; s < end; ++s)
+        {
+            fading = fading || detailFrom[s] != detail[s];
+
+            if (! levelOfDetail)
+            {
+                wanted = Detail::full;
+                continue;
+            }
+
+            // As of the last control block, which is near enough
+            const float sourceGain = gain_target[s];
+
+            // Four partial sums, so the compiler can keep them in one register
+            float peaks[4] = {}, sums[4] = {};
+            int i = 0;
+
+            for (; i + 4 <= n; i += 4)
+            {
+                for (int k = 0; k < 4; ++k)
+                {
+                    const float x = inputs[s][i + k];
+                    peaks[k] = std::max (peaks[k], std::abs (x));
+                    sums[k] += x * x;
+                }
+            }
+
+            for (; i < n; ++i)
+            {
+                peaks[0] = std::max (peaks[0], std::abs (inputs[s][i]));
+                sums[0] += inputs[s][i] * inputs[s][i];
+            }
+
+            const float peak = std::max (std::max (peaks[0], peaks[1]), std::max (peaks[2], peaks[3]));
+            const float sumSquares = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+
+            if (peak * sourceGain < DistanceModel::inaudibleGain)
+                silentSamples[s] = std::min (silentSamples[s] + n, tailLength);
+            else
+                silentSamples[s] = 0;
+
+            detailLevel[s] = std::max (std::sqrt(sumSquares / n) * sourceGain, detailLevel[s] * release);
+
+            Detail level = Detail::panned;
+
+            if (silentSamples[s] >= tailLength)             level = Detail::skipped;
+            else if (detailLevel[s] >= fullAbove)           level = Detail::full;
+            else if (detailLevel[s] >= reducedAbove)        level = Detail::reduced;
+
+            wanted = std::min (wanted, level);
+        }
+
+        // A crossfade under way finishes first; its fade position is above 0
+        for (int s = first; s < end; ++s)
+        {
+            if (! fading)
+            {
+                detailFadePosition[s] = 0;
+                detail[s] = wanted;
+            }
+
+            cost += kDetailCost[static_cast<size_t> (detail[s])];
+        }
+
+        // The loudest source stands for the register in the budget
+        detailOrder[chunk] = chunk;
+        chunkLevel[chunk] = *std::max_element (detailLevel.begin() + first, detailLevel.begin() + end);
+    }
+
+    // Demote the quietest registers until the scene fits the budget, full
+    // ones first, leaving alone those that are crossfading or skipped
+    if (levelOfDetail && cpuBudget > 0 && cost > cpuBudget)
+    {
+        std::sort (detailOrder.begin(), detailOrder.begin() + numChunks, [this] (int a, int b)
+        {
+            return chunkLevel[a] != chunkLevel[b] ? chunkLevel[a] < chunkLevel[b] : a < b;
+        });
+
+        for (const Detail demoted : { Detail::full, Detail::reduced })
+        {
+            const auto cheaper = static_cast<Detail> (static_cast<int> (demoted) + 1);
+            const float saving = kDetailCost[static_cast<size_t> (demoted)] - kDetailCost[static_cast<size_t> (cheaper)];
+
+            for (int i = 0; i < numChunks && cost > cpuBudget; ++i)
+            {
+                const int first = detailOrder[i] * lanes;
+                const int end = std::min (first + lanes, numSources);
+
+                if (detail[first] != demoted || detailFadePosition[first] != 0)
+                    continue;
+
+                for (int s = first; s < end; ++s)
+                {
+                    detail[s] = cheaper;
+                    cost -= saving;
+                }
+            }
+        }
+    }
+
+    bool settled = true;
+
+    for (int s = 0; s < numSources; ++s)
+    {
+        if (detail[s] != detailFrom[s] && detailFadePosition[s] == 0)
+        {
+            // Skipped sources come back with clean lines, and go once
+            // their output is inaudible: neither needs a crossfade
+            if (detail[s] == Detail::skipped || detailFrom[s] == Detail::skipped)
+                detailFrom[s] = detail[s];
+
+            // The head shadow did not run while panned
+            else if (detailFrom[s] == Detail::panned)
+                warmHeadShadow(s);
+        }
+
+        settled = settled && detail[s] == Detail::full && detailFrom[s] == Detail::full;
+    }
+
+    detailSettled = settled;
+}
+
+//==============================================================================
+double BinauralScene::DetailCounters::getSavedFraction() const
+{
+    double total = 0, spent = 0;
+
+    for (size_t level = 0; level < sourceSamples.size(); ++level)
+    {
+        total += static_cast<double> (sourceSamples[level]);
+        spent += static_cast<double> (sourceSamples[level]) * kDetailCost[level];
+    }
+
+    return total > 0 ? 1.0 - spent / total : 0.0;
+}
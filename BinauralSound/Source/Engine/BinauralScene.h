@@ -0,0 +1,353 @@
+/*
+  ==============================================================================
+
+    BinauralScene.h
+
+    Renders N mono sources, each with its own azimuth, elevation, distance
+    and gain, through the Brown-Duda chain into a single binaural output.
+
+    All per-source state is stored as structure-of-arrays so the control-rate
+    stage and the per-sample loops walk contiguous memory, and all sources
+    share one write position for their delay lines. The per-sample loop is
+    in SceneKernels, which renders several sources per SIMD register when
+    the CPU allows it. Sources too quiet or too far away to be heard are
+    skipped, so large scenes only pay for what is audible.
+
+    With level of detail on, sources may also get a cheaper version of the
+    model (SceneKernels::Detail), chosen once a block from their level at
+    the output: the full model for loud sources, ITD and head shadow for
+    quiet ones, a delayed gain per ear for the quietest, and nothing at all
+    once the input has been silent for longer than the lines are long. A
+    CPU budget demotes the quietest sources further. The choice is made per
+    SIMD register of sources, as a register costs the same however few of
+    its lanes are used, and changes crossfade over kDetailFadeLength
+    samples.
+
+    The room echo of every source is also sent to one late reverb bus
+    (FdnReverb), so the reverb costs the same for any number of sources.
+    Optional early reflections off the walls of a shoebox room are cached
+    per source (EarlyReflections).
+
+    Sources are rendered in fixed groups of kSourcesPerTask, each into its
+    own partial bus, and the buses are added up in group order. With a
+    SceneThreadPool the groups run on several threads at once; since the
+    groups and the order of the sum never change, the output is the same
+    to the bit whatever the number of threads.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "BrownDudaModel.h"
+#include "CoefficientTable.h"
+#include "DistanceModel.h"
+#include "EarlyReflections.h"
+#include "FdnReverb.h"
+#include "SceneKernels.h"
+#include "SceneThreadPool.h"
+
+//==============================================================================
+/**
+*/
+class BinauralScene
+{
+public:
+    //==============================================================================
+    BinauralScene() = default;
+
+    //==============================================================================
+    /** Allocates the state of numSources sources. Must be called before
+        process(), and never from the audio thread. The delay lines are sized
+        for sources up to maxDistance metres away; the default only leaves
+        room for sources on the model's 1 m sphere.
+    */
+    void prepare (double sampleRate, int maxBlock, int numSources,
+                  float maxDistance = DistanceModel::referenceDistance);
+
+    /** Clears delay lines and filter states of all sources. */
+    void reset();
+
+    /** Renders n samples of every source and sums them into outL / outR.
+        inputs must hold getNumSources() mono buffers of at least n samples.
+        The outputs are overwritten and must not alias any of the inputs.
+    */
+    void process (const float* const* inputs, float* outL, float* outR, int n);
+
+    //==============================================================================
+    int getNumSources() const           { return numSources; }
+
+    void setSourcePosition (int source, float azimuth, float elevation);
+    void setSourceGain (int source, float dB);
+
+    /** Distance in metres, clamped to [1, maxDistance]. Adds propagation
+        delay, 1/r gain and air absorption.
+    */
+    void setSourceDistance (int source, float metres);
+
+    float getSourceAzimuth (int source) const       { return gAzimuth_param[source]; }
+    float getSourceElevation (int source) const     { return gElevation_param[source]; }
+    float getSourceGain (int source) const          { return gVolume_param[source]; }
+    float getSourceDistance (int source) const      { return gDistance_param[source]; }
+
+    /** Sources rendered in the last control block; the others were below
+        DistanceModel::inaudibleGain, or silent with level of detail on, and
+        skipped.
+    */
+    int getNumRenderedSources() const               { return numRenderedSources; }
+
+    /** Late reverb shared by all sources. A wet level of 0 (the default)
+        switches it off and costs nothing. Changes glide over 50 ms.
+    */
+    void setReverbSize (float size)                 { reverb.setSize(size); } // 0 to 1
+    void setReverbDecayTime (float seconds)         { reverb.setDecayTime(seconds); }
+    void setReverbWet (float wet)                   { reverb.setWet(wet); } // linear gain
+
+    float getReverbSize() const                     { return reverb.getSize(); }
+    float getReverbDecayTime() const                { return reverb.getDecayTime(); }
+    float getReverbWet() const                      { return reverb.getWet(); }
+
+    /** First and second order reflections off the walls of a shoebox room
+        the listener is in. Each source only recomputes its reflections when
+        it or the room moves.
+    */
+    void setEarlyReflections (bool shouldRender)    { earlyReflections = shouldRender; }
+    void setRoom (const ShoeboxRoom& newRoom)       { room = newRoom; }
+
+    bool getEarlyReflections() const                { return earlyReflections; }
+    const ShoeboxRoom& getRoom() const              { return room; }
+
+    /** Chooses a SceneKernels::Detail per source once per block. Off by
+        default, when every source that is not culled gets the full model.
+    */
+    void setLevelOfDetail (bool shouldUse)          { levelOfDetail = shouldUse; }
+    bool getLevelOfDetail() const                   { return levelOfDetail; }
+
+    /** Output levels in dBFS (input RMS times gain, held with a 60 dB/s
+        release) from which a source gets the full model and ITD with head
+        shadow. Quieter sources are panned.
+    */
+    void setDetailThresholds (float fullAboveDb, float reducedAboveDb);
+
+    /** Most work per block, in sources rendered with the full model (see
+        kDetailCost). The quietest sources are demoted, full before reduced,
+        until the scene fits; none is skipped for it. 0, the default, for no
+        limit.
+    */
+    void setCpuBudget (float fullSources)           { cpuBudget = std::max (0.0f, fullSources); }
+    float getCpuBudget() const                      { return cpuBudget; }
+
+    /** Source-samples rendered at each SceneKernels::Detail since prepare()
+        or resetDetailCounters(), culled ones counted as skipped and
+        crossfades at the dearer level.
+    */
+    struct DetailCounters
+    {
+        std::array<uint64_t, 4> sourceSamples {};
+
+        /** Share of the full model's work saved, estimated from kDetailCost. */
+        double getSavedFraction() const;
+    };
+
+    const DetailCounters& getDetailCounters() const { return detailCounters; }
+    void resetDetailCounters()                      { detailCounters = {}; }
+
+    /** Renders the source groups on these threads and the calling one.
+        nullptr, the default, renders all of them on the caller. The pool
+        can be shared by scenes that are not processed at the same time.
+        Not for the audio thread.
+    */
+    void setThreadPool (std::shared_ptr<SceneThreadPool> poolToUse)    { threadPool = std::move (poolToUse); }
+    const std::shared_ptr<SceneThreadPool>& getThreadPool() const     { return threadPool; }
+
+    /** Selects the kernel used by process(). Defaults to the widest one the
+        CPU supports; requests for unsupported instruction sets fall back.
+    */
+    void setSimdLevel (SceneKernels::SimdLevel level);
+    SceneKernels::SimdLevel getSimdLevel() const    { return simdLevel; }
+
+    double getSampleRate() const        { return gSampleRate; }
+    int getMaximumBlockSize() const     { return gMaxBlock; }
+
+    /** Bytes used by this scene, including the state of all its sources but
+        not the shared CoefficientTable.
+    */
+    size_t getMemoryFootprint() const;
+
+    //==============================================================================
+    /** Number of samples between two evaluations of the position dependent
+        coefficients, the same as in BinauralEngine.
+    */
+    static constexpr int kControlBlockSize = 32;
+
+    /** Sources rendered by one task, a whole number of the widest SIMD
+        kernel's lanes. Small enough to balance uneven groups across
+        threads, large enough that the partial buses cost little to add up.
+    */
+    static constexpr int kSourcesPerTask = 16;
+
+    /** Length of the crossfade between two levels of detail. */
+    static constexpr int kDetailFadeLength = 4 * kControlBlockSize;
+
+    /** Cost of a source-sample at each SceneKernels::Detail relative to the
+        full model, control rate included, measured with detail_benchmark
+        on the AVX2 kernel. A skipped source still has its input measured.
+    */
+    static constexpr std::array<float, 4> kDetailCost { 1.0f, 0.5f, 0.4f, 0.1f };
+
+private:
+    //==============================================================================
+    void updateCoefficients (int firstSource, int endSource, bool jumpToTargets);
+
+    /** Renders sources [firstSource, endSource) over the whole block and
+        adds them to the outputs and the reverb send (if not nullptr).
+        Returns the number of them rendered in the last control block.
+    */
+    int renderSources (int firstSource, int endSource, const float* const* inputs,
+                       float* outputL, float* outputR, float* send, int n,
+                       std::array<uint64_t, 4>& detailSamples);
+
+    /** Picks the level of detail of every source for the next n samples and
+        starts the crossfades. Runs on the caller before the groups do.
+    */
+    void chooseDetail (const float* const* inputs, int n);
+
+    /** One group of sources, into the outputs for the first and into its
+        partial bus for the others.
+    */
+    void renderTask (int task);
+
+    struct BlockJob : SceneThreadPool::Job
+    {
+        BinauralScene* scene = nullptr;
+        void runTask (int task) override    { scene->renderTask(task); }
+    };
+
+    /** Decides whether source s is rendered in this control block. Skipped
+        sources land on their targets; sources coming back get clean lines.
+    */
+    bool updateAudibility (int s);
+    void clearSource (int s);
+    void warmHeadShadow (int s);
+
+    //==============================================================================
+    // BUFFER STUFF
+    // One input line per source (both ears read the same mono input) and one
+    // head shadow line per source and ear. Line lengths are powers of two
+    // derived from the longest delay read, and all lines share the write
+    // position.
+    int lineSize = 0;
+    int lineMask = 0;
+    int pinnaLineSize = 0;
+    int pinnaLineMask = 0;
+
+    int gInitLatency = 16; // initial latency to account for negative delays.
+
+    std::vector<float> gDelayBuffer; // [source][lineSize]
+    std::vector<float> gDelayBuffer_head_shaddow; // [ear][source][pinnaLineSize]
+    int gWritePointer = 0;
+
+
+    //==============================================================================
+    // AUDIO PARAMS
+    int numSources = 0;
+
+    std::vector<float> gAzimuth_param;
+    std::vector<float> gElevation_param;
+    std::vector<float> gVolume_param;
+    std::vector<float> gDistance_param;
+
+    float gSampleRate = 44100.0f;
+    float gMaxDistance = DistanceModel::referenceDistance;
+    int gMaxBlock = 0;
+
+
+    //==============================================================================
+    // CONTROL RATE
+    // Per ear, per source. Current values are where the last ramp ended,
+    // targets are evaluated at the start of every control block.
+    struct EarState
+    {
+        std::vector<float> delSamples, delSamples_target;
+        std::vector<float> b0, b0_target;
+        std::vector<float> b1, b1_target;
+        std::array<std::vector<float>, BrownDudaModel::numPinnaEvents> tau, tau_target;
+
+        // Filter states
+        std::vector<float> outVal_prev;
+        std::vector<float> outVal_head_shadow_prev;
+    };
+
+    std::shared_ptr<const CoefficientTable> coefficientTable;
+    std::array<EarState, 2> ears;
+
+    std::vector<float> gain, gain_target;
+    bool coefficientsValid = false; // jump straight to the targets after prepare() / reset()
+
+    float a1_head_shadow; // head shadow filter feedback coefficient
+
+    // Room model, the echo is delayed by the propagation delay as well
+    float Ke_ampl;
+    float tau_Ke_delay; // [samples]
+    std::vector<float> roomDelay, roomDelay_target;
+
+    // Distance
+    DistanceModel::AirAbsorptionTable airAbsorption;
+    std::vector<float> airPole, airPole_target, airState;
+
+    std::vector<unsigned char> audible; // rendered in the last control block
+    int numRenderedSources = 0;
+
+    // Early reflections, per source
+    ShoeboxRoom room;
+    bool earlyReflections = false;
+    std::vector<EarlyReflections> reflections;
+
+    // Late reverb bus
+    FdnReverb reverb;
+    std::vector<float> reverbSend; // room echo of all sources, the reverb input
+
+    // Per-sample loop
+    SceneKernels::SimdLevel simdLevel = SceneKernels::detectSimdLevel();
+    SceneKernels::Kernel kernel = SceneKernels::getKernel(simdLevel);
+    SceneKernels::DetailKernel detailKernel = SceneKernels::getDetailKernel(simdLevel);
+
+    // Level of detail, per source. A source is crossfading from detailFrom
+    // to detail while they differ.
+    bool levelOfDetail = false;
+    bool detailSettled = true; // every source full, nothing to choose while off
+    float fullAboveDb = -50.0f;
+    float reducedAboveDb = -70.0f;
+    float cpuBudget = 0.0f;
+
+    std::vector<SceneKernels::Detail> detail, detailFrom;
+    std::vector<int> detailFadePosition;
+    std::vector<float> detailLevel; // held output level, linear
+    std::vector<int> silentSamples; // since the input last reached an audible level
+    std::vector<int> detailOrder; // SIMD registers of sources, quietest first, for the budget
+    std::vector<float> chunkLevel; // loudest held level in each register
+
+    DetailCounters detailCounters;
+    std::vector<std::array<uint64_t, 4>> detailSamplesPerTask;
+
+    // Source groups. The block being processed, for the tasks.
+    int numTasks = 0;
+    std::vector<float> partialBuses; // [task - 1][left, right, send][maxBlock], the first task needs none
+    std::vector<int> numRenderedPerTask;
+
+    const float* const* blockInputs = nullptr;
+    float* blockOutputL = nullptr;
+    float* blockOutputR = nullptr;
+    float* blockSend = nullptr;
+    int blockSize = 0;
+
+    std::shared_ptr<SceneThreadPool> threadPool;
+    BlockJob blockJob;
+};
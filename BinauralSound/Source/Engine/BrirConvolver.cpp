@@ -0,0 +1,596 @@
+/*
+  ==============================================================================
+
+    BrirConvolver.cpp
+
+  ==============================================================================
+*/
+
+#include "BrirConvolver.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+    int log2 (int powerOfTwo)
+    {
+        int order = 0;
+        while ((1 << order) < powerOfTwo)
+            ++order;
+        return order;
+    }
+
+    int64_t now() // [ns]
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /** Sum over the partitions of a segment of the input spectra in its
+        delay line times the filter spectra, each with the measurement its
+        input block was played with.
+    */
+    void accumulate (const BrirFilters& filters, int segment, const std::vector<float>& fdl, const std::vector<int>& fdlMeasurements,
+                     int fdlPosition, int channel, float* re, float* im)
+    {
+        const auto& s = filters.getSegments()[segment];
+        const int numBins = s.partitionSize + 1;
+
+        std::fill (re, re + numBins, 0.0f);
+        std::fill (im, im + numBins, 0.0f);
+
+        for (int k = 0; k < s.numPartitions; ++k)
+        {
+            // Input block k blocks ago times partition k of the filter
+            const int slot = (fdlPosition - k + s.numPartitions) % s.numPartitions;
+
+            const float* const xr = fdl.data() + static_cast<size_t> (slot) * 2 * numBins;
+            const float* const xi = xr + numBins;
+            const float* const hr = filters.getSpectrum(fdlMeasurements[slot], channel, segment, k);
+            const float* const hi = hr + numBins;
+
+            for (int b = 0; b < numBins; ++b)
+            {
+                re[b] += xr[b]*hr[b] - xi[b]*hi[b];
+                im[b] += xr[b]*hi[b] + xi[b]*hr[b];
+            }
+        }
+    }
+}
+
+//==============================================================================
+std::vector<BrirFilters::Segment> BrirFilters::makeLayout (int length)
+{
+    std::vector<Segment> segments;
+
+    int partitionSize = headLength;
+    int offset = headLength;
+    size_t spectrumOffset = 0;
+
+    while (offset < length)
+    {
+        // The next segment starts two of its partitions in, which gives the
+        // workers one partition of audio time to compute each block
+        const int nextPartitionSize = partitionSize * partitionGrowth;
+        const int nextOffset = 2 * nextPartitionSize;
+        const bool last = partitionSize == maxPartitionSize || nextOffset >= length;
+
+        const int end = last ? length : nextOffset;
+        const int numPartitions = (end - offset + partitionSize - 1) / partitionSize;
+
+        segments.push_back({ partitionSize, offset, numPartitions, spectrumOffset });
+        spectrumOffset += static_cast<size_t> (numPartitions) * 2 * (partitionSize + 1);
+
+        if (last)
+            break;
+
+        partitionSize = nextPartitionSize;
+        offset = nextOffset;
+    }
+
+    return segments;
+}
+
+BrirFilters::BrirFilters (std::shared_ptr<const HrirSet> setToUse, double sampleRateToUse)
+    : set (std::move (setToUse)),
+      sampleRate (sampleRateToUse)
+{
+    length = static_cast<int> (std::ceil(set->getLength() * sampleRate / set->getSampleRate()));
+    segments = makeLayout(length);
+
+    for (auto& s : segments)
+        spectraPerEar += static_cast<size_t> (s.numPartitions) * 2 * (s.partitionSize + 1);
+
+    const int numMeasurements = set->getNumMeasurements();
+
+    heads.assign(static_cast<size_t> (numMeasurements) * 2 * headLength, 0.0f);
+    spectra.resize(static_cast<size_t> (numMeasurements) * 2 * spectraPerEar);
+
+    std::vector<std::unique_ptr<Fft>> ffts;
+    for (auto& s : segments)
+        ffts.push_back(std::make_unique<Fft> (log2(2 * s.partitionSize)));
+
+    std::vector<float> padded;
+
+    for (int m = 0; m < numMeasurements; ++m)
+    {
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            const std::vector<float> ir = set->getImpulseResponse(m, channel, sampleRate, length);
+            const int irLength = static_cast<int> (ir.size());
+
+            std::copy (ir.begin(), ir.begin() + std::min (irLength, headLength), heads.begin() + (static_cast<size_t> (m) * 2 + channel) * headLength);
+
+            for (size_t i = 0; i < segments.size(); ++i)
+            {
+                const auto& s = segments[i];
+                const Fft& fft = *ffts[i];
+
+                // Folds the 1 / 2P of the inverse transform into the filters
+                const float scale = 1.0f / fft.getSize();
+
+                padded.resize(2 * s.partitionSize);
+
+                for (int k = 0; k < s.numPartitions; ++k)
+                {
+                    // Partition in the first half, zeros in the second, as in HrirFilters
+                    std::fill (padded.begin(), padded.end(), 0.0f);
+
+                    const int start = s.offset + k * s.partitionSize;
+                    const int count = std::min (s.partitionSize, irLength - start);
+
+                    for (int n = 0; n < count; ++n)
+                        padded[n] = ir[start + n] * scale;
+
+                    float* const spectrum = spectra.data() + (static_cast<size_t> (m) * 2 + channel) * spectraPerEar
+                                                           + s.spectrumOffset + static_cast<size_t> (k) * 2 * (s.partitionSize + 1);
+                    fft.forward(padded.data(), spectrum, spectrum + s.partitionSize + 1);
+                }
+            }
+        }
+    }
+}
+
+size_t BrirFilters::getMemoryFootprint() const
+{
+    return sizeof (*this) + (heads.capacity() + spectra.capacity()) * sizeof (float);
+}
+
+//==============================================================================
+/** One segment computed by the pool. The audio thread publishes input
+    blocks with post(), the workers compute them into an output ring that
+    the audio thread plays from two partitions later.
+*/
+class BrirConvolver::TailSegment : public ConvolutionThreadPool::Task
+{
+public:
+    //==============================================================================
+    /** Input blocks that can wait at once. A block this late has missed its
+        deadline long ago, and its input may already be overwritten.
+    */
+    static constexpr int maxPending = 4;
+
+    /** Partitions held by the output ring. */
+    static constexpr int outputBlocks = 8;
+
+    TailSegment (const BrirConvolver& ownerToUse, int segmentToUse)
+        : owner (ownerToUse),
+          segment (segmentToUse),
+          layout (owner.filters->getSegments()[segment]),
+          fft (log2(2 * layout.partitionSize))
+    {
+        const int numBins = layout.partitionSize + 1;
+
+        fdl.assign(static_cast<size_t> (layout.numPartitions) * 2 * numBins, 0.0f);
+        fdlMeasurements.assign(layout.numPartitions, 0);
+        accumulator.assign(2 * numBins, 0.0f);
+        timeBlock.assign(2 * layout.partitionSize, 0.0f);
+
+        for (auto& ear : overlap)
+            ear.assign(layout.partitionSize, 0.0f);
+
+        for (auto& ear : output)
+            ear.assign(static_cast<size_t> (outputBlocks) * layout.partitionSize, 0.0f);
+
+        outputMask = outputBlocks * layout.partitionSize - 1;
+    }
+
+    /** Only while no thread runs it. */
+    void clear()
+    {
+        std::fill (fdl.begin(), fdl.end(), 0.0f);
+        std::fill (fdlMeasurements.begin(), fdlMeasurements.end(), 0);
+        fdlPosition = 0;
+
+        for (auto* ears : { &overlap, &output })
+            for (auto& ear : *ears)
+                std::fill (ear.begin(), ear.end(), 0.0f);
+
+        blocksPosted.store(0, std::memory_order_relaxed);
+        blocksDone.store(0, std::memory_order_relaxed);
+        playing = false;
+    }
+
+    //==============================================================================
+    // Audio thread
+    int getPartitionSize() const            { return layout.partitionSize; }
+    int getOffset() const                   { return layout.offset; }
+
+    /** Input block number block is complete in the owner's ring. */
+    void post (int64_t block, int measurement, int64_t deadline)
+    {
+        const auto slot = static_cast<size_t> (block % maxPending);
+
+        postedMeasurements[slot].store(measurement, std::memory_order_relaxed);
+        postedDeadlines[slot].store(deadline, std::memory_order_relaxed);
+        blocksPosted.store(block + 1, std::memory_order_release);
+    }
+
+    bool isDone (int64_t block) const       { return blocksDone.load(std::memory_order_acquire) > block; }
+
+    /** Adds count samples of the block being played, from time on. */
+    void play (int64_t time, float* outL, float* outR, int count) const
+    {
+        if (! playing)
+            return;
+
+        const float* const left = output[0].data() + (time & outputMask);
+        const float* const right = output[1].data() + (time & outputMask);
+
+        for (int i = 0; i < count; ++i)
+        {
+            outL[i] += left[i];
+            outR[i] += right[i];
+        }
+    }
+
+    bool playing = false; // the block being played was computed in time
+
+    //==============================================================================
+    // Workers
+    bool getNextDeadline (int64_t& deadline) const override
+    {
+        const int64_t block = blocksDone.load(std::memory_order_relaxed);
+
+        if (blocksPosted.load(std::memory_order_acquire) == block)
+            return false;
+
+        deadline = postedDeadlines[static_cast<size_t> (block % maxPending)].load(std::memory_order_relaxed);
+        return true;
+    }
+
+    void runNextBlock() override
+    {
+        const int64_t block = blocksDone.load(std::memory_order_relaxed);
+        const int partitionSize = layout.partitionSize;
+        const int numBins = partitionSize + 1;
+
+        // The block from the ring, unless the audio thread is so far ahead
+        // that it may be writing over it, then zeros to pad it to 2P
+        const bool intact = blocksPosted.load(std::memory_order_acquire) - block < maxPending;
+        const int64_t first = block * partitionSize;
+
+        for (int i = 0; i < partitionSize; ++i)
+            timeBlock[i] = intact ? owner.inputRing[static_cast<size_t> ((first + i) & owner.inputMask)] : 0.0f;
+
+        std::fill (timeBlock.begin() + partitionSize, timeBlock.end(), 0.0f);
+
+        fdlPosition = (fdlPosition + 1) % layout.numPartitions;
+
+        float* const xr = fdl.data() + static_cast<size_t> (fdlPosition) * 2 * numBins;
+        fft.forward(timeBlock.data(), xr, xr + numBins);
+        fdlMeasurements[fdlPosition] = postedMeasurements[static_cast<size_t> (block % maxPending)].load(std::memory_order_relaxed);
+
+        float* const re = accumulator.data();
+        float* const im = re + numBins;
+
+        const int64_t start = block * partitionSize + layout.offset;
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            // Overlap-add: the first half plus what the last block left over
+            accumulate(*owner.filters, segment, fdl, fdlMeasurements, fdlPosition, channel, re, im);
+            fft.inverse(re, im, timeBlock.data());
+
+            float* const out = output[channel].data() + (start & outputMask);
+            float* const rest = overlap[channel].data();
+
+            for (int i = 0; i < partitionSize; ++i)
+            {
+                out[i] = timeBlock[i] + rest[i];
+                rest[i] = timeBlock[partitionSize + i];
+            }
+        }
+
+        blocksDone.store(block + 1, std::memory_order_release);
+    }
+
+private:
+    //==============================================================================
+    const BrirConvolver& owner;
+    const int segment;
+    const BrirFilters::Segment& layout;
+
+    // Handed over by the audio thread
+    std::atomic<int64_t> blocksPosted { 0 }, blocksDone { 0 };
+    std::array<std::atomic<int>, maxPending> postedMeasurements {};
+    std::array<std::atomic<int64_t>, maxPending> postedDeadlines {};
+
+    // Only touched by the worker running the segment
+    Fft fft;
+    std::vector<float> fdl; // [partition][re | im]
+    std::vector<int> fdlMeasurements;
+    int fdlPosition = 0;
+    std::vector<float> accumulator, timeBlock;
+    std::vector<float> overlap[2]; // [partition] per ear
+
+    // Written by the workers, read by the audio thread two partitions later
+    std::vector<float> output[2]; // [outputBlocks * partition] per ear
+    int64_t outputMask = 0;
+};
+
+//==============================================================================
+BrirConvolver::BrirConvolver (std::shared_ptr<const BrirFilters> filtersToUse, std::shared_ptr<ConvolutionThreadPool> poolToUse)
+    : filters (std::move (filtersToUse)),
+      pool (std::move (poolToUse))
+{
+    inputBlock.assign(2 * blockSize, 0.0f);
+
+    for (auto& ear : headOutput)
+        ear.assign(blockSize, 0.0f);
+
+    for (auto* ears : { &output, &overlap })
+        for (auto& ear : *ears)
+            ear.assign(blockSize, 0.0f);
+
+    const auto& segments = filters->getSegments();
+
+    if (! segments.empty())
+    {
+        // The first segment, on the audio thread
+        numPartitions = segments[0].numPartitions;
+
+        fft = std::make_unique<Fft> (log2(2 * blockSize));
+        fdl.assign(static_cast<size_t> (numPartitions) * 2 * (blockSize + 1), 0.0f);
+        fdlMeasurements.assign(numPartitions, 0);
+        accumulator.assign(2 * (blockSize + 1), 0.0f);
+        timeBlock.assign(2 * blockSize, 0.0f);
+    }
+
+    if (segments.size() > 1)
+    {
+        // Room for the longest partition's blocks while they wait, are
+        // read and are played, with plenty to spare
+        const int64_t ringSize = static_cast<int64_t> (TailSegment::outputBlocks) * segments.back().partitionSize;
+
+        inputRing.assign(static_cast<size_t> (ringSize), 0.0f);
+        inputMask = ringSize - 1;
+
+        for (size_t i = 1; i < segments.size(); ++i)
+            tails.push_back(std::make_unique<TailSegment> (*this, static_cast<int> (i)));
+
+        if (pool != nullptr)
+            for (auto& tail : tails)
+                pool->add(tail.get());
+    }
+}
+
+BrirConvolver::~BrirConvolver()
+{
+    if (pool != nullptr)
+        for (auto& tail : tails)
+            pool->remove(tail.get());
+}
+
+void BrirConvolver::reset()
+{
+    for (auto& tail : tails)
+    {
+        if (pool != nullptr)
+            pool->remove(tail.get());
+
+        tail->clear();
+
+        if (pool != nullptr)
+            pool->add(tail.get());
+    }
+
+    std::fill (inputBlock.begin(), inputBlock.end(), 0.0f);
+    std::fill (fdl.begin(), fdl.end(), 0.0f);
+    std::fill (fdlMeasurements.begin(), fdlMeasurements.end(), 0);
+    std::fill (inputRing.begin(), inputRing.end(), 0.0f);
+
+    for (auto* ears : { &output, &overlap })
+        for (auto& ear : *ears)
+            std::fill (ear.begin(), ear.end(), 0.0f);
+
+    inputFill = 0;
+    time = 0;
+    fdlPosition = 0;
+    measurement_current = measurement_previous = 0;
+    missedDeadlines.store(0, std::memory_order_relaxed);
+}
+
+size_t BrirConvolver::getMemoryFootprint() const
+{
+    size_t bytes = sizeof (*this) + (inputBlock.capacity() + fdl.capacity() + accumulator.capacity()
+                                     + timeBlock.capacity() + inputRing.capacity()) * sizeof (float)
+                 + fdlMeasurements.capacity() * sizeof (int);
+
+    for (auto* ears : { &headOutput, &output, &overlap })
+        for (auto& ear : *ears)
+            bytes += ear.capacity() * sizeof (float);
+
+    // The tails' own buffers: delay line, output ring, overlap and scratch space
+    const auto& segments = filters->getSegments();
+
+    for (size_t i = 1; i < segments.size(); ++i)
+    {
+        const auto& s = segments[i];
+
+        bytes += sizeof (TailSegment) + (static_cast<size_t> (s.numPartitions) * 2 * (s.partitionSize + 1)
+                                         + 2 * static_cast<size_t> (TailSegment::outputBlocks) * s.partitionSize
+                                         + 2 * (s.partitionSize + 1) + 4 * s.partitionSize) * sizeof (float);
+    }
+
+    return bytes;
+}
+
+//==============================================================================
+void BrirConvolver::process (const float* in, float* outL, float* outR, int n)
+{
+    for (int done = 0; done < n;)
+    {
+        if (inputFill == 0)
+            startBlock();
+
+        const int count = std::min (n - done, blockSize - inputFill);
+        float* const current = inputBlock.data() + blockSize + inputFill;
+
+        // Read the input first, it may alias outL
+        std::copy (in + done, in + done + count, current);
+
+        for (int i = 0; i < count && ! inputRing.empty(); ++i)
+            inputRing[static_cast<size_t> ((time + i) & inputMask)] = current[i];
+
+        renderHead(count);
+
+        for (int i = 0; i < count; ++i)
+        {
+            outL[done + i] += headOutput[0][i] + output[0][inputFill + i];
+            outR[done + i] += headOutput[1][i] + output[1][inputFill + i];
+        }
+
+        for (auto& tail : tails)
+            tail->play(time, outL + done, outR + done, count);
+
+        inputFill += count;
+        time += count;
+        done += count;
+
+        if (inputFill == blockSize)
+        {
+            finishBlock();
+            inputFill = 0;
+        }
+    }
+}
+
+void BrirConvolver::renderHead (int count)
+{
+    // Input sample j of this block is x[j], the previous block ends at x[-1].
+    // Tap m of output sample j reads x[j - m], which was played with this
+    // block's measurement if j >= m and with the previous one otherwise.
+    const float* const x = inputBlock.data() + blockSize + inputFill;
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        const float* const h_current = filters->getHead(measurement_current, channel);
+        const float* const h_previous = filters->getHead(measurement_previous, channel);
+        float* const y = headOutput[channel].data();
+
+        std::fill (y, y + count, 0.0f);
+
+        for (int m = 0; m < blockSize; ++m)
+        {
+            const int split = std::clamp (m - inputFill, 0, count);
+            const float* const xm = x - m;
+
+            for (int i = 0; i < split; ++i)
+                y[i] += h_previous[m] * xm[i];
+
+            for (int i = split; i < count; ++i)
+                y[i] += h_current[m] * xm[i];
+        }
+    }
+}
+
+void BrirConvolver::startBlock()
+{
+    measurement_previous = measurement_current;
+    measurement_current = std::clamp (measurement_target, 0, filters->getNumMeasurements() - 1);
+
+    // Tail blocks that start playing now, if they were computed in time
+    for (auto& tail : tails)
+    {
+        const int partitionSize = tail->getPartitionSize();
+        const int64_t sinceStart = time - tail->getOffset();
+
+        if (sinceStart < 0 || sinceStart % partitionSize != 0)
+            continue;
+
+        const int64_t block = sinceStart / partitionSize;
+
+        if (waitForTail && pool != nullptr)
+        {
+            while (! tail->isDone(block))
+                std::this_thread::yield();
+        }
+
+        tail->playing = tail->isDone(block);
+
+        if (! tail->playing)
+            missedDeadlines.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void BrirConvolver::finishBlock()
+{
+    if (numPartitions > 0)
+    {
+        // Newest input spectrum into the delay line, from this block padded to 2P
+        fdlPosition = (fdlPosition + 1) % numPartitions;
+
+        std::copy (inputBlock.begin() + blockSize, inputBlock.end(), timeBlock.begin());
+        std::fill (timeBlock.begin() + blockSize, timeBlock.end(), 0.0f);
+
+        const int numBins = blockSize + 1;
+        float* const xr = fdl.data() + static_cast<size_t> (fdlPosition) * 2 * numBins;
+        fft->forward(timeBlock.data(), xr, xr + numBins);
+        fdlMeasurements[fdlPosition] = measurement_current;
+
+        float* const re = accumulator.data();
+        float* const im = re + numBins;
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            accumulate(*filters, 0, fdl, fdlMeasurements, fdlPosition, channel, re, im);
+            fft->inverse(re, im, timeBlock.data());
+
+            for (int i = 0; i < blockSize; ++i)
+            {
+                output[channel][i] = timeBlock[i] + overlap[channel][i];
+                overlap[channel][i] = timeBlock[blockSize + i];
+            }
+        }
+    }
+
+    std::copy (inputBlock.begin() + blockSize, inputBlock.end(), inputBlock.begin());
+
+    // Hand the tail blocks completed by this one to the workers. Each one is
+    // needed offset - partitionSize samples from now.
+    bool posted = false;
+
+    for (auto& tail : tails)
+    {
+        const int partitionSize = tail->getPartitionSize();
+
+        if (time % partitionSize != 0)
+            continue;
+
+        const double slack = (tail->getOffset() - partitionSize) / filters->getSampleRate(); // [s]
+
+        tail->post(time / partitionSize - 1, measurement_current, now() + static_cast<int64_t> (slack * 1e9));
+
+        if (pool == nullptr)
+            tail->runNextBlock();
+
+        posted = true;
+    }
+
+    if (posted && pool != nullptr)
+        pool->notify();
+}
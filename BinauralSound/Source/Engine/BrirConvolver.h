@@ -0,0 +1,231 @@
+/*
+  ==============================================================================
+
+    BrirConvolver.h
+
+    Convolution of one source with binaural room impulse responses of a few
+    seconds, without added latency and at a cost to the audio thread that
+    does not depend on their length.
+
+    The responses are split into segments of growing partition size
+    (non-uniform partitioning):
+
+        taps                partition   computed on
+        0 - 64              direct FIR  audio thread
+        64 - 1024           64          audio thread
+        1024 - 8192         512         worker threads
+        8192 - 65536        4096        worker threads
+        65536 - end         32768       worker threads
+
+    The first 64 taps are a plain FIR, so the direct sound comes out with
+    the sample that produced it. Every other segment is uniformly
+    partitioned like HrirConvolver, which delays it by its partition size P;
+    it starts P taps into the response, so that delay is the one the
+    response asks for anyway. They use overlap-add rather than overlap-save,
+    so that every spectrum in a delay line comes from exactly one block. The
+    64 sample segment is computed at the end of every 64 sample block, on
+    the audio thread, and only depends on those first 1024 taps.
+
+    The later segments start 2P taps in. Their blocks are handed to a
+    ConvolutionThreadPool when the P input samples are in, and are only
+    needed P samples later, which leaves the workers a whole partition of
+    audio time; the pool runs the block whose time is up first. If a block
+    is still not done when it should be played, that block of the tail is
+    left out and counted as a missed deadline rather than waited for,
+    except with setWaitForTail() for offline rendering.
+
+    The measurement is chosen per input block rather than for the output:
+    every block is convolved with the response of the direction the source
+    was in when it was played, and its reverberation stays there when the
+    source moves on. That needs no crossfade and no second convolution,
+    the delay lines just remember which measurement each block used.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ConvolutionThreadPool.h"
+#include "Fft.h"
+#include "HrirSet.h"
+
+//==============================================================================
+/** An HrirSet of room responses resampled to one sample rate, with the
+    head taps and the spectra of every segment's partitions. Immutable, so
+    every convolver running that set at that rate can share it.
+*/
+class BrirFilters
+{
+public:
+    //==============================================================================
+    /** Taps of the direct FIR, and block size of the convolver. */
+    static constexpr int headLength = 64;
+
+    /** Partition sizes grow by this factor from one segment to the next... */
+    static constexpr int partitionGrowth = 8;
+
+    /** ...up to this size, which takes all the remaining taps. */
+    static constexpr int maxPartitionSize = 32768;
+
+    struct Segment
+    {
+        int partitionSize;
+        int offset; // first tap
+        int numPartitions;
+        size_t spectrumOffset; // of its first partition in an ear's spectra
+    };
+
+    /** Segments after the head for a response of length taps. The first
+        one has a partition of headLength samples and runs on the audio
+        thread, the others on worker threads.
+    */
+    static std::vector<Segment> makeLayout (int length);
+
+    //==============================================================================
+    /** Resamples the set to sampleRate if it was measured at another rate
+        and transforms the partitions. Allocates, not for the audio thread.
+    */
+    BrirFilters (std::shared_ptr<const HrirSet> set, double sampleRate);
+
+    const HrirSet& getSet() const                   { return *set; }
+
+    /** Nearest measurement, see HrirSet::findNearest(). */
+    int findNearest (float azimuth, float elevation) const  { return set->findNearest(azimuth, elevation); }
+
+    double getSampleRate() const                    { return sampleRate; }
+    int getLength() const                           { return length; }
+    int getNumMeasurements() const                  { return set->getNumMeasurements(); }
+
+    const std::vector<Segment>& getSegments() const { return segments; }
+
+    /** The first headLength taps of one ear. */
+    const float* getHead (int measurement, int channel) const
+    {
+        return heads.data() + (static_cast<size_t> (measurement) * 2 + channel) * headLength;
+    }
+
+    /** Spectrum of one partition of a segment, partitionSize + 1 real parts
+        followed by as many imaginary parts. Scaled so that Fft::inverse()
+        needs no normalisation.
+    */
+    const float* getSpectrum (int measurement, int channel, int segment, int partition) const
+    {
+        const auto& s = segments[segment];
+        return spectra.data() + (static_cast<size_t> (measurement) * 2 + channel) * spectraPerEar
+                              + s.spectrumOffset + static_cast<size_t> (partition) * 2 * (s.partitionSize + 1);
+    }
+
+    size_t getMemoryFootprint() const;
+
+private:
+    //==============================================================================
+    std::shared_ptr<const HrirSet> set;
+    double sampleRate;
+    int length;
+
+    std::vector<Segment> segments;
+    size_t spectraPerEar = 0;
+
+    std::vector<float> heads; // [measurement][ear][headLength]
+    std::vector<float> spectra; // [measurement][ear][segment][partition][re | im]
+};
+
+//==============================================================================
+/**
+*/
+class BrirConvolver
+{
+public:
+    //==============================================================================
+    /** Allocates everything for these filters and registers the tail
+        segments with the pool. Without a pool the tail is computed on the
+        calling thread at the end of the block that completes it, which
+        gives the same output at a cost that grows with the length. Not for
+        the audio thread.
+    */
+    BrirConvolver (std::shared_ptr<const BrirFilters> filters, std::shared_ptr<ConvolutionThreadPool> pool);
+
+    /** Waits for the worker threads to let go of it. Not for the audio thread. */
+    ~BrirConvolver();
+
+    /** Clears the input and the whole tail. Waits for the worker threads
+        to finish what they are computing for this convolver, so not for the
+        audio thread.
+    */
+    void reset();
+
+    /** Measurement for the input from the next block on. */
+    void setMeasurement (int measurement)           { measurement_target = measurement; }
+
+    /** Waits for late tail blocks instead of leaving them out, for hosts
+        rendering faster than real time. Audio thread.
+    */
+    void setWaitForTail (bool shouldWait)           { waitForTail = shouldWait; }
+
+    /** Convolves n samples of in and adds both ears to outL / outR, without
+        latency. The input may alias outL. Never waits for the workers,
+        unless told to by setWaitForTail().
+    */
+    void process (const float* in, float* outL, float* outR, int n);
+
+    const std::shared_ptr<const BrirFilters>& getFilters() const    { return filters; }
+
+    /** Samples the output keeps ringing after the input stops. */
+    int getTailLength() const                       { return filters->getLength(); }
+
+    /** Tail blocks left out because they were not computed in time, since
+        construction or the last reset(). Can be read from any thread.
+    */
+    int64_t getMissedDeadlines() const              { return missedDeadlines.load(std::memory_order_relaxed); }
+
+    size_t getMemoryFootprint() const;
+
+    /** Samples between two runs of the audio thread's partitions. */
+    static constexpr int blockSize = BrirFilters::headLength;
+
+private:
+    //==============================================================================
+    class TailSegment;
+
+    void startBlock();
+    void finishBlock();
+    void renderHead (int count);
+
+    //==============================================================================
+    std::shared_ptr<const BrirFilters> filters;
+    std::shared_ptr<ConvolutionThreadPool> pool;
+
+    // Audio thread: the last two input blocks and the direct FIR's output
+    std::vector<float> inputBlock; // [previous blockSize | current blockSize]
+    int inputFill = 0; // samples in the current block
+    int64_t time = 0; // input samples so far
+    std::vector<float> headOutput[2]; // [blockSize] per ear
+
+    int measurement_current = 0, measurement_previous = 0; // of the current and the previous block
+    int measurement_target = 0;
+
+    // Audio thread: the 64 sample segment, if the response is long enough
+    std::unique_ptr<Fft> fft;
+    int numPartitions = 0;
+    std::vector<float> fdl; // [partition][re | im]
+    std::vector<int> fdlMeasurements; // measurement of each block in the delay line
+    int fdlPosition = 0;
+    std::vector<float> accumulator, timeBlock;
+    std::vector<float> output[2]; // [blockSize] per ear, played during the next block
+    std::vector<float> overlap[2]; // [blockSize] per ear, second half of the last block's result
+
+    // Shared with the workers: the input history they read their blocks from
+    std::vector<float> inputRing;
+    int64_t inputMask = 0;
+
+    std::vector<std::unique_ptr<TailSegment>> tails;
+
+    bool waitForTail = false;
+    std::atomic<int64_t> missedDeadlines { 0 };
+};
@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    BrownDudaModel.cpp
+
+  ==============================================================================
+*/
+
+#include "BrownDudaModel.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    constexpr float float_Pi = 3.14159265358979323846f;
+
+    int nextPowerOfTwo (int n)
+    {
+        int size = 1;
+        while (size < n)
+            size <<= 1;
+        return size;
+    }
+}
+
+//==============================================================================
+BrownDudaModel::EarCoefficients BrownDudaModel::computeEarCoefficients (float azimuth, float elevation, int channel, float sampleRate)
+{
+    EarCoefficients coeffs;
+
+    const float T = 1/sampleRate;
+
+    // Update parameters for sound source position
+    float thetaLeft = 90.0f + azimuth;
+    float thetaRight = 90.0f - azimuth;
+
+    float theta = (channel == 0) ? thetaLeft : thetaRight;
+    float theta_rad =  theta*float_Pi/180;
+
+    // ITD
+    float delta_T = 0;
+    if (0<=std::abs(theta_rad) && std::abs(theta_rad)<float_Pi/2)
+        delta_T = (-a/c)*std::cos(theta_rad);
+    else if (float_Pi/2 <= std::abs(theta_rad) && std::abs(theta_rad) < float_Pi)
+        delta_T = (a/c)*(std::abs(theta_rad)-float_Pi/2);
+
+    coeffs.delSamples = delta_T * sampleRate;
+
+    // HEAD SHADOW FILTER
+    float theta_min_rad = theta_min*float_Pi/180.0f;
+    float alpha = (1+alpha_min/2) + (1-alpha_min/2)*std::cos(theta_rad/theta_min_rad * float_Pi);
+    float beta = 2*c/a;
+
+    coeffs.b0 = (2*alpha + T*beta)/(2+T*beta);
+    coeffs.b1 = (-2*alpha + T*beta)/(2+T*beta);
+
+    // PINNA MODEL
+    for (int iEvent = 0; iEvent < numPinnaEvents; iEvent++)
+        coeffs.tau[iEvent] = Ak[iEvent]*std::cos(theta_rad/2)*std::sin(Dk1[iEvent]*(float_Pi/2-elevation*float_Pi/180))+Bk[iEvent];
+
+    return coeffs;
+}
+
+float BrownDudaModel::headShadowPole (float sampleRate)
+{
+    const float T = 1/sampleRate;
+    const float beta = 2*c/a;
+
+    return (-2 + T*beta)/(2+T*beta);
+}
+
+double BrownDudaModel::headShadowPole (double sampleRate)
+{
+    const double T = 1/sampleRate;
+    const double beta = 2.0*c/a;
+
+    return (-2 + T*beta)/(2+T*beta);
+}
+
+int BrownDudaModel::initialLatency (float sampleRate, int interpolationTaps)
+{
+    const int maxAdvance = static_cast<int> (std::ceil(a/c * sampleRate));
+
+    return std::max (16, maxAdvance + interpolationTaps / 2 - 1);
+}
+
+int BrownDudaModel::inputLineSize (float sampleRate, float extraDelay, int interpolationTaps)
+{
+    // Reads go back up to initialLatency + interpolationTaps / 2 + delay samples from the write position
+    const float maxITD = (a/c)*(float_Pi/2) * sampleRate;
+    const float maxDelay = std::max (maxITD, tau_Ke * sampleRate) + std::max (0.0f, extraDelay);
+
+    return nextPowerOfTwo(initialLatency(sampleRate, interpolationTaps) + interpolationTaps / 2 + 1 + static_cast<int> (std::ceil(maxDelay)));
+}
+
+int BrownDudaModel::pinnaLineSize (float sampleRate, int interpolationTaps)
+{
+    return nextPowerOfTwo(initialLatency(sampleRate) + interpolationTaps / 2 + 1 + static_cast<int> (maxPinnaDelay));
+}
+
+float BrownDudaModel::roomEchoGain()
+{
+    float response_db_Kr = 20 * std::log10(Kr);
+    float Ke_db = response_db_Kr - dB_difference;
+
+    return std::pow(10.0f,(Ke_db/20));
+}
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    BrownDudaModel.h
+
+    Constants and control-rate equations of the structural model, see Brown
+    and Duda, "A Structural Model for Binaural Sound Synthesis". Everything in
+    here is a pure function of the source position and the sample rate, so it
+    is shared by BinauralEngine and BinauralScene.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+
+//==============================================================================
+namespace BrownDudaModel
+{
+    //==============================================================================
+    // HEAD MODEL
+    constexpr float a = 8.75f/100; // radius of head
+    constexpr float c = 343; // speed of sound
+
+    constexpr float alpha_min = 0.1f; // head shadow filter param
+    constexpr float theta_min = 150; // head shadow filter param
+
+    //==============================================================================
+    // PINNA MODEL
+    constexpr int numPinnaEvents = 5;
+
+    using PinnaTable = std::array<float, numPinnaEvents>;
+
+    constexpr PinnaTable rho_k = {0.5f,-1.0f,0.5f,-0.25f,0.25f}; // reflection coefficients
+    constexpr PinnaTable Ak = {1,5,5,5,5}; // amplitudes of the delays [samples]
+    constexpr PinnaTable Bk = {2,4,7,11,13}; // offsets of the delays [samples]
+
+    constexpr PinnaTable Dk1 = {1,0.5f,0.5f,0.5f,0.5f}; // scaling factors
+    //constexpr PinnaTable Dk2 = {0.85f,0.35f,0.35f,0.35f,0.35f}; // alternative scaling factors, see the paper
+
+    /** Upper bound of any pinna delay, Ak + Bk, in samples. */
+    constexpr float maxPinnaDelay = 18.0f;
+
+    //==============================================================================
+    // ROOM MODEL
+    constexpr float Kr = 1;
+    constexpr float dB_difference = 15; // level of the echo below the direct sound
+    constexpr float tau_Ke = 15*0.001f; // echo delay [s]
+
+    //==============================================================================
+    /** Everything one ear needs to render a source at a given position. */
+    struct EarCoefficients
+    {
+        float delSamples = 0; // ITD delay in samples
+        float b0 = 1, b1 = 0; // head shadow filter feed forward coefficients
+        PinnaTable tau {}; // pinna event delays in samples
+    };
+
+    /** Evaluates the ITD, head shadow and pinna equations for one ear
+        (0 = left, 1 = right). Azimuth and elevation are in degrees.
+    */
+    EarCoefficients computeEarCoefficients (float azimuth, float elevation, int channel, float sampleRate);
+
+    /** Feedback coefficient of the head shadow filter. It does not depend on
+        the source position.
+    */
+    float headShadowPole (float sampleRate);
+    double headShadowPole (double sampleRate);
+
+    /** Linear gain of the room echo. */
+    float roomEchoGain();
+
+    /** Offset between the write and read positions of the delay lines. The
+        ITD delay of the ear facing the source is negative, so reads have to
+        start this many samples behind the write position. 16 samples used
+        to be hard coded, which is only enough up to about 62 kHz.
+        Interpolators with more than two taps (see Interpolation.h) also
+        read interpolationTaps / 2 - 1 samples ahead of the delayed
+        position, which may add to it.
+    */
+    int initialLatency (float sampleRate, int interpolationTaps = 2);
+
+    /** Power of two length of a line holding the mono input. Covers the
+        largest ITD delay and the room echo behind the initial latency, plus
+        extraDelay samples (e.g. the propagation delay of a distant source).
+    */
+    int inputLineSize (float sampleRate, float extraDelay = 0, int interpolationTaps = 2);
+
+    /** Power of two length of a line feeding the pinna taps. The pinna
+        delays never exceed maxPinnaDelay, so this stays within a few cache
+        lines at any sample rate the initial latency allows. The taps are
+        read initialLatency (sampleRate) behind the write position whatever
+        the interpolator: their delays are positive, so that leaves room for
+        the longest kernel's reads ahead.
+    */
+    int pinnaLineSize (float sampleRate, int interpolationTaps = 2);
+}
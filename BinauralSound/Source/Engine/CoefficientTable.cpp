@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    CoefficientTable.cpp
+
+  ==============================================================================
+*/
+
+#include "CoefficientTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace
+{
+    constexpr float float_Pi = 3.14159265358979323846f;
+    constexpr float range = 180.0f;
+}
+
+//==============================================================================
+CoefficientTable::CoefficientTable (float sampleRateToUse, float resolutionDegrees)
+    : sampleRate (sampleRateToUse),
+      resolution (resolutionDegrees),
+      invResolution (1.0f / resolutionDegrees),
+      numPoints (static_cast<int> (std::ceil (2 * range / resolutionDegrees)) + 1)
+{
+    using namespace BrownDudaModel;
+
+    azimuthRow.resize(numPoints);
+    elevationRow.resize(numPoints);
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        const float degrees = -range + i * resolution;
+
+        // Azimuth only terms, taken from the model itself so grid points are exact
+        const auto coeffs = computeEarCoefficients(degrees, 0.0f, 0, sampleRate);
+        const float theta_rad = (90.0f + degrees)*float_Pi/180;
+
+        azimuthRow[i] = { coeffs.delSamples, coeffs.b0, coeffs.b1, std::cos(theta_rad/2) };
+
+        // Elevation only terms
+        for (int iEvent = 0; iEvent < numPinnaEvents; iEvent++)
+            elevationRow[i][iEvent] = std::sin(Dk1[iEvent]*(float_Pi/2-degrees*float_Pi/180));
+    }
+}
+
+std::shared_ptr<const CoefficientTable> CoefficientTable::getShared (float sampleRate)
+{
+    static std::mutex lock;
+    static std::map<float, std::weak_ptr<const CoefficientTable>> tables;
+
+    std::lock_guard<std::mutex> guard (lock);
+
+    auto& entry = tables[sampleRate];
+
+    if (auto table = entry.lock())
+        return table;
+
+    auto table = std::make_shared<const CoefficientTable> (sampleRate);
+    entry = table;
+    return table;
+}
+
+size_t CoefficientTable::getMemoryFootprint() const
+{
+    return sizeof (*this)
+         + azimuthRow.capacity() * sizeof (AzimuthEntry)
+         + elevationRow.capacity() * sizeof (ElevationEntry);
+}
+
+//==============================================================================
+BrownDudaModel::EarCoefficients CoefficientTable::lookup (float azimuth, float elevation, int channel) const
+{
+    using namespace BrownDudaModel;
+
+    // The right ear sees the source mirrored in azimuth
+    if (channel != 0)
+        azimuth = -azimuth;
+
+    const auto locate = [this] (float degrees, int& index, float& frac)
+    {
+        const float x = (std::min (std::max (degrees, -range), range) + range) * invResolution;
+        index = std::min (static_cast<int> (x), numPoints - 2);
+        frac = x - index;
+    };
+
+    int ia, ie;
+    float fa, fe;
+    locate (azimuth, ia, fa);
+    locate (elevation, ie, fe);
+
+    const auto& a0 = azimuthRow[ia];
+    const auto& a1 = azimuthRow[ia + 1];
+    const auto& e0 = elevationRow[ie];
+    const auto& e1 = elevationRow[ie + 1];
+
+    EarCoefficients coeffs;
+    coeffs.delSamples = a0.delSamples + fa * (a1.delSamples - a0.delSamples);
+    coeffs.b0 = a0.b0 + fa * (a1.b0 - a0.b0);
+    coeffs.b1 = a0.b1 + fa * (a1.b1 - a0.b1);
+
+    const float cos_theta_2 = a0.cos_theta_2 + fa * (a1.cos_theta_2 - a0.cos_theta_2);
+
+    for (int iEvent = 0; iEvent < numPinnaEvents; iEvent++)
+    {
+        const float sin_elevation = e0[iEvent] + fe * (e1[iEvent] - e0[iEvent]);
+        coeffs.tau[iEvent] = Ak[iEvent]*cos_theta_2*sin_elevation+Bk[iEvent];
+    }
+
+    return coeffs;
+}
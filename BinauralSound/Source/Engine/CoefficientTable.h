@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    CoefficientTable.h
+
+    Precomputed BrownDudaModel::computeEarCoefficients() on a regular
+    azimuth / elevation grid, so moving sources cost a table lookup instead
+    of cos / sin calls at control rate.
+
+    The model is separable: the ITD and head shadow coefficients only depend
+    on the azimuth, and every pinna delay is Ak * f(azimuth) * g_k(elevation)
+    + Bk. The table therefore stores one azimuth row and one elevation row
+    and interpolates each linearly, which gives exactly the bilinear
+    interpolation of the full grid in a few kilobytes. The right ear is the
+    left ear mirrored in azimuth and shares the same row.
+
+    Tables only depend on the sample rate and are immutable once built, so
+    every source and every instance running at that rate shares one.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "BrownDudaModel.h"
+
+//==============================================================================
+/**
+*/
+class CoefficientTable
+{
+public:
+    //==============================================================================
+    /** Builds a table covering azimuth and elevation from -180 to 180 degrees. */
+    explicit CoefficientTable (float sampleRate, float resolutionDegrees = 1.0f);
+
+    /** Returns the table for the given sample rate, building it on first use.
+        Tables stay alive as long as someone holds on to them. Allocates, so
+        call it from prepare(), not from the audio thread.
+    */
+    static std::shared_ptr<const CoefficientTable> getShared (float sampleRate);
+
+    //==============================================================================
+    /** Bilinearly interpolated equivalent of
+        BrownDudaModel::computeEarCoefficients(). Positions outside
+        [-180, 180] degrees are clamped. Exact on grid points.
+    */
+    BrownDudaModel::EarCoefficients lookup (float azimuth, float elevation, int channel) const;
+
+    float getSampleRate() const             { return sampleRate; }
+    float getResolution() const             { return resolution; }
+    size_t getMemoryFootprint() const;
+
+private:
+    //==============================================================================
+    struct AzimuthEntry
+    {
+        float delSamples;
+        float b0, b1;
+        float cos_theta_2; // cos(theta_rad/2) of the pinna delays
+    };
+
+    using ElevationEntry = BrownDudaModel::PinnaTable; // sin(Dk1*(pi/2-elevation)) per pinna event
+
+    float sampleRate;
+    float resolution;
+    float invResolution;
+    int numPoints;
+
+    std::vector<AzimuthEntry> azimuthRow; // left ear
+    std::vector<ElevationEntry> elevationRow;
+};
@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    ConvolutionThreadPool.cpp
+
+  ==============================================================================
+*/
+
+#include "ConvolutionThreadPool.h"
+
+#include <algorithm>
+
+//==============================================================================
+ConvolutionThreadPool::ConvolutionThreadPool (int numThreads)
+{
+    for (int i = 0; i < std::max (1, numThreads); ++i)
+        threads.emplace_back([this] { run(); });
+}
+
+ConvolutionThreadPool::~ConvolutionThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard (lock);
+        stopping = true;
+    }
+
+    wakeUp.notify_all();
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+std::shared_ptr<ConvolutionThreadPool> ConvolutionThreadPool::getShared()
+{
+    static std::mutex sharedLock;
+    static std::weak_ptr<ConvolutionThreadPool> shared;
+
+    std::lock_guard<std::mutex> guard (sharedLock);
+
+    if (auto pool = shared.lock())
+        return pool;
+
+    // hardware_concurrency() may not know, then assume two cores
+    const int numCores = static_cast<int> (std::thread::hardware_concurrency());
+    const int numThreads = std::clamp ((numCores > 0 ? numCores : 2) - 1, 1, maxSharedThreads);
+
+    auto pool = std::make_shared<ConvolutionThreadPool> (numThreads);
+    shared = pool;
+    return pool;
+}
+
+//==============================================================================
+void ConvolutionThreadPool::add (Task* task)
+{
+    {
+        std::lock_guard<std::mutex> guard (lock);
+        tasks.push_back(task);
+    }
+
+    wakeUp.notify_all();
+}
+
+void ConvolutionThreadPool::remove (Task* task)
+{
+    std::unique_lock<std::mutex> guard (lock);
+
+    finished.wait(guard, [task] { return ! task->running; });
+    tasks.erase(std::remove (tasks.begin(), tasks.end(), task), tasks.end());
+}
+
+//==============================================================================
+void ConvolutionThreadPool::run()
+{
+    std::unique_lock<std::mutex> guard (lock);
+
+    while (! stopping)
+    {
+        // Earliest deadline first, among the tasks no other thread is running
+        Task* next = nullptr;
+        int64_t nextDeadline = 0;
+
+        for (auto* task : tasks)
+        {
+            int64_t deadline;
+
+            if (! task->running && task->getNextDeadline(deadline) && (next == nullptr || deadline < nextDeadline))
+            {
+                next = task;
+                nextDeadline = deadline;
+            }
+        }
+
+        if (next == nullptr)
+        {
+            wakeUp.wait_for(guard, pollInterval);
+            continue;
+        }
+
+        next->running = true;
+        guard.unlock();
+
+        next->runNextBlock();
+
+        guard.lock();
+        next->running = false;
+        finished.notify_all();
+    }
+}
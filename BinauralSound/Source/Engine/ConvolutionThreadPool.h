@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    ConvolutionThreadPool.h
+
+    Worker threads for the parts of a convolution that may finish later
+    than the audio callback that started them, e.g. the long tail
+    partitions of a BrirConvolver.
+
+    Work comes in tasks that run one block at a time. A task stays with one
+    thread while it runs a block, so its own state needs no locking, and
+    whenever a thread is free it picks the waiting block with the earliest
+    deadline, over all tasks of all instances (earliest deadline first).
+    Short partitions, which are due soon, therefore overtake long ones that
+    still have time.
+
+    The audio thread never takes the pool's lock. It only publishes blocks
+    through the tasks' own atomics and calls notify(), which wakes a thread
+    without waiting. A thread that misses that wake-up because it was just
+    going to sleep looks again after at most pollInterval, which bounds the
+    extra delay.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//==============================================================================
+/**
+*/
+class ConvolutionThreadPool
+{
+public:
+    //==============================================================================
+    /** Work that can be split into blocks with deadlines. Both functions
+        are called by the pool's threads; runNextBlock() never by two at once.
+    */
+    class Task
+    {
+    public:
+        virtual ~Task() = default;
+
+        /** True if a block is waiting, with the time it is due by in
+            steady_clock nanoseconds.
+        */
+        virtual bool getNextDeadline (int64_t& deadline) const = 0;
+
+        /** Runs the waiting block with the earliest deadline. */
+        virtual void runNextBlock() = 0;
+
+    private:
+        friend class ConvolutionThreadPool;
+        bool running = false; // guarded by the pool's lock
+    };
+
+    //==============================================================================
+    /** Starts numThreads threads. */
+    explicit ConvolutionThreadPool (int numThreads);
+
+    /** Stops and joins the threads. Remove every task first. */
+    ~ConvolutionThreadPool();
+
+    /** The pool shared by every convolver in the process, started on first
+        use with one thread per core, keeping one for the audio thread, and
+        at most maxSharedThreads. It stops when the last user lets go of it.
+        Allocates and starts threads, not for the audio thread.
+    */
+    static std::shared_ptr<ConvolutionThreadPool> getShared();
+
+    static constexpr int maxSharedThreads = 4;
+
+    //==============================================================================
+    /** Makes a task visible to the threads. Not for the audio thread. */
+    void add (Task* task);
+
+    /** Takes a task out, waiting for the block it runs to finish, after
+        which no thread touches it any more. Not for the audio thread.
+    */
+    void remove (Task* task);
+
+    /** Wakes a thread to look for work. Does not wait, so the audio thread
+        calls it after publishing blocks.
+    */
+    void notify()                       { wakeUp.notify_one(); }
+
+    int getNumThreads() const           { return static_cast<int> (threads.size()); }
+
+    /** Longest a sleeping thread can miss a notify(). */
+    static constexpr std::chrono::microseconds pollInterval { 500 };
+
+private:
+    //==============================================================================
+    void run();
+
+    std::mutex lock;
+    std::condition_variable wakeUp; // work to do
+    std::condition_variable finished; // a task finished a block, for remove()
+
+    std::vector<Task*> tasks; // guarded by lock
+    bool stopping = false; // guarded by lock
+
+    std::vector<std::thread> threads;
+};
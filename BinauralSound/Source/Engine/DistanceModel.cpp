@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    DistanceModel.cpp
+
+  ==============================================================================
+*/
+
+#include "DistanceModel.h"
+#include "BrownDudaModel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr double double_Pi = 3.14159265358979323846;
+
+    /** Pole of a unity-DC one-pole low pass whose gain at w (rad/sample) is g. */
+    double onePoleForGain (double g, double w)
+    {
+        if (g >= 1.0)
+            return 0.0;
+
+        // |H(w)|^2 = (1-p)^2 / (1 - 2p cos(w) + p^2) = g^2, smaller root
+        const double g2 = g * g;
+        const double b = 1.0 - g2 * std::cos(w);
+        const double a = 1.0 - g2;
+
+        return (b - std::sqrt(std::max (0.0, b*b - a*a))) / a;
+    }
+}
+
+//==============================================================================
+float DistanceModel::clampDistance (float distance, float maxDistance)
+{
+    return std::clamp (distance, referenceDistance, std::max (referenceDistance, maxDistance));
+}
+
+float DistanceModel::propagationDelay (float distance, float sampleRate)
+{
+    return (distance - referenceDistance) / BrownDudaModel::c * sampleRate;
+}
+
+float DistanceModel::distanceGain (float distance)
+{
+    return referenceDistance / std::max (distance, referenceDistance);
+}
+
+//==============================================================================
+void DistanceModel::AirAbsorptionTable::prepare (float sampleRate, float maxDistance)
+{
+    const int numEntries = static_cast<int> (std::ceil(std::max (0.0f, maxDistance - referenceDistance))) + 2;
+
+    // Stay well below Nyquist at low sample rates
+    const double frequency = std::min (static_cast<double> (airAbsorptionFrequency), 0.4 * sampleRate);
+    const double w = 2 * double_Pi * frequency / sampleRate;
+
+    poles.resize(numEntries);
+
+    for (int i = 0; i < numEntries; ++i)
+    {
+        const double attenuation_dB = airAbsorption_dB * i;
+        poles[i] = static_cast<float> (onePoleForGain(std::pow(10.0, -attenuation_dB/20), w));
+    }
+}
+
+float DistanceModel::AirAbsorptionTable::lookup (float distance) const
+{
+    const float position = std::clamp (distance - referenceDistance, 0.0f, static_cast<float> (poles.size() - 2));
+    const int index = static_cast<int> (position);
+    const float frac = position - index;
+
+    return poles[index] + frac * (poles[index + 1] - poles[index]);
+}
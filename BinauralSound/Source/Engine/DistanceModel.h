@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    DistanceModel.h
+
+    Source range on top of the structural model: propagation delay, inverse
+    distance gain and air absorption.
+
+    The Brown-Duda model places every source on a 1 m sphere around the head
+    and is a far-field model, so that sphere is the reference: a source at
+    1 m renders exactly as before, closer sources are clamped to it. The
+    propagation delay is the extra travel time beyond the reference, added
+    to the ITD delays, so a moving source gets Doppler from the fractional
+    delay reads for free.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+
+//==============================================================================
+namespace DistanceModel
+{
+    //==============================================================================
+    constexpr float referenceDistance = 1.0f; // [m], the radius the model was made for
+
+    /** Sources whose gain stays below this (-80 dB) are not rendered at all. */
+    constexpr float inaudibleGain = 0.0001f;
+
+    // Air absorption at 20 degC and 50 % relative humidity (ISO 9613-1),
+    // matched by a one-pole low pass at this frequency
+    constexpr float airAbsorption_dB = 0.1f; // [dB/m]
+    constexpr float airAbsorptionFrequency = 8000.0f; // [Hz]
+
+    //==============================================================================
+    /** Clamps a distance to [referenceDistance, maxDistance]. */
+    float clampDistance (float distance, float maxDistance);
+
+    /** Travel time beyond the reference distance, in samples. */
+    float propagationDelay (float distance, float sampleRate);
+
+    /** Inverse distance law, 1 at the reference distance. */
+    float distanceGain (float distance);
+
+    //==============================================================================
+    /** Poles of the air absorption low pass, tabulated per metre so the
+        control-rate update is a single interpolated read.
+    */
+    class AirAbsorptionTable
+    {
+    public:
+        /** Allocates the table up to maxDistance. Not for the audio thread. */
+        void prepare (float sampleRate, float maxDistance);
+
+        /** Pole p of y[n] = (1 - p) x[n] + p y[n-1] for a source at this
+            distance. 0 at the reference distance.
+        */
+        float lookup (float distance) const;
+
+    private:
+        std::vector<float> poles; // poles[i] is at referenceDistance + i metres
+    };
+}
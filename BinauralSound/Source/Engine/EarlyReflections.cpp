@@ -0,0 +1,336 @@
+/*
+  ==============================================================================
+
+    EarlyReflections.cpp
+
+  ==============================================================================
+*/
+
+#include "EarlyReflections.h"
+#include "DistanceModel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr float float_Pi = 3.14159265358979323846f;
+    constexpr float toRadians = float_Pi/180;
+    constexpr float toDegrees = 180/float_Pi;
+
+    /** Coordinate of image m along one axis of a room of size L. Odd images
+        are mirrored, even ones shifted by whole room lengths.
+    */
+    float imageCoordinate (float s, float L, int m)
+    {
+        return (m % 2 == 0) ? m*L + s : (m + 1)*L - s;
+    }
+}
+
+//==============================================================================
+void EarlyReflections::prepare (std::shared_ptr<const CoefficientTable> table, float a1, int initLatency, float maxDelay)
+{
+    coefficientTable = std::move (table);
+    a1_head_shadow = a1;
+    gInitLatency = initLatency;
+    gMaxDelay = maxDelay;
+
+    pinnaLineSize = BrownDudaModel::pinnaLineSize(coefficientTable->getSampleRate());
+    pinnaLineMask = pinnaLineSize - 1;
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        pinnaLines[channel].assign(pinnaLineSize, 0.0f);
+        pinnaLines[channel].shrink_to_fit();
+
+        const auto front = coefficientTable->lookup(0.0f, 0.0f, channel);
+
+        for (int iEvent = 0; iEvent < BrownDudaModel::numPinnaEvents; iEvent++)
+            pinnaDelay[channel][iEvent] = static_cast<int> (std::round(front.tau[iEvent]));
+    }
+
+    reset();
+}
+
+void EarlyReflections::reset()
+{
+    for (auto& ear : gain)
+        ear.fill(0.0f);
+
+    for (auto& ear : gain_target)
+        ear.fill(0.0f);
+
+    for (auto& line : pinnaLines)
+        std::fill (line.begin(), line.end(), 0.0f);
+
+    pinnaWritePointer = 0;
+    pinnaLinesStale = false;
+    pinnaTail = 0;
+
+    imagesValid = false;
+    tapsValid = false;
+    delaysValid = false;
+    active = false;
+}
+
+size_t EarlyReflections::getMemoryFootprint() const
+{
+    size_t bytes = sizeof (*this);
+
+    for (auto& line : pinnaLines)
+        bytes += line.capacity() * sizeof (float);
+
+    return bytes;
+}
+
+//==============================================================================
+void EarlyReflections::updateImages (const ShoeboxRoom& room, float azimuth, float elevation, float distance)
+{
+    // Source in room coordinates, same axes as HeadOrientation
+    const float theta = azimuth * toRadians;
+    const float phi = elevation * toRadians;
+
+    const float sx = room.listenerX + distance * std::cos(theta) * std::cos(phi);
+    const float sy = room.listenerY - distance * std::sin(theta);
+    const float sz = room.listenerZ + distance * std::cos(theta) * std::sin(phi);
+
+    const float reflectionGain = std::sqrt(1 - std::clamp (room.absorption, 0.0f, 1.0f));
+
+    numReflections = 0;
+
+    for (int mx = -2; mx <= 2; ++mx)
+    {
+        for (int my = -2; my <= 2; ++my)
+        {
+            for (int mz = -2; mz <= 2; ++mz)
+            {
+                const int order = std::abs (mx) + std::abs (my) + std::abs (mz);
+
+                if (order == 0 || order > 2)
+                    continue;
+
+                auto& image = images[numReflections++];
+                image.x = imageCoordinate(sx, room.length, mx) - room.listenerX;
+                image.y = imageCoordinate(sy, room.width, my) - room.listenerY;
+                image.z = imageCoordinate(sz, room.height, mz) - room.listenerZ;
+                image.wallGain = order == 1 ? reflectionGain : reflectionGain * reflectionGain;
+            }
+        }
+    }
+}
+
+void EarlyReflections::updateTaps (const HeadOrientation& head)
+{
+    const float sampleRate = coefficientTable->getSampleRate();
+
+    for (int r = 0; r < numReflections; ++r)
+    {
+        const auto& image = images[r];
+
+        const float distance = std::max (std::sqrt(image.x*image.x + image.y*image.y + image.z*image.z), 1.0e-3f);
+        const float clampedDistance = std::max (distance, DistanceModel::referenceDistance);
+
+        // Direction the reflection arrives from, then relative to the head
+        float azimuth = std::asin(std::clamp (-image.y / distance, -1.0f, 1.0f)) * toDegrees;
+        float elevation = std::atan2(image.z, image.x) * toDegrees;
+
+        if (! head.isIdentity())
+            head.toHeadRelative(azimuth, elevation);
+
+        const float propagationDelay = DistanceModel::propagationDelay(clampedDistance, sampleRate);
+        const float gain_geometry = image.wallGain * DistanceModel::distanceGain(clampedDistance);
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            const auto coeffs = coefficientTable->lookup(azimuth, elevation, channel);
+
+            // Head shadow as a broadband gain, halfway between its DC and Nyquist gains
+            const float gain_dc = (coeffs.b0 + coeffs.b1) / (1 + a1_head_shadow);
+            const float gain_nyquist = (coeffs.b0 - coeffs.b1) / (1 - a1_head_shadow);
+            const float headShadow = 0.5f * (std::abs(gain_dc) + std::abs(gain_nyquist));
+
+            const float tapDelay = coeffs.delSamples + propagationDelay;
+
+            // Drop reflections the line is too short for
+            delay_target[channel][r] = std::min (tapDelay, gMaxDelay);
+            tapGain[channel][r] = tapDelay <= gMaxDelay ? gain_geometry * headShadow : 0.0f;
+        }
+    }
+}
+
+void EarlyReflections::update (const ShoeboxRoom* room, float azimuth, float elevation, float distance,
+                               const HeadOrientation& head, float volumeGain)
+{
+    if (room == nullptr)
+    {
+        // Fade out, and recompute everything when switched on again
+        for (auto& ear : gain_target)
+            ear.fill(0.0f);
+
+        imagesValid = false;
+        return;
+    }
+
+    if (! imagesValid || *room != cachedRoom || azimuth != cachedAzimuth || elevation != cachedElevation || distance != cachedDistance)
+    {
+        updateImages(*room, azimuth, elevation, distance);
+
+        cachedRoom = *room;
+        cachedAzimuth = azimuth;
+        cachedElevation = elevation;
+        cachedDistance = distance;
+        imagesValid = true;
+        tapsValid = false;
+    }
+
+    if (! tapsValid || head.yaw != cachedHead.yaw || head.pitch != cachedHead.pitch || head.roll != cachedHead.roll)
+    {
+        updateTaps(head);
+
+        cachedHead = head;
+        tapsValid = true;
+    }
+
+    for (int channel = 0; channel < 2; ++channel)
+        for (int r = 0; r < numReflections; ++r)
+            gain_target[channel][r] = tapGain[channel][r] * volumeGain;
+
+    if (! delaysValid)
+    {
+        delay = delay_target;
+        delaysValid = true;
+    }
+
+    active = true;
+}
+
+//==============================================================================
+void EarlyReflections::render (const float* line, int lineSize, int readPointer, float* outL, float* outR, int numSamples)
+{
+    if (! active)
+        return;
+
+    if (pinnaLinesStale)
+    {
+        for (auto& line : pinnaLines)
+            std::fill (line.begin(), line.end(), 0.0f);
+
+        pinnaLinesStale = false;
+    }
+
+    const int lineMask = lineSize - 1;
+    const float ramp = 1.0f / numSamples;
+
+    float sum[2][maxBlockSize] = {};
+    bool audible = false, rendered = false;
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        float* const out = sum[channel];
+
+        for (int r = 0; r < numReflections; ++r)
+        {
+            const float g = gain[channel][r];
+            const float g_target = gain_target[channel][r];
+
+            gain[channel][r] = g_target;
+
+            if (g == 0.0f && g_target == 0.0f)
+            {
+                delay[channel][r] = delay_target[channel][r];
+                continue;
+            }
+
+            audible = audible || g_target != 0.0f;
+            rendered = true;
+
+            const float g_inc = (g_target - g) * ramp;
+
+            float d = delay[channel][r];
+            const float d_inc = (delay_target[channel][r] - d) * ramp;
+
+            delay[channel][r] = delay_target[channel][r];
+
+            if (d_inc == 0.0f)
+            {
+                // Static tap: one fractional read position for the whole block
+                const float d_floor = std::floor(d);
+                const float frac_part = d - d_floor;
+                const int tapPointer = (readPointer - static_cast<int>(d_floor)) & lineMask;
+
+                if (tapPointer >= 1 && tapPointer + numSamples <= lineSize)
+                {
+                    // No wrap around in this block, so this loop vectorises
+                    const float* const read = line + tapPointer;
+
+                    for (int i = 0; i < numSamples; ++i)
+                        out[i] += (g + g_inc * (i + 1)) * (frac_part*read[i - 1] + (1-frac_part)*read[i]);
+                }
+                else
+                {
+                    for (int i = 0; i < numSamples; ++i)
+                        out[i] += (g + g_inc * (i + 1)) * (frac_part*line[(tapPointer + i - 1) & lineMask] + (1-frac_part)*line[(tapPointer + i) & lineMask]);
+                }
+            }
+            else
+            {
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    d += d_inc;
+                    float d_floor = std::floor(d);
+                    float frac_part = d - d_floor;
+
+                    int outPointer = (readPointer + i - 1 - static_cast<int>(d_floor)) & lineMask;
+                    int outPointer_frac = (readPointer + i - static_cast<int>(d_floor)) & lineMask;
+
+                    out[i] += (g + g_inc * (i + 1)) * (frac_part*line[outPointer] + (1-frac_part)*line[outPointer_frac]);
+                }
+            }
+        }
+    }
+
+    // PINNA MODEL, shared by all reflections of this ear
+    float* const outputs[2] = { outL, outR };
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        float* const line = pinnaLines[channel].data();
+        float* const out = outputs[channel];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const int writePointer = (pinnaWritePointer + i) & pinnaLineMask;
+            line[writePointer] = sum[channel][i];
+
+            float outVal_post_pinnae = 0;
+            for (int iEvent = 0; iEvent < BrownDudaModel::numPinnaEvents; iEvent++)
+                outVal_post_pinnae += BrownDudaModel::rho_k[iEvent] * line[(writePointer - gInitLatency - pinnaDelay[channel][iEvent]) & pinnaLineMask];
+
+            out[i] += outVal_post_pinnae;
+        }
+    }
+
+    pinnaWritePointer = (pinnaWritePointer + numSamples) & pinnaLineMask;
+
+    // Keep going until what was written has come out of the pinna lines
+    if (rendered)
+        pinnaTail = gInitLatency + static_cast<int> (BrownDudaModel::maxPinnaDelay) + 1;
+    else
+        pinnaTail -= numSamples;
+
+    active = audible || pinnaTail > 0;
+}
+
+void EarlyReflections::land()
+{
+    delay = delay_target;
+    gain = gain_target;
+    pinnaLinesStale = true;
+    pinnaTail = 0;
+
+    active = false;
+
+    for (auto& ear : gain_target)
+        for (int r = 0; r < numReflections; ++r)
+            active = active || ear[r] != 0.0f;
+}
@@ -0,0 +1,154 @@
+/*
+  ==============================================================================
+
+    EarlyReflections.h
+
+    First and second order wall reflections of one source in a shoebox
+    room, from the image-source model.
+
+    Every reflection becomes one tap per ear on the source's input line,
+    rendered at reduced quality: it gets the ITD and propagation delay of
+    its image, 1/r and wall losses, and the head shadow as a broadband gain
+    (the mean of the filter's DC and Nyquist gains). All taps of a source
+    are read in one pass per control block with their delays and gains
+    ramped like the direct path, so 24 reflections cost a few multiply-adds
+    per sample each. Their sum goes through one pinna model per ear with
+    fixed, whole-sample delays (those of a source straight ahead), so the
+    reflections keep the spectral shape and the latency of the direct path.
+
+    The geometry is cached: image positions are only recomputed when the
+    room or the source moves, and the taps when the images or the
+    listener's head move.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "CoefficientTable.h"
+#include "HeadOrientation.h"
+
+//==============================================================================
+/** A rectangular room, with the listener somewhere inside it. Positions are
+    in metres from the back, right, bottom corner, with x to the front, y to
+    the left and z up, the listener facing along x.
+*/
+struct ShoeboxRoom
+{
+    float length = 8, width = 6, height = 3; // [m] along x, y and z
+    float listenerX = 4, listenerY = 3, listenerZ = 1.2f; // [m]
+    float absorption = 0.3f; // energy lost per wall bounce, 0 to 1
+
+    bool operator== (const ShoeboxRoom& other) const
+    {
+        return length == other.length && width == other.width && height == other.height
+            && listenerX == other.listenerX && listenerY == other.listenerY && listenerZ == other.listenerZ
+            && absorption == other.absorption;
+    }
+
+    bool operator!= (const ShoeboxRoom& other) const    { return ! (*this == other); }
+};
+
+//==============================================================================
+/**
+*/
+class EarlyReflections
+{
+public:
+    //==============================================================================
+    static constexpr int maxReflections = 24; // 6 first order, 18 second order
+
+    /** Longest block render() takes, one control block. */
+    static constexpr int maxBlockSize = 32;
+
+    //==============================================================================
+    /** maxDelay is the longest delay in samples the input line can serve;
+        reflections arriving later are dropped. initLatency is the one of
+        the direct path's pinna taps. Allocates, not for the audio thread.
+    */
+    void prepare (std::shared_ptr<const CoefficientTable> table, float a1_head_shadow, int initLatency, float maxDelay);
+
+    /** Forgets the cached geometry and fades the next reflections in. */
+    void reset();
+
+    /** Sets the targets of the next control block for a source at this
+        position in room (not head-relative) coordinates, heard with the
+        head in the given orientation. volumeGain is the source level
+        without its distance gain. A null room fades the reflections out.
+    */
+    void update (const ShoeboxRoom* room, float azimuth, float elevation, float distance,
+                 const HeadOrientation& head, float volumeGain);
+
+    /** Adds numSamples (at most maxBlockSize) of all taps to outL / outR
+        and lands on the targets. readPointer is where the direct path reads
+        the first sample of the block (write position minus the initial
+        latency), line is the source's input line of power of two size
+        lineSize.
+    */
+    void render (const float* line, int lineSize, int readPointer, float* outL, float* outR, int numSamples);
+
+    /** Jumps to the targets without rendering, for skipped control blocks. */
+    void land();
+
+    /** False once the reflections have faded out, render() can be skipped. */
+    bool isActive() const                   { return active; }
+
+    int getNumReflections() const           { return numReflections; }
+
+    /** Where the last update() sent one reflection at one ear: its delay
+        in samples behind the direct path's read position, and its gain.
+    */
+    float getTargetDelay (int channel, int reflection) const    { return delay_target[channel][reflection]; }
+    float getTargetGain (int channel, int reflection) const     { return gain_target[channel][reflection]; }
+
+    /** Bytes used, including the pinna lines but not the shared table. */
+    size_t getMemoryFootprint() const;
+
+private:
+    //==============================================================================
+    void updateImages (const ShoeboxRoom& room, float azimuth, float elevation, float distance);
+    void updateTaps (const HeadOrientation& head);
+
+    //==============================================================================
+    std::shared_ptr<const CoefficientTable> coefficientTable;
+    float a1_head_shadow = 0;
+    float gMaxDelay = 0;
+    int gInitLatency = 16;
+
+    // Pinna model of the summed reflections, one line per ear
+    int pinnaLineSize = 0;
+    int pinnaLineMask = 0;
+    std::array<std::vector<float>, 2> pinnaLines;
+    int pinnaWritePointer = 0;
+    std::array<std::array<int, BrownDudaModel::numPinnaEvents>, 2> pinnaDelay; // [samples], behind the initial latency
+    bool pinnaLinesStale = false; // hold samples from before skipped blocks
+    int pinnaTail = 0; // samples until the last reflection has left the pinna lines
+
+    // Image sources relative to the listener, in room coordinates
+    struct Image
+    {
+        float x, y, z;
+        float wallGain; // pressure reflection coefficient ^ order
+    };
+
+    std::array<Image, maxReflections> images;
+    int numReflections = 0;
+
+    // What the cache was computed for
+    ShoeboxRoom cachedRoom;
+    float cachedAzimuth = 0, cachedElevation = 0, cachedDistance = 0;
+    HeadOrientation cachedHead;
+    bool imagesValid = false, tapsValid = false;
+
+    // Per ear, per reflection. tapGain is the geometric part of the gain,
+    // gain also includes the source volume.
+    std::array<std::array<float, maxReflections>, 2> delay, delay_target; // [samples]
+    std::array<std::array<float, maxReflections>, 2> tapGain, gain, gain_target;
+
+    bool delaysValid = false; // jump to the first delays instead of gliding from 0
+    bool active = false;
+};
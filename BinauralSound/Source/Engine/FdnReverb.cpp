@@ -0,0 +1,291 @@
+/*
+  ==============================================================================
+
+    FdnReverb.cpp
+
+  ==============================================================================
+*/
+
+#include "FdnReverb.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    // Line lengths at the largest size [ms], spread out and without common
+    // factors so the echoes do not line up. With 8 lines every other one is
+    // used.
+    constexpr float lineLengths_ms[FdnReverb::maxNumLines] = {
+        23.1f, 27.7f, 31.3f, 35.9f, 40.1f, 44.3f, 49.7f, 53.9f,
+        59.3f, 63.7f, 69.1f, 73.3f, 79.7f, 84.1f, 89.3f, 97.1f
+    };
+
+    constexpr float minScale = 0.25f; // line lengths at size 0, relative to size 1
+    constexpr float minDecayTime = 0.05f; // [s]
+
+    int nextPowerOfTwo (int n)
+    {
+        int size = 1;
+        while (size < n)
+            size <<= 1;
+        return size;
+    }
+}
+
+//==============================================================================
+void FdnReverb::prepare (double sampleRate, int numLinesToUse)
+{
+    gSampleRate = static_cast<float> (sampleRate);
+    numLines = numLinesToUse <= 8 ? 8 : maxNumLines;
+
+    lineSize = nextPowerOfTwo(static_cast<int> (std::ceil(lineLengths_ms[maxNumLines - 1] * 0.001f * gSampleRate)) + 2);
+    lineMask = lineSize - 1;
+
+    gDelayBuffer.assign(static_cast<size_t> (numLines) * lineSize, 0.0f);
+    gDelayBuffer.shrink_to_fit();
+
+    setSmoothingTime(gSmoothingTime);
+
+    reset();
+}
+
+void FdnReverb::setSmoothingTime (double seconds)
+{
+    gSmoothingTime = std::max (0.0, seconds);
+
+    const int rampLength = static_cast<int> (std::round (gSmoothingTime * gSampleRate));
+
+    for (auto* smoother : { &size_smoothed, &decay_smoothed, &wet_smoothed })
+        smoother->setRampLength(rampLength);
+}
+
+void FdnReverb::reset()
+{
+    // The lines are cleared when the reverb next becomes active
+    gWritePointer = 0;
+    wet_smoothed.setCurrentAndTarget(0.0f);
+
+    idle = true;
+    linesValid = false;
+}
+
+size_t FdnReverb::getMemoryFootprint() const
+{
+    return sizeof (*this) + gDelayBuffer.capacity() * sizeof (float);
+}
+
+//==============================================================================
+void FdnReverb::updateLines (float size, float decayTime)
+{
+    if (size == lastSize && decayTime == lastDecay)
+        return;
+
+    lastSize = size;
+    lastDecay = decayTime;
+
+    const float scale = minScale + (1 - minScale) * std::clamp (size, 0.0f, 1.0f);
+    const float rt60 = std::max (decayTime, minDecayTime) * gSampleRate; // [samples]
+    const int stride = maxNumLines / numLines;
+
+    for (int k = 0; k < numLines; ++k)
+    {
+        // Every line must hold at least a control block, see process()
+        const float delay = std::max (lineLengths_ms[k * stride] * 0.001f * scale * gSampleRate, static_cast<float> (kControlBlockSize));
+        const float g = std::pow(10.0f, -3 * delay / rt60);
+
+        delay_target[k] = delay;
+        gain[k] = g;
+
+        // DC gain g, gain g^2 at Nyquist: high frequencies decay twice as fast
+        dampingPole[k] = (1 - g) / (1 + g);
+    }
+}
+
+//==============================================================================
+void FdnReverb::process (const float* send, float* outL, float* outR, int n)
+{
+    if (! isActive())
+    {
+        idle = true;
+        return;
+    }
+
+    if (idle)
+    {
+        // Whatever is left in the lines is from before the reverb was muted
+        std::fill (gDelayBuffer.begin(), gDelayBuffer.end(), 0.0f);
+        dampingState.fill(0.0f);
+        idle = false;
+    }
+
+    const float mixGain = 1 / std::sqrt(static_cast<float> (numLines)); // normalises the Hadamard matrix
+    const float inputGain = mixGain;
+    const float outputGain = std::sqrt(2 / static_cast<float> (numLines));
+
+    for (int start = 0; start < n; start += kControlBlockSize)
+    {
+        const int numSamples = std::min (kControlBlockSize, n - start);
+        const float ramp = 1.0f / numSamples;
+
+        if (! linesValid)
+        {
+            size_smoothed.setCurrentAndTarget(gSize_param);
+            decay_smoothed.setCurrentAndTarget(gDecay_param);
+        }
+
+        // Parameter values at the end of this control block
+        updateLines(size_smoothed.getNext(gSize_param, numSamples), decay_smoothed.getNext(gDecay_param, numSamples));
+
+        const float wet_start = wet_smoothed.getCurrentValue();
+        const float wet_inc = (wet_smoothed.getNext(gWet_param, numSamples) - wet_start) * ramp;
+
+        if (! linesValid)
+        {
+            delay_current = delay_target;
+            linesValid = true;
+        }
+
+        // Read the whole control block from every line. All delays are at
+        // least a control block long, so none of it is written yet.
+        for (int k = 0; k < numLines; ++k)
+        {
+            const float* const line = gDelayBuffer.data() + static_cast<size_t> (k) * lineSize;
+            float* const row = block[k].data();
+
+            float delay = delay_current[k];
+            const float delay_inc = (delay_target[k] - delay_current[k]) * ramp;
+
+            if (delay_inc == 0.0f)
+            {
+                // Size not changing: the read position moves with the write position
+                const float delay_floor = std::floor(delay);
+                const float frac_part = delay - delay_floor;
+                const int readPointer = (gWritePointer - static_cast<int>(delay_floor)) & lineMask;
+
+                if (readPointer >= 1 && readPointer + numSamples <= lineSize)
+                {
+                    // No wrap around in this block, so this loop vectorises
+                    const float* const read = line + readPointer;
+
+                    for (int i = 0; i < numSamples; ++i)
+                        row[i] = frac_part*read[i - 1] + (1-frac_part)*read[i];
+                }
+                else
+                {
+                    for (int i = 0; i < numSamples; ++i)
+                        row[i] = frac_part*line[(readPointer + i - 1) & lineMask] + (1-frac_part)*line[(readPointer + i) & lineMask];
+                }
+            }
+            else
+            {
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    delay += delay_inc;
+                    float delay_floor = std::floor(delay);
+                    float frac_part = delay - delay_floor;
+
+                    int outPointer = (gWritePointer + i - 1 - static_cast<int>(delay_floor)) & lineMask;
+                    int outPointer_frac = (gWritePointer + i - static_cast<int>(delay_floor)) & lineMask;
+
+                    row[i] = frac_part*line[outPointer] + (1-frac_part)*line[outPointer_frac];
+                }
+            }
+
+            delay_current[k] = delay_target[k];
+        }
+
+        // Damping. The recursion runs across the lines, so each step is
+        // independent work for every line instead of one long dependency
+        // chain per line.
+        {
+            float z[maxNumLines], p[maxNumLines], g[maxNumLines];
+
+            for (int k = 0; k < numLines; ++k)
+            {
+                z[k] = dampingState[k];
+                p[k] = dampingPole[k];
+                g[k] = gain[k];
+            }
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                for (int k = 0; k < numLines; ++k)
+                {
+                    z[k] = (1-p[k])*block[k][i] + p[k]*z[k];
+                    block[k][i] = g[k]*z[k];
+                }
+            }
+
+            for (int k = 0; k < numLines; ++k)
+                dampingState[k] = z[k];
+        }
+
+        // Even lines to the left ear, odd lines to the right
+        float sumL[kControlBlockSize] = {}, sumR[kControlBlockSize] = {};
+
+        for (int k = 0; k < numLines; k += 2)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                sumL[i] += block[k][i];
+                sumR[i] += block[k + 1][i];
+            }
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float wet = (wet_start + wet_inc * (i + 1)) * outputGain;
+
+            outL[start + i] += wet * sumL[i];
+            outR[start + i] += wet * sumR[i];
+        }
+
+        // Feedback matrix: fast Walsh-Hadamard transform across the lines,
+        // one butterfly per pair of rows
+        for (int h = 1; h < numLines; h *= 2)
+        {
+            for (int j = 0; j < numLines; j += 2 * h)
+            {
+                for (int k = j; k < j + h; ++k)
+                {
+                    float* const a = block[k].data();
+                    float* const b = block[k + h].data();
+
+                    for (int i = 0; i < numSamples; ++i)
+                    {
+                        const float sum = a[i] + b[i];
+                        const float difference = a[i] - b[i];
+                        a[i] = sum;
+                        b[i] = difference;
+                    }
+                }
+            }
+        }
+
+        // Write back with the send, alternating its sign across the lines
+        const bool wraps = gWritePointer + numSamples > lineSize;
+
+        for (int k = 0; k < numLines; ++k)
+        {
+            float* const line = gDelayBuffer.data() + static_cast<size_t> (k) * lineSize;
+            const float* const row = block[k].data();
+            const float lineInputGain = (k & 1) != 0 ? -inputGain : inputGain;
+
+            if (! wraps)
+            {
+                float* const write = line + gWritePointer;
+
+                for (int i = 0; i < numSamples; ++i)
+                    write[i] = mixGain * row[i] + lineInputGain * send[start + i];
+            }
+            else
+            {
+                for (int i = 0; i < numSamples; ++i)
+                    line[(gWritePointer + i) & lineMask] = mixGain * row[i] + lineInputGain * send[start + i];
+            }
+        }
+
+        gWritePointer = (gWritePointer + numSamples) & lineMask;
+    }
+}
@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    FdnReverb.h
+
+    Late reverb bus: a feedback delay network with 8 or 16 lines, fed by a
+    mono send and added to the binaural output.
+
+    Each line has a one-pole damping filter whose gain gives the requested
+    decay time at DC and half of it at Nyquist. The lines are mixed through
+    a normalised Hadamard matrix, applied as a fast Walsh-Hadamard transform
+    on whole control blocks: every line is at least one control block long,
+    so a block can be read from all lines before any of it is written back,
+    and each butterfly is an add/subtract of two contiguous rows that the
+    compiler vectorises. Even lines feed the left ear and odd lines the
+    right one, which keeps the two ears decorrelated.
+
+    One bus serves any number of sources, so the reverb costs the same
+    whether one source or hundreds send to it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "ParameterSmoother.h"
+
+//==============================================================================
+/**
+*/
+class FdnReverb
+{
+public:
+    //==============================================================================
+    static constexpr int maxNumLines = 16;
+
+    /** Number of samples between two updates of the delays and gains. */
+    static constexpr int kControlBlockSize = 32;
+
+    //==============================================================================
+    FdnReverb() = default;
+
+    /** Allocates the lines. numLines is 8 or 16. Not for the audio thread. */
+    void prepare (double sampleRate, int numLines = maxNumLines);
+
+    /** Clears the lines and filter states without reallocating. */
+    void reset();
+
+    /** Runs the network on n samples of the send and adds the result, scaled
+        by the wet level, to outL / outR. Does nothing while the wet level is
+        0; the tail starts from silence when it is raised again.
+    */
+    void process (const float* send, float* outL, float* outR, int n);
+
+    //==============================================================================
+    // These set targets; process() glides to them over the smoothing time.
+    void setSize (float newSize)            { gSize_param = newSize; } // 0 (small) to 1 (large)
+    void setDecayTime (float seconds)       { gDecay_param = seconds; } // RT60 at DC
+    void setWet (float newWet)              { gWet_param = newWet; } // linear gain of the reverb output
+
+    float getSize() const                   { return gSize_param; }
+    float getDecayTime() const              { return gDecay_param; }
+    float getWet() const                    { return gWet_param; }
+
+    void setSmoothingTime (double seconds);
+
+    /** False while the wet level is and stays at 0, so callers can skip
+        filling the send.
+    */
+    bool isActive() const                   { return gWet_param > 0.0f || wet_smoothed.getCurrentValue() > 0.0f; }
+
+    int getNumLines() const                 { return numLines; }
+
+    size_t getMemoryFootprint() const;
+
+private:
+    //==============================================================================
+    void updateLines (float size, float decayTime);
+
+    //==============================================================================
+    // BUFFER STUFF
+    // One power of two line per FDN line, all sharing the write position.
+    int numLines = maxNumLines;
+    int lineSize = 0;
+    int lineMask = 0;
+
+    std::vector<float> gDelayBuffer; // [line][lineSize]
+    int gWritePointer = 0;
+
+    // One control block per line: what was read, then what is written back
+    std::array<std::array<float, kControlBlockSize>, maxNumLines> block;
+
+
+    //==============================================================================
+    // AUDIO PARAMS
+    float gSize_param = 0.5f;
+    float gDecay_param = 1.5f; // [s]
+    float gWet_param = 0.0f;
+
+    ParameterSmoother size_smoothed, decay_smoothed, wet_smoothed;
+    double gSmoothingTime = 0.05; // [s]
+
+    float gSampleRate = 44100.0f;
+
+
+    //==============================================================================
+    // CONTROL RATE
+    std::array<float, maxNumLines> delay_current, delay_target; // [samples]
+    std::array<float, maxNumLines> gain; // feedback gain of each line
+    std::array<float, maxNumLines> dampingPole;
+    std::array<float, maxNumLines> dampingState;
+
+    float lastSize = -1, lastDecay = -1; // updateLines() skips unchanged values
+    bool linesValid = false; // jump straight to the targets after prepare() / reset()
+    bool idle = true; // the lines hold nothing worth playing
+};
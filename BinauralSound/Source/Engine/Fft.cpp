@@ -0,0 +1,159 @@
+/*
+  ==============================================================================
+
+    Fft.cpp
+
+  ==============================================================================
+*/
+
+#include "Fft.h"
+
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+    constexpr double double_Pi = 3.14159265358979323846;
+}
+
+//==============================================================================
+Fft::Fft (int order)
+    : size (1 << order),
+      half (size / 2)
+{
+    assert (order >= 2);
+
+    const int halfOrder = order - 1;
+
+    bitReversed.resize(half);
+
+    for (int n = 0; n < half; ++n)
+    {
+        int reversed = 0;
+        for (int bit = 0; bit < halfOrder; ++bit)
+            reversed |= ((n >> bit) & 1) << (halfOrder - 1 - bit);
+
+        bitReversed[n] = reversed;
+    }
+
+    cosTable.resize(half / 2);
+    sinTable.resize(half / 2);
+
+    for (int k = 0; k < half / 2; ++k)
+    {
+        cosTable[k] = static_cast<float> (std::cos(2 * double_Pi * k / half));
+        sinTable[k] = static_cast<float> (std::sin(2 * double_Pi * k / half));
+    }
+
+    splitCos.resize(half + 1);
+    splitSin.resize(half + 1);
+
+    for (int k = 0; k <= half; ++k)
+    {
+        splitCos[k] = static_cast<float> (std::cos(2 * double_Pi * k / size));
+        splitSin[k] = static_cast<float> (std::sin(2 * double_Pi * k / size));
+    }
+
+    workRe.resize(half);
+    workIm.resize(half);
+}
+
+//==============================================================================
+void Fft::transform (float* re, float* im, bool inverse) const
+{
+    // Radix-2 decimation in time on bit reversed input
+    const float sign = inverse ? 1.0f : -1.0f;
+
+    for (int length = 2; length <= half; length *= 2)
+    {
+        const int halfLength = length / 2;
+        const int step = half / length;
+
+        for (int start = 0; start < half; start += length)
+        {
+            for (int j = 0; j < halfLength; ++j)
+            {
+                const float wr = cosTable[j * step];
+                const float wi = sign * sinTable[j * step];
+
+                const int a = start + j;
+                const int b = a + halfLength;
+
+                const float tr = wr*re[b] - wi*im[b];
+                const float ti = wr*im[b] + wi*re[b];
+
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+void Fft::forward (const float* input, float* re, float* im) const
+{
+    float* const zr = workRe.data();
+    float* const zi = workIm.data();
+
+    // Even samples as the real part, odd ones as the imaginary part
+    for (int n = 0; n < half; ++n)
+    {
+        zr[bitReversed[n]] = input[2*n];
+        zi[bitReversed[n]] = input[2*n + 1];
+    }
+
+    transform(zr, zi, false);
+
+    // Split into the spectra of the even and odd samples and recombine:
+    // X[k] = E[k] + e^(-2 pi i k / size) O[k]
+    re[0] = zr[0] + zi[0];
+    im[0] = 0;
+    re[half] = zr[0] - zi[0];
+    im[half] = 0;
+
+    for (int k = 1; k < half; ++k)
+    {
+        const float ar = zr[k], ai = zi[k];
+        const float br = zr[half - k], bi = -zi[half - k]; // conjugate of the mirrored bin
+
+        const float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+        const float or_ = 0.5f * (ai - bi), oi = -0.5f * (ar - br); // (a - b) / 2i
+
+        const float wr = splitCos[k], wi = -splitSin[k];
+
+        re[k] = er + wr*or_ - wi*oi;
+        im[k] = ei + wr*oi + wi*or_;
+    }
+}
+
+void Fft::inverse (const float* re, const float* im, float* output) const
+{
+    float* const zr = workRe.data();
+    float* const zi = workIm.data();
+
+    // Undo the split: E[k] = X[k] + conj(X[half - k]),
+    // O[k] = (X[k] - conj(X[half - k])) e^(2 pi i k / size), then z = E + iO
+    for (int k = 0; k < half; ++k)
+    {
+        const float ar = re[k], ai = k == 0 ? 0.0f : im[k];
+        const float br = re[half - k], bi = k == 0 ? 0.0f : -im[half - k];
+
+        const float er = ar + br, ei = ai + bi;
+        const float dr = ar - br, di = ai - bi;
+
+        const float wr = splitCos[k], wi = splitSin[k];
+        const float or_ = dr*wr - di*wi, oi = dr*wi + di*wr;
+
+        zr[bitReversed[k]] = er - oi;
+        zi[bitReversed[k]] = ei + or_;
+    }
+
+    transform(zr, zi, true);
+
+    for (int n = 0; n < half; ++n)
+    {
+        output[2*n] = zr[n];
+        output[2*n + 1] = zi[n];
+    }
+}
@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    Fft.h
+
+    Real-only FFT of power of two size, for the convolution engines.
+
+    A real signal of size N is transformed as a complex one of size N/2
+    (even samples as the real part, odd samples as the imaginary part) and
+    then split into the N/2 + 1 bins of the real spectrum. Spectra are kept
+    as separate real and imaginary arrays, so the complex multiply-adds of
+    a convolution are plain float loops that the compiler vectorises.
+
+    forward() and inverse() share work buffers, so an instance must not be
+    used from two threads at once.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+
+//==============================================================================
+/**
+*/
+class Fft
+{
+public:
+    //==============================================================================
+    /** Prepares the tables for a transform of 2^order real samples.
+        Allocates, not for the audio thread.
+    */
+    explicit Fft (int order);
+
+    int getSize() const                 { return size; }
+    int getNumBins() const              { return size / 2 + 1; }
+
+    //==============================================================================
+    /** Spectrum of size real samples, written to getNumBins() bins.
+        Does not allocate.
+    */
+    void forward (const float* input, float* re, float* im) const;
+
+    /** Real signal of the spectrum in getNumBins() bins, scaled by getSize()
+        (forward then inverse multiplies by the size). The imaginary parts of
+        the first and last bin are ignored. Does not allocate.
+    */
+    void inverse (const float* re, const float* im, float* output) const;
+
+private:
+    //==============================================================================
+    void transform (float* re, float* im, bool inverse) const; // complex, in place, size / 2 points
+
+    int size;
+    int half;
+
+    std::vector<int> bitReversed;
+    std::vector<float> cosTable, sinTable; // complex twiddles e^(-2 pi i k / half)
+    std::vector<float> splitCos, splitSin; // real split twiddles e^(-2 pi i k / size)
+
+    // Work buffers for the half size transform, see forward() and inverse()
+    mutable std::vector<float> workRe, workIm;
+};
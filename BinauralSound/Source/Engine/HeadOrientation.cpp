@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    HeadOrientation.cpp
+
+  ==============================================================================
+*/
+
+#include "HeadOrientation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr float float_Pi = 3.14159265358979323846f;
+    constexpr float toRadians = float_Pi/180;
+    constexpr float toDegrees = 180/float_Pi;
+
+    float interpolateAngle (float a, float b, float t)
+    {
+        // Shortest way from a to b, wrapped to [-180, 180)
+        float difference = std::fmod(b - a + 180.0f, 360.0f);
+        if (difference < 0)
+            difference += 360.0f;
+
+        return a + (difference - 180.0f) * t;
+    }
+
+    /** Undoes the head rotation: yaw about z, then pitch about y, then roll about x. */
+    void undoRotation (const HeadOrientation& head, float& x, float& y, float& z)
+    {
+        const float cy = std::cos(head.yaw * toRadians), sy = std::sin(head.yaw * toRadians);
+        const float x1 = cy*x + sy*y;
+        const float y1 = -sy*x + cy*y;
+
+        const float cp = std::cos(head.pitch * toRadians), sp = std::sin(head.pitch * toRadians);
+        const float x2 = cp*x1 + sp*z;
+        const float z2 = -sp*x1 + cp*z;
+
+        const float cr = std::cos(head.roll * toRadians), sr = std::sin(head.roll * toRadians);
+        const float y3 = cr*y1 + sr*z2;
+        const float z3 = -sr*y1 + cr*z2;
+
+        x = x2; y = y3; z = z3;
+    }
+}
+
+//==============================================================================
+HeadOrientation HeadOrientation::interpolate (const HeadOrientation& a, const HeadOrientation& b, float t)
+{
+    HeadOrientation result;
+    result.yaw = interpolateAngle(a.yaw, b.yaw, t);
+    result.pitch = interpolateAngle(a.pitch, b.pitch, t);
+    result.roll = interpolateAngle(a.roll, b.roll, t);
+    return result;
+}
+
+void HeadOrientation::toHeadRelative (float& azimuth, float& elevation) const
+{
+    // Direction of the source with x to the front, y to the left and z up
+    const float theta = azimuth * toRadians;
+    const float phi = elevation * toRadians;
+
+    float x = std::cos(theta) * std::cos(phi);
+    float y = -std::sin(theta);
+    float z = std::cos(theta) * std::sin(phi);
+
+    undoRotation(*this, x, y, z);
+
+    azimuth = std::asin(std::clamp(-y, -1.0f, 1.0f)) * toDegrees;
+    elevation = std::atan2(z, x) * toDegrees;
+}
+
+HeadOrientation::Matrix HeadOrientation::getHeadRelativeMatrix() const
+{
+    // Columns are the rotated basis vectors
+    Matrix m;
+
+    for (int j = 0; j < 3; ++j)
+    {
+        float v[3] = { 0, 0, 0 };
+        v[j] = 1;
+        undoRotation(*this, v[0], v[1], v[2]);
+
+        for (int i = 0; i < 3; ++i)
+            m[i][j] = v[i];
+    }
+
+    return m;
+}
@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    HeadOrientation.h
+
+    Listener head orientation from a head tracker, and the counter-rotation
+    of a source position into head-relative coordinates.
+
+    Source positions use the model's interaural-polar angles: azimuth is the
+    angle from the median plane (positive to the right), elevation the angle
+    around the interaural axis (0 in front, 90 above, +-180 behind).
+
+    Head orientation is yaw, pitch, roll in degrees, applied in that order:
+    positive yaw turns the head to the left, positive pitch tilts the nose
+    up and positive roll tilts the right ear down.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+
+//==============================================================================
+/**
+*/
+struct HeadOrientation
+{
+    float yaw = 0, pitch = 0, roll = 0; // [deg]
+
+    bool isIdentity() const     { return yaw == 0 && pitch == 0 && roll == 0; }
+
+    /** Moves from a to b as t goes from 0 to 1, each angle along its shorter
+        way round.
+    */
+    static HeadOrientation interpolate (const HeadOrientation& a, const HeadOrientation& b, float t);
+
+    /** Turns a position fixed in the room into the position the listener
+        hears with the head in this orientation.
+    */
+    void toHeadRelative (float& azimuth, float& elevation) const;
+
+    /** The same rotation as a matrix acting on unit vectors with x to the
+        front, y to the left and z up: headRelative[i] = sum of m[i][j] * room[j].
+    */
+    using Matrix = std::array<std::array<float, 3>, 3>;
+    Matrix getHeadRelativeMatrix() const;
+};
@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+    HeadTrackerPacket.cpp
+
+  ==============================================================================
+*/
+
+#include "HeadTrackerPacket.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+    //==============================================================================
+    // OSC is big endian, the binary format little endian
+    uint32_t readBigEndian32 (const char* p)
+    {
+        const auto* b = reinterpret_cast<const unsigned char*> (p);
+        return (uint32_t (b[0]) << 24) | (uint32_t (b[1]) << 16) | (uint32_t (b[2]) << 8) | uint32_t (b[3]);
+    }
+
+    uint64_t readBigEndian64 (const char* p)
+    {
+        return (uint64_t (readBigEndian32 (p)) << 32) | readBigEndian32 (p + 4);
+    }
+
+    uint32_t readLittleEndian32 (const char* p)
+    {
+        const auto* b = reinterpret_cast<const unsigned char*> (p);
+        return (uint32_t (b[3]) << 24) | (uint32_t (b[2]) << 16) | (uint32_t (b[1]) << 8) | uint32_t (b[0]);
+    }
+
+    uint64_t readLittleEndian64 (const char* p)
+    {
+        return (uint64_t (readLittleEndian32 (p + 4)) << 32) | readLittleEndian32 (p);
+    }
+
+    template <typename Float, typename Int>
+    Float bitCast (Int bits)
+    {
+        static_assert (sizeof (Float) == sizeof (Int), "size mismatch");
+        Float value;
+        std::memcpy (&value, &bits, sizeof (value));
+        return value;
+    }
+
+    //==============================================================================
+    /** Length of the padded OSC string at p, or 0 if it is not terminated
+        within size bytes.
+    */
+    int oscStringSize (const char* p, int size)
+    {
+        const void* end = std::memchr (p, 0, static_cast<size_t> (size));
+
+        if (end == nullptr)
+            return 0;
+
+        const int length = static_cast<int> (static_cast<const char*> (end) - p);
+        return (length + 4) & ~3;
+    }
+
+    bool parseOscMessage (const char* data, int size, HeadOrientation& orientation, double& sentTime)
+    {
+        const int addressSize = oscStringSize (data, size);
+
+        if (addressSize == 0 || (std::strcmp (data, "/head/ypr") != 0 && std::strcmp (data, "/ypr") != 0))
+            return false;
+
+        const char* tags = data + addressSize;
+        const int tagsSize = oscStringSize (tags, size - addressSize);
+
+        if (tagsSize == 0 || tags[0] != ',')
+            return false;
+
+        const char* arg = tags + tagsSize;
+        const char* const end = data + size;
+
+        double values[4] = {};
+        int numValues = 0;
+
+        for (const char* tag = tags + 1; *tag != 0 && numValues < 4; ++tag)
+        {
+            if (*tag == 'f' || *tag == 'i')
+            {
+                if (end - arg < 4)
+                    return false;
+
+                const uint32_t bits = readBigEndian32 (arg);
+                values[numValues++] = *tag == 'f' ? bitCast<float> (bits) : static_cast<double> (static_cast<int32_t> (bits));
+                arg += 4;
+            }
+            else if (*tag == 'd')
+            {
+                if (end - arg < 8)
+                    return false;
+
+                values[numValues++] = bitCast<double> (readBigEndian64 (arg));
+                arg += 8;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        if (numValues < 3)
+            return false;
+
+        orientation = { static_cast<float> (values[0]), static_cast<float> (values[1]), static_cast<float> (values[2]) };
+        sentTime = numValues > 3 ? values[3] : 0.0;
+        return true;
+    }
+
+    bool parseOscPacket (const char* data, int size, HeadOrientation& orientation, double& sentTime)
+    {
+        if (size < 8 || size % 4 != 0)
+            return false;
+
+        if (std::memcmp (data, "#bundle", 8) != 0)
+            return parseOscMessage (data, size, orientation, sentTime);
+
+        // #bundle, time tag, then size prefixed elements; the last orientation wins
+        bool found = false;
+
+        for (int pos = 16; pos + 4 <= size;)
+        {
+            const int elementSize = static_cast<int> (readBigEndian32 (data + pos));
+            pos += 4;
+
+            if (elementSize <= 0 || elementSize > size - pos)
+                break;
+
+            found = parseOscPacket (data + pos, elementSize, orientation, sentTime) || found;
+            pos += elementSize;
+        }
+
+        return found;
+    }
+}
+
+//==============================================================================
+bool HeadTrackerPacket::parse (const char* data, int size, HeadOrientation& orientation, double& sentTime)
+{
+    if (size >= 16 && std::memcmp (data, "HTRK", 4) == 0)
+    {
+        orientation = { bitCast<float> (readLittleEndian32 (data + 4)),
+                        bitCast<float> (readLittleEndian32 (data + 8)),
+                        bitCast<float> (readLittleEndian32 (data + 12)) };
+        sentTime = size >= 24 ? bitCast<double> (readLittleEndian64 (data + 16)) : 0.0;
+        return true;
+    }
+
+    return parseOscPacket (data, size, orientation, sentTime);
+}
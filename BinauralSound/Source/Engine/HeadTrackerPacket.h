@@ -0,0 +1,33 @@
+/*
+  ==============================================================================
+
+    HeadTrackerPacket.h
+
+    Decodes the datagrams a head tracker sends. Two formats are understood:
+
+    - OSC: a message to /head/ypr (or /ypr) with yaw, pitch and roll in
+      degrees as float, double or int arguments, optionally followed by the
+      sender's timestamp in seconds. Bundles are unpacked and the last
+      orientation in them wins.
+    - Binary: the four bytes "HTRK", then yaw, pitch and roll as little
+      endian float32, optionally followed by a float64 timestamp.
+
+    Kept free of JUCE so the parser can be tested on its own; the socket
+    side is HeadTrackerReceiver in the plugin.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "HeadOrientation.h"
+
+//==============================================================================
+namespace HeadTrackerPacket
+{
+    /** Decodes one datagram of size bytes. Returns false, leaving the outputs
+        untouched, if it is not an orientation. sentTime is 0 if the packet
+        carried no timestamp.
+    */
+    bool parse (const char* data, int size, HeadOrientation& orientation, double& sentTime);
+}
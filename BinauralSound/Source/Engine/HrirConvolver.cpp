@@ -0,0 +1,244 @@
+/*
+  ==============================================================================
+
+    HrirConvolver.cpp
+
+  ==============================================================================
+*/
+
+#include "HrirConvolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    int log2 (int powerOfTwo)
+    {
+        int order = 0;
+        while ((1 << order) < powerOfTwo)
+            ++order;
+        return order;
+    }
+}
+
+//==============================================================================
+HrirFilters::HrirFilters (std::shared_ptr<const HrirSet> setToUse, double sampleRateToUse, int partitionSizeToUse, int maxLength)
+    : set (std::move (setToUse)),
+      sampleRate (sampleRateToUse),
+      partitionSize (partitionSizeToUse)
+{
+    const int length = std::min (maxLength, static_cast<int> (std::ceil(set->getLength() * sampleRate / set->getSampleRate())));
+    numPartitions = std::max (1, (length + partitionSize - 1) / partitionSize);
+
+    const int numBins = getNumBins();
+    const Fft fft (log2(2 * partitionSize));
+
+    // Folds the 1 / 2P of the inverse transform into the filters
+    const float scale = 1.0f / fft.getSize();
+
+    spectra.resize(static_cast<size_t> (set->getNumMeasurements()) * 2 * numPartitions * 2 * numBins);
+
+    std::vector<float> padded (2 * partitionSize);
+
+    for (int m = 0; m < set->getNumMeasurements(); ++m)
+    {
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            const std::vector<float> ir = set->getImpulseResponse(m, channel, sampleRate, length);
+
+            for (int k = 0; k < numPartitions; ++k)
+            {
+                // Partition in the first half, zeros in the second: the
+                // valid half of each circular convolution is then the last one
+                std::fill (padded.begin(), padded.end(), 0.0f);
+
+                const int start = k * partitionSize;
+                const int count = std::min (partitionSize, static_cast<int> (ir.size()) - start);
+
+                for (int i = 0; i < count; ++i)
+                    padded[i] = ir[start + i] * scale;
+
+                float* const spectrum = spectra.data() + ((static_cast<size_t> (m) * 2 + channel) * numPartitions + k) * 2 * numBins;
+                fft.forward(padded.data(), spectrum, spectrum + numBins);
+            }
+        }
+    }
+}
+
+size_t HrirFilters::getMemoryFootprint() const
+{
+    return sizeof (*this) + spectra.capacity() * sizeof (float);
+}
+
+//==============================================================================
+void HrirConvolver::prepare (int partitionSizeToUse, int maxNumPartitionsToUse)
+{
+    partitionSize = partitionSizeToUse;
+    numBins = partitionSize + 1;
+    maxNumPartitions = maxNumPartitionsToUse;
+
+    fft = std::make_unique<Fft> (log2(2 * partitionSize));
+
+    inputBlock.assign(2 * partitionSize, 0.0f);
+
+    for (auto& ear : output)
+        ear.assign(partitionSize, 0.0f);
+
+    fdl.assign(static_cast<size_t> (maxNumPartitions) * 2 * numBins, 0.0f);
+    accumulator.assign(2 * numBins, 0.0f);
+    timeBlock.assign(2 * partitionSize, 0.0f);
+    fadeBlock.assign(2 * partitionSize, 0.0f);
+
+    // Filters made for another partition size do not fit any more
+    if (filters != nullptr && ! setFilters(filters))
+        filters.reset();
+
+    reset();
+}
+
+void HrirConvolver::reset()
+{
+    std::fill (inputBlock.begin(), inputBlock.end(), 0.0f);
+
+    for (auto& ear : output)
+        std::fill (ear.begin(), ear.end(), 0.0f);
+
+    std::fill (fdl.begin(), fdl.end(), 0.0f);
+
+    inputFill = 0;
+    fdlPosition = 0;
+    measurement_current = -1;
+}
+
+bool HrirConvolver::setFilters (std::shared_ptr<const HrirFilters> newFilters)
+{
+    if (newFilters != nullptr
+        && (newFilters->getPartitionSize() != partitionSize || newFilters->getNumPartitions() > maxNumPartitions))
+        return false;
+
+    // Indices of the old set mean nothing in the new one
+    if (newFilters != filters)
+        measurement_current = -1;
+
+    filters = std::move (newFilters);
+    return true;
+}
+
+size_t HrirConvolver::getMemoryFootprint() const
+{
+    size_t bytes = sizeof (*this) + (inputBlock.capacity() + fdl.capacity() + accumulator.capacity()
+                                     + timeBlock.capacity() + fadeBlock.capacity()) * sizeof (float);
+
+    for (auto& ear : output)
+        bytes += ear.capacity() * sizeof (float);
+
+    return bytes;
+}
+
+//==============================================================================
+void HrirConvolver::process (const float* in, float* outL, float* outR, int n)
+{
+    for (int done = 0; done < n;)
+    {
+        const int count = std::min (n - done, partitionSize - inputFill);
+
+        // Output of the previous block while this one fills up. Read the
+        // input first, it may alias outL.
+        std::copy (in + done, in + done + count, inputBlock.begin() + partitionSize + inputFill);
+
+        for (int i = 0; i < count; ++i)
+        {
+            outL[done + i] += output[0][inputFill + i];
+            outR[done + i] += output[1][inputFill + i];
+        }
+
+        inputFill += count;
+        done += count;
+
+        if (inputFill == partitionSize)
+        {
+            processPartition();
+            inputFill = 0;
+        }
+    }
+}
+
+void HrirConvolver::accumulate (int measurement, int channel, float* re, float* im) const
+{
+    std::fill (re, re + numBins, 0.0f);
+    std::fill (im, im + numBins, 0.0f);
+
+    for (int k = 0; k < filters->getNumPartitions(); ++k)
+    {
+        // Input block k blocks ago times partition k of the filter
+        const int slot = (fdlPosition - k + maxNumPartitions) % maxNumPartitions;
+
+        const float* const xr = fdl.data() + static_cast<size_t> (slot) * 2 * numBins;
+        const float* const xi = xr + numBins;
+        const float* const hr = filters->getSpectrum(measurement, channel, k);
+        const float* const hi = hr + numBins;
+
+        for (int b = 0; b < numBins; ++b)
+        {
+            re[b] += xr[b]*hr[b] - xi[b]*hi[b];
+            im[b] += xr[b]*hi[b] + xi[b]*hr[b];
+        }
+    }
+}
+
+void HrirConvolver::processPartition()
+{
+    // Newest input spectrum into the delay line, from the last two blocks
+    fdlPosition = (fdlPosition + 1) % maxNumPartitions;
+
+    float* const xr = fdl.data() + static_cast<size_t> (fdlPosition) * 2 * numBins;
+    fft->forward(inputBlock.data(), xr, xr + numBins);
+
+    std::copy (inputBlock.begin() + partitionSize, inputBlock.end(), inputBlock.begin());
+
+    if (filters == nullptr)
+    {
+        for (auto& ear : output)
+            std::fill (ear.begin(), ear.end(), 0.0f);
+
+        return;
+    }
+
+    const int target = std::clamp (measurement_target, 0, filters->getSet().getNumMeasurements() - 1);
+    const bool crossfade = measurement_current >= 0 && measurement_current != target;
+
+    float* const re = accumulator.data();
+    float* const im = re + numBins;
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        // Overlap-save: the second half of the circular convolution is valid
+        accumulate(target, channel, re, im);
+        fft->inverse(re, im, timeBlock.data());
+
+        const float* const current = timeBlock.data() + partitionSize;
+        float* const out = output[channel].data();
+
+        if (crossfade)
+        {
+            accumulate(measurement_current, channel, re, im);
+            fft->inverse(re, im, fadeBlock.data());
+
+            const float* const previous = fadeBlock.data() + partitionSize;
+            const float ramp = 1.0f / partitionSize;
+
+            for (int i = 0; i < partitionSize; ++i)
+            {
+                const float fade = (i + 1) * ramp;
+                out[i] = previous[i] + fade * (current[i] - previous[i]);
+            }
+        }
+        else
+        {
+            std::copy (current, current + partitionSize, out);
+        }
+    }
+
+    measurement_current = target;
+}
@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    HrirConvolver.h
+
+    Binaural rendering of one source by convolution with measured HRIRs,
+    uniformly partitioned in the frequency domain (overlap-save).
+
+    The impulse responses are cut into partitions of P samples, each one
+    zero padded to 2P and transformed once when the set is loaded
+    (HrirFilters). At run time the input is collected into blocks of P
+    samples; every block is transformed once, kept in a frequency domain
+    delay line, and both ears are the sum over partitions of delayed input
+    spectra times filter spectra, followed by one inverse transform per ear.
+    That adds P samples of latency and costs one forward and two inverse
+    transforms of 2P points per P samples, plus a complex multiply-add per
+    bin and partition, instead of a multiply-add per tap and sample.
+
+    The filter is chosen once per block, from the nearest measured
+    direction. When it changes, the block is computed with the old and the
+    new filter and crossfaded linearly, so moving sources do not click; the
+    input spectra do not depend on the filter, so that costs one extra
+    inverse transform and multiply-add pass per ear.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "Fft.h"
+#include "HrirSet.h"
+
+//==============================================================================
+/** An HrirSet resampled to one sample rate and transformed into partitions
+    of one size. Immutable, so every source and instance running with that
+    set, rate and partition size can share it.
+*/
+class HrirFilters
+{
+public:
+    //==============================================================================
+    /** Resamples the set to sampleRate if it was measured at another rate,
+        cuts it to at most maxLength samples and transforms the partitions.
+        partitionSize must be a power of two. Allocates, not for the audio
+        thread.
+    */
+    HrirFilters (std::shared_ptr<const HrirSet> set, double sampleRate, int partitionSize, int maxLength);
+
+    const HrirSet& getSet() const           { return *set; }
+
+    /** Nearest measurement, see HrirSet::findNearest(). */
+    int findNearest (float azimuth, float elevation) const  { return set->findNearest(azimuth, elevation); }
+
+    double getSampleRate() const            { return sampleRate; }
+    int getPartitionSize() const            { return partitionSize; }
+    int getNumPartitions() const            { return numPartitions; }
+    int getNumBins() const                  { return partitionSize + 1; }
+
+    /** Spectrum of one partition of one ear, getNumBins() real parts
+        followed by getNumBins() imaginary parts. Scaled so that Fft::inverse()
+        needs no normalisation.
+    */
+    const float* getSpectrum (int measurement, int channel, int partition) const
+    {
+        return spectra.data() + ((static_cast<size_t> (measurement) * 2 + channel) * numPartitions + partition) * 2 * getNumBins();
+    }
+
+    size_t getMemoryFootprint() const;
+
+private:
+    //==============================================================================
+    std::shared_ptr<const HrirSet> set;
+    double sampleRate;
+    int partitionSize;
+    int numPartitions;
+
+    std::vector<float> spectra; // [measurement][ear][partition][re | im]
+};
+
+//==============================================================================
+/**
+*/
+class HrirConvolver
+{
+public:
+    //==============================================================================
+    /** Allocates the delay line for filters of up to maxNumPartitions
+        partitions of partitionSize samples. Not for the audio thread.
+    */
+    void prepare (int partitionSize, int maxNumPartitions);
+
+    /** Clears the input, the delay line and the pending output. */
+    void reset();
+
+    /** Switches to another set without crossfading. Returns false and keeps
+        the current filters if the new ones do not fit what prepare() was
+        called with. Does not allocate, but the convolver shares ownership:
+        make sure the filters it lets go of are still held elsewhere when
+        calling this from the audio thread.
+    */
+    bool setFilters (std::shared_ptr<const HrirFilters> newFilters);
+
+    const std::shared_ptr<const HrirFilters>& getFilters() const   { return filters; }
+
+    /** Measurement to use from the next block on. */
+    void setMeasurement (int measurement)   { measurement_target = measurement; }
+
+    /** Convolves n samples of in and adds both ears to outL / outR, delayed
+        by getLatency() samples. Outputs nothing without filters.
+    */
+    void process (const float* in, float* outL, float* outR, int n);
+
+    int getLatency() const                  { return partitionSize; }
+
+    size_t getMemoryFootprint() const;
+
+private:
+    //==============================================================================
+    void processPartition();
+    void accumulate (int measurement, int channel, float* re, float* im) const;
+
+    //==============================================================================
+    std::shared_ptr<const HrirFilters> filters;
+    std::unique_ptr<Fft> fft;
+
+    int partitionSize = 0;
+    int numBins = 0;
+    int maxNumPartitions = 0;
+
+    // Time domain: the last two input blocks, and the output of the last one
+    std::vector<float> inputBlock; // [previous P | current P]
+    int inputFill = 0; // samples in the current block
+    std::vector<float> output[2]; // [P] per ear
+
+    // Frequency domain delay line of the input, newest block at fdlPosition
+    std::vector<float> fdl; // [partition][re | im]
+    int fdlPosition = 0;
+
+    // Scratch space for one block
+    std::vector<float> accumulator; // [re | im]
+    std::vector<float> timeBlock, fadeBlock; // [2P]
+
+    int measurement_current = -1; // -1: no block rendered yet, start without a crossfade
+    int measurement_target = 0;
+};
@@ -0,0 +1,232 @@
+/*
+  ==============================================================================
+
+    HrirSet.cpp
+
+  ==============================================================================
+*/
+
+#include "HrirSet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+    constexpr double double_Pi = 3.14159265358979323846;
+    constexpr float float_Pi = 3.14159265358979323846f;
+    constexpr float toRadians = float_Pi/180;
+    constexpr float toDegrees = 180/float_Pi;
+
+    constexpr int numAzimuths = 181; // -90 to 90
+    constexpr int numElevations = 361; // -180 to 180
+
+    constexpr uint32_t maxLength = 1 << 21; // [samples], 43 s at 48 kHz, longer than any room response
+    constexpr uint32_t maxMeasurements = 1 << 16; // dense SOFA sets hold a few thousand
+
+    constexpr int resamplingZeroCrossings = 16; // half length of the interpolation kernel
+
+    struct Vector
+    {
+        float x, y, z;
+    };
+
+    /** Unit vector of an interaural-polar direction, x to the front, y to
+        the left and z up.
+    */
+    Vector toVector (float azimuth, float elevation)
+    {
+        const float theta = azimuth * toRadians;
+        const float phi = elevation * toRadians;
+
+        return { std::cos(theta) * std::cos(phi), -std::sin(theta), std::cos(theta) * std::sin(phi) };
+    }
+
+    HrirSet::Direction toDirection (const Vector& v)
+    {
+        return { std::asin(std::clamp (-v.y, -1.0f, 1.0f)) * toDegrees, std::atan2(v.z, v.x) * toDegrees };
+    }
+
+    template <typename Type>
+    bool read (std::istream& stream, Type& value)
+    {
+        return static_cast<bool> (stream.read(reinterpret_cast<char*> (&value), sizeof (Type)));
+    }
+}
+
+//==============================================================================
+HrirSet::HrirSet (double sampleRateToUse, int lengthToUse, std::vector<Direction> directionsToUse, std::vector<float> impulseResponsesToUse)
+    : sampleRate (sampleRateToUse),
+      length (lengthToUse),
+      directions (std::move (directionsToUse)),
+      impulseResponses (std::move (impulseResponsesToUse))
+{
+    std::vector<Vector> measured;
+    measured.reserve(directions.size());
+
+    for (auto& direction : directions)
+        measured.push_back(toVector(direction.azimuth, direction.elevation));
+
+    // Nearest measurement of every grid point: the one with the largest dot product
+    nearest.resize(static_cast<size_t> (numAzimuths) * numElevations);
+
+    for (int i = 0; i < numAzimuths; ++i)
+    {
+        for (int j = 0; j < numElevations; ++j)
+        {
+            const Vector v = toVector(static_cast<float> (i - 90), static_cast<float> (j - 180));
+
+            int best = 0;
+            float bestDot = -2;
+
+            for (size_t m = 0; m < measured.size(); ++m)
+            {
+                const float dot = v.x*measured[m].x + v.y*measured[m].y + v.z*measured[m].z;
+
+                if (dot > bestDot)
+                {
+                    bestDot = dot;
+                    best = static_cast<int> (m);
+                }
+            }
+
+            nearest[static_cast<size_t> (i) * numElevations + j] = best;
+        }
+    }
+}
+
+HrirSet::Direction HrirSet::fromSpherical (float azimuth, float elevation)
+{
+    const float phi = azimuth * toRadians;
+    const float theta = elevation * toRadians;
+
+    return toDirection({ std::cos(theta) * std::cos(phi), std::cos(theta) * std::sin(phi), std::sin(theta) });
+}
+
+//==============================================================================
+std::shared_ptr<const HrirSet> HrirSet::load (const std::string& path, std::string& error)
+{
+    std::ifstream stream (path, std::ios::binary);
+
+    if (! stream)
+    {
+        error = "cannot open " + path;
+        return nullptr;
+    }
+
+    char magic[4];
+    uint32_t version = 0, numMeasurements = 0, fileLength = 0;
+    float fileSampleRate = 0;
+
+    if (! stream.read(magic, 4) || std::memcmp (magic, "HRIR", 4) != 0)
+    {
+        error = path + " is not an HRIR file";
+        return nullptr;
+    }
+
+    if (! read(stream, version) || version != 1)
+    {
+        error = "unsupported HRIR file version " + std::to_string (version);
+        return nullptr;
+    }
+
+    if (! (read(stream, fileSampleRate) && read(stream, numMeasurements) && read(stream, fileLength))
+        || ! (fileSampleRate > 0) || numMeasurements == 0 || numMeasurements > maxMeasurements
+        || fileLength == 0 || fileLength > maxLength)
+    {
+        error = "invalid HRIR file header";
+        return nullptr;
+    }
+
+    // Check the header against the file before allocating for it, a corrupt
+    // count would otherwise ask for gigabytes
+    const uint64_t measurementSize = (2 + 2 * static_cast<uint64_t> (fileLength)) * sizeof (float);
+    const uint64_t expectedSize = numMeasurements * measurementSize;
+
+    const auto dataStart = stream.tellg();
+    stream.seekg(0, std::ios::end);
+    const auto fileEnd = stream.tellg();
+    stream.seekg(dataStart);
+
+    if (dataStart < 0 || fileEnd < dataStart || static_cast<uint64_t> (fileEnd - dataStart) < expectedSize)
+    {
+        error = "HRIR file is too short for " + std::to_string (numMeasurements) + " measurements of " + std::to_string (fileLength) + " samples";
+        return nullptr;
+    }
+
+    std::vector<Direction> directions (numMeasurements);
+    std::vector<float> impulseResponses (static_cast<size_t> (numMeasurements) * 2 * fileLength);
+
+    for (uint32_t m = 0; m < numMeasurements; ++m)
+    {
+        float azimuth = 0, elevation = 0;
+        char* const data = reinterpret_cast<char*> (impulseResponses.data() + static_cast<size_t> (m) * 2 * fileLength);
+
+        if (! (read(stream, azimuth) && read(stream, elevation) && stream.read(data, 2 * fileLength * sizeof (float))))
+        {
+            error = "HRIR file ends after " + std::to_string (m) + " of " + std::to_string (numMeasurements) + " measurements";
+            return nullptr;
+        }
+
+        directions[m] = fromSpherical(azimuth, elevation);
+    }
+
+    return std::make_shared<const HrirSet> (fileSampleRate, static_cast<int> (fileLength), std::move (directions), std::move (impulseResponses));
+}
+
+//==============================================================================
+std::vector<float> HrirSet::getImpulseResponse (int measurement, int channel, double newSampleRate, int maxLength) const
+{
+    const float* const input = getImpulseResponse(measurement, channel);
+    const double ratio = newSampleRate / sampleRate;
+
+    if (ratio == 1.0)
+        return std::vector<float> (input, input + std::min (length, maxLength));
+
+    const int outputLength = std::min (maxLength, static_cast<int> (std::ceil(length * ratio)));
+
+    // The cutoff is the lower of the two Nyquist frequencies, a little below
+    // it to leave room for the window's transition band
+    const double cutoff = 0.95 * std::min (1.0, ratio); // relative to the input Nyquist
+    const double halfWidth = resamplingZeroCrossings / cutoff; // [input samples]
+
+    std::vector<float> output (outputLength, 0.0f);
+
+    for (int m = 0; m < outputLength; ++m)
+    {
+        const double t = m / ratio; // position in input samples
+        const int first = std::max (0, static_cast<int> (std::ceil(t - halfWidth)));
+        const int last = std::min (length - 1, static_cast<int> (std::floor(t + halfWidth)));
+
+        double sum = 0;
+
+        for (int n = first; n <= last; ++n)
+        {
+            const double u = t - n;
+            const double x = double_Pi * cutoff * u;
+            const double sinc = x == 0 ? 1.0 : std::sin(x) / x;
+            const double window = 0.42 + 0.5 * std::cos(double_Pi * u / halfWidth) + 0.08 * std::cos(2 * double_Pi * u / halfWidth);
+
+            sum += input[n] * cutoff * sinc * window;
+        }
+
+        output[m] = static_cast<float> (sum);
+    }
+
+    return output;
+}
+
+//==============================================================================
+int HrirSet::findNearest (float azimuth, float elevation) const
+{
+    // Back to the grid's ranges, whatever the angles were
+    const Direction direction = toDirection(toVector(azimuth, elevation));
+
+    const int i = std::clamp (static_cast<int> (std::lround(direction.azimuth)) + 90, 0, numAzimuths - 1);
+    const int j = std::clamp (static_cast<int> (std::lround(direction.elevation)) + 180, 0, numElevations - 1);
+
+    return nearest[static_cast<size_t> (i) * numElevations + j];
+}
@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    HrirSet.h
+
+    Measured head related impulse responses, one pair per direction, with a
+    nearest neighbour index over the sphere. Binaural room impulse responses
+    are stored the same way, only longer.
+
+    Sets are read from a plain binary dump rather than from SOFA directly,
+    which would pull in netCDF / HDF5; Tools/SofaToHrir converts SOFA files
+    to it. All fields are little endian:
+
+        char[4]   "HRIR"
+        uint32    version, 1
+        float32   sample rate [Hz]
+        uint32    number of measurements M
+        uint32    impulse response length N [samples]
+        M times:
+            float32     azimuth [deg], counterclockwise from the front (SOFA)
+            float32     elevation [deg], up from the horizontal plane (SOFA)
+            float32[N]  left ear
+            float32[N]  right ear
+
+    Directions are stored in the model's interaural-polar convention once
+    loaded: azimuth from -90 (left) to 90 (right), elevation around the
+    interaural axis from -180 to 180, 0 in front and 90 above.
+
+    The index is a 1 degree grid over that azimuth / elevation range holding
+    the nearest measurement of every grid point, computed once when the set
+    is built. A lookup is then a rounding and one read, whatever the number
+    of measurements.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+//==============================================================================
+/**
+*/
+class HrirSet
+{
+public:
+    //==============================================================================
+    struct Direction
+    {
+        float azimuth = 0; // [deg], interaural-polar as above
+        float elevation = 0; // [deg]
+    };
+
+    //==============================================================================
+    /** Takes impulse responses stored as [measurement][ear][length], one
+        direction per measurement, and builds the index. Allocates.
+    */
+    HrirSet (double sampleRate, int length, std::vector<Direction> directions, std::vector<float> impulseResponses);
+
+    /** Reads a binary dump. Returns nullptr and fills error on failure,
+        including headers the file is too short for or with more than 65536
+        measurements, before allocating for them.
+    */
+    static std::shared_ptr<const HrirSet> load (const std::string& path, std::string& error);
+
+    /** Converts SOFA spherical coordinates (azimuth counterclockwise, i.e.
+        positive to the left) to the interaural-polar ones used here.
+    */
+    static Direction fromSpherical (float azimuth, float elevation);
+
+    //==============================================================================
+    /** Measurement closest to a direction given in the model's convention.
+        Any angles are accepted. Does not allocate.
+    */
+    int findNearest (float azimuth, float elevation) const;
+
+    double getSampleRate() const                        { return sampleRate; }
+    int getLength() const                               { return length; }
+    int getNumMeasurements() const                      { return static_cast<int> (directions.size()); }
+    const Direction& getDirection (int measurement) const   { return directions[measurement]; }
+
+    /** length samples of one ear, 0 is left. */
+    const float* getImpulseResponse (int measurement, int channel) const
+    {
+        return impulseResponses.data() + (static_cast<size_t> (measurement) * 2 + channel) * length;
+    }
+
+    /** One ear at another sample rate, band limited with a Blackman windowed
+        sinc, and cut to at most maxLength samples. A plain copy if the rate
+        is the set's own. Allocates.
+    */
+    std::vector<float> getImpulseResponse (int measurement, int channel, double newSampleRate, int maxLength) const;
+
+private:
+    //==============================================================================
+    double sampleRate;
+    int length;
+
+    std::vector<Direction> directions;
+    std::vector<float> impulseResponses; // [measurement][ear][length]
+
+    std::vector<int> nearest; // [azimuth + 90][elevation + 180], 1 degree steps
+};
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    Interpolation.cpp
+
+  ==============================================================================
+*/
+
+#include "Interpolation.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr double pi = 3.14159265358979323846;
+
+    // Kaiser window shape: the most accurate up to 16 kHz at 48 kHz for
+    // each length. Larger values trade the top of the band for less ripple
+    // below it.
+    constexpr double getKaiserBeta (int numTaps)    { return numTaps == 8 ? 4.0 : 7.0; }
+
+    double besselI0 (double x)
+    {
+        double sum = 1, term = 1;
+
+        for (int k = 1; k < 32; ++k)
+        {
+            term *= (x / (2 * k)) * (x / (2 * k));
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    template <int N>
+    std::array<float, (Interpolation::numPhases + 1) * N> makeSincTable()
+    {
+        std::array<float, (Interpolation::numPhases + 1) * N> table {};
+        constexpr double beta = getKaiserBeta (N);
+
+        for (int phase = 0; phase <= Interpolation::numPhases; ++phase)
+        {
+            const double frac = static_cast<double> (phase) / Interpolation::numPhases;
+            double taps[N], sum = 0;
+
+            // Tap k is the sample N/2 - k before the read pointer, which is
+            // this far from the point read
+            for (int k = 0; k < N; ++k)
+            {
+                const double t = N / 2 - k - frac;
+                const double x = t / (N / 2);
+                const double window = std::abs (x) < 1 ? besselI0 (beta * std::sqrt (1 - x * x)) / besselI0 (beta) : 0;
+                const double sinc = t == 0 ? 1 : std::sin (pi * t) / (pi * t);
+
+                taps[k] = sinc * window;
+                sum += taps[k];
+            }
+
+            // Unity gain at DC for every fraction
+            for (int k = 0; k < N; ++k)
+                table[phase * N + k] = static_cast<float> (taps[k] / sum);
+        }
+
+        return table;
+    }
+}
+
+//==============================================================================
+const std::array<float, (Interpolation::numPhases + 1) * 8> Interpolation::sinc8Table = makeSincTable<8>();
+const std::array<float, (Interpolation::numPhases + 1) * 16> Interpolation::sinc16Table = makeSincTable<16>();
+
+//==============================================================================
+const char* Interpolation::getName (Kind kind)
+{
+    switch (kind)
+    {
+        case Kind::linear:      return "linear";
+        case Kind::lagrange4:   return "lagrange4";
+        case Kind::sinc8:       return "sinc8";
+        case Kind::sinc16:      return "sinc16";
+    }
+
+    return "linear";
+}
+
+bool Interpolation::fromName (const char* name, Kind& kind)
+{
+    for (Kind k : { Kind::linear, Kind::lagrange4, Kind::sinc8, Kind::sinc16 })
+    {
+        if (std::strcmp (name, getName(k)) == 0)
+        {
+            kind = k;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    LatencyHistogram.h
+
+    Latency statistics collected on the audio thread and read from any other
+    thread. Values go into fixed 0.1 ms bins, so add() never allocates or
+    locks; percentiles are accurate to the bin width.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+//==============================================================================
+/**
+*/
+class LatencyHistogram
+{
+public:
+    //==============================================================================
+    static constexpr int numBins = 2000;
+    static constexpr double binWidth = 0.0001; // [s], latencies above 200 ms go into the last bin
+
+    struct Summary
+    {
+        uint64_t count = 0;
+        double mean = 0, p50 = 0, p95 = 0, p99 = 0, max = 0; // [s]
+    };
+
+    //==============================================================================
+    /** Adds one measurement, in seconds. Only one thread may call this. */
+    void add (double seconds)
+    {
+        seconds = std::max (0.0, seconds);
+
+        const int bin = std::min (numBins - 1, static_cast<int> (seconds / binWidth));
+        bins[bin].store (bins[bin].load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        sum.store (sum.load (std::memory_order_relaxed) + seconds, std::memory_order_relaxed);
+        max.store (std::max (max.load (std::memory_order_relaxed), seconds), std::memory_order_relaxed);
+        count.store (count.load (std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /** Safe to call from any thread while add() runs; the result may then
+        miss the measurements being added.
+    */
+    Summary getSummary() const
+    {
+        Summary summary;
+        summary.count = count.load (std::memory_order_acquire);
+
+        if (summary.count == 0)
+            return summary;
+
+        summary.mean = sum.load (std::memory_order_relaxed) / summary.count;
+        summary.max = max.load (std::memory_order_relaxed);
+
+        std::array<uint32_t, numBins> snapshot;
+        uint64_t total = 0;
+
+        for (int i = 0; i < numBins; ++i)
+            total += snapshot[i] = bins[i].load (std::memory_order_relaxed);
+
+        auto percentile = [&] (double p)
+        {
+            const uint64_t rank = static_cast<uint64_t> (p * total);
+            uint64_t seen = 0;
+
+            for (int i = 0; i < numBins; ++i)
+            {
+                seen += snapshot[i];
+                if (seen > rank)
+                    return std::min ((i + 0.5) * binWidth, summary.max);
+            }
+
+            return numBins * binWidth;
+        };
+
+        summary.p50 = percentile (0.5);
+        summary.p95 = percentile (0.95);
+        summary.p99 = percentile (0.99);
+        return summary;
+    }
+
+private:
+    //==============================================================================
+    std::array<std::atomic<uint32_t>, numBins> bins {};
+    std::atomic<uint64_t> count { 0 };
+    std::atomic<double> sum { 0 }, max { 0 };
+};
@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    ParameterSmoother.h
+
+    Linear ramp towards a parameter value, advanced on the audio thread in
+    steps of a whole control block.
+
+    A new target restarts the ramp from wherever the value currently is, so
+    the time to reach it is always the ramp length, however often the target
+    moves. A ramp length of 0 follows the target immediately.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+
+//==============================================================================
+/**
+*/
+class ParameterSmoother
+{
+public:
+    //==============================================================================
+    void setRampLength (int numSamples)     { rampLength = std::max (0, numSamples); }
+    int getRampLength() const               { return rampLength; }
+
+    /** Jumps to value, cancelling any ramp in progress. */
+    void setCurrentAndTarget (float value)
+    {
+        current = target = value;
+        remaining = 0;
+    }
+
+    /** Moves numSamples along the ramp towards newTarget and returns the
+        value reached.
+    */
+    float getNext (float newTarget, int numSamples)
+    {
+        if (newTarget != target)
+        {
+            target = newTarget;
+            remaining = rampLength;
+            step = rampLength > 0 ? (target - current) / rampLength : 0.0f;
+        }
+
+        if (remaining <= numSamples)
+        {
+            current = target;
+            remaining = 0;
+        }
+        else
+        {
+            current += step * numSamples;
+            remaining -= numSamples;
+        }
+
+        return current;
+    }
+
+    bool isSmoothing() const                { return remaining > 0; }
+    float getCurrentValue() const           { return current; }
+
+private:
+    //==============================================================================
+    float current = 0, target = 0, step = 0;
+    int remaining = 0; // samples left in the ramp
+    int rampLength = 0;
+};
@@ -0,0 +1,495 @@
+/*
+  ==============================================================================
+
+    SceneKernels.cpp
+
+    Scalar kernel and run-time dispatch. The vector kernels live in
+    SceneKernels_SSE41.cpp and SceneKernels_AVX2.cpp.
+
+  ==============================================================================
+*/
+
+#include "SceneKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+ #define BINAURAL_X86 1
+ #if defined(_MSC_VER)
+  #include <intrin.h>
+  #include <immintrin.h>
+ #endif
+#else
+ #define BINAURAL_X86 0
+#endif
+
+//==============================================================================
+SceneKernels::SimdLevel SceneKernels::detectSimdLevel()
+{
+   #if BINAURAL_X86 && defined(_MSC_VER)
+    int info[4];
+    __cpuid (info, 1);
+
+    const bool sse41 = (info[2] & (1 << 19)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+
+    __cpuidex (info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0
+                        && avx && osxsave
+                        && (_xgetbv (0) & 6) == 6; // the OS saves the ymm registers
+
+    if (avx2)   return SimdLevel::avx2;
+    if (sse41)  return SimdLevel::sse41;
+   #elif BINAURAL_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports ("avx2"))    return SimdLevel::avx2;
+    if (__builtin_cpu_supports ("sse4.1"))  return SimdLevel::sse41;
+   #endif
+
+    return SimdLevel::scalar;
+}
+
+int SceneKernels::getNumLanes (SimdLevel level)
+{
+    switch (level)
+    {
+        case SimdLevel::avx2:   return 8;
+        case SimdLevel::sse41:  return 4;
+        case SimdLevel::scalar: break;
+    }
+
+    return 1;
+}
+
+SceneKernels::Kernel SceneKernels::getKernel (SimdLevel level)
+{
+    static const SimdLevel supported = detectSimdLevel();
+
+    if (static_cast<int> (level) > static_cast<int> (supported))
+        level = supported;
+
+    switch (level)
+    {
+        case SimdLevel::avx2:   return renderAVX2;
+        case SimdLevel::sse41:  return renderSSE41;
+        case SimdLevel::scalar: break;
+    }
+
+    return renderScalar;
+}
+
+SceneKernels::DetailKernel SceneKernels::getDetailKernel (SimdLevel level)
+{
+    static const SimdLevel supported = detectSimdLevel();
+
+    if (static_cast<int> (level) > static_cast<int> (supported))
+        level = supported;
+
+    switch (level)
+    {
+        case SimdLevel::avx2:   return renderDetailAVX2;
+        case SimdLevel::sse41:  return renderDetailSSE41;
+        case SimdLevel::scalar: break;
+    }
+
+    return renderDetailScalar;
+}
+
+const char* SceneKernels::getName (SimdLevel level)
+{
+    switch (level)
+    {
+        case SimdLevel::avx2:   return "avx2";
+        case SimdLevel::sse41:  return "sse4.1";
+        case SimdLevel::scalar: break;
+    }
+
+    return "scalar";
+}
+
+//==============================================================================
+void SceneKernels::renderScalar (const Args& args, int firstSource, int count)
+{
+    using BrownDudaModel::rho_k;
+    constexpr int numEvents = BrownDudaModel::numPinnaEvents;
+
+    const int lineMask = args.lineMask;
+    const float ramp = args.ramp;
+
+    for (int s = firstSource; s < firstSource + count; ++s)
+    {
+        const float* const in_buffer = args.inputs[s] + args.start;
+        float* const inputLine = args.inputLines + static_cast<size_t> (s) * args.lineSize;
+
+        // Ramps for both ears of this source
+        float delSamples[2], delSamples_inc[2];
+        float b0[2], b0_inc[2], b1[2], b1_inc[2];
+        float tau[2][numEvents], tau_inc[2][numEvents];
+        float outVal_prev[2], outVal_head_shadow_prev[2];
+        float* headShadowLine[2];
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            auto& ear = args.ears[channel];
+
+            delSamples[channel] = ear.delSamples[s];
+            delSamples_inc[channel] = (ear.delSamples_target[s] - ear.delSamples[s]) * ramp;
+            b0[channel] = ear.b0[s];
+            b0_inc[channel] = (ear.b0_target[s] - ear.b0[s]) * ramp;
+            b1[channel] = ear.b1[s];
+            b1_inc[channel] = (ear.b1_target[s] - ear.b1[s]) * ramp;
+
+            for (int iEvent = 0; iEvent < numEvents; iEvent++)
+            {
+                tau[channel][iEvent] = ear.tau[iEvent][s];
+                tau_inc[channel][iEvent] = (ear.tau_target[iEvent][s] - ear.tau[iEvent][s]) * ramp;
+            }
+
+            outVal_prev[channel] = ear.outVal_prev[s];
+            outVal_head_shadow_prev[channel] = ear.outVal_head_shadow_prev[s];
+            headShadowLine[channel] = args.headShadowLines + (static_cast<size_t> (channel) * args.numSources + s) * args.pinnaLineSize;
+        }
+
+        float g = args.gain[s];
+        const float g_inc = (args.gain_target[s] - args.gain[s]) * ramp;
+
+        float roomDelay = args.roomDelay[s];
+        const float roomDelay_inc = (args.roomDelay_target[s] - args.roomDelay[s]) * ramp;
+
+        float airPole = args.airPole[s];
+        const float airPole_inc = (args.airPole_target[s] - args.airPole[s]) * ramp;
+        float airState = args.airState[s];
+
+        for (int i = 0; i < args.numSamples; ++i)
+        {
+            const int writePointer = (args.writePointer + i) & lineMask;
+            const int readPointer = writePointer - args.initLatency;
+
+            // Air absorption, then populate buffer, shared by both ears
+            airPole += airPole_inc;
+            airState = (1-airPole)*in_buffer[i] + airPole*airState;
+
+            inputLine[writePointer] = airState;
+
+            g += g_inc;
+
+            // Room model, the same for both ears
+            roomDelay += roomDelay_inc;
+            float roomDelay_floor = std::floor(roomDelay);
+            float room_frac_part = roomDelay - roomDelay_floor;
+
+            int outPointer_room = (readPointer - 1 - static_cast<int>(roomDelay_floor)) & lineMask;
+            int outPointer_room_frac = (readPointer - static_cast<int>(roomDelay_floor)) & lineMask;
+
+            const float outVal_room = args.Ke_ampl * (room_frac_part*inputLine[outPointer_room] + (1-room_frac_part)*inputLine[outPointer_room_frac]);
+
+            if (args.reverbSend != nullptr)
+                args.reverbSend[args.start + i] += outVal_room * g;
+
+            float out[2];
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                // ITD
+                delSamples[channel] += delSamples_inc[channel];
+                float delSamples_floor = std::floor(delSamples[channel]);
+                float frac_part = delSamples[channel] - delSamples_floor;
+
+                int outPointer = (readPointer - 1 - static_cast<int>(delSamples_floor)) & lineMask;
+                int outPointer_frac = (readPointer - static_cast<int>(delSamples_floor)) & lineMask;
+
+                const float outVal = frac_part*inputLine[outPointer] + (1-frac_part)*inputLine[outPointer_frac];
+
+                // HEAD SHADOW FILTER
+                b0[channel] += b0_inc[channel];
+                b1[channel] += b1_inc[channel];
+
+                const float outVal_head_shadow = b0[channel] * outVal + b1[channel] * outVal_prev[channel] - args.a1_head_shadow * outVal_head_shadow_prev[channel];
+
+                outVal_prev[channel] = outVal;
+                outVal_head_shadow_prev[channel] = outVal_head_shadow;
+
+                // PINNA MODEL
+                float* const line = headShadowLine[channel];
+                line[writePointer & args.pinnaLineMask] = outVal_head_shadow;
+
+                float outVal_post_pinnae = 0;
+                for (int iEvent = 0; iEvent < numEvents; iEvent++)
+                {
+                    tau[channel][iEvent] += tau_inc[channel][iEvent];
+
+                    float tau_samples = std::floor(tau[channel][iEvent]);
+                    float tau_samples_frac_part = tau[channel][iEvent] - tau_samples;
+
+                    int outPointer_k = (readPointer - 1 - static_cast<int>(tau_samples)) & args.pinnaLineMask;
+                    int outPointer_k_frac = (readPointer - static_cast<int>(tau_samples)) & args.pinnaLineMask;
+
+                    outVal_post_pinnae += rho_k[iEvent] * (tau_samples_frac_part*line[outPointer_k] + (1-tau_samples_frac_part)*line[outPointer_k_frac]);
+                }
+
+                out[channel] = (outVal_post_pinnae + outVal_room) * g;
+            }
+
+            args.outputL[args.start + i] += out[0];
+            args.outputR[args.start + i] += out[1];
+        }
+
+        // Store the filter states and land exactly on the targets
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            auto& ear = args.ears[channel];
+
+            ear.outVal_prev[s] = outVal_prev[channel];
+            ear.outVal_head_shadow_prev[s] = outVal_head_shadow_prev[channel];
+
+            ear.delSamples[s] = ear.delSamples_target[s];
+            ear.b0[s] = ear.b0_target[s];
+            ear.b1[s] = ear.b1_target[s];
+            for (int iEvent = 0; iEvent < numEvents; iEvent++)
+                ear.tau[iEvent][s] = ear.tau_target[iEvent][s];
+        }
+
+        args.gain[s] = args.gain_target[s];
+        args.roomDelay[s] = args.roomDelay_target[s];
+        args.airPole[s] = args.airPole_target[s];
+        args.airState[s] = airState;
+    }
+}
+
+//==============================================================================
+namespace
+{
+    using SceneKernels::Detail;
+
+    /** std::floor for the delays, without the library call. */
+    inline int floorToInt (float x)
+    {
+        const int i = static_cast<int> (x);
+        return i - (x < static_cast<float> (i) ? 1 : 0);
+    }
+
+    /** Linear read d samples behind position, as in the kernels. */
+    inline float readLinear (const float* line, int mask, int position, float d)
+    {
+        const int d_floor = floorToInt(d);
+        const float frac_part = d - static_cast<float> (d_floor);
+
+        return frac_part*line[(position - 1 - d_floor) & mask] + (1-frac_part)*line[(position - d_floor) & mask];
+    }
+
+    /** renderDetail for one combination of the stages the two levels need,
+        so the per-sample loop has no branches on them.
+    */
+    template <bool HeadShadow, bool Pinna, bool Panned>
+    void renderStages (const SceneKernels::Args& args, int s, Detail from, Detail to, float fadeStart, float fadeInc)
+    {
+        using BrownDudaModel::rho_k;
+        constexpr int numEvents = BrownDudaModel::numPinnaEvents;
+
+        const int lineMask = args.lineMask;
+        const int pinnaLineMask = args.pinnaLineMask;
+        const float ramp = args.ramp;
+        const float pinnaGain = SceneKernels::getPinnaGain();
+        const float a1 = args.a1_head_shadow;
+
+        const float* const in_buffer = args.inputs[s] + args.start;
+        float* const inputLine = args.inputLines + static_cast<size_t> (s) * args.lineSize;
+
+        // Ramps for both ears of this source, as in renderScalar
+        float delSamples[2], delSamples_inc[2];
+        float b0[2], b0_inc[2], b1[2], b1_inc[2];
+        float tau[2][numEvents], tau_inc[2][numEvents];
+        float outVal_prev[2], outVal_head_shadow_prev[2];
+        float panGain[2], panGain_inc[2];
+        float* headShadowLine[2];
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            auto& ear = args.ears[channel];
+
+            delSamples[channel] = ear.delSamples[s];
+            delSamples_inc[channel] = (ear.delSamples_target[s] - ear.delSamples[s]) * ramp;
+            b0[channel] = ear.b0[s];
+            b0_inc[channel] = (ear.b0_target[s] - ear.b0[s]) * ramp;
+            b1[channel] = ear.b1[s];
+            b1_inc[channel] = (ear.b1_target[s] - ear.b1[s]) * ramp;
+
+            for (int iEvent = 0; iEvent < numEvents; iEvent++)
+            {
+                tau[channel][iEvent] = ear.tau[iEvent][s];
+                tau_inc[channel][iEvent] = (ear.tau_target[iEvent][s] - ear.tau[iEvent][s]) * ramp;
+            }
+
+            outVal_prev[channel] = ear.outVal_prev[s];
+            outVal_head_shadow_prev[channel] = ear.outVal_head_shadow_prev[s];
+            headShadowLine[channel] = args.headShadowLines + (static_cast<size_t> (channel) * args.numSources + s) * args.pinnaLineSize;
+
+            // Panned keeps the spectrum flat and follows the head shadow's level only
+            panGain[channel] = SceneKernels::getHeadShadowGain(ear.b0[s], ear.b1[s], a1) * pinnaGain;
+            panGain_inc[channel] = (SceneKernels::getHeadShadowGain(ear.b0_target[s], ear.b1_target[s], a1) * pinnaGain - panGain[channel]) * ramp;
+        }
+
+        float g = args.gain[s];
+        const float g_inc = (args.gain_target[s] - args.gain[s]) * ramp;
+
+        float roomDelay = args.roomDelay[s];
+        const float roomDelay_inc = (args.roomDelay_target[s] - args.roomDelay[s]) * ramp;
+
+        float airPole = args.airPole[s];
+        const float airPole_inc = (args.airPole_target[s] - args.airPole[s]) * ramp;
+        float airState = args.airState[s];
+
+        const int fromIndex = static_cast<int> (from);
+        const int toIndex = static_cast<int> (to);
+
+        for (int i = 0; i < args.numSamples; ++i)
+        {
+            const int writePointer = (args.writePointer + i) & lineMask;
+            const int readPointer = writePointer - args.initLatency;
+
+            // Air absorption, then populate buffer, shared by both ears
+            airPole += airPole_inc;
+            airState = (1-airPole)*in_buffer[i] + airPole*airState;
+
+            inputLine[writePointer] = airState;
+
+            g += g_inc;
+
+            // Room model, the same for both ears and at every level of detail
+            roomDelay += roomDelay_inc;
+            const float outVal_room = args.Ke_ampl * readLinear(inputLine, lineMask, readPointer, roomDelay);
+
+            if (args.reverbSend != nullptr)
+                args.reverbSend[args.start + i] += outVal_room * g;
+
+            const float weight = std::min(1.0f, fadeStart + fadeInc * static_cast<float> (i + 1));
+
+            delSamples[0] += delSamples_inc[0];
+            delSamples[1] += delSamples_inc[1];
+
+            // One read at the mean of the ears' delays, after the pinna's latency
+            float direct = 0;
+            if (Panned)
+                direct = readLinear(inputLine, lineMask, readPointer, 0.5f * (delSamples[0] + delSamples[1]) + static_cast<float> (args.initLatency));
+
+            float out[2];
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                float level[4] = {}; // output at each Detail
+
+                if (Panned)
+                {
+                    panGain[channel] += panGain_inc[channel];
+                    level[static_cast<int> (Detail::panned)] = direct * panGain[channel];
+                }
+
+                if (HeadShadow)
+                {
+                    // ITD
+                    const float outVal = readLinear(inputLine, lineMask, readPointer, delSamples[channel]);
+
+                    // HEAD SHADOW FILTER
+                    b0[channel] += b0_inc[channel];
+                    b1[channel] += b1_inc[channel];
+
+                    const float outVal_head_shadow = b0[channel] * outVal + b1[channel] * outVal_prev[channel] - a1 * outVal_head_shadow_prev[channel];
+
+                    outVal_prev[channel] = outVal;
+                    outVal_head_shadow_prev[channel] = outVal_head_shadow;
+
+                    float* const line = headShadowLine[channel];
+                    line[writePointer & pinnaLineMask] = outVal_head_shadow;
+
+                    // Where the pinna reads from, without the reflections
+                    level[static_cast<int> (Detail::reduced)] = line[readPointer & pinnaLineMask] * pinnaGain;
+
+                    if (Pinna)
+                    {
+                        // PINNA MODEL
+                        float outVal_post_pinnae = 0;
+                        for (int iEvent = 0; iEvent < numEvents; iEvent++)
+                        {
+                            tau[channel][iEvent] += tau_inc[channel][iEvent];
+                            outVal_post_pinnae += rho_k[iEvent] * readLinear(line, pinnaLineMask, readPointer, tau[channel][iEvent]);
+                        }
+
+                        level[static_cast<int> (Detail::full)] = outVal_post_pinnae;
+                    }
+                }
+
+                const float mixed = (1 - weight) * level[fromIndex] + weight * level[toIndex];
+
+                out[channel] = (mixed + outVal_room) * g;
+            }
+
+            args.outputL[args.start + i] += out[0];
+            args.outputR[args.start + i] += out[1];
+        }
+
+        // Store the filter states and land exactly on the targets. Without
+        // the head shadow they go stale; the scene runs the filter again over
+        // the input line before it goes back to a level that needs them.
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            auto& ear = args.ears[channel];
+
+            ear.outVal_prev[s] = outVal_prev[channel];
+            ear.outVal_head_shadow_prev[s] = outVal_head_shadow_prev[channel];
+
+            ear.delSamples[s] = ear.delSamples_target[s];
+            ear.b0[s] = ear.b0_target[s];
+            ear.b1[s] = ear.b1_target[s];
+            for (int iEvent = 0; iEvent < numEvents; iEvent++)
+                ear.tau[iEvent][s] = ear.tau_target[iEvent][s];
+        }
+
+        args.gain[s] = args.gain_target[s];
+        args.roomDelay[s] = args.roomDelay_target[s];
+        args.airPole[s] = args.airPole_target[s];
+        args.airState[s] = airState;
+    }
+}
+
+float SceneKernels::getPinnaGain()
+{
+    float sum = 0;
+    for (float rho : BrownDudaModel::rho_k)
+        sum += rho * rho;
+
+    return std::sqrt(sum);
+}
+
+float SceneKernels::getHeadShadowGain (float b0, float b1, float a1)
+{
+    const float tail = b1 - a1 * b0;
+    return std::sqrt(b0 * b0 + tail * tail / (1 - a1 * a1));
+}
+
+void SceneKernels::renderDetail (const Args& args, int s, Detail from, Detail to, float fadeStart, float fadeInc)
+{
+    const bool pinna = from == Detail::full || to == Detail::full;
+    const bool headShadow = pinna || from == Detail::reduced || to == Detail::reduced;
+    const bool panned = from == Detail::panned || to == Detail::panned;
+
+    if (pinna && panned)            renderStages<true, true, true> (args, s, from, to, fadeStart, fadeInc);
+    else if (pinna)                 renderStages<true, true, false> (args, s, from, to, fadeStart, fadeInc);
+    else if (headShadow && panned)  renderStages<true, false, true> (args, s, from, to, fadeStart, fadeInc);
+    else if (headShadow)            renderStages<true, false, false> (args, s, from, to, fadeStart, fadeInc);
+    else                            renderStages<false, false, true> (args, s, from, to, fadeStart, fadeInc);
+}
+
+void SceneKernels::renderDetailScalar (const Args& args, int firstSource, int count, Detail detail)
+{
+    if (detail == Detail::full)
+    {
+        renderScalar (args, firstSource, count);
+        return;
+    }
+
+    for (int s = firstSource; s < firstSource + count; ++s)
+        renderDetail (args, s, detail, detail, 1.0f, 0.0f);
+}
@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    SceneKernels.h
+
+    Per-sample inner loop of BinauralScene: air absorption, ITD read, head
+    shadow filter, 5-tap pinna model and room echo for a range of sources,
+    plus the room echo sent to the reverb bus.
+
+    The scalar kernel renders one source at a time. The SSE4.1 and AVX2
+    kernels render 4 or 8 sources in lockstep, one source per lane, so the
+    pinna taps become vector gathers and the head shadow update a handful of
+    vector multiply-adds. The best kernel the CPU supports is picked at run
+    time; sources left over after the last full register go through the
+    scalar kernel.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "BrownDudaModel.h"
+
+//==============================================================================
+namespace SceneKernels
+{
+    //==============================================================================
+    /** Raw views into the structure-of-arrays state of a BinauralScene for one
+        control block. Arrays are indexed by source.
+    */
+    struct Args
+    {
+        const float* const* inputs;
+        float* outputL;
+        float* outputR;
+
+        int start; // first sample of the control block
+        int numSamples;
+        float ramp; // 1 / numSamples
+
+        float* inputLines; // [source][lineSize]
+        float* headShadowLines; // [ear][source][pinnaLineSize]
+        int numSources;
+        int lineSize;
+        int lineMask;
+        int pinnaLineSize;
+        int pinnaLineMask;
+        int writePointer; // write position of the first sample of the control block
+        int initLatency;
+
+        struct Ear
+        {
+            float* delSamples;
+            const float* delSamples_target;
+            float* b0;
+            const float* b0_target;
+            float* b1;
+            const float* b1_target;
+            float* tau[BrownDudaModel::numPinnaEvents];
+            const float* tau_target[BrownDudaModel::numPinnaEvents];
+
+            float* outVal_prev;
+            float* outVal_head_shadow_prev;
+        };
+
+        Ear ears[2];
+
+        float* gain;
+        const float* gain_target;
+
+        float* roomDelay; // room echo delay in samples, includes the propagation delay
+        const float* roomDelay_target;
+
+        float* airPole; // air absorption low pass
+        const float* airPole_target;
+        float* airState;
+
+        float a1_head_shadow;
+        float Ke_ampl;
+
+        float* reverbSend; // the room echo of all sources is added here, nullptr while the reverb is off
+    };
+
+    /** Renders sources [firstSource, firstSource + count) and adds them to
+        the outputs. Ramps are advanced and land on their targets.
+    */
+    using Kernel = void (*) (const Args&, int firstSource, int count);
+
+    //==============================================================================
+    /** How much of the model a source is rendered with, dearest first.
+        Every level but skipped keeps the source's input line and room echo
+        going, so it can move to any other level without a gap.
+    */
+    enum class Detail : unsigned char
+    {
+        full,       // ITD, head shadow, pinna and room echo
+        reduced,    // ITD and head shadow, the pinna replaced by its gain
+        panned,     // one delayed read with a gain per ear, no filters
+        skipped     // nothing rendered, the lines are left as they are
+    };
+
+    /** Broadband gain of the pinna taps, sqrt (sum rho_k^2). The cheaper
+        levels are scaled to the full model's level for white noise.
+    */
+    float getPinnaGain();
+
+    /** Broadband gain of the head shadow filter, the square root of the
+        power of its impulse response b0, (b1 - a1 b0) (-a1)^(n - 1).
+    */
+    float getHeadShadowGain (float b0, float b1, float a1);
+
+    /** Renders sources [firstSource, firstSource + count) at one level of
+        detail, other than skipped, like a Kernel.
+    */
+    using DetailKernel = void (*) (const Args&, int firstSource, int count, Detail detail);
+
+    /** Renders one source while it crossfades between two levels of detail:
+        the weight of `to` starts at fadeStart, rises by fadeInc per sample
+        and stops at 1. Adds to the outputs and lands the ramps like a
+        Kernel. Scalar; the head shadow filter only runs if either level
+        needs it.
+    */
+    void renderDetail (const Args&, int source, Detail from, Detail to, float fadeStart, float fadeInc);
+
+    //==============================================================================
+    enum class SimdLevel
+    {
+        scalar,
+        sse41,
+        avx2
+    };
+
+    /** The widest instruction set the running CPU supports. */
+    SimdLevel detectSimdLevel();
+
+    /** Number of sources rendered per register at the given level. */
+    int getNumLanes (SimdLevel level);
+
+    /** The kernel for the given level, clamped to what the CPU supports. */
+    Kernel getKernel (SimdLevel level);
+    DetailKernel getDetailKernel (SimdLevel level);
+
+    const char* getName (SimdLevel level);
+
+    //==============================================================================
+    void renderScalar (const Args&, int firstSource, int count);
+    void renderSSE41 (const Args&, int firstSource, int count);
+    void renderAVX2 (const Args&, int firstSource, int count);
+
+    void renderDetailScalar (const Args&, int firstSource, int count, Detail detail);
+    void renderDetailSSE41 (const Args&, int firstSource, int count, Detail detail);
+    void renderDetailAVX2 (const Args&, int firstSource, int count, Detail detail);
+}
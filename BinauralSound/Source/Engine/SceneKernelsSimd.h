@@ -0,0 +1,305 @@
+/*
+  ==============================================================================
+
+    SceneKernelsSimd.h
+
+    Vector kernel shared by the SSE4.1 and AVX2 translation units. Each of
+    them includes this file after defining its register traits `V` inside a
+    target-specific region, so the same code compiles for both widths.
+
+    Lane n of every register belongs to source firstSource + n. The math and
+    its evaluation order are the same as in renderScalar(), so results only
+    differ from the scalar kernel by the order in which the sources are
+    summed into the outputs. The reduced and panned levels of detail leave
+    out the stages they do not need and follow renderDetail() instead.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SceneKernels.h"
+
+namespace SceneKernels
+{
+namespace Simd
+{
+    //==============================================================================
+    template <typename V, Detail Level>
+    void renderGroup (const Args& args, int s)
+    {
+        static_assert (Level != Detail::skipped, "skipped sources are not rendered");
+
+        using F = typename V::Float;
+        using I = typename V::Int;
+        using BrownDudaModel::rho_k;
+
+        constexpr int W = V::width;
+        constexpr int numEvents = BrownDudaModel::numPinnaEvents;
+
+        const F ramp = V::set1 (args.ramp);
+        const F one = V::set1 (1.0f);
+        const I mask = V::set1i (args.lineMask);
+        const I pinnaMask = V::set1i (args.pinnaLineMask);
+
+        // Offsets of each lane's lines
+        alignas (32) int laneOffsets[W], pinnaLaneOffsets[W];
+        for (int lane = 0; lane < W; ++lane)
+        {
+            laneOffsets[lane] = (s + lane) * args.lineSize;
+            pinnaLaneOffsets[lane] = (s + lane) * args.pinnaLineSize;
+        }
+
+        const I inputLineBase = V::loadi (laneOffsets);
+
+        I headShadowLineBase[2];
+        for (int channel = 0; channel < 2; ++channel)
+            headShadowLineBase[channel] = V::addi (V::loadi (pinnaLaneOffsets), V::set1i (channel * args.numSources * args.pinnaLineSize));
+
+        // Ramps for both ears
+        F delSamples[2], delSamples_inc[2];
+        F b0[2], b0_inc[2], b1[2], b1_inc[2];
+        F tau[2][numEvents], tau_inc[2][numEvents];
+        F outVal_prev[2], outVal_head_shadow_prev[2];
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            auto& ear = args.ears[channel];
+
+            delSamples[channel] = V::load (ear.delSamples + s);
+            delSamples_inc[channel] = V::mul (V::sub (V::load (ear.delSamples_target + s), delSamples[channel]), ramp);
+            b0[channel] = V::load (ear.b0 + s);
+            b0_inc[channel] = V::mul (V::sub (V::load (ear.b0_target + s), b0[channel]), ramp);
+            b1[channel] = V::load (ear.b1 + s);
+            b1_inc[channel] = V::mul (V::sub (V::load (ear.b1_target + s), b1[channel]), ramp);
+
+            for (int iEvent = 0; iEvent < numEvents; iEvent++)
+            {
+                tau[channel][iEvent] = V::load (ear.tau[iEvent] + s);
+                tau_inc[channel][iEvent] = V::mul (V::sub (V::load (ear.tau_target[iEvent] + s), tau[channel][iEvent]), ramp);
+            }
+
+            outVal_prev[channel] = V::load (ear.outVal_prev + s);
+            outVal_head_shadow_prev[channel] = V::load (ear.outVal_head_shadow_prev + s);
+        }
+
+        // Panned follows the head shadow's broadband gain instead of running it
+        F panGain[2], panGain_inc[2];
+
+        if constexpr (Level == Detail::panned)
+        {
+            alignas (32) float gains[W], targets[W];
+            const float pinnaGain = getPinnaGain();
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                auto& ear = args.ears[channel];
+
+                for (int lane = 0; lane < W; ++lane)
+                {
+                    gains[lane] = getHeadShadowGain (ear.b0[s + lane], ear.b1[s + lane], args.a1_head_shadow) * pinnaGain;
+                    targets[lane] = getHeadShadowGain (ear.b0_target[s + lane], ear.b1_target[s + lane], args.a1_head_shadow) * pinnaGain;
+                }
+
+                panGain[channel] = V::load (gains);
+                panGain_inc[channel] = V::mul (V::sub (V::load (targets), panGain[channel]), ramp);
+            }
+        }
+
+        F g = V::load (args.gain + s);
+        const F g_inc = V::mul (V::sub (V::load (args.gain_target + s), g), ramp);
+
+        F roomDelay = V::load (args.roomDelay + s);
+        const F roomDelay_inc = V::mul (V::sub (V::load (args.roomDelay_target + s), roomDelay), ramp);
+
+        F airPole = V::load (args.airPole + s);
+        const F airPole_inc = V::mul (V::sub (V::load (args.airPole_target + s), airPole), ramp);
+        F airState = V::load (args.airState + s);
+
+        const F a1 = V::set1 (args.a1_head_shadow);
+        const F Ke_ampl = V::set1 (args.Ke_ampl);
+        const F pinnaGain = V::set1 (getPinnaGain());
+
+        alignas (32) float lanes[W];
+
+        for (int i = 0; i < args.numSamples; ++i)
+        {
+            const int writePointer = (args.writePointer + i) & args.lineMask;
+            const int readPointer = writePointer - args.initLatency;
+
+            // Air absorption, then populate buffers, one line per lane
+            for (int lane = 0; lane < W; ++lane)
+                lanes[lane] = args.inputs[s + lane][args.start + i];
+
+            airPole = V::add (airPole, airPole_inc);
+            airState = V::add (V::mul (V::sub (one, airPole), V::load (lanes)), V::mul (airPole, airState));
+
+            V::store (lanes, airState);
+            for (int lane = 0; lane < W; ++lane)
+                args.inputLines[laneOffsets[lane] + writePointer] = lanes[lane];
+
+            g = V::add (g, g_inc);
+
+            const I readPointer_1 = V::set1i (readPointer - 1);
+            const I readPointer_0 = V::set1i (readPointer);
+
+            // Room model
+            roomDelay = V::add (roomDelay, roomDelay_inc);
+            const F roomDelay_floor = V::floor (roomDelay);
+            const F room_frac_part = V::sub (roomDelay, roomDelay_floor);
+            const I roomDelay_int = V::toInt (roomDelay_floor);
+
+            const F room_1 = V::gather (args.inputLines, V::addi (inputLineBase, V::andi (V::subi (readPointer_1, roomDelay_int), mask)));
+            const F room_0 = V::gather (args.inputLines, V::addi (inputLineBase, V::andi (V::subi (readPointer_0, roomDelay_int), mask)));
+            const F outVal_room = V::mul (Ke_ampl, V::add (V::mul (room_frac_part, room_1), V::mul (V::sub (one, room_frac_part), room_0)));
+
+            if (args.reverbSend != nullptr)
+                args.reverbSend[args.start + i] += V::sum (V::mul (outVal_room, g));
+
+            F out[2];
+
+            if constexpr (Level == Detail::panned)
+            {
+                // One read at the mean of the ears' delays, after the pinna's latency
+                delSamples[0] = V::add (delSamples[0], delSamples_inc[0]);
+                delSamples[1] = V::add (delSamples[1], delSamples_inc[1]);
+
+                const F delay = V::add (V::mul (V::set1 (0.5f), V::add (delSamples[0], delSamples[1])), V::set1 (static_cast<float> (args.initLatency)));
+                const F delay_floor = V::floor (delay);
+                const F frac_part = V::sub (delay, delay_floor);
+                const I delay_int = V::toInt (delay_floor);
+
+                const F direct = V::add (V::mul (frac_part, V::gather (args.inputLines, V::addi (inputLineBase, V::andi (V::subi (readPointer_1, delay_int), mask)))),
+                                         V::mul (V::sub (one, frac_part), V::gather (args.inputLines, V::addi (inputLineBase, V::andi (V::subi (readPointer_0, delay_int), mask)))));
+
+                for (int channel = 0; channel < 2; ++channel)
+                {
+                    panGain[channel] = V::add (panGain[channel], panGain_inc[channel]);
+                    out[channel] = V::mul (V::add (V::mul (direct, panGain[channel]), outVal_room), g);
+                }
+            }
+            else
+            {
+                for (int channel = 0; channel < 2; ++channel)
+                {
+                    // ITD
+                    delSamples[channel] = V::add (delSamples[channel], delSamples_inc[channel]);
+                    const F delSamples_floor = V::floor (delSamples[channel]);
+                    const F frac_part = V::sub (delSamples[channel], delSamples_floor);
+                    const I delSamples_int = V::toInt (delSamples_floor);
+
+                    const I outPointer = V::addi (inputLineBase, V::andi (V::subi (readPointer_1, delSamples_int), mask));
+                    const I outPointer_frac = V::addi (inputLineBase, V::andi (V::subi (readPointer_0, delSamples_int), mask));
+
+                    const F outVal = V::add (V::mul (frac_part, V::gather (args.inputLines, outPointer)),
+                                             V::mul (V::sub (one, frac_part), V::gather (args.inputLines, outPointer_frac)));
+
+                    // HEAD SHADOW FILTER
+                    b0[channel] = V::add (b0[channel], b0_inc[channel]);
+                    b1[channel] = V::add (b1[channel], b1_inc[channel]);
+
+                    const F outVal_head_shadow = V::sub (V::add (V::mul (b0[channel], outVal), V::mul (b1[channel], outVal_prev[channel])),
+                                                         V::mul (a1, outVal_head_shadow_prev[channel]));
+
+                    outVal_prev[channel] = outVal;
+                    outVal_head_shadow_prev[channel] = outVal_head_shadow;
+
+                    // PINNA MODEL
+                    V::store (lanes, outVal_head_shadow);
+                    float* const headShadowLines = args.headShadowLines + static_cast<size_t> (channel) * args.numSources * args.pinnaLineSize;
+                    for (int lane = 0; lane < W; ++lane)
+                        headShadowLines[pinnaLaneOffsets[lane] + (writePointer & args.pinnaLineMask)] = lanes[lane];
+
+                    if constexpr (Level == Detail::reduced)
+                    {
+                        // Where the pinna reads from, without the reflections
+                        const F tap = V::gather (args.headShadowLines, V::addi (headShadowLineBase[channel], V::andi (readPointer_0, pinnaMask)));
+
+                        out[channel] = V::mul (V::add (V::mul (tap, pinnaGain), outVal_room), g);
+                    }
+                    else
+                    {
+                        F outVal_post_pinnae = V::set1 (0.0f);
+                        for (int iEvent = 0; iEvent < numEvents; iEvent++)
+                        {
+                            tau[channel][iEvent] = V::add (tau[channel][iEvent], tau_inc[channel][iEvent]);
+
+                            const F tau_samples = V::floor (tau[channel][iEvent]);
+                            const F tau_samples_frac_part = V::sub (tau[channel][iEvent], tau_samples);
+                            const I tau_int = V::toInt (tau_samples);
+
+                            const I outPointer_k = V::addi (headShadowLineBase[channel], V::andi (V::subi (readPointer_1, tau_int), pinnaMask));
+                            const I outPointer_k_frac = V::addi (headShadowLineBase[channel], V::andi (V::subi (readPointer_0, tau_int), pinnaMask));
+
+                            const F tap = V::add (V::mul (tau_samples_frac_part, V::gather (args.headShadowLines, outPointer_k)),
+                                                  V::mul (V::sub (one, tau_samples_frac_part), V::gather (args.headShadowLines, outPointer_k_frac)));
+
+                            outVal_post_pinnae = V::add (outVal_post_pinnae, V::mul (V::set1 (rho_k[iEvent]), tap));
+                        }
+
+                        out[channel] = V::mul (V::add (outVal_post_pinnae, outVal_room), g);
+                    }
+                }
+            }
+
+            args.outputL[args.start + i] += V::sum (out[0]);
+            args.outputR[args.start + i] += V::sum (out[1]);
+        }
+
+        // Store the filter states and land exactly on the targets
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            auto& ear = args.ears[channel];
+
+            V::store (ear.outVal_prev + s, outVal_prev[channel]);
+            V::store (ear.outVal_head_shadow_prev + s, outVal_head_shadow_prev[channel]);
+
+            V::store (ear.delSamples + s, V::load (ear.delSamples_target + s));
+            V::store (ear.b0 + s, V::load (ear.b0_target + s));
+            V::store (ear.b1 + s, V::load (ear.b1_target + s));
+            for (int iEvent = 0; iEvent < numEvents; iEvent++)
+                V::store (ear.tau[iEvent] + s, V::load (ear.tau_target[iEvent] + s));
+        }
+
+        V::store (args.gain + s, V::load (args.gain_target + s));
+        V::store (args.roomDelay + s, V::load (args.roomDelay_target + s));
+        V::store (args.airPole + s, V::load (args.airPole_target + s));
+        V::store (args.airState + s, airState);
+    }
+
+    //==============================================================================
+    template <typename V>
+    void render (const Args& args, int firstSource, int count)
+    {
+        const int end = firstSource + count;
+        int s = firstSource;
+
+        for (; s + V::width <= end; s += V::width)
+            renderGroup<V, Detail::full> (args, s);
+
+        if (s < end)
+            renderScalar (args, s, end - s);
+    }
+
+    template <typename V>
+    void renderDetail (const Args& args, int firstSource, int count, Detail detail)
+    {
+        const int end = firstSource + count;
+        int s = firstSource;
+
+        for (; s + V::width <= end; s += V::width)
+        {
+            switch (detail)
+            {
+                case Detail::full:      renderGroup<V, Detail::full> (args, s); break;
+                case Detail::reduced:   renderGroup<V, Detail::reduced> (args, s); break;
+                case Detail::panned:    renderGroup<V, Detail::panned> (args, s); break;
+                case Detail::skipped:   break;
+            }
+        }
+
+        if (s < end)
+            renderDetailScalar (args, s, end - s, detail);
+    }
+}
+}
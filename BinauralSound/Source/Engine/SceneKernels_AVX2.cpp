@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    SceneKernels_AVX2.cpp
+
+    8 sources per register. Only called after SceneKernels::getKernel() has
+    checked that the CPU supports AVX2.
+
+  ==============================================================================
+*/
+
+#include "SceneKernels.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+ #pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+ #pragma GCC push_options
+ #pragma GCC target("avx2")
+#endif
+
+namespace
+{
+    struct AVX2
+    {
+        using Float = __m256;
+        using Int = __m256i;
+        static constexpr int width = 8;
+
+        static Float set1 (float x)                     { return _mm256_set1_ps (x); }
+        static Float load (const float* p)              { return _mm256_loadu_ps (p); }
+        static void store (float* p, Float x)           { _mm256_storeu_ps (p, x); }
+        static Float add (Float a, Float b)             { return _mm256_add_ps (a, b); }
+        static Float sub (Float a, Float b)             { return _mm256_sub_ps (a, b); }
+        static Float mul (Float a, Float b)             { return _mm256_mul_ps (a, b); }
+        static Float floor (Float x)                    { return _mm256_floor_ps (x); }
+
+        static Int set1i (int x)                        { return _mm256_set1_epi32 (x); }
+        static Int loadi (const int* p)                 { return _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (p)); }
+        static Int addi (Int a, Int b)                  { return _mm256_add_epi32 (a, b); }
+        static Int subi (Int a, Int b)                  { return _mm256_sub_epi32 (a, b); }
+        static Int andi (Int a, Int b)                  { return _mm256_and_si256 (a, b); }
+        static Int toInt (Float x)                      { return _mm256_cvttps_epi32 (x); }
+
+        static Float gather (const float* base, Int index)  { return _mm256_i32gather_ps (base, index, 4); }
+
+        static float sum (Float x)
+        {
+            alignas (32) float lanes[width];
+            _mm256_store_ps (lanes, x);
+
+            float total = 0;
+            for (float lane : lanes)
+                total += lane;
+            return total;
+        }
+    };
+}
+
+#include "SceneKernelsSimd.h"
+
+void SceneKernels::renderAVX2 (const Args& args, int firstSource, int count)
+{
+    Simd::render<AVX2> (args, firstSource, count);
+}
+
+void SceneKernels::renderDetailAVX2 (const Args& args, int firstSource, int count, Detail detail)
+{
+    Simd::renderDetail<AVX2> (args, firstSource, count, detail);
+}
+
+#if defined(__clang__)
+ #pragma clang attribute pop
+#elif defined(__GNUC__)
+ #pragma GCC pop_options
+#endif
+
+#else
+
+void SceneKernels::renderAVX2 (const Args& args, int firstSource, int count)
+{
+    renderScalar (args, firstSource, count);
+}
+
+void SceneKernels::renderDetailAVX2 (const Args& args, int firstSource, int count, Detail detail)
+{
+    renderDetailScalar (args, firstSource, count, detail);
+}
+
+#endif
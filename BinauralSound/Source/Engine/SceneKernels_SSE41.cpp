@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    SceneKernels_SSE41.cpp
+
+    4 sources per register. SSE has no gather instruction, so the delay line
+    reads are four scalar loads; the rest of the chain is vectorised.
+
+  ==============================================================================
+*/
+
+#include "SceneKernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+
+#include <smmintrin.h>
+
+#if defined(__clang__)
+ #pragma clang attribute push (__attribute__((target("sse4.1"))), apply_to = function)
+#elif defined(__GNUC__)
+ #pragma GCC push_options
+ #pragma GCC target("sse4.1")
+#endif
+
+namespace
+{
+    struct SSE41
+    {
+        using Float = __m128;
+        using Int = __m128i;
+        static constexpr int width = 4;
+
+        static Float set1 (float x)                     { return _mm_set1_ps (x); }
+        static Float load (const float* p)              { return _mm_loadu_ps (p); }
+        static void store (float* p, Float x)           { _mm_storeu_ps (p, x); }
+        static Float add (Float a, Float b)             { return _mm_add_ps (a, b); }
+        static Float sub (Float a, Float b)             { return _mm_sub_ps (a, b); }
+        static Float mul (Float a, Float b)             { return _mm_mul_ps (a, b); }
+        static Float floor (Float x)                    { return _mm_floor_ps (x); }
+
+        static Int set1i (int x)                        { return _mm_set1_epi32 (x); }
+        static Int loadi (const int* p)                 { return _mm_loadu_si128 (reinterpret_cast<const __m128i*> (p)); }
+        static Int addi (Int a, Int b)                  { return _mm_add_epi32 (a, b); }
+        static Int subi (Int a, Int b)                  { return _mm_sub_epi32 (a, b); }
+        static Int andi (Int a, Int b)                  { return _mm_and_si128 (a, b); }
+        static Int toInt (Float x)                      { return _mm_cvttps_epi32 (x); }
+
+        static Float gather (const float* base, Int index)
+        {
+            return _mm_setr_ps (base[_mm_extract_epi32 (index, 0)],
+                                base[_mm_extract_epi32 (index, 1)],
+                                base[_mm_extract_epi32 (index, 2)],
+                                base[_mm_extract_epi32 (index, 3)]);
+        }
+
+        static float sum (Float x)
+        {
+            alignas (16) float lanes[width];
+            _mm_store_ps (lanes, x);
+
+            return ((lanes[0] + lanes[1]) + lanes[2]) + lanes[3];
+        }
+    };
+}
+
+#include "SceneKernelsSimd.h"
+
+void SceneKernels::renderSSE41 (const Args& args, int firstSource, int count)
+{
+    Simd::render<SSE41> (args, firstSource, count);
+}
+
+void SceneKernels::renderDetailSSE41 (const Args& args, int firstSource, int count, Detail detail)
+{
+    Simd::renderDetail<SSE41> (args, firstSource, count, detail);
+}
+
+#if defined(__clang__)
+ #pragma clang attribute pop
+#elif defined(__GNUC__)
+ #pragma GCC pop_options
+#endif
+
+#else
+
+void SceneKernels::renderSSE41 (const Args& args, int firstSource, int count)
+{
+    renderScalar (args, firstSource, count);
+}
+
+void SceneKernels::renderDetailSSE41 (const Args& args, int firstSource, int count, Detail detail)
+{
+    renderDetailScalar (args, firstSource, count, detail);
+}
+
+#endif
@@ -0,0 +1,273 @@
+/*
+  ==============================================================================
+
+    SceneThreadPool.cpp
+
+  ==============================================================================
+*/
+
+#include "SceneThreadPool.h"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #include <windows.h>
+ #if defined(_MSC_VER)
+  #pragma comment(lib, "Synchronization.lib") // WaitOnAddress
+ #endif
+#else
+ #include <pthread.h>
+ #include <sched.h>
+#endif
+
+#if defined(__linux__)
+ #include <climits>
+ #include <ctime>
+ #include <linux/futex.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+ #include <immintrin.h>
+ #define BINAURAL_X86 1
+#else
+ #define BINAURAL_X86 0
+#endif
+
+namespace
+{
+    /** Tells the core this thread is waiting on memory, in a spin loop. */
+    inline void cpuPause()
+    {
+       #if BINAURAL_X86
+        _mm_pause();
+       #else
+        std::this_thread::yield();
+       #endif
+    }
+
+    /** Asks for real-time scheduling of the calling thread, a little below
+        where audio threads usually run. False if the system refuses.
+    */
+    bool setRealtimePriority()
+    {
+       #if defined(_WIN32)
+        return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+       #else
+        sched_param param {};
+        param.sched_priority = std::max (sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO) - 10);
+        return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+       #endif
+    }
+
+    /** Sleeps while word still holds expected, for at most timeout. May
+        return early, callers check what they were waiting for again.
+    */
+    void waitOnAddress (std::atomic<uint32_t>& word, uint32_t expected, std::chrono::microseconds timeout)
+    {
+        static_assert (sizeof (std::atomic<uint32_t>) == sizeof (uint32_t), "the kernel waits on the plain word");
+
+       #if defined(__linux__)
+        timespec relative {};
+        relative.tv_nsec = static_cast<long> (timeout.count() * 1000);
+        syscall(SYS_futex, reinterpret_cast<uint32_t*> (&word), FUTEX_WAIT_PRIVATE, expected, &relative, nullptr, 0);
+       #elif defined(_WIN32)
+        const auto milliseconds = static_cast<DWORD> ((timeout.count() + 999) / 1000);
+        WaitOnAddress(&word, &expected, sizeof (expected), milliseconds);
+       #else
+        // No wait on an address here, poll
+        if (word.load() == expected)
+            std::this_thread::sleep_for(timeout);
+       #endif
+    }
+
+    /** Wakes every thread in waitOnAddress() on word. Does not block. */
+    void wakeAllOnAddress (std::atomic<uint32_t>& word)
+    {
+       #if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<uint32_t*> (&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+       #elif defined(_WIN32)
+        WakeByAddressAll(&word);
+       #else
+        (void) word;
+       #endif
+    }
+}
+
+//==============================================================================
+SceneThreadPool::SceneThreadPool (int numWorkers)
+    : ranges (new Range[std::max (0, numWorkers) + 1])
+{
+    for (int i = 0; i < numWorkers; ++i)
+        threads.emplace_back([this, i] { runWorker(i + 1); });
+}
+
+SceneThreadPool::~SceneThreadPool()
+{
+    stopping = true;
+    wakeWorkers();
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+int SceneThreadPool::getDefaultNumWorkers()
+{
+    // hardware_concurrency() may not know, then assume two cores
+    const int numCores = static_cast<int> (std::thread::hardware_concurrency());
+    return std::max (0, (numCores > 0 ? numCores : 2) - 1);
+}
+
+//==============================================================================
+void SceneThreadPool::run (Job& jobToRun, int numTasks)
+{
+    if (numTasks <= 0)
+        return;
+
+    const int numThreads = getNumThreads();
+
+    // Everything a worker needs is in place before it can take a task
+    job.store(&jobToRun);
+    remaining.store(numTasks);
+
+    for (int thread = 0; thread < numThreads; ++thread)
+    {
+        const auto first = static_cast<uint32_t> (static_cast<int64_t> (numTasks) * thread / numThreads);
+        const auto end = static_cast<uint32_t> (static_cast<int64_t> (numTasks) * (thread + 1) / numThreads);
+
+        ranges[thread].tasks.store(pack(first, end));
+    }
+
+    generation.fetch_add(1);
+
+    // Pairs with sleep(): a worker either sees the new generation before it
+    // waits, or is counted here and woken
+    if (numSleeping.load() > 0)
+        wakeWorkers();
+
+    runTasks(0);
+
+    // The last tasks may still be running elsewhere; they are short
+    while (remaining.load() > 0)
+        cpuPause();
+}
+
+//==============================================================================
+void SceneThreadPool::runWorker (int self)
+{
+    if (setRealtimePriority())
+        ++numRealtimeWorkers;
+
+    uint64_t seen = generation.load();
+
+    while (! stopping.load())
+    {
+        if (generation.load() != seen)
+        {
+            seen = generation.load();
+            runTasks(self);
+            continue;
+        }
+
+        // The next block is probably less than a period away
+        const auto spinUntil = std::chrono::steady_clock::now() + spinTime;
+
+        while (generation.load() == seen && ! stopping.load() && std::chrono::steady_clock::now() < spinUntil)
+            cpuPause();
+
+        if (generation.load() != seen || stopping.load())
+            continue;
+
+        sleep(seen);
+    }
+}
+
+void SceneThreadPool::sleep (uint64_t seen)
+{
+    numSleeping.fetch_add(1);
+
+    // The epoch is read before the generation is checked, so a run() after
+    // the check changes it and the wait returns at once
+    const uint32_t epoch = wakeEpoch.load();
+
+    if (generation.load() == seen && ! stopping.load())
+        waitOnAddress(wakeEpoch, epoch, pollInterval);
+
+    numSleeping.fetch_sub(1);
+}
+
+void SceneThreadPool::wakeWorkers()
+{
+    wakeEpoch.fetch_add(1);
+    wakeAllOnAddress(wakeEpoch);
+}
+
+void SceneThreadPool::runTasks (int self)
+{
+    int task;
+
+    while (takeOwnTask(self, task) || stealTask(self, task))
+    {
+        // A task taken belongs to the block being run, whose job is already set
+        job.load()->runTask(task);
+        remaining.fetch_sub(1);
+    }
+}
+
+bool SceneThreadPool::takeOwnTask (int self, int& task)
+{
+    auto& range = ranges[self].tasks;
+    uint64_t tasks = range.load();
+
+    for (;;)
+    {
+        const auto first = static_cast<uint32_t> (tasks >> 32);
+        const auto end = static_cast<uint32_t> (tasks);
+
+        if (first >= end)
+            return false;
+
+        if (range.compare_exchange_weak(tasks, pack(first + 1, end)))
+        {
+            task = static_cast<int> (first);
+            return true;
+        }
+    }
+}
+
+bool SceneThreadPool::stealTask (int self, int& task)
+{
+    const int numThreads = getNumThreads();
+
+    // From the back, furthest from where the owner is working
+    for (int offset = 1; offset < numThreads; ++offset)
+    {
+        auto& range = ranges[(self + offset) % numThreads].tasks;
+        uint64_t tasks = range.load();
+
+        for (;;)
+        {
+            const auto first = static_cast<uint32_t> (tasks >> 32);
+            const auto end = static_cast<uint32_t> (tasks);
+
+            if (first >= end)
+                break;
+
+            if (range.compare_exchange_weak(tasks, pack(first, end - 1)))
+            {
+                task = static_cast<int> (end - 1);
+                numStolenTasks.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
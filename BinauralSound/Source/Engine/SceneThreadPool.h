@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    SceneThreadPool.h
+
+    Worker threads that help the audio thread render one block of a large
+    BinauralScene before the block is due.
+
+    A block is split into a fixed number of tasks (groups of sources). run()
+    deals them out in contiguous ranges, one range per thread, the calling
+    audio thread included, and every thread works through its own range
+    from the front. A thread whose range is empty steals from the back of
+    another one's, so sources that are culled or cheaper than others, or a
+    worker that wakes up late, do not hold up the block: whoever is free
+    takes the rest. Each range is a single atomic word, so taking a task is
+    one compare-and-swap and nothing ever locks on the audio thread.
+
+    Workers spin for a short while after a block, as the next one is
+    usually near, and then sleep on an atomic wake-up counter: a futex on
+    Linux, WaitOnAddress on Windows. run() only bumps the counter and, if
+    a worker is asleep, makes the wake system call, which neither blocks
+    nor takes a lock the workers could hold; there is no mutex or
+    condition variable on the audio thread. Where no such call exists the
+    sleeping workers poll instead. Either way a worker that misses a
+    wake-up looks again after at most pollInterval, by when the others have
+    stolen its tasks. The threads ask for real-time
+    scheduling when they start, which the system may refuse (on Linux it
+    needs the rtprio limit); they then run at normal priority.
+
+    Which thread runs a task changes from block to block, so callers must
+    not let the result depend on it: BinauralScene renders every task into
+    its own partial bus and sums them in task order.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+//==============================================================================
+/**
+*/
+class SceneThreadPool
+{
+public:
+    //==============================================================================
+    /** Work split into tasks that may run on any thread, in any order, and
+        at the same time as each other.
+    */
+    class Job
+    {
+    public:
+        virtual ~Job() = default;
+
+        virtual void runTask (int task) = 0;
+    };
+
+    //==============================================================================
+    /** Starts numWorkers threads; run() adds the calling thread to them. 0
+        workers is allowed and runs every task on the caller.
+    */
+    explicit SceneThreadPool (int numWorkers);
+
+    /** Stops and joins the threads. Not while run() is running. */
+    ~SceneThreadPool();
+
+    /** One worker per core but the one the audio thread runs on. More than
+        that and a spinning worker competes with the audio thread.
+    */
+    static int getDefaultNumWorkers();
+
+    /** Runs tasks 0 to numTasks - 1 of the job on the workers and the
+        calling thread, and returns when all of them have finished. Does not
+        allocate or lock, so the audio thread calls it. One run() at a time.
+    */
+    void run (Job& job, int numTasks);
+
+    //==============================================================================
+    int getNumWorkers() const                   { return static_cast<int> (threads.size()); }
+    int getNumThreads() const                   { return getNumWorkers() + 1; } // with the caller of run()
+
+    /** Workers that were given real-time scheduling. */
+    int getNumRealtimeWorkers() const           { return numRealtimeWorkers.load(); }
+
+    /** Tasks run by another thread than the one they were dealt to, since
+        the pool started.
+    */
+    uint64_t getNumStolenTasks() const          { return numStolenTasks.load(std::memory_order_relaxed); }
+
+    /** A worker keeps looking for the next block this long before it sleeps. */
+    static constexpr std::chrono::microseconds spinTime { 200 };
+
+    /** Longest a sleeping worker can miss a run(). */
+    static constexpr std::chrono::microseconds pollInterval { 500 };
+
+private:
+    //==============================================================================
+    void runWorker (int self);
+    void runTasks (int self);
+
+    void sleep (uint64_t seen);
+    void wakeWorkers();
+
+    bool takeOwnTask (int self, int& task);
+    bool stealTask (int self, int& task);
+
+    // Tasks [first, end) dealt to one thread, packed into one word
+    struct alignas (64) Range
+    {
+        std::atomic<uint64_t> tasks { 0 };
+    };
+
+    static uint64_t pack (uint32_t first, uint32_t end)    { return (static_cast<uint64_t> (first) << 32) | end; }
+
+    std::unique_ptr<Range[]> ranges; // [thread], the caller of run() is 0
+
+    std::atomic<Job*> job { nullptr };
+    std::atomic<int> remaining { 0 }; // tasks of the current block not finished yet
+    std::atomic<uint64_t> generation { 0 }; // counts run()s, workers watch it
+
+    std::atomic<int> numRealtimeWorkers { 0 };
+    std::atomic<uint64_t> numStolenTasks { 0 };
+
+    std::atomic<uint32_t> wakeEpoch { 0 }; // the word sleeping workers wait on
+    std::atomic<int> numSleeping { 0 };
+    std::atomic<bool> stopping { false };
+
+    std::vector<std::thread> threads;
+};
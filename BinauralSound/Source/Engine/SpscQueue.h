@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    SpscQueue.h
+
+    Bounded single-producer / single-consumer queue. push() and pop() are
+    wait-free and never allocate, so one side can be the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+//==============================================================================
+/**
+*/
+template <typename T>
+class SpscQueue
+{
+public:
+    //==============================================================================
+    /** Allocates room for at least capacity items. */
+    explicit SpscQueue (size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity + 1)
+            size <<= 1;
+
+        buffer.resize (size);
+        mask = size - 1;
+    }
+
+    //==============================================================================
+    /** Producer side. Returns false, dropping the item, when the queue is full. */
+    bool push (const T& item)
+    {
+        const size_t write = writeIndex.load (std::memory_order_relaxed);
+        const size_t next = (write + 1) & mask;
+
+        if (next == readIndex.load (std::memory_order_acquire))
+            return false;
+
+        buffer[write] = item;
+        writeIndex.store (next, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer side. Returns false when the queue is empty. */
+    bool pop (T& item)
+    {
+        const size_t read = readIndex.load (std::memory_order_relaxed);
+
+        if (read == writeIndex.load (std::memory_order_acquire))
+            return false;
+
+        item = buffer[read];
+        readIndex.store ((read + 1) & mask, std::memory_order_release);
+        return true;
+    }
+
+    size_t getCapacity() const      { return mask; }
+
+private:
+    //==============================================================================
+    std::vector<T> buffer;
+    size_t mask = 0;
+
+    // On separate cache lines so the two threads don't keep invalidating each other
+    alignas (64) std::atomic<size_t> writeIndex { 0 };
+    alignas (64) std::atomic<size_t> readIndex { 0 };
+};
@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    HeadTrackerReceiver.cpp
+
+  ==============================================================================
+*/
+
+#include "HeadTrackerReceiver.h"
+
+#include <chrono>
+
+//==============================================================================
+HeadTrackerReceiver::HeadTrackerReceiver()
+    : juce::Thread ("Head tracker")
+{
+}
+
+HeadTrackerReceiver::~HeadTrackerReceiver()
+{
+    stop();
+}
+
+bool HeadTrackerReceiver::start (int portToUse)
+{
+    stop();
+
+    socket = std::make_unique<juce::DatagramSocket> (false);
+
+    if (! socket->bindToPort (portToUse, "127.0.0.1"))
+    {
+        socket.reset();
+        portInUse = true;
+        return false;
+    }
+
+    port = portToUse;
+    startThread();
+    return true;
+}
+
+void HeadTrackerReceiver::stop()
+{
+    signalThreadShouldExit();
+
+    if (socket != nullptr)
+        socket->shutdown();
+
+    stopThread (1000);
+    socket.reset();
+    portInUse = false;
+}
+
+double HeadTrackerReceiver::now()
+{
+    return std::chrono::duration<double> (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool HeadTrackerReceiver::parsePacket (const char* data, int size, Sample& sample)
+{
+    return HeadTrackerPacket::parse (data, size, sample.orientation, sample.sentTime);
+}
+
+//==============================================================================
+void HeadTrackerReceiver::run()
+{
+    char buffer[1536];
+
+    while (! threadShouldExit())
+    {
+        // Time out now and then to check for threadShouldExit()
+        if (socket->waitUntilReady (true, 100) != 1)
+            continue;
+
+        const int size = socket->read (buffer, static_cast<int> (sizeof (buffer)), false);
+
+        Sample sample;
+
+        if (size > 0 && parsePacket (buffer, size, sample))
+        {
+            sample.receivedTime = now();
+
+            if (! queue.push (sample))
+                ++numDropped;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    HeadTrackerReceiver.h
+
+    Receives head tracker orientations over UDP on localhost and hands them
+    to the audio thread through a wait-free queue. The OSC and binary
+    packet formats it understands are described in HeadTrackerPacket.h.
+
+    The timestamp, when present, has to be on the same monotonic clock as
+    now() (e.g. Python's time.monotonic() on the same machine). It is used
+    to measure the motion-to-sound latency; see Tools/HeadTrackerSender.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "Engine/HeadOrientation.h"
+#include "Engine/HeadTrackerPacket.h"
+#include "Engine/SpscQueue.h"
+
+//==============================================================================
+/**
+*/
+class HeadTrackerReceiver  : private juce::Thread
+{
+public:
+    //==============================================================================
+    struct Sample
+    {
+        HeadOrientation orientation;
+        double sentTime = 0; // sender's timestamp [s], 0 if the packet had none
+        double receivedTime = 0; // [s]
+    };
+
+    static constexpr int defaultPort = 9000;
+
+    //==============================================================================
+    HeadTrackerReceiver();
+    ~HeadTrackerReceiver() override;
+
+    /** Binds to the port on localhost and starts the receiver thread.
+        Returns false if the port is taken, e.g. by another instance.
+    */
+    bool start (int port = defaultPort);
+    void stop();
+
+    bool isReceiving() const            { return isThreadRunning(); }
+
+    /** True if the last start() failed because the port was taken, until stop(). */
+    bool isPortInUse() const            { return portInUse.load(); }
+    int getPort() const                 { return port; }
+
+    /** Consumer side of the queue, for the audio thread only. */
+    bool pop (Sample& sample)           { return queue.pop (sample); }
+
+    /** Packets lost because the audio thread was not draining the queue. */
+    int getNumDropped() const           { return numDropped.load(); }
+
+    /** Seconds on the clock used for all timestamps. */
+    static double now();
+
+    /** Decodes one datagram. Returns false if it is not an orientation. */
+    static bool parsePacket (const char* data, int size, Sample& sample);
+
+private:
+    //==============================================================================
+    void run() override;
+
+    std::unique_ptr<juce::DatagramSocket> socket;
+    int port = 0;
+    std::atomic<bool> portInUse { false };
+
+    SpscQueue<Sample> queue { 256 };
+    std::atomic<int> numDropped { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HeadTrackerReceiver)
+};
@@ -15,14 +15,11 @@ BinauralSoundAudioProcessorEditor::BinauralSoundAudioProcessorEditor (BinauralSo
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (400, 710);
     
     
     addAndMakeVisible(gAzimuth_Slider);
     gAzimuth_Slider.setTextValueSuffix(" [deg]");
-    gAzimuth_Slider.addListener(this);
-    gAzimuth_Slider.setRange(-89.0,89.0);
-    gAzimuth_Slider.setValue(0.0);
     addAndMakeVisible(gAzimuth_Label);
     gAzimuth_Label.setText("Azimuth", juce::dontSendNotification);
     gAzimuth_Label.attachToComponent(&gAzimuth_Slider, true);
@@ -31,9 +28,6 @@ BinauralSoundAudioProcessorEditor::BinauralSoundAudioProcessorEditor (BinauralSo
     
     addAndMakeVisible(gElevation_Slider);
     gElevation_Slider.setTextValueSuffix(" [deg]");
-    gElevation_Slider.addListener(this);
-    gElevation_Slider.setRange(-180.0,180.0);
-    gElevation_Slider.setValue(0.0);
     addAndMakeVisible(gElevation_Label);
     gElevation_Label.setText("Elevation", juce::dontSendNotification);
     gElevation_Label.attachToComponent(&gElevation_Slider, true);
@@ -42,14 +36,83 @@ BinauralSoundAudioProcessorEditor::BinauralSoundAudioProcessorEditor (BinauralSo
     
     addAndMakeVisible(gVolume_Slider);
     gVolume_Slider.setTextValueSuffix(" [dB]");
-    gVolume_Slider.addListener(this);
-    gVolume_Slider.setRange(-20.0,20.0);
-    gVolume_Slider.setValue(0.0);
     addAndMakeVisible(gVolume_Label);
     gVolume_Label.setText("Volume", juce::dontSendNotification);
     gVolume_Label.attachToComponent(&gVolume_Slider, true);
 
     gVolume_SliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.apvts,"VOLUME",gVolume_Slider);
+
+    addAndMakeVisible(gDistance_Slider);
+    gDistance_Slider.setTextValueSuffix(" [m]");
+    addAndMakeVisible(gDistance_Label);
+    gDistance_Label.setText("Distance", juce::dontSendNotification);
+    gDistance_Label.attachToComponent(&gDistance_Slider, true);
+
+    gDistance_SliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.apvts,"DISTANCE",gDistance_Slider);
+
+    addAndMakeVisible(gReverbSize_Slider);
+    gReverbSize_Slider.setTextValueSuffix(" [%]");
+    addAndMakeVisible(gReverbSize_Label);
+    gReverbSize_Label.setText("Reverb size", juce::dontSendNotification);
+    gReverbSize_Label.attachToComponent(&gReverbSize_Slider, true);
+
+    gReverbSize_SliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.apvts,"REVERB_SIZE",gReverbSize_Slider);
+
+    addAndMakeVisible(gReverbDecay_Slider);
+    gReverbDecay_Slider.setTextValueSuffix(" [s]");
+    addAndMakeVisible(gReverbDecay_Label);
+    gReverbDecay_Label.setText("Reverb decay", juce::dontSendNotification);
+    gReverbDecay_Label.attachToComponent(&gReverbDecay_Slider, true);
+
+    gReverbDecay_SliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.apvts,"REVERB_DECAY",gReverbDecay_Slider);
+
+    addAndMakeVisible(gReverbWet_Slider);
+    gReverbWet_Slider.setTextValueSuffix(" [%]");
+    addAndMakeVisible(gReverbWet_Label);
+    gReverbWet_Label.setText("Reverb wet", juce::dontSendNotification);
+    gReverbWet_Label.attachToComponent(&gReverbWet_Slider, true);
+
+    gReverbWet_SliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.apvts,"REVERB_WET",gReverbWet_Slider);
+
+    addAndMakeVisible(gReflections_Button);
+
+    gReflections_ButtonAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.apvts,"REFLECTIONS",gReflections_Button);
+
+    addAndMakeVisible(gRoomSize_Slider);
+    gRoomSize_Slider.setTextValueSuffix(" [x]");
+    addAndMakeVisible(gRoomSize_Label);
+    gRoomSize_Label.setText("Room size", juce::dontSendNotification);
+    gRoomSize_Label.attachToComponent(&gRoomSize_Slider, true);
+
+    gRoomSize_SliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.apvts,"ROOM_SIZE",gRoomSize_Slider);
+
+    // The items must be there before the attachment selects one
+    addAndMakeVisible(gRenderingMode_Box);
+    gRenderingMode_Box.addItemList({ "Structural model", "HRIR", "BRIR" }, 1);
+    addAndMakeVisible(gRenderingMode_Label);
+    gRenderingMode_Label.setText("Rendering", juce::dontSendNotification);
+    gRenderingMode_Label.attachToComponent(&gRenderingMode_Box, true);
+
+    gRenderingMode_BoxAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.apvts,"RENDERING_MODE",gRenderingMode_Box);
+
+    addAndMakeVisible(loadHrirs_Button);
+    loadHrirs_Button.onClick = [this] { chooseHrirFile(); };
+
+    addAndMakeVisible(hrirFile_Label);
+    hrirFile_Label.setFont(juce::Font(12.0f));
+    updateHrirLabel();
+
+    addAndMakeVisible(loadBrirs_Button);
+    loadBrirs_Button.onClick = [this] { chooseBrirFile(); };
+
+    addAndMakeVisible(brirFile_Label);
+    brirFile_Label.setFont(juce::Font(12.0f));
+    updateBrirLabel();
+
+    addAndMakeVisible(headTracking_Label);
+    headTracking_Label.setFont(juce::Font(12.0f));
+    timerCallback();
+    startTimerHz(2);
 }
 
 BinauralSoundAudioProcessorEditor::~BinauralSoundAudioProcessorEditor()
@@ -74,24 +137,111 @@ void BinauralSoundAudioProcessorEditor::resized()
     gAzimuth_Slider.setBounds(sliderLeft, 20, getWidth() - sliderLeft - 10, 20);
     gElevation_Slider.setBounds(sliderLeft, 80, getWidth() - sliderLeft - 10, 20);
     gVolume_Slider.setBounds(sliderLeft, 80+60, getWidth() - sliderLeft - 10, 20);
+    gDistance_Slider.setBounds(sliderLeft, 80+120, getWidth() - sliderLeft - 10, 20);
+    gReverbSize_Slider.setBounds(sliderLeft, 80+180, getWidth() - sliderLeft - 10, 20);
+    gReverbDecay_Slider.setBounds(sliderLeft, 80+240, getWidth() - sliderLeft - 10, 20);
+    gReverbWet_Slider.setBounds(sliderLeft, 80+300, getWidth() - sliderLeft - 10, 20);
+    gReflections_Button.setBounds(sliderLeft, 80+360, getWidth() - sliderLeft - 10, 20);
+    gRoomSize_Slider.setBounds(sliderLeft, 80+420, getWidth() - sliderLeft - 10, 20);
+    gRenderingMode_Box.setBounds(sliderLeft, 80+480, getWidth() - sliderLeft - 10, 20);
+    loadHrirs_Button.setBounds(sliderLeft, 80+510, 100, 20);
+    hrirFile_Label.setBounds(sliderLeft + 110, 80+510, getWidth() - sliderLeft - 120, 20);
+    loadBrirs_Button.setBounds(sliderLeft, 80+540, 100, 20);
+    brirFile_Label.setBounds(sliderLeft + 110, 80+540, getWidth() - sliderLeft - 120, 20);
+
+    headTracking_Label.setBounds(10, getHeight() - 40, getWidth() - 20, 30);
 }
 
-
-void BinauralSoundAudioProcessorEditor::sliderValueChanged(Slider* slider)
+void BinauralSoundAudioProcessorEditor::timerCallback()
 {
+    auto& headTracker = audioProcessor.getHeadTracker();
 
-    if (slider == &gAzimuth_Slider)
+    if (headTracker.isPortInUse())
     {
-        audioProcessor.set_gAzimuth_param(gAzimuth_Slider.getValue(),audioProcessor.gAzimuth_param_prev);
-//        DBG(String(gFB_Slider.getValue()));
+        headTracking_Label.setText("Head tracking off: UDP port " + String(HeadTrackerReceiver::defaultPort)
+                                   + " is in use by another instance or program", juce::dontSendNotification);
+        return;
     }
-    else if (slider == &gElevation_Slider)
+
+    if (! headTracker.isReceiving())
     {
-        audioProcessor.set_gElevation_param(gElevation_Slider.getValue(),audioProcessor.gElevation_param_prev);
+        headTracking_Label.setText("Head tracking starts with playback", juce::dontSendNotification);
+        return;
     }
-    else if (slider == &gVolume_Slider)
+
+    const auto latency = audioProcessor.getHeadTrackingLatency();
+
+    String text = "Head tracking on UDP port " + String(headTracker.getPort()) + ": ";
+
+    if (latency.count == 0)
+        text << "waiting for data";
+    else
+        text << String(static_cast<juce::int64> (latency.count)) << " updates, latency p50 " << String(latency.p50 * 1000, 1)
+             << " ms, p95 " << String(latency.p95 * 1000, 1) << " ms, max " << String(latency.max * 1000, 1) << " ms";
+
+    headTracking_Label.setText(text, juce::dontSendNotification);
+}
+
+void BinauralSoundAudioProcessorEditor::chooseHrirFile()
+{
+    hrirChooser = std::make_unique<juce::FileChooser>("Load HRIRs", audioProcessor.getHrirFile(), "*.hrir");
+
+    hrirChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                             [this] (const juce::FileChooser& chooser)
     {
-        audioProcessor.set_gVolume_param(gVolume_Slider.getValue());
-    }
+        const auto file = chooser.getResult();
+
+        if (file == juce::File())
+            return;
+
+        juce::String error;
+
+        if (audioProcessor.loadHrirs(file, error))
+            updateHrirLabel();
+        else
+            hrirFile_Label.setText("Cannot load HRIRs: " + error, juce::dontSendNotification);
+    });
+}
+
+void BinauralSoundAudioProcessorEditor::updateHrirLabel()
+{
+    const auto* set = audioProcessor.getHrirSet();
+
+    if (set == nullptr)
+        hrirFile_Label.setText("No HRIRs, the HRIR mode uses the model", juce::dontSendNotification);
+    else
+        hrirFile_Label.setText(audioProcessor.getHrirFile().getFileName() + " (" + String(set->getNumMeasurements()) + " directions)", juce::dontSendNotification);
+}
+
+void BinauralSoundAudioProcessorEditor::chooseBrirFile()
+{
+    brirChooser = std::make_unique<juce::FileChooser>("Load BRIRs", audioProcessor.getBrirFile(), "*.hrir");
+
+    brirChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                             [this] (const juce::FileChooser& chooser)
+    {
+        const auto file = chooser.getResult();
+
+        if (file == juce::File())
+            return;
+
+        juce::String error;
+
+        if (audioProcessor.loadBrirs(file, error))
+            updateBrirLabel();
+        else
+            brirFile_Label.setText("Cannot load BRIRs: " + error, juce::dontSendNotification);
+    });
+}
+
+void BinauralSoundAudioProcessorEditor::updateBrirLabel()
+{
+    const auto* set = audioProcessor.getBrirSet();
+
+    if (set == nullptr)
+        brirFile_Label.setText("No BRIRs, the BRIR mode uses the model", juce::dontSendNotification);
+    else
+        brirFile_Label.setText(audioProcessor.getBrirFile().getFileName() + " (" + String(set->getNumMeasurements()) + " directions, "
+                               + String(set->getLength() / set->getSampleRate(), 2) + " s)", juce::dontSendNotification);
 }
 
@@ -15,7 +15,7 @@
 /**
 */
 class BinauralSoundAudioProcessorEditor  : public juce::AudioProcessorEditor,
-                                           public juce::Slider::Listener
+                                           private juce::Timer
 {
 public:
     BinauralSoundAudioProcessorEditor (BinauralSoundAudioProcessor&);
@@ -25,9 +25,14 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 
-    void sliderValueChanged (Slider* slider) override;
-
 private:
+    void timerCallback() override;
+
+    void chooseHrirFile();
+    void updateHrirLabel();
+    void chooseBrirFile();
+    void updateBrirLabel();
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     BinauralSoundAudioProcessor& audioProcessor;
@@ -46,6 +51,43 @@ private:
     Slider gVolume_Slider;
     Label gVolume_Label;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gVolume_SliderAttachment;
+
+    Slider gDistance_Slider;
+    Label gDistance_Label;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gDistance_SliderAttachment;
+
+    Slider gReverbSize_Slider;
+    Label gReverbSize_Label;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gReverbSize_SliderAttachment;
+
+    Slider gReverbDecay_Slider;
+    Label gReverbDecay_Label;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gReverbDecay_SliderAttachment;
+
+    Slider gReverbWet_Slider;
+    Label gReverbWet_Label;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gReverbWet_SliderAttachment;
+
+    ToggleButton gReflections_Button { "Early reflections" };
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> gReflections_ButtonAttachment;
+
+    Slider gRoomSize_Slider;
+    Label gRoomSize_Label;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gRoomSize_SliderAttachment;
+
+    ComboBox gRenderingMode_Box;
+    Label gRenderingMode_Label;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> gRenderingMode_BoxAttachment;
+
+    TextButton loadHrirs_Button { "Load HRIRs..." };
+    Label hrirFile_Label; // loaded set, or why loading failed
+    std::unique_ptr<juce::FileChooser> hrirChooser;
+
+    TextButton loadBrirs_Button { "Load BRIRs..." };
+    Label brirFile_Label;
+    std::unique_ptr<juce::FileChooser> brirChooser;
+
+    Label headTracking_Label; // receiver state and motion-to-sound latency
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BinauralSoundAudioProcessorEditor)
 };
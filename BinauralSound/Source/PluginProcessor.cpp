@@ -9,6 +9,61 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+namespace
+{
+    /** Input layouts the bed virtualiser renders. */
+    bool isBedLayout (const juce::AudioChannelSet& set)
+    {
+        return set == juce::AudioChannelSet::create5point1()
+            || set == juce::AudioChannelSet::create7point1()
+            || set == juce::AudioChannelSet::create7point1point4();
+    }
+
+    /** The bed channel of a JUCE channel type. Anything a bed layout does
+        not hold is heard from the front.
+    */
+    BedVirtualiser::Channel getBedChannel (juce::AudioChannelSet::ChannelType type)
+    {
+        using Type = juce::AudioChannelSet::ChannelType;
+        using Channel = BedVirtualiser::Channel;
+
+        switch (type)
+        {
+            case Type::left:                return Channel::left;
+            case Type::right:               return Channel::right;
+            case Type::centre:              return Channel::centre;
+            case Type::LFE:                 return Channel::lfe;
+            case Type::leftSurround:        return Channel::leftSurround;
+            case Type::rightSurround:       return Channel::rightSurround;
+            case Type::leftSurroundSide:    return Channel::leftSurroundSide;
+            case Type::rightSurroundSide:   return Channel::rightSurroundSide;
+            case Type::leftSurroundRear:    return Channel::leftSurroundRear;
+            case Type::rightSurroundRear:   return Channel::rightSurroundRear;
+            case Type::topFrontLeft:        return Channel::topFrontLeft;
+            case Type::topFrontRight:       return Channel::topFrontRight;
+            case Type::topRearLeft:         return Channel::topRearLeft;
+            case Type::topRearRight:        return Channel::topRearRight;
+            default:                        return Channel::centre;
+        }
+    }
+
+    /** Standard position of each channel of a bed layout. JUCE orders the
+        channels of a set by type, not in film or SMPTE order, so this goes
+        by the type of every channel.
+    */
+    std::vector<BedVirtualiser::Speaker> getBedSpeakers (const juce::AudioChannelSet& set)
+    {
+        const bool hasRears = set.getChannelIndexForType(juce::AudioChannelSet::leftSurroundRear) >= 0;
+
+        std::vector<BedVirtualiser::Speaker> speakers;
+
+        for (int channel = 0; channel < set.size(); ++channel)
+            speakers.push_back(BedVirtualiser::getSpeaker(getBedChannel(set.getTypeOfChannel(channel)), hasRears));
+
+        return speakers;
+    }
+}
+
 //==============================================================================
 BinauralSoundAudioProcessor::BinauralSoundAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -22,10 +77,22 @@ BinauralSoundAudioProcessor::BinauralSoundAudioProcessor()
                        ), apvts(*this, nullptr, "Parameters", createParameters())
 #endif
 {
+    gAzimuth_param = apvts.getRawParameterValue("AZIMUTH");
+    gElevation_param = apvts.getRawParameterValue("ELEVATION");
+    gVolume_param = apvts.getRawParameterValue("VOLUME");
+    gDistance_param = apvts.getRawParameterValue("DISTANCE");
+    gReverbSize_param = apvts.getRawParameterValue("REVERB_SIZE");
+    gReverbDecay_param = apvts.getRawParameterValue("REVERB_DECAY");
+    gReverbWet_param = apvts.getRawParameterValue("REVERB_WET");
+    gReflections_param = apvts.getRawParameterValue("REFLECTIONS");
+    gRoomSize_param = apvts.getRawParameterValue("ROOM_SIZE");
+    gRenderingMode_param = apvts.getRawParameterValue("RENDERING_MODE");
 }
 
 BinauralSoundAudioProcessor::~BinauralSoundAudioProcessor()
 {
+    cancelPendingUpdate();
+    headTracker.stop();
 }
 
 //==============================================================================
@@ -63,7 +130,8 @@ bool BinauralSoundAudioProcessor::isMidiEffect() const
 
 double BinauralSoundAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // The reverb rings on for about its decay time once the input stops
+    return gReverbWet_param->load() > 0 ? gReverbDecay_param->load() : 0.0;
 }
 
 int BinauralSoundAudioProcessor::getNumPrograms()
@@ -95,56 +163,214 @@ void BinauralSoundAudioProcessor::prepareToPlay (double sampleRate, int samplesP
 {
 
     // Print sample rate -- for checking purposes
-    gSampleRate = sampleRate;
-    T = 1/gSampleRate;
     Logger::getCurrentLogger()->outputDebugString("Sample rate is " + String(sampleRate) + ".");
     
-    // Read parameters from sliders
-    auto* selection_gAzimuth = dynamic_cast<AudioParameterFloat*> (apvts.getParameter ("AZIMUTH"));
-    gAzimuth_param = selection_gAzimuth->get();
-    gAzimuth_param = 0.0; // overwriting.. just in case
-    
-    auto* selection_gElevation = dynamic_cast<AudioParameterFloat*> (apvts.getParameter ("ELEVATION"));
-    gElevation_param = selection_gElevation->get();
-    gElevation_param = 0.0; // overwriting.. just in case
-    
-    
-    gVolume_param = 0.0;
-    
-    // Resizing buffers and preallocating read and write pointers
-    gDelayBuffer.resize(2); // 2 channels
-    for (int i = 0; i < 2; ++i)
-        gDelayBuffer[i].resize(BUFFER_SIZE,0);
-    
-    gDelayBuffer_head_shaddow.resize(2); // 2 channels
-    for (int i = 0; i < 2; ++i)
-        gDelayBuffer_head_shaddow[i].resize(BUFFER_SIZE,0);
-    
-    gInitLatency = 16;
-    
-    gWritePointer.resize(2,gInitLatency);
-    gReadPointer.resize(2,0);
-    
-    gWritePointer_head_shadow.resize(2,gInitLatency);
-    gReadPointer_head_shadow.resize(2,0);
-    
-    
-    // OTHER
-    theta_min_rad = theta_min*float_Pi/180.0;
-    
-    outVal_room.resize(2,0);
-    outVal.resize(2,0);
-    outVal_prev.resize(2,0);
-    outVal_head_shadow.resize(2,0);
-    outVal_head_shadow_prev.resize(2,0);
-    outVal_post_pinnae.resize(2,0);
-    
+    // Allocates the delay lines and clears all filter states
+    engine.setSmoothingTime(parameterSmoothingTime);
+    engine.prepare(sampleRate, samplesPerBlock, maxDistance);
+
+    // Rounding in the model's feedback grows with the rate; a double precision host always gets double filters
+    engine.setDoublePrecisionFilters(sampleRate > 96000.0);
+
+    // A B-format input bus gets its decoder filters here, once per rate and order
+    const int ambisonicOrder = getChannelLayoutOfBus(true, 0).getAmbisonicOrder();
+    ambisonicInput = ambisonicOrder >= 1 && ambisonicOrder <= Ambisonics::order;
+
+    if (ambisonicInput)
+    {
+        ambisonicDecoder.setSmoothingTime(parameterSmoothingTime);
+        ambisonicDecoder.prepare(sampleRate, samplesPerBlock, ambisonicOrder);
+        multichannelBuffer.setSize(ambisonicDecoder.getNumChannels(), samplesPerBlock);
+    }
+
+    // A surround input gets the filters of its speakers here, once per rate and layout
+    const auto inputLayout = getChannelLayoutOfBus(true, 0);
+    bedInput = isBedLayout(inputLayout);
+
+    if (bedInput)
+    {
+        bedVirtualiser.setSmoothingTime(parameterSmoothingTime);
+        bedVirtualiser.prepare(sampleRate, samplesPerBlock, getBedSpeakers(inputLayout));
+        multichannelBuffer.setSize(bedVirtualiser.getNumChannels(), samplesPerBlock);
+    }
+
+    // HRIRs are resampled for the new rate; the audio thread is not running yet
+    if (hrirSet != nullptr)
+    {
+        installHrirs(sampleRate);
+
+        const juce::SpinLock::ScopedLockType lock (hrirLock);
+        engine.setHrirs(std::move (pendingHrirs));
+    }
+
+    if (brirSet != nullptr)
+    {
+        installBrirs(sampleRate);
+
+        const juce::SpinLock::ScopedLockType lock (hrirLock);
+        engine.setBrirs(std::move (pendingBrirs));
+    }
+
+    // Start at the current parameter values rather than gliding in from 0
+    updateEngineParameters();
+
+    // The port is only held while playing, so an instance that is merely
+    // loaded does not keep it from the one in use. Only one instance can own
+    // it; the others render without head tracking and the editor says why.
+    if (! headTracker.isReceiving() && ! headTracker.start())
+        Logger::getCurrentLogger()->outputDebugString("Head tracker port " + String(HeadTrackerReceiver::defaultPort) + " is in use.");
+
+    // prepare() applied the interpolator and the layout picked the path,
+    // both of which change the latency. The audio thread is not running
+    // yet, so tell the host right away.
+    renderLatency = getRenderLatency();
+    setLatencySamples(renderLatency);
+}
+
+int BinauralSoundAudioProcessor::getRenderLatency() const
+{
+    // The path processSamples() takes for this input layout
+    if (ambisonicInput && getTotalNumInputChannels() >= ambisonicDecoder.getNumChannels())
+        return ambisonicDecoder.getLatency();
+
+    if (bedInput && getTotalNumInputChannels() >= bedVirtualiser.getNumChannels())
+        return bedVirtualiser.getLatency();
+
+    return engine.getLatency();
+}
+
+void BinauralSoundAudioProcessor::updateRenderLatency()
+{
+    const int latency = getRenderLatency();
+
+    if (renderLatency.exchange(latency) != latency)
+        triggerAsyncUpdate();
+}
+
+void BinauralSoundAudioProcessor::handleAsyncUpdate()
+{
+    setLatencySamples(renderLatency.load());
+}
+
+bool BinauralSoundAudioProcessor::loadHrirs (const juce::File& file, juce::String& error)
+{
+    std::string loadError;
+    auto set = HrirSet::load(file.getFullPathName().toStdString(), loadError);
+
+    if (set == nullptr)
+    {
+        error = loadError;
+        return false;
+    }
+
+    hrirFile = file;
+    hrirSet = std::move (set);
+
+    if (getSampleRate() > 0)
+        installHrirs(getSampleRate());
+
+    return true;
+}
+
+void BinauralSoundAudioProcessor::installHrirs (double sampleRate)
+{
+    auto filters = std::make_shared<const HrirFilters> (hrirSet, sampleRate, BinauralEngine::hrirPartitionSize, BinauralEngine::maxHrirLength);
+
+    {
+        const juce::SpinLock::ScopedLockType lock (hrirLock);
+        pendingHrirs = filters;
+    }
+
+    // Free the filters nobody else holds any more, here rather than on the audio thread
+    installedHrirs.erase(std::remove_if(installedHrirs.begin(), installedHrirs.end(),
+                                        [] (const auto& installed) { return installed.use_count() == 1; }),
+                         installedHrirs.end());
+
+    installedHrirs.push_back(std::move (filters));
+}
+
+bool BinauralSoundAudioProcessor::loadBrirs (const juce::File& file, juce::String& error)
+{
+    std::string loadError;
+    auto set = HrirSet::load(file.getFullPathName().toStdString(), loadError);
+
+    if (set == nullptr)
+    {
+        error = loadError;
+        return false;
+    }
+
+    brirFile = file;
+    brirSet = std::move (set);
+
+    if (getSampleRate() > 0)
+        installBrirs(getSampleRate());
+
+    return true;
+}
+
+void BinauralSoundAudioProcessor::installBrirs (double sampleRate)
+{
+    if (convolutionPool == nullptr)
+        convolutionPool = ConvolutionThreadPool::getShared();
+
+    auto convolver = std::make_shared<BrirConvolver> (std::make_shared<const BrirFilters> (brirSet, sampleRate), convolutionPool);
+
+    {
+        const juce::SpinLock::ScopedLockType lock (hrirLock);
+        pendingBrirs = convolver;
+    }
+
+    // The engine has let go of the old convolvers once they are only held here
+    installedBrirs.erase(std::remove_if(installedBrirs.begin(), installedBrirs.end(),
+                                        [] (const auto& installed) { return installed.use_count() == 1; }),
+                         installedBrirs.end());
+
+    installedBrirs.push_back(std::move (convolver));
+}
+
+void BinauralSoundAudioProcessor::updateEngineParameters()
+{
+    engine.setAzimuth(gAzimuth_param->load());
+    engine.setElevation(gElevation_param->load());
+    engine.setVolume(gVolume_param->load());
+    engine.setDistance(gDistance_param->load());
+    engine.setReverbSize(gReverbSize_param->load() / 100);
+    engine.setReverbDecayTime(gReverbDecay_param->load());
+    engine.setReverbWet(gReverbWet_param->load() / 100);
+
+    // The default room scaled by the size parameter, listener in the middle at ear height
+    const float roomScale = gRoomSize_param->load();
+
+    ShoeboxRoom room;
+    room.length *= roomScale;
+    room.width *= roomScale;
+    room.height *= roomScale;
+    room.listenerX = room.length / 2;
+    room.listenerY = room.width / 2;
+    room.listenerZ = std::min (1.2f, room.height / 2);
+
+    engine.setRoom(room);
+    engine.setEarlyReflections(gReflections_param->load() >= 0.5f);
+
+    engine.setRenderingMode(static_cast<BinauralEngine::RenderingMode> (juce::jlimit(0, 2, juce::roundToInt(gRenderingMode_param->load()))));
+
+    // The decoder only takes what applies to a whole sound field
+    ambisonicDecoder.setVolume(gVolume_param->load());
+    ambisonicDecoder.setReverbSize(gReverbSize_param->load() / 100);
+    ambisonicDecoder.setReverbDecayTime(gReverbDecay_param->load());
+    ambisonicDecoder.setReverbWet(gReverbWet_param->load() / 100);
+
+    bedVirtualiser.setVolume(gVolume_param->load());
+    bedVirtualiser.setReverbSize(gReverbSize_param->load() / 100);
+    bedVirtualiser.setReverbDecayTime(gReverbDecay_param->load());
+    bedVirtualiser.setReverbWet(gReverbWet_param->load() / 100);
 }
 
 void BinauralSoundAudioProcessor::releaseResources()
 {
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
+    // Frees the port for whichever instance plays next
+    headTracker.stop();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -162,6 +388,18 @@ bool BinauralSoundAudioProcessor::isBusesLayoutSupported (const BusesLayout& lay
      && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
         return false;
 
+    // B-format in, binaural out
+   #if ! JucePlugin_IsSynth
+    const int ambisonicOrder = layouts.getMainInputChannelSet().getAmbisonicOrder();
+
+    if (ambisonicOrder >= 1 && ambisonicOrder <= Ambisonics::order)
+        return layouts.getMainOutputChannelSet() == juce::AudioChannelSet::stereo();
+
+    // 5.1, 7.1 or 7.1.4 in, binaural out
+    if (isBedLayout(layouts.getMainInputChannelSet()))
+        return layouts.getMainOutputChannelSet() == juce::AudioChannelSet::stereo();
+   #endif
+
     // This checks if the input layout matches the output layout
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
@@ -173,186 +411,127 @@ bool BinauralSoundAudioProcessor::isBusesLayoutSupported (const BusesLayout& lay
 }
 #endif
 
-void BinauralSoundAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void BinauralSoundAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    processSamples(buffer);
+}
+
+void BinauralSoundAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    processSamples(buffer);
+}
+
+template <typename FloatType>
+void BinauralSoundAudioProcessor::processSamples (juce::AudioBuffer<FloatType>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
-    float* const outputL = buffer.getWritePointer(0);
-    float* const outputR = buffer.getWritePointer(1);
+    FloatType* const outputL = buffer.getWritePointer(0);
+    FloatType* const outputR = buffer.getWritePointer(1);
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    
-    //Logger::getCurrentLogger()->outputDebugString("gAzimuth_param is " + String(gAzimuth_param) + ".");
-    //Logger::getCurrentLogger()->outputDebugString("gElevation_param is " + String(gElevation_param) + ".");
+    // Read the parameters once per block. The engine smooths them per sample,
+    // whether they come from the editor or from host automation.
+    updateEngineParameters();
 
-//    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-//    for (int channel = 0; channel < 2; ++channel) // Hardcoded to 2 channels
-    for (int channel = 1; channel > -1; --channel) // doing this because im overwriting the first channel after going through the first iteration of the loop !
+    // Newly loaded HRIRs. If the message thread is handing some over right
+    // now, take them on the next block instead of waiting.
     {
-//        auto* input = buffer.getWritePointer (channel);
-        auto* input = buffer.getWritePointer (0); // HARDCODED : always take the left channel.. to avoidn stereo problems
+        const juce::SpinLock::ScopedTryLockType lock (hrirLock);
+
+        if (lock.isLocked() && pendingHrirs != nullptr)
+            engine.setHrirs(std::move (pendingHrirs));
+
+        if (lock.isLocked() && pendingBrirs != nullptr)
+            engine.setBrirs(std::move (pendingBrirs));
+    }
+
+    // The rendering mode or new HRIRs may have changed the latency
+    updateRenderLatency();
+
+    // A host rendering faster than real time would leave the workers behind
+    if (const auto& brirs = engine.getBrirs())
+        brirs->setWaitForTail(isNonRealtime());
+
+    // Drain the head tracker queue and aim for the newest orientation. The engine
+    // interpolates from the previous one across this block.
+    HeadTrackerReceiver::Sample headSample;
+    bool headMoved = false;
 
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
+    const double now = HeadTrackerReceiver::now();
+    const double headLatency = (buffer.getNumSamples() + renderLatency.load()) / getSampleRate();
+
+    while (headTracker.pop(headSample))
+    {
+        // Fall back to the arrival time if the sender's clock is clearly not ours
+        const bool sentTimeValid = headSample.sentTime > 0 && headSample.sentTime <= now && now - headSample.sentTime < 10.0;
+
+        headTrackingLatency.add(now - (sentTimeValid ? headSample.sentTime : headSample.receivedTime) + headLatency);
+        headMoved = true;
+    }
+
+    if (headMoved)
+    {
+        engine.setHeadOrientation(headSample.orientation);
+        ambisonicDecoder.setHeadOrientation(headSample.orientation);
+    }
+
+    // All channels of a B-format or surround input at once, in place
+    if (ambisonicInput && totalNumInputChannels >= ambisonicDecoder.getNumChannels())
+    {
+        processMultichannel(ambisonicDecoder, buffer);
+        return;
+    }
+
+    if (bedInput && totalNumInputChannels >= bedVirtualiser.getNumChannels())
+    {
+        processMultichannel(bedVirtualiser, buffer);
+        return;
+    }
+
+    // HARDCODED : always take the left channel.. to avoid stereo problems. The engine renders in place.
+    engine.process(buffer.getReadPointer(0), outputL, outputR, buffer.getNumSamples());
+}
+
+template <typename Renderer, typename FloatType>
+void BinauralSoundAudioProcessor::processMultichannel (Renderer& renderer, juce::AudioBuffer<FloatType>& buffer)
+{
+    FloatType* const outputL = buffer.getWritePointer(0);
+    FloatType* const outputR = buffer.getWritePointer(1);
+
+    if constexpr (std::is_same<FloatType, float>::value)
+    {
+        renderer.process(buffer.getArrayOfReadPointers(), outputL, outputR, buffer.getNumSamples());
+    }
+    else
+    {
+        // The decoder's and the bed's filters are float, convert around them
+        const int numSamples = buffer.getNumSamples();
+        jassert (numSamples <= multichannelBuffer.getNumSamples());
+
+        for (int channel = 0; channel < renderer.getNumChannels(); ++channel)
         {
-            // Current input sample
-            float in = input[i];
-
-            // Update parameters for sound source position
-            thetaLeft = 90.0 + gAzimuth_param;
-            thetaRight = 90.0 - gAzimuth_param;
-            
-            float theta;
-            if (channel == 0)
-                theta = thetaLeft;
-            else if (channel == 1)
-                theta = thetaRight;
-            
-            float theta_rad =  theta*float_Pi/180;
-            
-            float delta_T;
-            if (0<=abs(theta_rad) && abs(theta_rad)<float_Pi/2)
-                delta_T = (-a/c)*cos(theta_rad);
-            else if (float_Pi/2 <= abs(theta_rad) && abs(theta_rad) < float_Pi)
-                delta_T = (a/c)*(abs(theta_rad)-float_Pi/2);
-            
-            
-            // Room model
-            float Kr = 1;
-            float dB_difference = 15; // add a slider for this !
-
-
-            float response_db_Kr = 20 * log10(Kr);
-            float Ke_db = response_db_Kr - dB_difference;
-
-            float Ke_ampl = pow(10,(Ke_db/20));
-
-            float tau_Ke = 15*0.001;
-            float tau_Ke_samples = floorf(tau_Ke*gSampleRate);
-            float tau_Ke_samples_frac = tau_Ke*gSampleRate - tau_Ke_samples;
-
-
-            // Populate buffer
-            gDelayBuffer[channel][gWritePointer[channel]] = in;
-
-            // Convert delay to samples
-            float delSamples = delta_T * gSampleRate;
-            float delSamples_floor = floorf(delSamples);
-            float frac_part = delSamples - delSamples_floor;
-            
-            // Read from delay line
-            int outPointer = (gReadPointer[channel] - 1 - static_cast<int>(delSamples_floor) + BUFFER_SIZE) % BUFFER_SIZE;
-            int outPointer_frac = (gReadPointer[channel] - static_cast<int>(delSamples_floor) + BUFFER_SIZE) % BUFFER_SIZE;
-            
-            outVal[channel] = frac_part*gDelayBuffer[channel][outPointer] + (1-frac_part)*gDelayBuffer[channel][outPointer_frac];
-            
-
-            int outPointer_room = (gReadPointer[channel] - 1 - static_cast<int>(tau_Ke_samples) + BUFFER_SIZE) % BUFFER_SIZE;
-            int outPointer_room_frac = (gReadPointer[channel] - static_cast<int>(tau_Ke_samples) + BUFFER_SIZE) % BUFFER_SIZE;
-
-            outVal_room[channel] = Ke_ampl * (tau_Ke_samples_frac*gDelayBuffer[channel][outPointer_room] + (1-tau_Ke_samples_frac)*gDelayBuffer[channel][outPointer_room_frac]);
-            
-
-            // HEAD SHADOW FILTER
-            float alpha = (1+alpha_min/2) + (1-alpha_min/2)*cos(theta_rad/theta_min_rad * float_Pi);
-            float beta = 2*c/a;
-
-            outVal_head_shadow[channel] = (2*alpha + T*beta)/(2+T*beta) * outVal[channel] + (-2*alpha + T*beta)/(2+T*beta) * outVal_prev[channel] - (-2 + T*beta)/(2+T*beta) * outVal_head_shadow_prev[channel];
-
-            outVal_prev[channel] = outVal[channel];
-            outVal_head_shadow_prev[channel] = outVal_head_shadow[channel];
-
-            // PINNA MODEL
-            std::vector<float> rho_k = {0.5,-1,0.5,-0.25,0.25};
-            std::vector<float> Ak = {1,5,5,5,5};
-            std::vector<float> Bk = {2,4,7,11,13};
-            
-            std::vector<float> Dk1 = {1,0.5,0.5,0.5,0.5};
-            //std::vector<float>  Dk2 = {0.85,0.35,0.35,0.35,0.35}; // alternative scaling factors. see paper Duda and Brown "A Structural Model for Binaural Sound Synthesis"
-
-            std::vector<float> tau;
-            std::vector<float> tau_samples;
-            std::vector<float> tau_samples_frac_part;
-            tau.resize(5,0.0);
-            tau_samples.resize(5,0.0);
-            tau_samples_frac_part.resize(5,0.0);
-            for (int iEvent = 0; iEvent < 5; iEvent++)
-            {
-                tau[iEvent] = Ak[iEvent]*cos(theta_rad/2)*sin(Dk1[iEvent]*(float_Pi/2-gElevation_param*float_Pi/180))+Bk[iEvent];
-                tau_samples[iEvent] = floorf(tau[iEvent]);
-                tau_samples_frac_part[iEvent] = tau[iEvent] - tau_samples[iEvent];
-            }
-            
-            
-            // Write to delayLine
-            gDelayBuffer_head_shaddow[channel][gWritePointer_head_shadow[channel]] = outVal_head_shadow[channel];
-            
-            int outPointer_1 = (gReadPointer_head_shadow[channel] - 1 - static_cast<int>(tau_samples[0]) + BUFFER_SIZE) % BUFFER_SIZE;
-            int outPointer_1_frac = (gReadPointer_head_shadow[channel] - static_cast<int>(tau_samples[0]) + BUFFER_SIZE) % BUFFER_SIZE;
-
-            int outPointer_2 = (gReadPointer_head_shadow[channel] - 1 - static_cast<int>(tau_samples[1]) + BUFFER_SIZE) % BUFFER_SIZE;
-            int outPointer_2_frac = (gReadPointer_head_shadow[channel] - static_cast<int>(tau_samples[1]) + BUFFER_SIZE) % BUFFER_SIZE;
-            
-            int outPointer_3 = (gReadPointer_head_shadow[channel] - 1 - static_cast<int>(tau_samples[2]) + BUFFER_SIZE) % BUFFER_SIZE;
-            int outPointer_3_frac = (gReadPointer_head_shadow[channel] - static_cast<int>(tau_samples[2]) + BUFFER_SIZE) % BUFFER_SIZE;
-            
-            int outPointer_4 = (gReadPointer_head_shadow[channel] - 1 - static_cast<int>(tau_samples[3]) + BUFFER_SIZE) % BUFFER_SIZE;
-            int outPointer_4_frac = (gReadPointer_head_shadow[channel] - static_cast<int>(tau_samples[3]) + BUFFER_SIZE) % BUFFER_SIZE;
-            
-            int outPointer_5 = (gReadPointer_head_shadow[channel] - 1 - static_cast<int>(tau_samples[4]) + BUFFER_SIZE) % BUFFER_SIZE;
-            int outPointer_5_frac = (gReadPointer_head_shadow[channel] - static_cast<int>(tau_samples[4]) + BUFFER_SIZE) % BUFFER_SIZE;
-            
-            
-            outVal_post_pinnae[channel] =
-            rho_k[0] * (tau_samples_frac_part[0]*gDelayBuffer_head_shaddow[channel][outPointer_1] + (1-tau_samples_frac_part[0])*gDelayBuffer_head_shaddow[channel][outPointer_1_frac])
-            + rho_k[1] * (tau_samples_frac_part[1]*gDelayBuffer_head_shaddow[channel][outPointer_2] + (1-tau_samples_frac_part[1])*gDelayBuffer_head_shaddow[channel][outPointer_2_frac])
-            + rho_k[2] * (tau_samples_frac_part[2]*gDelayBuffer_head_shaddow[channel][outPointer_3] + (1-tau_samples_frac_part[2])*gDelayBuffer_head_shaddow[channel][outPointer_3_frac])
-            + rho_k[3] * (tau_samples_frac_part[3]*gDelayBuffer_head_shaddow[channel][outPointer_4] + (1-tau_samples_frac_part[3])*gDelayBuffer_head_shaddow[channel][outPointer_4_frac])
-            + rho_k[4] * (tau_samples_frac_part[4]*gDelayBuffer_head_shaddow[channel][outPointer_5] + (1-tau_samples_frac_part[4])*gDelayBuffer_head_shaddow[channel][outPointer_5_frac]);
-                            
-            // update gWritePointer
-            gWritePointer[channel] = gWritePointer[channel] + 1;
-            if (gWritePointer[channel] >= BUFFER_SIZE)
-                gWritePointer[channel] = 0;
-
-            // update gReadPointer
-            gReadPointer[channel] = gReadPointer[channel] + 1;
-            if (gReadPointer[channel] >= BUFFER_SIZE)
-                gReadPointer[channel] = 0;
-            
-            // update gWritePointer_head_shadow
-            gWritePointer_head_shadow[channel] = gWritePointer_head_shadow[channel] + 1;
-            if (gWritePointer_head_shadow[channel] >= BUFFER_SIZE)
-                gWritePointer_head_shadow[channel] = 0;
-
-            // update gReadPointer_head_shadow
-            gReadPointer_head_shadow[channel] = gReadPointer_head_shadow[channel] + 1;
-            if (gReadPointer_head_shadow[channel] >= BUFFER_SIZE)
-                gReadPointer_head_shadow[channel] = 0;
-            
-            if (abs((outVal_post_pinnae[channel])) > 1)
-            {
-                Logger::getCurrentLogger()->outputDebugString("Output is too loud!");
-            }
-            
-            if (channel == 0)
-            {
-                outputL[i] = (outVal_post_pinnae[channel] + outVal_room[channel]) * powf(10,(gVolume_param/20));
-//                outputL[i] = (outVal_post_pinnae[channel]) * 1.0;
-//                outputL[i] = (outVal_head_shadow[channel]) * 1.0;
-            }
-            else if (channel == 1)
-            {
-                outputR[i] = (outVal_post_pinnae[channel] + outVal_room[channel]) * powf(10,(gVolume_param/20));
-//                outputR[i] = (outVal_post_pinnae[channel]) * 1.0;
-//                outputR[i] = (outVal_head_shadow[channel]) * 1.0;
-            }
+            const double* in = buffer.getReadPointer(channel);
+            float* out = multichannelBuffer.getWritePointer(channel);
 
+            for (int i = 0; i < numSamples; ++i)
+                out[i] = static_cast<float> (in[i]);
+        }
+
+        float* const renderedL = multichannelBuffer.getWritePointer(0);
+        float* const renderedR = multichannelBuffer.getWritePointer(1);
+
+        renderer.process(multichannelBuffer.getArrayOfReadPointers(), renderedL, renderedR, numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            outputL[i] = renderedL[i];
+            outputR[i] = renderedR[i];
         }
-        // ..do something to the data...
     }
 }
 
@@ -9,11 +9,17 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "Engine/AmbisonicDecoder.h"
+#include "Engine/BedVirtualiser.h"
+#include "Engine/BinauralEngine.h"
+#include "Engine/LatencyHistogram.h"
+#include "HeadTrackerReceiver.h"
 
 //==============================================================================
 /**
 */
-class BinauralSoundAudioProcessor  : public juce::AudioProcessor
+class BinauralSoundAudioProcessor  : public juce::AudioProcessor,
+                                     private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -29,6 +35,10 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    /** 64 bit hosts get the engine's double precision path without converting. */
+    bool supportsDoublePrecisionProcessing() const override             { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -57,55 +67,136 @@ public:
     
     //==============================================================================
     // FOR PARAMETERS !
+    // The editor and the host both write to these; processBlock reads them.
     juce::AudioProcessorValueTreeState apvts;
-    
-//    void set_gAzimuth_param(float val) { gAzimuth_param = val; }
-    void set_gAzimuth_param(float val, float &gAzimuth_param_prev)
-    {
-        gAzimuth_param = (1-0.8)*val + 0.8*gAzimuth_param_prev;
-        gAzimuth_param_prev = gAzimuth_param;
-    }
-//    void set_gElevation_param(float val) { gElevation_param = val; }
-    void set_gElevation_param(float val, float &gElevation_param_prev) // I guess this could just be done in PluginEditor..
-    {
-        gElevation_param = (1-0.8)*val + 0.8*gElevation_param_prev;
-        gElevation_param_prev = gElevation_param;
-    }
-    
-    void set_gVolume_param(float val) { gVolume_param = val; }
 
-    
-    // Parameters updated in PluginEditor -> need to be public.
-    float gAzimuth_param_prev;
-    float gElevation_param_prev;
-    
-private:
+    /** Time the engine takes to glide to a new position or volume. */
+    static constexpr double parameterSmoothingTime = 0.05; // [s]
+
+    /** Upper end of the distance parameter; the delay lines are sized for it. */
+    static constexpr float maxDistance = 50.0f; // [m]
+
     //==============================================================================
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BinauralSoundAudioProcessor)
-    
+    // HEAD TRACKING
+    const HeadTrackerReceiver& getHeadTracker() const                   { return headTracker; }
+
+    /** Time from a head tracker packet being sent (or received, if it
+        carries no timestamp) until the rendered block fully reflects it,
+        excluding the audio device's own output latency.
+    */
+    LatencyHistogram::Summary getHeadTrackingLatency() const            { return headTrackingLatency.getSummary(); }
+
     //==============================================================================
-    // BUFFER STUFF
-    int BUFFER_SIZE = 16384; // size of delay buffers
-    
-    int gInitLatency = 16; // initial latency to account for negative delays.
+    // HRIRS
+    /** Reads an HRIR file (see HrirSet) for the HRIR rendering mode and hands
+        it to the audio thread. Message thread only. Returns false and fills
+        error if the file cannot be read.
+    */
+    bool loadHrirs (const juce::File& file, juce::String& error);
+
+    const juce::File& getHrirFile() const                               { return hrirFile; }
+    const HrirSet* getHrirSet() const                                   { return hrirSet.get(); }
+
+    /** Reads binary room impulse responses, in the same file format, for the
+        BRIR rendering mode. Message thread only, like loadHrirs().
+    */
+    bool loadBrirs (const juce::File& file, juce::String& error);
+
+    const juce::File& getBrirFile() const                               { return brirFile; }
+    const HrirSet* getBrirSet() const                                   { return brirSet.get(); }
 
-    std::vector<std::vector<float>> gDelayBuffer; // delay buffer from input
-    std::vector<int> gWritePointer; // write pointer for delay buffer from input
-    std::vector<int> gReadPointer; // read pointer for delay buffer from input
-    
-    std::vector<std::vector<float>> gDelayBuffer_head_shaddow; // delay buffer loaded from head shadow model
-    std::vector<int> gWritePointer_head_shadow; // write pointer for delay buffer loaded from head shadow model
-    std::vector<int> gReadPointer_head_shadow; // read pointer for delay buffer loaded from head shadow model
-    
-    
     //==============================================================================
-    // HEAD MODEL STUFF
-    float a = 8.75/100; // radius of head
-    float c = 343; // speed of sound
+    // AMBISONIC INPUT
+    /** Order of the B-format input being decoded, or 0 when the input is a
+        mono or stereo source rendered by the engine. Set by prepareToPlay()
+        from the input bus layout.
+    */
+    int getAmbisonicInputOrder() const                                  { return ambisonicInput ? ambisonicDecoder.getOrder() : 0; }
+
+    //==============================================================================
+    // SURROUND INPUT
+    /** Channels of the 5.1, 7.1 or 7.1.4 input being virtualised, or 0 when
+        the input is not a surround bed. Set by prepareToPlay() from the
+        input bus layout.
+    */
+    int getBedInputChannels() const                                     { return bedInput ? bedVirtualiser.getNumChannels() : 0; }
+
+private:
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BinauralSoundAudioProcessor)
     
-    float alpha_min = 0.1; // head shadow filter param
-    float theta_min = 150; // head shadow filter param
-    float theta_min_rad; // head shadow filter param
+    //==============================================================================
+    // DSP
+    BinauralEngine engine; // ITD, head shadow, pinna and room model all live here
+
+    HeadTrackerReceiver headTracker; // listener orientation from UDP, counter-rotates the source
+    LatencyHistogram headTrackingLatency;
+
+    /** Hands the current parameter values to the engine. */
+    void updateEngineParameters();
+
+    // The host delays everything else by what setLatencySamples() was told.
+    // The input layout picks the decoder, the bed or the engine, whose
+    // latencies differ, and is applied by prepareToPlay(), which reports it
+    // at once. The rendering mode and the HRIRs change the engine's latency
+    // on the audio thread, which only notes it; the message thread reports it.
+    std::atomic<int> renderLatency { 0 };
+
+    /** Latency of the path processBlock renders the current input layout
+        with: the ambisonic decoder, the bed virtualiser or the engine.
+    */
+    int getRenderLatency() const;
+
+    /** Called on the audio thread after anything that can change the latency. */
+    void updateRenderLatency();
+
+    void handleAsyncUpdate() override;
+
+    /** Both processBlock()s, for float and double buffers. */
+    template <typename FloatType>
+    void processSamples (juce::AudioBuffer<FloatType>& buffer);
+
+    /** Renders all input channels of the buffer to its first two with the
+        ambisonic decoder or the bed virtualiser, converting a double
+        buffer through multichannelBuffer.
+    */
+    template <typename Renderer, typename FloatType>
+    void processMultichannel (Renderer& renderer, juce::AudioBuffer<FloatType>& buffer);
+
+    // HRIRs are loaded and transformed on the message thread, then picked up
+    // by processBlock. Filters the engine may still hold are kept alive here,
+    // so the audio thread never frees them.
+    juce::File hrirFile;
+    std::shared_ptr<const HrirSet> hrirSet;
+    std::vector<std::shared_ptr<const HrirFilters>> installedHrirs; // message thread
+    std::shared_ptr<const HrirFilters> pendingHrirs; // guarded by hrirLock
+    juce::SpinLock hrirLock;
+
+    /** Transforms the loaded set for this sample rate and queues it. */
+    void installHrirs (double sampleRate);
+
+    // BRIRs the same way, as a whole convolver: it is not shared with
+    // anything, and its tail runs on the convolution pool's threads
+    juce::File brirFile;
+    std::shared_ptr<const HrirSet> brirSet;
+    std::shared_ptr<ConvolutionThreadPool> convolutionPool;
+    std::vector<std::shared_ptr<BrirConvolver>> installedBrirs; // message thread
+    std::shared_ptr<BrirConvolver> pendingBrirs; // guarded by hrirLock
+
+    /** Builds a convolver of the loaded set for this sample rate and queues it. */
+    void installBrirs (double sampleRate);
+
+    // B-format input (AmbiX, first to third order) is decoded to binaural
+    // instead of rendering a source; the position parameters do not apply
+    AmbisonicDecoder ambisonicDecoder;
+    bool ambisonicInput = false;
+
+    // A surround bed (5.1, 7.1, 7.1.4) is virtualised the same way, every
+    // speaker channel at its standard position
+    BedVirtualiser bedVirtualiser;
+    bool bedInput = false;
+
+    juce::AudioBuffer<float> multichannelBuffer; // the decoder and the bed render in float, a double block goes through this
 
     
     //==============================================================================
@@ -117,23 +208,28 @@ private:
         params.push_back(std::make_unique<AudioParameterFloat>("AZIMUTH","Azimuth",-89.0,89.0f,0.0f));
         params.push_back(std::make_unique<AudioParameterFloat>("ELEVATION","Elevation",-180.0f,180.0f,0.0f));
         params.push_back(std::make_unique<AudioParameterFloat>("VOLUME","Volume",-20.0f,20.0f,0.0f)); // in dB
+        params.push_back(std::make_unique<AudioParameterFloat>("DISTANCE","Distance",NormalisableRange<float>(1.0f,maxDistance,0.0f,0.3f),1.0f)); // in m
+        params.push_back(std::make_unique<AudioParameterFloat>("REVERB_SIZE","Reverb Size",0.0f,100.0f,50.0f)); // in %
+        params.push_back(std::make_unique<AudioParameterFloat>("REVERB_DECAY","Reverb Decay",NormalisableRange<float>(0.1f,10.0f,0.0f,0.5f),1.5f)); // in s
+        params.push_back(std::make_unique<AudioParameterFloat>("REVERB_WET","Reverb Wet",0.0f,100.0f,0.0f)); // in %
+        params.push_back(std::make_unique<AudioParameterBool>("REFLECTIONS","Early Reflections",false));
+        params.push_back(std::make_unique<AudioParameterFloat>("ROOM_SIZE","Room Size",NormalisableRange<float>(0.5f,3.0f,0.0f,0.6f),1.0f)); // relative to 8 x 6 x 3 m
+        params.push_back(std::make_unique<AudioParameterChoice>("RENDERING_MODE","Rendering Mode",StringArray { "Structural model", "HRIR", "BRIR" },0));
 
         return { params.begin(), params.end()};
     }
     
-    float gAzimuth_param;
-    float gElevation_param;
-    float gVolume_param;
-
+    // Raw parameter values, written by the message thread or the host and
+    // read once per block on the audio thread
+    std::atomic<float>* gAzimuth_param = nullptr;
+    std::atomic<float>* gElevation_param = nullptr;
+    std::atomic<float>* gVolume_param = nullptr;
+    std::atomic<float>* gDistance_param = nullptr;
+    std::atomic<float>* gReverbSize_param = nullptr;
+    std::atomic<float>* gReverbDecay_param = nullptr;
+    std::atomic<float>* gReverbWet_param = nullptr;
+    std::atomic<float>* gReflections_param = nullptr;
+    std::atomic<float>* gRoomSize_param = nullptr;
+    std::atomic<float>* gRenderingMode_param = nullptr;
 
-    float thetaLeft;
-    float thetaRight;
-
-    float gSampleRate;
-    float T;
-    
-    
-    // Outputs
-    std::vector<float> outVal_room, outVal, outVal_prev, outVal_head_shadow, outVal_head_shadow_prev, outVal_post_pinnae;
-    
 };
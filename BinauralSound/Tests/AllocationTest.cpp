@@ -0,0 +1,280 @@
+/*
+  ==============================================================================
+
+    AllocationTest.cpp
+
+    Checks that the audio path never allocates. Global operator new and
+    delete are replaced by versions that count calls while counting is on;
+    an engine is prepared with counting off, then processed in float and in
+    double precision over many blocks while every parameter moves (position,
+    distance, volume, head orientation, reverb and early reflections). Any
+    allocation during process() fails the test.
+
+    The interpolator only changes in prepare(), so the engine is prepared
+    once per kind outside the counted region. The HRIR and BRIR modes are
+    counted too, with a second set of filters handed over to the engine
+    half way through, as the plugin does on the audio thread after taking
+    them from behind its SpinLock.
+
+  ==============================================================================
+*/
+
+#include "BinauralEngine.h"
+#include "BinauralScene.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::atomic<bool> counting { false };
+    std::atomic<int> numAllocations { 0 };
+
+    void* allocate (std::size_t size)
+    {
+        if (counting.load())
+            ++numAllocations;
+
+        if (void* p = std::malloc (size > 0 ? size : 1))
+            return p;
+
+        throw std::bad_alloc();
+    }
+
+    void* allocateAligned (std::size_t size, std::align_val_t alignment)
+    {
+        if (counting.load())
+            ++numAllocations;
+
+        const auto align = static_cast<std::size_t> (alignment);
+        const std::size_t rounded = (size + align - 1) / align * align;
+
+       #if defined(_MSC_VER)
+        if (void* p = _aligned_malloc (rounded > 0 ? rounded : align, align))
+       #else
+        if (void* p = std::aligned_alloc (align, rounded > 0 ? rounded : align))
+       #endif
+            return p;
+
+        throw std::bad_alloc();
+    }
+
+    void deallocateAligned (void* p)
+    {
+       #if defined(_MSC_VER)
+        _aligned_free (p);
+       #else
+        std::free (p);
+       #endif
+    }
+}
+
+void* operator new (std::size_t size)                                       { return allocate (size); }
+void* operator new[] (std::size_t size)                                     { return allocate (size); }
+void* operator new (std::size_t size, std::align_val_t alignment)           { return allocateAligned (size, alignment); }
+void* operator new[] (std::size_t size, std::align_val_t alignment)         { return allocateAligned (size, alignment); }
+void operator delete (void* p) noexcept                                     { std::free (p); }
+void operator delete[] (void* p) noexcept                                   { std::free (p); }
+void operator delete (void* p, std::size_t) noexcept                        { std::free (p); }
+void operator delete[] (void* p, std::size_t) noexcept                      { std::free (p); }
+void operator delete (void* p, std::align_val_t) noexcept                   { deallocateAligned (p); }
+void operator delete[] (void* p, std::align_val_t) noexcept                 { deallocateAligned (p); }
+void operator delete (void* p, std::size_t, std::align_val_t) noexcept      { deallocateAligned (p); }
+void operator delete[] (void* p, std::size_t, std::align_val_t) noexcept    { deallocateAligned (p); }
+
+namespace
+{
+    constexpr double sampleRate = 48000;
+    constexpr int blockSize = 256;
+    constexpr int numBlocks = 1000; // about 5 s
+    constexpr float maxDistance = 20.0f;
+
+    /** Decaying noise for 8 directions around the listener, seeded so the
+        two sets handed over differ.
+    */
+    std::shared_ptr<const HrirSet> makeResponses (int length, unsigned seed)
+    {
+        constexpr int numDirections = 8;
+
+        std::mt19937 rng (seed);
+        std::normal_distribution<float> noise (0.0f, 0.1f);
+
+        std::vector<HrirSet::Direction> directions;
+        std::vector<float> impulseResponses (static_cast<size_t> (numDirections) * 2 * length);
+
+        for (int m = 0; m < numDirections; ++m)
+            directions.push_back ({ 0.0f, 360.0f * m / numDirections - 180.0f });
+
+        for (size_t i = 0; i < impulseResponses.size(); ++i)
+            impulseResponses[i] = noise (rng) * std::pow (10.0f, -3.0f * static_cast<int> (i % length) / length);
+
+        return std::make_shared<const HrirSet> (sampleRate, length, std::move (directions), std::move (impulseResponses));
+    }
+
+    /** Filters of both modes, made before counting and held here for the
+        whole run, so the engine never frees the ones it lets go of.
+    */
+    struct Convolution
+    {
+        std::shared_ptr<const HrirFilters> hrirs[2];
+        std::shared_ptr<BrirConvolver> brirs[2];
+    };
+
+    Convolution makeConvolution()
+    {
+        Convolution c;
+        auto pool = ConvolutionThreadPool::getShared();
+
+        for (unsigned i = 0; i < 2; ++i)
+        {
+            c.hrirs[i] = std::make_shared<const HrirFilters> (makeResponses (256, i + 1), sampleRate,
+                                                              BinauralEngine::hrirPartitionSize, BinauralEngine::maxHrirLength);
+            c.brirs[i] = std::make_shared<BrirConvolver> (std::make_shared<const BrirFilters> (makeResponses (24000, i + 3), sampleRate), pool);
+        }
+
+        return c;
+    }
+
+    /** Moves every parameter of the engine a little, as a host would. */
+    void moveParameters (BinauralEngine& engine, int block)
+    {
+        const float t = static_cast<float> (block) * blockSize / static_cast<float> (sampleRate);
+
+        engine.setAzimuth (170.0f * std::sin (0.7f * t));
+        engine.setElevation (40.0f * std::cos (0.3f * t));
+        engine.setDistance (1.0f + 0.5f * maxDistance * (1.0f + std::sin (0.2f * t)));
+        engine.setVolume (-12.0f + 6.0f * std::sin (1.3f * t));
+
+        HeadOrientation head;
+        head.yaw = 30.0f * std::sin (0.9f * t);
+        head.pitch = 10.0f * std::sin (0.4f * t);
+        engine.setHeadOrientation (head);
+
+        // Settings switched at run time
+        engine.setReverbWet ((block / 500) % 2 == 0 ? 0.3f : 0.0f);
+        engine.setEarlyReflections ((block / 333) % 2 == 0);
+        engine.setDoublePrecisionFilters ((block / 400) % 2 == 1);
+    }
+
+    template <typename SampleType>
+    int countEngineAllocations (Interpolation::Kind kind, BinauralEngine::RenderingMode mode, Convolution& convolution)
+    {
+        BinauralEngine engine;
+        engine.setInterpolation (kind);
+        engine.prepare (sampleRate, blockSize, maxDistance);
+        engine.setRenderingMode (mode);
+
+        // -1 fails the check as well
+        if (! (engine.setHrirs (convolution.hrirs[0]) && engine.setBrirs (convolution.brirs[0])))
+            return -1;
+
+        std::vector<SampleType> in (blockSize), outL (blockSize), outR (blockSize);
+
+        for (int i = 0; i < blockSize; ++i)
+            in[i] = static_cast<SampleType> (std::sin (0.05 * i));
+
+        numAllocations = 0;
+        counting = true;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            if (block == numBlocks / 2)
+            {
+                engine.setHrirs (convolution.hrirs[1]);
+                engine.setBrirs (convolution.brirs[1]);
+            }
+
+            moveParameters (engine, block);
+            engine.process (in.data(), outL.data(), outR.data(), blockSize);
+        }
+
+        counting = false;
+        return numAllocations.load();
+    }
+
+    int countSceneAllocations()
+    {
+        constexpr int numSources = 40;
+
+        BinauralScene scene;
+        scene.prepare (sampleRate, blockSize, numSources, maxDistance);
+        scene.setReverbWet (0.3f);
+        scene.setEarlyReflections (true);
+        scene.setLevelOfDetail (true);
+        scene.setCpuBudget (10.0f);
+
+        std::vector<std::vector<float>> inputs (numSources, std::vector<float> (blockSize));
+        std::vector<const float*> inputPointers;
+
+        for (int s = 0; s < numSources; ++s)
+        {
+            for (int i = 0; i < blockSize; ++i)
+                inputs[s][i] = std::sin (0.01f * (s + 1) * i) / static_cast<float> (s + 1);
+
+            inputPointers.push_back (inputs[s].data());
+        }
+
+        std::vector<float> outL (blockSize), outR (blockSize);
+
+        numAllocations = 0;
+        counting = true;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            const float t = static_cast<float> (block) * blockSize / static_cast<float> (sampleRate);
+
+            for (int s = 0; s < numSources; ++s)
+            {
+                scene.setSourcePosition (s, 170.0f * std::sin (0.5f * t + s), 30.0f * std::cos (0.3f * t + s));
+                scene.setSourceDistance (s, 1.0f + (s % 8) * std::abs (std::sin (0.1f * t)));
+            }
+
+            scene.process (inputPointers.data(), outL.data(), outR.data(), blockSize);
+        }
+
+        counting = false;
+        return numAllocations.load();
+    }
+
+    bool check (const std::string& name, int allocations)
+    {
+        std::printf ("%-32s %d allocations in %d blocks\n", name.c_str(), allocations, numBlocks);
+        return allocations == 0;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    bool passed = true;
+
+    using Mode = BinauralEngine::RenderingMode;
+    auto convolution = makeConvolution();
+
+    for (auto kind : { Interpolation::Kind::linear, Interpolation::Kind::lagrange4, Interpolation::Kind::sinc8, Interpolation::Kind::sinc16 })
+    {
+        const std::string name = std::string ("engine ") + Interpolation::getName (kind);
+
+        passed = check (name + " float", countEngineAllocations<float> (kind, Mode::structural, convolution)) && passed;
+        passed = check (name + " double", countEngineAllocations<double> (kind, Mode::structural, convolution)) && passed;
+    }
+
+    for (auto mode : { Mode::hrir, Mode::brir })
+    {
+        const std::string name = mode == Mode::hrir ? "engine hrir" : "engine brir";
+
+        passed = check (name + " float", countEngineAllocations<float> (Interpolation::Kind::linear, mode, convolution)) && passed;
+        passed = check (name + " double", countEngineAllocations<double> (Interpolation::Kind::linear, mode, convolution)) && passed;
+    }
+
+    passed = check ("scene", countSceneAllocations()) && passed;
+
+    std::printf ("%s\n", passed ? "passed" : "FAILED: the audio path allocates");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+/*
+  ==============================================================================
+
+    AmbisonicsTest.cpp
+
+    Checks the ambisonic encoder and decoder on a grid of source
+    directions, for decoders of order 1 to 3:
+
+    - Round trip: decoding a source to the 26 virtual speakers and encoding
+      the speakers again gives back the source's harmonics, each order
+      scaled by a constant (its max-rE weight and the diffuse-field scale)
+      that does not depend on the direction. The Lebedev grid integrates
+      the products of the harmonics exactly, so this holds to rounding.
+    - Level: the speakers' summed power stays within 0.5 dB of 1.
+    - Direction: the speakers' energy vector points at the source, to
+      within 5 degrees; 26 speakers only sample the decoded beam.
+    - Rotation: rotating an encoded field by a head orientation gives the
+      harmonics of the head-relative direction.
+
+  ==============================================================================
+*/
+
+#include "Ambisonics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+    constexpr double pi = 3.14159265358979323846;
+
+    struct Errors
+    {
+        double roundTrip = 0, level_dB = 0, direction = 0, rotation = 0; // direction in degrees
+    };
+
+    /** Decodes the source at (x, y, z) and encodes the speakers again. */
+    void decodeAndEncode (float x, float y, float z, int decoderOrder, float* reencoded, double& power, double (&energyVector)[3])
+    {
+        std::fill (reencoded, reencoded + Ambisonics::numChannels, 0.0f);
+        power = 0;
+        std::fill (std::begin (energyVector), std::end (energyVector), 0.0);
+
+        float harmonics[Ambisonics::numChannels];
+        Ambisonics::evaluate (x, y, z, harmonics);
+
+        for (auto& speaker : Ambisonics::getVirtualSpeakers())
+        {
+            float gains[Ambisonics::numChannels];
+            Ambisonics::getDecoderGains (speaker, speaker.x, speaker.y, speaker.z, gains, decoderOrder);
+
+            float signal = 0;
+            for (int c = 0; c < Ambisonics::getNumChannels (decoderOrder); ++c)
+                signal += gains[c] * harmonics[c];
+
+            float speakerHarmonics[Ambisonics::numChannels];
+            Ambisonics::evaluate (speaker.x, speaker.y, speaker.z, speakerHarmonics);
+
+            // Plain encoding, the inverse of sampling on the grid
+            for (int c = 0; c < Ambisonics::numChannels; ++c)
+                reencoded[c] += signal * speakerHarmonics[c];
+
+            power += signal * signal;
+            energyVector[0] += signal * signal * speaker.x;
+            energyVector[1] += signal * signal * speaker.y;
+            energyVector[2] += signal * signal * speaker.z;
+        }
+    }
+
+    bool check (int decoderOrder)
+    {
+        // Each order's scale, taken from a source straight ahead (only the
+        // channels that are 1 there, one per order, define it)
+        float reencoded[Ambisonics::numChannels], front[Ambisonics::numChannels];
+        double power, energyVector[3];
+
+        decodeAndEncode (1, 0, 0, decoderOrder, reencoded, power, energyVector);
+        Ambisonics::evaluate (1.0f, 0.0f, 0.0f, front);
+
+        double scale[Ambisonics::order + 1] = {};
+        for (int c = 0; c < Ambisonics::numChannels; ++c)
+            if (std::abs (front[c]) > 0.5f)
+                scale[Ambisonics::channelOrder (c)] = reencoded[c] / front[c];
+
+        Errors errors;
+
+        for (int azimuth = -90; azimuth <= 90; azimuth += 15)
+        {
+            for (int elevation = -180; elevation < 180; elevation += 20)
+            {
+                float x, y, z;
+                Ambisonics::toCartesian (static_cast<float> (azimuth), static_cast<float> (elevation), x, y, z);
+
+                float harmonics[Ambisonics::numChannels];
+                Ambisonics::evaluate (x, y, z, harmonics);
+
+                decodeAndEncode (x, y, z, decoderOrder, reencoded, power, energyVector);
+
+                for (int c = 0; c < Ambisonics::numChannels; ++c)
+                    errors.roundTrip = std::max (errors.roundTrip, std::abs (reencoded[c] - scale[Ambisonics::channelOrder (c)] * harmonics[c]));
+
+                errors.level_dB = std::max (errors.level_dB, std::abs (10 * std::log10 (power)));
+
+                const double length = std::sqrt (energyVector[0] * energyVector[0] + energyVector[1] * energyVector[1] + energyVector[2] * energyVector[2]);
+                const double cosine = (energyVector[0] * x + energyVector[1] * y + energyVector[2] * z) / length;
+                errors.direction = std::max (errors.direction, std::acos (std::min (1.0, cosine)) * 180 / pi);
+
+                // A field rotated by a head orientation against the head-relative direction
+                const HeadOrientation head { 40.0f + azimuth, 0.5f * elevation - 20, 25.0f };
+
+                float rotation[Ambisonics::numChannels * Ambisonics::numChannels];
+                Ambisonics::getRotation (head.getHeadRelativeMatrix(), Ambisonics::order, rotation);
+
+                float headAzimuth = static_cast<float> (azimuth), headElevation = static_cast<float> (elevation);
+                head.toHeadRelative (headAzimuth, headElevation);
+
+                float hx, hy, hz, headHarmonics[Ambisonics::numChannels];
+                Ambisonics::toCartesian (headAzimuth, headElevation, hx, hy, hz);
+                Ambisonics::evaluate (hx, hy, hz, headHarmonics);
+
+                for (int row = 0; row < Ambisonics::numChannels; ++row)
+                {
+                    float rotated = 0;
+                    for (int column = 0; column < Ambisonics::numChannels; ++column)
+                        rotated += rotation[row * Ambisonics::numChannels + column] * harmonics[column];
+
+                    errors.rotation = std::max (errors.rotation, static_cast<double> (std::abs (rotated - headHarmonics[row])));
+                }
+            }
+        }
+
+        // Orders above the decoder's are dropped, lower ones are weighted less as the order rises
+        bool tapered = true;
+        for (int n = 1; n <= Ambisonics::order; ++n)
+            tapered = tapered && (n > decoderOrder ? std::abs (scale[n]) < 1.0e-5 : scale[n] < scale[n - 1] && scale[n] > 0);
+
+        std::printf ("order %d: scales %.4f %.4f %.4f %.4f, round trip error %.1e, level within %.2f dB, direction within %.2f deg, rotation error %.1e\n",
+                     decoderOrder, scale[0], scale[1], scale[2], scale[3], errors.roundTrip, errors.level_dB, errors.direction, errors.rotation);
+
+        return tapered && errors.roundTrip < 1.0e-5 && errors.level_dB < 0.5 && errors.direction < 5 && errors.rotation < 1.0e-5;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    bool passed = true;
+
+    for (int decoderOrder = 1; decoderOrder <= Ambisonics::order; ++decoderOrder)
+        passed = check (decoderOrder) && passed;
+
+    std::printf ("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
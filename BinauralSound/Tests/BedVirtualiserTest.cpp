@@ -0,0 +1,231 @@
+/*
+  ==============================================================================
+
+    BedVirtualiserTest.cpp
+
+    Checks the surround bed's channel map and what each channel renders to.
+    Every layout's channels have to come out in ITU / SMPTE order at the
+    angles of BS.775 and BS.2051, and those angles have to land where the
+    model expects them: a speaker at 45 degrees left, 45 up is 30 degrees
+    to the left of the median plane and 54.7 degrees up the cone of
+    confusion.
+
+    Then noise is fed to one channel at a time. A speaker channel has to
+    sound like a BinauralEngine at the speaker's position, room echo
+    included, to within float rounding: 90 dB below the signal, RMS over
+    both ears. The two round in different places, the engine keeping its
+    head shadow output as float ahead of the pinna taps, which comes to
+    about -93 dB for the height speakers and below -115 dB for the others.
+    The LFE has to reach both ears as the input itself, delayed by
+    twice the model's initial latency, where the direct sound of the other
+    channels is.
+
+  ==============================================================================
+*/
+
+#include "Ambisonics.h"
+#include "BedVirtualiser.h"
+#include "BinauralEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double sampleRate = 48000;
+    constexpr int blockSize = 256;
+    constexpr int numSamples = 40 * blockSize;
+
+    using Channel = BedVirtualiser::Channel;
+    using Layout = BedVirtualiser::Layout;
+
+    /** A channel, its place around the listener and the model's
+        interaural-polar angles of that place.
+    */
+    struct Expected
+    {
+        Channel channel;
+        float azimuth, elevation;
+        float modelAzimuth, modelElevation;
+    };
+
+    const std::vector<Expected> surround51 = {
+        { Channel::left,                  30,  0,  -30,   0 },
+        { Channel::right,                -30,  0,   30,   0 },
+        { Channel::centre,                 0,  0,    0,   0 },
+        { Channel::lfe,                    0,  0,    0,   0 },
+        { Channel::leftSurround,         110,  0,  -70, 180 },
+        { Channel::rightSurround,       -110,  0,   70, 180 },
+    };
+
+    const std::vector<Expected> surround71 = {
+        { Channel::left,                  30,  0,  -30,   0 },
+        { Channel::right,                -30,  0,   30,   0 },
+        { Channel::centre,                 0,  0,    0,   0 },
+        { Channel::lfe,                    0,  0,    0,   0 },
+        { Channel::leftSurroundSide,      90,  0,  -90,   0 },
+        { Channel::rightSurroundSide,    -90,  0,   90,   0 },
+        { Channel::leftSurroundRear,     135,  0,  -45, 180 },
+        { Channel::rightSurroundRear,   -135,  0,   45, 180 },
+    };
+
+    const std::vector<Expected> surround714 = {
+        { Channel::left,                  30,  0,  -30,   0 },
+        { Channel::right,                -30,  0,   30,   0 },
+        { Channel::centre,                 0,  0,    0,   0 },
+        { Channel::lfe,                    0,  0,    0,   0 },
+        { Channel::leftSurroundSide,      90,  0,  -90,   0 },
+        { Channel::rightSurroundSide,    -90,  0,   90,   0 },
+        { Channel::leftSurroundRear,     135,  0,  -45, 180 },
+        { Channel::rightSurroundRear,   -135,  0,   45, 180 },
+        { Channel::topFrontLeft,          45, 45,  -30,  54.7356f },
+        { Channel::topFrontRight,        -45, 45,   30,  54.7356f },
+        { Channel::topRearLeft,          135, 45,  -30, 125.2644f },
+        { Channel::topRearRight,        -135, 45,   30, 125.2644f },
+    };
+
+    void getModelAngles (const BedVirtualiser::Speaker& speaker, float& azimuth, float& elevation)
+    {
+        const double azimuth_rad = speaker.azimuth * pi / 180;
+        const double elevation_rad = speaker.elevation * pi / 180;
+
+        Ambisonics::toInterauralPolar (static_cast<float> (std::cos (elevation_rad) * std::cos (azimuth_rad)),
+                                       static_cast<float> (std::cos (elevation_rad) * std::sin (azimuth_rad)),
+                                       static_cast<float> (std::sin (elevation_rad)), azimuth, elevation);
+    }
+
+    bool checkMap (Layout layout, const std::vector<Expected>& expected)
+    {
+        const auto channels = BedVirtualiser::getLayoutChannels (layout);
+        const auto speakers = BedVirtualiser::getLayoutSpeakers (layout);
+
+        bool passed = channels.size() == expected.size() && speakers.size() == expected.size();
+
+        for (size_t i = 0; passed && i < expected.size(); ++i)
+        {
+            const auto& e = expected[i];
+            const bool lfe = e.channel == Channel::lfe;
+
+            float modelAzimuth, modelElevation;
+            getModelAngles (speakers[i], modelAzimuth, modelElevation);
+
+            passed = channels[i] == e.channel && speakers[i].lfe == lfe
+                  && speakers[i].azimuth == e.azimuth && speakers[i].elevation == e.elevation
+                  && (lfe || (std::abs (modelAzimuth - e.modelAzimuth) < 0.01f && std::abs (modelElevation - e.modelElevation) < 0.01f));
+        }
+
+        std::printf ("%-6s %zu channels, map %s\n", BedVirtualiser::getName (layout), channels.size(), passed ? "ok" : "wrong");
+        return passed;
+    }
+
+    //==============================================================================
+    /** The bed's output for noise in one of its channels. */
+    void renderBed (const std::vector<BedVirtualiser::Speaker>& speakers, int channel, const std::vector<float>& input,
+                    std::vector<float>& left, std::vector<float>& right, int& latency)
+    {
+        BedVirtualiser bed;
+        bed.setSmoothingTime (0);
+        bed.prepare (sampleRate, blockSize, speakers);
+
+        std::vector<std::vector<float>> channels (speakers.size(), std::vector<float> (numSamples, 0.0f));
+        channels[channel] = input;
+
+        std::vector<const float*> inputs (speakers.size());
+
+        for (int start = 0; start < numSamples; start += blockSize)
+        {
+            for (size_t c = 0; c < channels.size(); ++c)
+                inputs[c] = channels[c].data() + start;
+
+            bed.process (inputs.data(), left.data() + start, right.data() + start, blockSize);
+        }
+
+        latency = bed.getLatency();
+    }
+
+    void renderEngine (const BedVirtualiser::Speaker& speaker, const std::vector<float>& input,
+                       std::vector<float>& left, std::vector<float>& right)
+    {
+        float azimuth, elevation;
+        getModelAngles (speaker, azimuth, elevation);
+
+        BinauralEngine engine;
+        engine.setSmoothingTime (0);
+        engine.prepare (sampleRate, blockSize);
+        engine.setAzimuth (azimuth);
+        engine.setElevation (elevation);
+        engine.reset();
+
+        for (int start = 0; start < numSamples; start += blockSize)
+            engine.process (input.data() + start, left.data() + start, right.data() + start, blockSize);
+    }
+
+    bool checkRender (Layout layout)
+    {
+        const auto speakers = BedVirtualiser::getLayoutSpeakers (layout);
+
+        std::mt19937 rng (1);
+        std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+
+        std::vector<float> input (numSamples);
+        for (auto& x : input)
+            x = noise (rng);
+
+        std::vector<float> bedL (numSamples), bedR (numSamples), expectedL (numSamples), expectedR (numSamples);
+        bool passed = true;
+        double worst = -400;
+
+        for (int channel = 0; channel < static_cast<int> (speakers.size()); ++channel)
+        {
+            int latency = 0;
+            renderBed (speakers, channel, input, bedL, bedR, latency);
+
+            if (speakers[channel].lfe)
+            {
+                std::fill (expectedL.begin(), expectedL.end(), 0.0f);
+                std::copy (input.begin(), input.end() - 2 * latency, expectedL.begin() + 2 * latency);
+                expectedR = expectedL;
+            }
+            else
+            {
+                renderEngine (speakers[channel], input, expectedL, expectedR);
+            }
+
+            double error = 0, signal = 0;
+
+            for (int n = 0; n < numSamples; ++n)
+            {
+                error += (bedL[n] - expectedL[n]) * (bedL[n] - expectedL[n]) + (bedR[n] - expectedR[n]) * (bedR[n] - expectedR[n]);
+                signal += expectedL[n] * expectedL[n] + expectedR[n] * expectedR[n];
+            }
+
+            const double error_dB = 10 * std::log10 (std::max (error, 1e-40) / signal);
+            worst = std::max (worst, error_dB);
+
+            passed = error_dB < -90 && passed;
+        }
+
+        std::printf ("%-6s worst channel %.1f dB from the engine\n", BedVirtualiser::getName (layout), worst);
+        return passed;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    bool passed = true;
+
+    passed = checkMap (Layout::surround51, surround51) && passed;
+    passed = checkMap (Layout::surround71, surround71) && passed;
+    passed = checkMap (Layout::surround714, surround714) && passed;
+
+    for (auto layout : { Layout::surround51, Layout::surround71, Layout::surround714 })
+        passed = checkRender (layout) && passed;
+
+    std::printf ("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
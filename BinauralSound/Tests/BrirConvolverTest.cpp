@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+
+    BrirConvolverTest.cpp
+
+    Checks BrirConvolver against a direct time-domain convolution. The
+    response is 70000 taps of decaying noise, long enough for every
+    segment of the non-uniform layout, so the output crosses the
+    boundaries at 64, 1024, 8192 and 65536 taps where one partition size
+    hands over to the next. An impulse has to come out as the response
+    itself, and a short noise burst as its convolution with it, both to
+    within float rounding of the FFTs.
+
+    The input is fed in blocks of uneven sizes that do not line up with
+    the convolver's 64 sample blocks, and the tail runs on the shared
+    worker pool with setWaitForTail (true), so no tail block is left out.
+
+  ==============================================================================
+*/
+
+#include "BrirConvolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr double sampleRate = 48000;
+    constexpr int length = 70000;
+
+    /** Decaying noise per ear, like a room. */
+    std::shared_ptr<const HrirSet> makeResponses()
+    {
+        std::mt19937 rng (1);
+        std::normal_distribution<float> noise (0.0f, 0.1f);
+
+        std::vector<float> impulseResponses (2 * length);
+
+        for (int n = 0; n < 2 * length; ++n)
+            impulseResponses[n] = noise (rng) * std::pow (10.0f, -3.0f * (n % length) / length);
+
+        return std::make_shared<const HrirSet> (sampleRate, length, std::vector<HrirSet::Direction> { { 0.0f, 0.0f } }, std::move (impulseResponses));
+    }
+
+    /** Runs the input, followed by silence for the whole tail, through the
+        convolver in blocks of varying size.
+    */
+    void render (BrirConvolver& convolver, const std::vector<float>& input, std::vector<float> (&out)[2])
+    {
+        const int numSamples = static_cast<int> (input.size()) + length;
+
+        std::vector<float> in (input);
+        in.resize (numSamples, 0.0f);
+
+        for (auto& ear : out)
+            ear.assign (numSamples, 0.0f);
+
+        constexpr int blockSizes[] = { 1, 37, 64, 100, 512, 13, 2048, 63 };
+
+        for (int pos = 0, i = 0; pos < numSamples; ++i)
+        {
+            const int n = std::min (blockSizes[i % 8], numSamples - pos);
+            convolver.process (in.data() + pos, out[0].data() + pos, out[1].data() + pos, n);
+            pos += n;
+        }
+    }
+
+    bool check (const char* name, const HrirSet& set, const std::vector<float>& input, const std::vector<float> (&out)[2])
+    {
+        double maxError = 0, peak = 0;
+        int worstTap = 0;
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            const float* const h = set.getImpulseResponse (0, channel);
+
+            for (size_t n = 0; n < out[channel].size(); ++n)
+            {
+                double expected = 0;
+
+                const size_t first = n >= static_cast<size_t> (length) ? n - length + 1 : 0;
+                for (size_t k = first; k <= n && k < input.size(); ++k)
+                    expected += static_cast<double> (input[k]) * h[n - k];
+
+                const double error = std::abs (out[channel][n] - expected);
+
+                if (error > maxError)
+                {
+                    maxError = error;
+                    worstTap = static_cast<int> (n);
+                }
+
+                peak = std::max (peak, std::abs (expected));
+            }
+        }
+
+        const double error_dB = 20 * std::log10 (std::max (maxError, 1.0e-20) / peak);
+
+        std::printf ("%-12s peak %.4f, worst error %.1f dB below it at sample %d\n", name, peak, -error_dB, worstTap);
+        return error_dB < -90;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    const auto set = makeResponses();
+    const auto filters = std::make_shared<const BrirFilters> (set, sampleRate);
+
+    std::printf ("segments:");
+    for (auto& s : filters->getSegments())
+        std::printf (" %d x %d from %d", s.numPartitions, s.partitionSize, s.offset);
+    std::printf ("\n");
+
+    BrirConvolver convolver (filters, ConvolutionThreadPool::getShared());
+    convolver.setWaitForTail (true);
+
+    bool passed = true;
+    std::vector<float> out[2];
+
+    std::vector<float> impulse (1, 1.0f);
+    render (convolver, impulse, out);
+    passed = check ("impulse", *set, impulse, out) && passed;
+
+    convolver.reset();
+
+    std::mt19937 rng (2);
+    std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+
+    std::vector<float> burst (3000);
+    for (auto& x : burst)
+        x = noise (rng);
+
+    render (convolver, burst, out);
+    passed = check ("noise burst", *set, burst, out) && passed;
+
+    passed = convolver.getMissedDeadlines() == 0 && passed;
+
+    std::printf ("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+    EarlyReflectionsTest.cpp
+
+    Checks the early reflections of a source 2 m in front of the listener
+    in the default 8 x 6 x 3 m room. The six first-order images are worked
+    out by hand, mirrored in each wall, and every one of them has to show
+    up among the taps with the delay and gain the model gives it: the ITD
+    of its direction plus the propagation delay beyond the 1 m reference,
+    and one wall loss times 1/r times the head shadow's broadband gain,
+    (1 + alpha) / 2 for the filter's DC gain of 1 and Nyquist gain alpha.
+
+    Switching the room off has to fade the reflections out: the taps ramp
+    to silence over one block, the pinna lines drain, isActive() drops to
+    false once they have, and nothing is added after that.
+
+  ==============================================================================
+*/
+
+#include "EarlyReflections.h"
+#include "DistanceModel.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr float pi = 3.14159265358979323846f;
+    constexpr float sampleRate = 48000;
+    constexpr int lineSize = 4096;
+    constexpr int initLatency = 16;
+    constexpr int blockSize = EarlyReflections::maxBlockSize;
+
+    void prepare (EarlyReflections& reflections)
+    {
+        reflections.prepare (CoefficientTable::getShared (sampleRate), BrownDudaModel::headShadowPole (sampleRate),
+                             initLatency, static_cast<float> (lineSize - initLatency - 2));
+    }
+
+    //==============================================================================
+    struct Image
+    {
+        const char* wall;
+        float x, y, z; // [m] from the listener
+    };
+
+    // Listener at (4, 3, 1.2), source at (6, 3, 1.2); each image is the
+    // source mirrored in one wall
+    const Image firstOrder[] = {
+        { "front (x = 8)",   6,  0,  0    },  // x = 16 - 6
+        { "back (x = 0)",  -10,  0,  0    },  // x = -6
+        { "left (y = 6)",    2,  6,  0    },  // y = 12 - 3
+        { "right (y = 0)",   2, -6,  0    },  // y = -3
+        { "ceiling (z = 3)", 2,  0,  3.6f },  // z = 6 - 1.2
+        { "floor (z = 0)",   2,  0, -2.4f },  // z = -1.2
+    };
+
+    /** The Brown-Duda ITD and head shadow gain of one ear, with theta the
+        angle between the source and that ear's axis.
+    */
+    void getEar (float azimuth, int channel, float& itdSamples, float& headShadow)
+    {
+        using namespace BrownDudaModel;
+
+        const float theta = (channel == 0 ? 90 + azimuth : 90 - azimuth) * pi / 180;
+
+        itdSamples = (theta < pi / 2 ? -a / c * std::cos (theta) : a / c * (theta - pi / 2)) * sampleRate;
+
+        const float alpha = (1 + alpha_min / 2) + (1 - alpha_min / 2) * std::cos (theta / (theta_min * pi / 180) * pi);
+        headShadow = 0.5f * (1 + std::abs (alpha));
+    }
+
+    bool checkFirstOrder()
+    {
+        ShoeboxRoom room; // 8 x 6 x 3 m, listener at (4, 3, 1.2)
+
+        EarlyReflections reflections;
+        prepare (reflections);
+        reflections.update (&room, 0.0f, 0.0f, 2.0f, {}, 1.0f);
+
+        const float wallGain = std::sqrt (1 - room.absorption);
+
+        bool passed = reflections.getNumReflections() == EarlyReflections::maxReflections;
+        std::vector<bool> used (reflections.getNumReflections(), false);
+
+        for (auto& image : firstOrder)
+        {
+            const float distance = std::sqrt (image.x * image.x + image.y * image.y + image.z * image.z);
+            const float azimuth = std::asin (-image.y / distance) * 180 / pi; // positive to the right
+
+            float delay[2], gain[2];
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                float itd, headShadow;
+                getEar (azimuth, channel, itd, headShadow);
+
+                delay[channel] = itd + (distance - 1) / BrownDudaModel::c * sampleRate;
+                gain[channel] = wallGain / distance * headShadow;
+            }
+
+            // The image may be any of the taps, but only one of them
+            int match = -1;
+
+            for (int r = 0; r < reflections.getNumReflections() && match < 0; ++r)
+            {
+                bool matches = ! used[r];
+
+                for (int channel = 0; channel < 2; ++channel)
+                    matches = matches && std::abs (reflections.getTargetDelay (channel, r) - delay[channel]) < 0.01f
+                                      && std::abs (reflections.getTargetGain (channel, r) / gain[channel] - 1) < 0.002f;
+
+                if (matches)
+                    match = r;
+            }
+
+            if (match >= 0)
+                used[match] = true;
+
+            std::printf ("%-16s %5.2f m: delay %8.2f %8.2f gain %.4f %.4f, %s\n", image.wall, distance,
+                         delay[0], delay[1], gain[0], gain[1], match >= 0 ? "found" : "MISSING");
+
+            passed = match >= 0 && passed;
+        }
+
+        return passed;
+    }
+
+    //==============================================================================
+    bool checkFadeOut()
+    {
+        ShoeboxRoom room;
+
+        EarlyReflections reflections;
+        prepare (reflections);
+
+        std::mt19937 rng (1);
+        std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+
+        std::vector<float> line (lineSize, 0.0f);
+        int writePointer = 0;
+
+        const auto renderBlock = [&] (const ShoeboxRoom* roomToUse, float* outL, float* outR)
+        {
+            for (int i = 0; i < blockSize; ++i)
+                line[(writePointer + i) & (lineSize - 1)] = noise (rng);
+
+            std::fill (outL, outL + blockSize, 0.0f);
+            std::fill (outR, outR + blockSize, 0.0f);
+
+            if (roomToUse != nullptr || reflections.isActive())
+                reflections.update (roomToUse, 30.0f, 0.0f, 2.0f, {}, 1.0f);
+
+            reflections.render (line.data(), lineSize, writePointer - initLatency, outL, outR, blockSize);
+            writePointer = (writePointer + blockSize) & (lineSize - 1);
+        };
+
+        float outL[blockSize], outR[blockSize];
+
+        // Long enough for the latest second-order reflection to arrive
+        double steadyEnergy = 0;
+
+        for (int block = 0; block < 200; ++block)
+        {
+            renderBlock (&room, outL, outR);
+
+            if (block == 199)
+                for (int i = 0; i < blockSize; ++i)
+                    steadyEnergy += outL[i] * outL[i] + outR[i] * outR[i];
+        }
+
+        // The block the room is switched off in ramps every tap to 0, then
+        // what is still in the pinna lines drains
+        renderBlock (nullptr, outL, outR);
+
+        const bool drainingAfterFade = reflections.isActive() && steadyEnergy > 0;
+
+        const int tail = initLatency + static_cast<int> (BrownDudaModel::maxPinnaDelay) + 1;
+        const int expectedTailBlocks = (tail + blockSize - 1) / blockSize;
+
+        int tailBlocks = 0, lastSound = -1;
+
+        while (reflections.isActive() && tailBlocks < 100)
+        {
+            renderBlock (nullptr, outL, outR);
+
+            for (int i = 0; i < blockSize; ++i)
+                if (outL[i] != 0 || outR[i] != 0)
+                    lastSound = tailBlocks * blockSize + i;
+
+            ++tailBlocks;
+        }
+
+        // Inactive now, and rendering anyway adds nothing
+        bool silentAfter = true;
+
+        for (int block = 0; block < 10; ++block)
+        {
+            renderBlock (nullptr, outL, outR);
+
+            for (int i = 0; i < blockSize; ++i)
+                silentAfter = silentAfter && outL[i] == 0 && outR[i] == 0;
+        }
+
+        std::printf ("null room: inactive after %d tail blocks (expected %d), last sound %d samples into the tail (at most %d), %s after\n",
+                     tailBlocks, expectedTailBlocks, lastSound, tail - 1, silentAfter ? "silent" : "NOT silent");
+
+        return drainingAfterFade && tailBlocks == expectedTailBlocks && lastSound >= 0 && lastSound < tail
+            && ! reflections.isActive() && silentAfter;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    bool passed = true;
+
+    passed = checkFirstOrder() && passed;
+    passed = checkFadeOut() && passed;
+
+    std::printf ("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    FdnReverbTest.cpp
+
+    Checks the reverb's decay time. An impulse is sent into the network
+    for several decay times, sizes and line counts, and the decay time of
+    its output is measured the way a room's is: Schroeder backward
+    integration of the energy, and a line fitted from -5 to -35 dB (T30).
+
+    The lines are damped towards high frequencies, so the requested decay
+    time only holds at DC. The output is low passed at 200 Hz before it is
+    measured there, and has to match within 5 %. A high passed copy has to
+    decay faster.
+
+  ==============================================================================
+*/
+
+#include "FdnReverb.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double sampleRate = 48000;
+
+    /** T30 of a response, extrapolated to 60 dB, in seconds. */
+    double measureDecayTime (const std::vector<double>& response)
+    {
+        // Energy left after each sample, in dB below the total
+        std::vector<double> decay (response.size());
+        double energy = 0;
+
+        for (size_t n = response.size(); n-- > 0;)
+        {
+            energy += response[n] * response[n];
+            decay[n] = energy;
+        }
+
+        for (auto& d : decay)
+            d = 10 * std::log10 (d / energy);
+
+        // Least squares line through the -5 to -35 dB part
+        double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+        int count = 0;
+
+        for (size_t n = 0; n < decay.size() && decay[n] > -35; ++n)
+        {
+            if (decay[n] > -5)
+                continue;
+
+            const double x = static_cast<double> (n);
+            sumX += x;
+            sumY += decay[n];
+            sumXX += x * x;
+            sumXY += x * decay[n];
+            ++count;
+        }
+
+        const double slope = (count * sumXY - sumX * sumY) / (count * sumXX - sumX * sumX); // [dB/sample]
+        return -60 / slope / sampleRate;
+    }
+
+    /** Four one-pole low passes, or four first differences, in series. */
+    std::vector<double> filter (const std::vector<double>& x, bool highPass)
+    {
+        const double p = std::exp (-2 * pi * 200 / sampleRate);
+
+        std::vector<double> y (x);
+
+        for (int stage = 0; stage < 4; ++stage)
+        {
+            double state = 0;
+
+            for (auto& v : y)
+            {
+                const double in = v;
+                v = highPass ? 0.5 * (in - state) : (1 - p) * in + p * state;
+                state = highPass ? in : v;
+            }
+        }
+
+        return y;
+    }
+
+    bool check (float decayTime, float size, int numLines)
+    {
+        FdnReverb reverb;
+        reverb.setSmoothingTime (0);
+        reverb.prepare (sampleRate, numLines);
+        reverb.setDecayTime (decayTime);
+        reverb.setSize (size);
+        reverb.setWet (1.0f);
+        reverb.reset();
+
+        // Long enough for the energy to fall by 35 dB and then some
+        const int length = static_cast<int> (sampleRate * (decayTime * 1.2 + 0.1));
+
+        std::vector<float> send (length, 0.0f), left (length, 0.0f), right (length, 0.0f);
+        send[0] = 1.0f;
+
+        for (int pos = 0; pos < length; pos += 512)
+            reverb.process (send.data() + pos, left.data() + pos, right.data() + pos, std::min (512, length - pos));
+
+        std::vector<double> output (length);
+        for (int n = 0; n < length; ++n)
+            output[n] = left[n] + right[n];
+
+        const double low = measureDecayTime (filter (output, false));
+        const double high = measureDecayTime (filter (output, true));
+
+        std::printf ("decay %.1f s, size %.1f, %2d lines: %.3f s at low frequencies, %.3f s at high ones\n",
+                     decayTime, size, numLines, low, high);
+
+        return std::abs (low / decayTime - 1) < 0.05 && high < low;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    bool passed = true;
+
+    for (float decayTime : { 0.5f, 1.5f, 4.0f })
+        for (float size : { 0.0f, 0.5f, 1.0f })
+            for (int numLines : { 8, 16 })
+                passed = check (decayTime, size, numLines) && passed;
+
+    std::printf ("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
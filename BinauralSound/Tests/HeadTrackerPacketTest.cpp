@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    HeadTrackerPacketTest.cpp
+
+    Checks the head tracker's packet parser on datagrams built byte by
+    byte: OSC messages with float, int and double arguments, with and
+    without a timestamp, bundles, the binary HTRK format, and packets it
+    has to reject, such as another address, too few arguments or a
+    message cut short. A rejected packet must leave the outputs alone.
+
+  ==============================================================================
+*/
+
+#include "HeadTrackerPacket.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace
+{
+    //==============================================================================
+    /** Builds a datagram the way a sender would. */
+    struct Packet
+    {
+        std::string bytes;
+
+        Packet& string (const char* s)
+        {
+            bytes.append (s, std::strlen (s) + 1);
+            while (bytes.size() % 4 != 0)
+                bytes.push_back (0);
+            return *this;
+        }
+
+        Packet& bigEndian (uint64_t bits, int size)
+        {
+            for (int i = size - 1; i >= 0; --i)
+                bytes.push_back (static_cast<char> (bits >> (8 * i)));
+            return *this;
+        }
+
+        Packet& littleEndian (uint64_t bits, int size)
+        {
+            for (int i = 0; i < size; ++i)
+                bytes.push_back (static_cast<char> (bits >> (8 * i)));
+            return *this;
+        }
+
+        Packet& oscFloat (float value)      { uint32_t bits; std::memcpy (&bits, &value, 4); return bigEndian (bits, 4); }
+        Packet& oscDouble (double value)    { uint64_t bits; std::memcpy (&bits, &value, 8); return bigEndian (bits, 8); }
+        Packet& oscInt (int32_t value)      { return bigEndian (static_cast<uint32_t> (value), 4); }
+        Packet& binaryFloat (float value)   { uint32_t bits; std::memcpy (&bits, &value, 4); return littleEndian (bits, 4); }
+        Packet& binaryDouble (double value) { uint64_t bits; std::memcpy (&bits, &value, 8); return littleEndian (bits, 8); }
+
+        /** Appends p as a bundle element. */
+        Packet& element (const Packet& p)
+        {
+            bigEndian (p.bytes.size(), 4);
+            bytes += p.bytes;
+            return *this;
+        }
+
+        Packet cut (size_t size) const      { return { bytes.substr (0, size) }; }
+    };
+
+    Packet bundle()
+    {
+        return Packet().string ("#bundle").bigEndian (1, 8);
+    }
+
+    //==============================================================================
+    bool check (const char* name, const Packet& packet, bool shouldParse, HeadOrientation expected = {}, double expectedTime = 0)
+    {
+        // Outputs start out as something no packet here carries
+        HeadOrientation orientation { -1, -1, -1 };
+        double sentTime = -1;
+
+        const bool parsed = HeadTrackerPacket::parse (packet.bytes.data(), static_cast<int> (packet.bytes.size()), orientation, sentTime);
+
+        const bool passed = parsed == shouldParse
+                         && (parsed ? orientation.yaw == expected.yaw && orientation.pitch == expected.pitch
+                                          && orientation.roll == expected.roll && sentTime == expectedTime
+                                    : orientation.yaw == -1 && orientation.pitch == -1 && orientation.roll == -1 && sentTime == -1);
+
+        std::printf ("%-32s %-8s %s\n", name, parsed ? "parsed" : "rejected", passed ? "ok" : "FAILED");
+        return passed;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    bool passed = true;
+
+    const auto floats = Packet().string ("/head/ypr").string (",fff").oscFloat (30.5f).oscFloat (-10.25f).oscFloat (5.0f);
+    const auto timed = Packet().string ("/head/ypr").string (",fffd").oscFloat (30.5f).oscFloat (-10.25f).oscFloat (5.0f).oscDouble (1234.5678);
+
+    passed = check ("osc floats", floats, true, { 30.5f, -10.25f, 5.0f }) && passed;
+    passed = check ("osc floats and timestamp", timed, true, { 30.5f, -10.25f, 5.0f }, 1234.5678) && passed;
+    passed = check ("osc ints", Packet().string ("/ypr").string (",iii").oscInt (-90).oscInt (45).oscInt (0), true, { -90, 45, 0 }) && passed;
+    passed = check ("osc doubles", Packet().string ("/ypr").string (",ddd").oscDouble (1.5).oscDouble (-2.5).oscDouble (3.5), true, { 1.5f, -2.5f, 3.5f }) && passed;
+    passed = check ("osc mixed", Packet().string ("/ypr").string (",fid").oscFloat (1.0f).oscInt (2).oscDouble (3.0), true, { 1, 2, 3 }) && passed;
+
+    passed = check ("osc bundle", bundle().element (floats), true, { 30.5f, -10.25f, 5.0f }) && passed;
+    passed = check ("osc bundle, last one wins", bundle().element (floats).element (timed).element (
+                        Packet().string ("/ypr").string (",iii").oscInt (7).oscInt (8).oscInt (9)), true, { 7, 8, 9 }) && passed;
+    passed = check ("osc nested bundle", bundle().element (bundle().element (timed)), true, { 30.5f, -10.25f, 5.0f }, 1234.5678) && passed;
+
+    passed = check ("osc other address", Packet().string ("/head/xyz").string (",fff").oscFloat (1).oscFloat (2).oscFloat (3), false) && passed;
+    passed = check ("osc two arguments", Packet().string ("/ypr").string (",ff").oscFloat (1).oscFloat (2), false) && passed;
+    passed = check ("osc string argument", Packet().string ("/ypr").string (",fffs").oscFloat (1).oscFloat (2).oscFloat (3).string ("x"), false) && passed;
+    passed = check ("osc missing type tags", Packet().string ("/ypr").oscFloat (1).oscFloat (2).oscFloat (3), false) && passed;
+    passed = check ("osc cut short", floats.cut (floats.bytes.size() - 4), false) && passed;
+    passed = check ("osc not padded", floats.cut (floats.bytes.size() - 1), false) && passed;
+    passed = check ("osc unterminated address", Packet().bigEndian (0x2f797072, 4).bigEndian (0x2f797072, 4), false) && passed;
+    passed = check ("osc bundle, oversized element", bundle().bigEndian (1000, 4).string ("/ypr"), false) && passed;
+
+    const auto binary = Packet { "HTRK" }.binaryFloat (-45.0f).binaryFloat (12.5f).binaryFloat (-3.0f);
+
+    passed = check ("binary", binary, true, { -45.0f, 12.5f, -3.0f }) && passed;
+    passed = check ("binary and timestamp", Packet (binary).binaryDouble (98.765), true, { -45.0f, 12.5f, -3.0f }, 98.765) && passed;
+    passed = check ("binary cut short", binary.cut (15), false) && passed;
+
+    passed = check ("empty", Packet(), false) && passed;
+
+    std::printf ("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    HrirSetTest.cpp
+
+    Checks that HrirSet::load() reads a valid dump and rejects corrupt
+    headers with an error, without allocating for what the header claims.
+    A measurement count of 2^32 - 1 would otherwise ask for tens of
+    gigabytes and throw std::bad_alloc into the host.
+
+  ==============================================================================
+*/
+
+#include "HrirSet.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace
+{
+    const std::string path = "hrir_set_test.bin";
+
+    template <typename T>
+    void write (std::ofstream& stream, T value)
+    {
+        stream.write(reinterpret_cast<const char*> (&value), sizeof (T));
+    }
+
+    /** A dump whose header claims numMeasurements of length samples, holding
+        numWritten of them.
+    */
+    void writeFile (uint32_t numMeasurements, uint32_t length, uint32_t numWritten)
+    {
+        std::ofstream stream (path, std::ios::binary);
+
+        stream.write("HRIR", 4);
+        write(stream, uint32_t (1));
+        write(stream, 48000.0f);
+        write(stream, numMeasurements);
+        write(stream, length);
+
+        for (uint32_t m = 0; m < numWritten; ++m)
+        {
+            write(stream, 90.0f * m);
+            write(stream, 0.0f);
+
+            for (uint32_t n = 0; n < 2 * length; ++n)
+                write(stream, n == 0 ? 1.0f : 0.0f);
+        }
+    }
+
+    bool check (const char* name, uint32_t numMeasurements, uint32_t length, uint32_t numWritten, bool shouldLoad)
+    {
+        writeFile (numMeasurements, length, numWritten);
+
+        std::string error;
+        const auto set = HrirSet::load(path, error);
+        const bool loaded = set != nullptr;
+        const bool passed = loaded == shouldLoad && (loaded || ! error.empty())
+                         && (! loaded || (set->getNumMeasurements() == static_cast<int> (numMeasurements) && set->getLength() == static_cast<int> (length)));
+
+        std::printf ("%-24s %s%s%s\n", name, loaded ? "loaded" : "rejected", error.empty() ? "" : ": ", error.c_str());
+        return passed;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    bool passed = true;
+
+    passed = check ("valid", 4, 256, 4, true) && passed;
+    passed = check ("huge measurement count", 0xffffffff, 256, 4, false) && passed;
+    passed = check ("count past the data", 60000, 1 << 20, 4, false) && passed;
+    passed = check ("truncated", 4, 256, 3, false) && passed;
+
+    std::remove (path.c_str());
+
+    std::printf ("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
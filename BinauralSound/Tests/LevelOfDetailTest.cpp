@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+    LevelOfDetailTest.cpp
+
+    Checks BinauralScene's level of detail. With every source forced to
+    the full model the output has to be that of level of detail off, to
+    the bit.
+
+    Then one source playing a 300 Hz sine is moved from full to reduced to
+    panned and back to full, by changing the thresholds between blocks.
+    The levels sound very different (switching outright would jump by
+    0.4 to 0.9), so each change has to be a crossfade: over
+    kDetailFadeLength samples, the output has to follow the linear blend
+    of scenes held at either level all along to 100 dB below the signal,
+    and match the new level exactly once the fade is over. Going back from
+    panned is the hard case: the head shadow filter did not run while the
+    source was panned, so the scene has to rebuild what the pinna reads.
+
+  ==============================================================================
+*/
+
+#include "BinauralScene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double sampleRate = 48000;
+    constexpr int blockSize = 128;
+    constexpr int numBlocks = 120;
+    constexpr int numSamples = numBlocks * blockSize;
+
+    using SceneKernels::Detail;
+
+    /** Thresholds that force every source to one level. */
+    void forceDetail (BinauralScene& scene, Detail detail)
+    {
+        switch (detail)
+        {
+            case Detail::full:      scene.setDetailThresholds (-400.0f, -400.0f); break;
+            case Detail::reduced:   scene.setDetailThresholds (400.0f, -400.0f); break;
+            default:                scene.setDetailThresholds (400.0f, 400.0f); break;
+        }
+    }
+
+    const char* getName (Detail detail)
+    {
+        switch (detail)
+        {
+            case Detail::full:      return "full";
+            case Detail::reduced:   return "reduced";
+            case Detail::panned:    return "panned";
+            case Detail::skipped:   return "skipped";
+        }
+
+        return "";
+    }
+
+    struct Output
+    {
+        std::vector<float> left, right;
+    };
+
+    /** One source, at the level getDetail (block) gives for every block,
+        or with level of detail off.
+    */
+    template <typename GetDetail>
+    Output render (bool levelOfDetail, GetDetail&& getDetail)
+    {
+        BinauralScene scene;
+        scene.prepare (sampleRate, blockSize, 1);
+        scene.setLevelOfDetail (levelOfDetail);
+        scene.setSourcePosition (0, 40.0f, 20.0f);
+
+        std::vector<float> input (numSamples);
+        for (int n = 0; n < numSamples; ++n)
+            input[n] = static_cast<float> (0.5 * std::sin (2.0 * pi * 300.0 * n / sampleRate));
+
+        Output output { std::vector<float> (numSamples), std::vector<float> (numSamples) };
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            const int start = block * blockSize;
+            const float* in = input.data() + start;
+
+            forceDetail (scene, getDetail (block));
+            scene.process (&in, output.left.data() + start, output.right.data() + start, blockSize);
+        }
+
+        return output;
+    }
+
+    Output render (Detail detail)
+    {
+        return render (true, [detail] (int) { return detail; });
+    }
+
+    /** Largest difference, either ear, in [start, end) between the output
+        and the blend of from and to a crossfade starting at start gives.
+    */
+    float getFadeError (const Output& output, const Output& from, const Output& to, int start, int end)
+    {
+        float error = 0;
+
+        for (int n = start; n < end; ++n)
+        {
+            const float weight = std::min (1.0f, static_cast<float> (n - start + 1) / BinauralScene::kDetailFadeLength);
+
+            error = std::max (error, std::abs (output.left[n] - ((1 - weight) * from.left[n] + weight * to.left[n])));
+            error = std::max (error, std::abs (output.right[n] - ((1 - weight) * from.right[n] + weight * to.right[n])));
+        }
+
+        return error;
+    }
+
+    float getPeak (const Output& output)
+    {
+        float peak = 0;
+
+        for (const auto* ear : { &output.left, &output.right })
+            for (auto x : *ear)
+                peak = std::max (peak, std::abs (x));
+
+        return peak;
+    }
+
+    bool isSame (const Output& a, const Output& b, int start, int end)
+    {
+        return std::equal (a.left.begin() + start, a.left.begin() + end, b.left.begin() + start)
+            && std::equal (a.right.begin() + start, a.right.begin() + end, b.right.begin() + start);
+    }
+}
+
+//==============================================================================
+int main()
+{
+    bool passed = true;
+
+    const Output off = render (false, [] (int) { return Detail::full; });
+    const Output full = render (Detail::full);
+    const Output reduced = render (Detail::reduced);
+    const Output panned = render (Detail::panned);
+
+    const bool fullSame = isSame (full, off, 0, numSamples);
+    std::printf ("full detail against level of detail off: %s\n", fullSame ? "same" : "DIFFERENT");
+    passed = fullSame && passed;
+
+    // Full, reduced, panned, then full again, a quarter of the blocks each
+    const Detail schedule[] = { Detail::full, Detail::reduced, Detail::panned, Detail::full };
+    const Output* steady[] = { &full, &reduced, &panned, &full };
+    constexpr int blocksPerLevel = numBlocks / 4;
+
+    const Output changing = render (true, [&] (int block) { return schedule[block / blocksPerLevel]; });
+
+    for (int i = 1; i < 4; ++i)
+    {
+        const int change = i * blocksPerLevel * blockSize;
+        const int faded = change + BinauralScene::kDetailFadeLength;
+        const int next = std::min ((i + 1) * blocksPerLevel * blockSize, numSamples);
+
+        const auto& from = *steady[i - 1];
+        const auto& to = *steady[i];
+
+        const float peak = std::max (getPeak (from), getPeak (to));
+        const float error = getFadeError (changing, from, to, change, faded);
+        const float jump = std::max (std::abs (from.left[change] - to.left[change]), std::abs (from.right[change] - to.right[change]));
+        const bool settled = isSame (changing, to, faded, next);
+
+        std::printf ("%-7s to %-7s: %.1f dB from the crossfade, %.2f switching outright; %s after it\n",
+                     getName (schedule[i - 1]), getName (schedule[i]), 20 * std::log10 (std::max (error, 1e-20f) / peak), jump,
+                     settled ? "settled" : "NOT SETTLED");
+
+        passed = error < 1e-5f * peak && settled && passed;
+    }
+
+    std::printf ("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
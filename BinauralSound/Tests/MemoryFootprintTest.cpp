@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    MemoryFootprintTest.cpp
+
+    Checks BinauralScene::getMemoryFootprint() against the state a source
+    should need, worked out from the model's line sizes. Two scenes whose
+    source counts differ by whole tasks are prepared; their difference
+    must be exactly that many sources and tasks, so every per-source
+    vector, including the byte-sized ones and the early reflections' pinna
+    lines, has to be counted at its real size.
+
+  ==============================================================================
+*/
+
+#include "BinauralScene.h"
+
+#include <cstdio>
+
+namespace
+{
+    constexpr int maxBlock = 512;
+    constexpr float maxDistance = 20.0f;
+
+    size_t getExpectedBytesPerSource (float sampleRate)
+    {
+        const int lineSize = BrownDudaModel::inputLineSize(sampleRate, DistanceModel::propagationDelay(maxDistance, sampleRate));
+        const int pinnaLineSize = BrownDudaModel::pinnaLineSize(sampleRate);
+
+        const size_t floats = lineSize                                          // input line
+                            + 2 * pinnaLineSize                                 // head shadow lines
+                            + 4                                                 // azimuth, elevation, volume, distance
+                            + 2 * (8 + 2 * BrownDudaModel::numPinnaEvents)      // ear state
+                            + 2 + 2 + 3                                         // gain, room echo delay, air absorption
+                            + 2;                                                // detail level, chunk level
+
+        return floats * sizeof (float)
+             + 3 * sizeof (int)                                                 // fade position, silent samples, budget order
+             + sizeof (unsigned char)                                           // audible
+             + 2 * sizeof (SceneKernels::Detail)                                // detail, fading from
+             + sizeof (EarlyReflections) + 2 * pinnaLineSize * sizeof (float);  // reflections and their pinna lines
+    }
+
+    size_t getExpectedBytesPerTask()
+    {
+        return 3 * maxBlock * sizeof (float)                                    // partial left, right and send bus
+             + sizeof (int)                                                     // rendered sources
+             + 4 * sizeof (uint64_t);                                           // detail counters
+    }
+
+    bool check (double sampleRate)
+    {
+        constexpr int fewSources = 2 * BinauralScene::kSourcesPerTask;
+        constexpr int manySources = 6 * BinauralScene::kSourcesPerTask;
+
+        BinauralScene few, many;
+        few.prepare (sampleRate, maxBlock, fewSources, maxDistance);
+        many.prepare (sampleRate, maxBlock, manySources, maxDistance);
+
+        const size_t measured = many.getMemoryFootprint() - few.getMemoryFootprint();
+        const size_t expected = (manySources - fewSources) * getExpectedBytesPerSource (static_cast<float> (sampleRate))
+                              + (manySources - fewSources) / BinauralScene::kSourcesPerTask * getExpectedBytesPerTask();
+
+        std::printf ("%6.0f Hz: %zu bytes per source, expected %zu\n", sampleRate,
+                     measured / (manySources - fewSources), expected / (manySources - fewSources));
+
+        return measured == expected;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    bool passed = true;
+
+    for (double sampleRate : { 44100.0, 48000.0, 96000.0 })
+        passed = check (sampleRate) && passed;
+
+    std::printf ("%s\n", passed ? "passed" : "FAILED: the footprint does not match the per-source state");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+    RenderPathsTest.cpp
+
+    Checks that BinauralEngine's specialised inner loops render what the
+    generic model does. The engine picks a loop per control block: one for
+    delays that move and one that works out every read position once for
+    blocks where they stand still, each with and without the room echo.
+
+    - With the echo on, a source that alternately moves and holds still,
+      so the engine keeps switching between the static and moving loops,
+      has to match BinauralScene's scalar kernel, which has no such
+      specialisation, sample for sample.
+    - With the echo off, the output has to be the same minus the echo
+      alone, the input delayed by the echo time and scaled by its gain,
+      and raising the reverb's wet level must not change it, since the
+      reverb gets no input.
+
+  ==============================================================================
+*/
+
+#include "BinauralEngine.h"
+#include "BinauralScene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double sampleRate = 48000;
+    constexpr int blockSize = 256;
+    constexpr int numBlocks = 400;
+    constexpr int numSamples = numBlocks * blockSize;
+
+    /** Moves for a quarter of a second, then holds still for as long. */
+    void getPosition (int block, float& azimuth, float& elevation)
+    {
+        const double time = std::min (static_cast<double> (block * blockSize), std::floor (block * blockSize / 24000.0) * 24000 + 12000) / sampleRate;
+
+        azimuth = static_cast<float> (80 * std::sin (2 * pi * 0.7 * time));
+        elevation = static_cast<float> (40 * std::cos (2 * pi * 0.4 * time));
+    }
+
+    struct Output
+    {
+        std::vector<float> left, right;
+    };
+
+    Output renderEngine (const std::vector<float>& input, bool roomEcho, float reverbWet)
+    {
+        BinauralEngine engine;
+        engine.setSmoothingTime (0); // the scene jumps to each block's position
+        engine.setRoomEcho (roomEcho);
+        engine.setReverbWet (reverbWet);
+        engine.prepare (sampleRate, blockSize);
+        engine.reset();
+
+        Output out { std::vector<float> (numSamples), std::vector<float> (numSamples) };
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            float azimuth, elevation;
+            getPosition (block, azimuth, elevation);
+
+            engine.setAzimuth (azimuth);
+            engine.setElevation (elevation);
+            engine.process (input.data() + block * blockSize, out.left.data() + block * blockSize, out.right.data() + block * blockSize, blockSize);
+        }
+
+        return out;
+    }
+
+    Output renderScene (const std::vector<float>& input)
+    {
+        BinauralScene scene;
+        scene.setSimdLevel (SceneKernels::SimdLevel::scalar);
+        scene.prepare (sampleRate, blockSize, 1);
+        scene.reset();
+
+        Output out { std::vector<float> (numSamples), std::vector<float> (numSamples) };
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            float azimuth, elevation;
+            getPosition (block, azimuth, elevation);
+
+            scene.setSourcePosition (0, azimuth, elevation);
+
+            const float* inputs[] = { input.data() + block * blockSize };
+            scene.process (inputs, out.left.data() + block * blockSize, out.right.data() + block * blockSize, blockSize);
+        }
+
+        return out;
+    }
+
+    /** Largest difference between a and b once expected[n] is added to b. */
+    double getMaxDifference (const Output& a, const Output& b, const std::vector<float>& expected = {})
+    {
+        double difference = 0;
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            const float add = expected.empty() ? 0.0f : expected[n];
+
+            difference = std::max (difference, static_cast<double> (std::abs (a.left[n] - (b.left[n] + add))));
+            difference = std::max (difference, static_cast<double> (std::abs (a.right[n] - (b.right[n] + add))));
+        }
+
+        return difference;
+    }
+
+    bool check (const char* name, double difference, double tolerance)
+    {
+        std::printf ("%-40s max difference %.1e\n", name, difference);
+        return difference <= tolerance;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    std::mt19937 rng (1);
+    std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+
+    std::vector<float> input (numSamples);
+    for (auto& x : input)
+        x = noise (rng);
+
+    const auto withEcho = renderEngine (input, true, 0.0f);
+    const auto withoutEcho = renderEngine (input, false, 0.0f);
+
+    // The echo alone: the input, behind the model's latency and the echo
+    // time (a whole number of samples at 48 kHz) at the echo's gain
+    BinauralEngine engine;
+    engine.prepare (sampleRate, blockSize);
+
+    const int echoDelay = engine.getLatency() + static_cast<int> (std::lround (BrownDudaModel::tau_Ke * sampleRate));
+
+    std::vector<float> echo (numSamples, 0.0f);
+    for (int n = echoDelay; n < numSamples; ++n)
+        echo[n] = BrownDudaModel::roomEchoGain() * input[n - echoDelay];
+
+    bool passed = true;
+
+    passed = check ("echo on against the scene", getMaxDifference (withEcho, renderScene (input)), 1.0e-6) && passed;
+    passed = check ("echo off plus the echo against echo on", getMaxDifference (withEcho, withoutEcho, echo), 1.0e-6) && passed;
+    passed = check ("echo off, reverb wet against dry", getMaxDifference (renderEngine (input, false, 1.0f), withoutEcho), 0.0) && passed;
+
+    std::printf ("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
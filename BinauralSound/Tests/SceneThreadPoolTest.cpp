@@ -0,0 +1,158 @@
+/*
+  ==============================================================================
+
+    SceneThreadPoolTest.cpp
+
+    Checks that BinauralScene sounds the same on a SceneThreadPool as on
+    the calling thread alone, to the bit. A scene of many moving sources,
+    at several distances, with early reflections, the late reverb, level
+    of detail under a CPU budget and every third group of sources culled,
+    so the groups cost very different amounts and the workers have to
+    steal, is rendered in blocks of changing sizes without a pool and
+    then on pools of 1, 3 and 7 workers. Every sample of both ears has to
+    match.
+
+    A pool may be shared by scenes that are not processed at the same
+    time, so two scenes processed in turn on one pool have to match their
+    single-threaded renders as well.
+
+  ==============================================================================
+*/
+
+#include "BinauralScene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr double sampleRate = 48000;
+    constexpr int maxBlock = 256;
+    constexpr int numBlocks = 64;
+    constexpr int numSources = 10 * BinauralScene::kSourcesPerTask;
+    constexpr float maxDistance = 10.0f;
+    constexpr double pi = 3.14159265358979323846;
+
+    /** A busy scene, its sources seeded by seed. */
+    struct Setup
+    {
+        explicit Setup (unsigned seed)
+        {
+            scene.prepare (sampleRate, maxBlock, numSources, maxDistance);
+            scene.setEarlyReflections (true);
+            scene.setReverbWet (0.3f);
+            scene.setLevelOfDetail (true);
+            scene.setCpuBudget (numSources / 2.0f);
+
+            std::mt19937 rng (seed);
+            std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+
+            inputs.assign (numSources, std::vector<float> (numBlocks * maxBlock));
+
+            for (int s = 0; s < numSources; ++s)
+            {
+                for (auto& x : inputs[s])
+                    x = noise (rng);
+
+                // Quieter sources further down each group, so level of detail has to choose
+                scene.setSourceGain (s, (s / BinauralScene::kSourcesPerTask) % 3 == 0 ? -200.0f : -3.0f * (s % BinauralScene::kSourcesPerTask));
+                scene.setSourceDistance (s, 1.0f + (s % 7));
+            }
+
+            inputPointers.resize (numSources);
+        }
+
+        /** Renders the next block of n samples into the end of left and right. */
+        void processBlock (int start, int n)
+        {
+            const double time = start / sampleRate;
+
+            for (int s = 0; s < numSources; ++s)
+            {
+                scene.setSourcePosition (s, static_cast<float> (80.0 * std::sin (2.0 * pi * 0.5 * time + s)),
+                                            static_cast<float> (30.0 * std::cos (2.0 * pi * 0.3 * time + s)));
+                inputPointers[s] = inputs[s].data() + start;
+            }
+
+            left.resize (start + n);
+            right.resize (start + n);
+
+            scene.process (inputPointers.data(), left.data() + start, right.data() + start, n);
+        }
+
+        BinauralScene scene;
+
+        std::vector<std::vector<float>> inputs;
+        std::vector<const float*> inputPointers;
+        std::vector<float> left, right;
+    };
+
+    /** Block sizes that change from block to block, up to maxBlock. */
+    int getBlockSize (int block)
+    {
+        constexpr int sizes[] = { maxBlock, 64, 200, 1, maxBlock, 129 };
+        return sizes[block % 6];
+    }
+
+    /** Renders scenes with these seeds in turn, on the pool or without one. */
+    std::vector<std::unique_ptr<Setup>> render (std::vector<unsigned> seeds, std::shared_ptr<SceneThreadPool> pool)
+    {
+        std::vector<std::unique_ptr<Setup>> setups;
+
+        for (auto seed : seeds)
+        {
+            setups.push_back (std::make_unique<Setup> (seed));
+            setups.back()->scene.setThreadPool (pool);
+        }
+
+        for (int block = 0, start = 0; block < numBlocks; start += getBlockSize (block), ++block)
+            for (auto& setup : setups)
+                setup->processBlock (start, getBlockSize (block));
+
+        return setups;
+    }
+
+    bool isSame (const Setup& a, const Setup& b)
+    {
+        return a.left == b.left && a.right == b.right;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    bool passed = true;
+
+    const auto single = render ({ 1 }, nullptr);
+
+    float peak = 0;
+    for (auto x : single[0]->left)
+        peak = std::max (peak, std::abs (x));
+
+    passed = peak > 0.01f;
+
+    for (int numWorkers : { 1, 3, 7 })
+    {
+        const auto pool = std::make_shared<SceneThreadPool> (numWorkers);
+        const bool same = isSame (*render ({ 1 }, pool)[0], *single[0]);
+
+        std::printf ("%d workers: %s, %llu tasks stolen\n", numWorkers, same ? "same" : "DIFFERENT",
+                     static_cast<unsigned long long> (pool->getNumStolenTasks()));
+
+        passed = same && passed;
+    }
+
+    const auto other = render ({ 2 }, nullptr);
+    const auto shared = render ({ 1, 2 }, std::make_shared<SceneThreadPool> (3));
+    const bool sharedSame = isSame (*shared[0], *single[0]) && isSame (*shared[1], *other[0]);
+
+    std::printf ("two scenes on one pool: %s\n", sharedSame ? "same" : "DIFFERENT");
+    passed = sharedSame && passed;
+
+    std::printf ("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
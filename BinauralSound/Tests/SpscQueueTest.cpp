@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    SpscQueueTest.cpp
+
+    Checks the head tracker's SpscQueue: it holds at least the capacity it
+    was made with, refuses items when full and gives nothing when empty,
+    keeps FIFO order as the indices wrap round, and hands a long run of
+    items from one thread to another without losing, duplicating or
+    reordering any.
+
+  ==============================================================================
+*/
+
+#include "SpscQueue.h"
+
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+    bool check (const char* name, bool passed)
+    {
+        std::printf ("%-28s %s\n", name, passed ? "ok" : "FAILED");
+        return passed;
+    }
+
+    bool checkFullAndEmpty()
+    {
+        SpscQueue<int> queue (5);
+
+        int item = 0;
+        bool passed = ! queue.pop (item) && queue.getCapacity() >= 5;
+
+        const int capacity = static_cast<int> (queue.getCapacity());
+
+        for (int i = 0; i < capacity; ++i)
+            passed = queue.push (i) && passed;
+
+        passed = ! queue.push (capacity) && passed;
+
+        for (int i = 0; i < capacity; ++i)
+            passed = queue.pop (item) && item == i && passed;
+
+        return ! queue.pop (item) && passed;
+    }
+
+    bool checkWraparound()
+    {
+        SpscQueue<int> queue (3);
+
+        // Uneven pushes and pops walk the indices round the buffer many times
+        int next = 0, expected = 0;
+        bool passed = true;
+
+        for (int round = 0; round < 1000; ++round)
+        {
+            for (int i = 0; i < 1 + round % 3; ++i)
+                passed = queue.push (next++) && passed;
+
+            for (int i = 0; i < 1 + (round + 1) % 3; ++i)
+            {
+                int item = 0;
+
+                if (queue.pop (item))
+                    passed = item == expected++ && passed;
+            }
+        }
+
+        int item = 0;
+        while (queue.pop (item))
+            passed = item == expected++ && passed;
+
+        return expected == next && passed;
+    }
+
+    bool checkTwoThreads()
+    {
+        constexpr int numItems = 1000000;
+
+        SpscQueue<int> queue (64);
+
+        std::thread producer ([&]
+        {
+            for (int i = 0; i < numItems; ++i)
+                while (! queue.push (i))
+                    std::this_thread::yield();
+        });
+
+        int expected = 0;
+        bool inOrder = true;
+
+        while (expected < numItems)
+        {
+            int item = 0;
+
+            if (! queue.pop (item))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            inOrder = item == expected && inOrder;
+            ++expected;
+        }
+
+        producer.join();
+
+        int item = 0;
+        return inOrder && ! queue.pop (item);
+    }
+}
+
+//==============================================================================
+int main()
+{
+    bool passed = true;
+
+    passed = check ("full and empty", checkFullAndEmpty()) && passed;
+    passed = check ("wraparound", checkWraparound()) && passed;
+    passed = check ("producer and consumer thread", checkTwoThreads()) && passed;
+
+    std::printf ("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
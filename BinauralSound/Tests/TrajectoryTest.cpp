@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    TrajectoryTest.cpp
+
+    Checks binaural_render's trajectory parser. A valid file, with
+    comments, blank lines and an optional gain column, has to load and
+    interpolate linearly between its keyframes while holding the ends.
+    Malformed lines and values outside the model's angle ranges have to
+    be rejected with an error naming their line.
+
+  ==============================================================================
+*/
+
+#include "Trajectory.h"
+
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    bool parse (const std::string& text, Trajectory& trajectory, std::string& error)
+    {
+        std::istringstream stream (text);
+        return trajectory.parse (stream, error);
+    }
+
+    /** The line should be rejected with an error naming it. */
+    bool checkRejected (const char* name, const std::string& text, int line)
+    {
+        Trajectory trajectory;
+        std::string error;
+
+        const bool parsed = parse (text, trajectory, error);
+        const bool passed = ! parsed && error.rfind ("line " + std::to_string (line) + ":", 0) == 0;
+
+        std::printf ("%-28s %s%s\n", name, parsed ? "parsed" : "rejected: ", error.c_str());
+        return passed;
+    }
+
+    bool checkKey (const Trajectory& trajectory, double time, float azimuth, float elevation, float gain)
+    {
+        const auto key = trajectory.evaluate (time);
+        const bool passed = std::abs (key.azimuth - azimuth) < 1.0e-4f
+                         && std::abs (key.elevation - elevation) < 1.0e-4f
+                         && std::abs (key.gain - gain) < 1.0e-4f;
+
+        std::printf ("  t = %5.2f s: %8.3f %8.3f %7.3f dB, expected %8.3f %8.3f %7.3f dB\n",
+                     time, key.azimuth, key.elevation, key.gain, azimuth, elevation, gain);
+        return passed;
+    }
+
+    bool checkValid()
+    {
+        const std::string text = "# time  azimuth  elevation  gain\r\n"
+                                 "\n"
+                                 "0.0     -60      0          0     # start on the left\n"
+                                 "   \t\n"
+                                 "2.0      60      20        -6\n"
+                                 "3.0      90     -180\n"
+                                 "3.0     -90      180        3\n";
+
+        Trajectory trajectory;
+        std::string error;
+
+        const bool parsed = parse (text, trajectory, error);
+        std::printf ("%-28s %s%s\n", "valid", parsed ? "parsed" : "rejected: ", error.c_str());
+
+        if (! parsed || trajectory.keyframes.size() != 4)
+            return false;
+
+        bool passed = true;
+
+        passed = checkKey (trajectory, -1.0, -60, 0, 0) && passed;          // held before the first
+        passed = checkKey (trajectory, 0.0, -60, 0, 0) && passed;
+        passed = checkKey (trajectory, 0.5, -30, 5, -1.5f) && passed;
+        passed = checkKey (trajectory, 1.0, 0, 10, -3) && passed;
+        passed = checkKey (trajectory, 2.0, 60, 20, -6) && passed;
+        passed = checkKey (trajectory, 2.25, 67.5f, -30, -4.5f) && passed;  // no gain column: 0 dB
+        passed = checkKey (trajectory, 10.0, -90, 180, 3) && passed;        // held after the last
+
+        return passed;
+    }
+
+    bool checkEmpty()
+    {
+        Trajectory trajectory;
+        std::string error;
+
+        const bool passed = parse ("# nothing but a comment\n\n", trajectory, error) && trajectory.keyframes.empty();
+        std::printf ("%-28s %s\n", "empty", passed ? "parsed" : "FAILED");
+
+        return checkKey (trajectory, 1.0, 0, 0, 0) && passed;
+    }
+
+    bool checkMissingFile()
+    {
+        Trajectory trajectory;
+        std::string error;
+
+        const bool loaded = trajectory.load ("no_such_trajectory.txt", error);
+        std::printf ("%-28s %s%s\n", "missing file", loaded ? "loaded" : "rejected: ", error.c_str());
+        return ! loaded && ! error.empty();
+    }
+}
+
+//==============================================================================
+int main()
+{
+    bool passed = true;
+
+    passed = checkValid() && passed;
+    passed = checkEmpty() && passed;
+    passed = checkMissingFile() && passed;
+
+    // Malformed lines
+    passed = checkRejected ("no time", "0 0 0\nleft 0 0\n", 2) && passed;
+    passed = checkRejected ("no elevation", "0 0 0\n1 30\n", 2) && passed;
+    passed = checkRejected ("gain not a number", "0 0 0 loud\n", 1) && passed;
+    passed = checkRejected ("extra column", "0 0 0\n\n1 30 0 -3 7\n", 3) && passed;
+    passed = checkRejected ("not sorted", "0 0 0\n2 10 0\n1 20 0\n", 3) && passed;
+
+    // Values outside the model's ranges
+    passed = checkRejected ("negative time", "-0.5 0 0\n", 1) && passed;
+    passed = checkRejected ("azimuth above 90", "0 0 0\n1 90.5 0\n", 2) && passed;
+    passed = checkRejected ("azimuth below -90", "0 -120 0\n", 1) && passed;
+    passed = checkRejected ("elevation beyond 180", "0 0 0\n1 0 0\n2 0 -270\n", 3) && passed;
+
+    std::printf ("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,343 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    binaural_render: offline binaural rendering of mono files along a
+    position trajectory, through the same BinauralEngine as the plugin.
+
+    usage:
+        binaural_render [options] input.wav trajectory.txt output.wav
+        binaural_render [options] --batch jobs.txt
+
+    A batch file lists one "input trajectory output" triple per line. Files
+    are rendered in parallel on a thread pool and the realtime factor of
+    each one is reported when it finishes.
+
+    options:
+        -j <threads>     worker threads (default: number of CPU cores)
+        -b <samples>     block size (default: 512)
+        --hrir <file>    render the direct sound with these HRIRs (see
+                         HrirSet.h) instead of the structural model
+        --brir <file>    render direct sound and room with these binaural
+                         room impulse responses, same format; wins over --hrir
+        --interpolation <linear|lagrange4|sinc8|sinc16>
+                         fractional delay interpolator of the model (default:
+                         linear, see Interpolation.h); sinc16 keeps the top
+                         octave of moving sources
+
+  ==============================================================================
+*/
+
+#include <juce_audio_formats/juce_audio_formats.h>
+
+#include "BinauralEngine.h"
+#include "Trajectory.h"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+namespace
+{
+    //==============================================================================
+    struct RenderJob
+    {
+        juce::File input, trajectory, output;
+    };
+
+    struct RenderResult
+    {
+        bool ok = false;
+        juce::String error;
+        double audioSeconds = 0;
+        double renderSeconds = 0;
+    };
+
+    //==============================================================================
+    RenderResult renderFile (const RenderJob& job, int blockSize, const std::shared_ptr<const HrirSet>& hrirs,
+                             const std::shared_ptr<const HrirSet>& brirs, Interpolation::Kind interpolation)
+    {
+        RenderResult result;
+
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (job.input));
+
+        if (reader == nullptr)
+        {
+            result.error = "cannot read " + job.input.getFullPathName();
+            return result;
+        }
+
+        Trajectory trajectory;
+        std::string trajectoryError;
+
+        if (! trajectory.load (job.trajectory.getFullPathName().toStdString(), trajectoryError))
+        {
+            result.error = job.trajectory.getFileName() + ": " + juce::String (trajectoryError);
+            return result;
+        }
+
+        auto* format = formats.findFormatForFileExtension (job.output.getFileExtension());
+
+        if (format == nullptr)
+        {
+            result.error = "unsupported output format " + job.output.getFileExtension();
+            return result;
+        }
+
+        const double sampleRate = reader->sampleRate;
+        const int bitsPerSample = reader->bitsPerSample > 16 ? 24 : 16;
+
+        job.output.deleteFile();
+        std::unique_ptr<juce::FileOutputStream> stream (job.output.createOutputStream());
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+
+        if (stream != nullptr)
+            writer.reset (format->createWriterFor (stream.get(), sampleRate, 2, bitsPerSample, {}, 0));
+
+        if (writer == nullptr)
+        {
+            result.error = "cannot write " + job.output.getFullPathName();
+            return result;
+        }
+
+        stream.release(); // now owned by the writer
+
+        // The trajectory is already continuous, follow it without extra lag
+        BinauralEngine engine;
+        engine.setSmoothingTime (0);
+        engine.setInterpolation (interpolation);
+        engine.prepare (sampleRate, blockSize);
+
+        // Let the delay lines ring out after the end of the input
+        juce::int64 numSamples = reader->lengthInSamples
+                               + BrownDudaModel::inputLineSize (static_cast<float> (sampleRate), 0, Interpolation::getNumTaps (interpolation));
+
+        if (hrirs != nullptr)
+        {
+            auto filters = std::make_shared<const HrirFilters> (hrirs, sampleRate, BinauralEngine::hrirPartitionSize, BinauralEngine::maxHrirLength);
+            numSamples += filters->getNumPartitions() * filters->getPartitionSize() + engine.getLatency();
+
+            engine.setHrirs (std::move (filters));
+            engine.setRenderingMode (BinauralEngine::RenderingMode::hrir);
+        }
+
+        if (brirs != nullptr)
+        {
+            // The tail on this thread rather than a pool: the jobs already
+            // keep every core busy, and nothing has a deadline here
+            auto convolver = std::make_shared<BrirConvolver> (std::make_shared<const BrirFilters> (brirs, sampleRate), nullptr);
+            numSamples += convolver->getTailLength();
+
+            engine.setBrirs (std::move (convolver));
+            engine.setRenderingMode (BinauralEngine::RenderingMode::brir);
+        }
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+
+        const double startTime = juce::Time::getMillisecondCounterHiRes();
+
+        for (juce::int64 pos = 0; pos < numSamples; pos += blockSize)
+        {
+            const int n = static_cast<int> (juce::jmin<juce::int64> (blockSize, numSamples - pos));
+
+            // Only the first channel is rendered; reads past the end are zero filled
+            buffer.clear();
+            reader->read (&buffer, 0, n, pos, true, false);
+
+            // Follow the trajectory at the engine's control rate
+            for (int sub = 0; sub < n; sub += BinauralEngine::kControlBlockSize)
+            {
+                const int m = juce::jmin (BinauralEngine::kControlBlockSize, n - sub);
+                const auto key = trajectory.evaluate (static_cast<double> (pos + sub) / sampleRate);
+
+                engine.setAzimuth (key.azimuth);
+                engine.setElevation (key.elevation);
+                engine.setVolume (key.gain);
+
+                engine.process (buffer.getReadPointer (0) + sub, buffer.getWritePointer (0) + sub, buffer.getWritePointer (1) + sub, m);
+            }
+
+            if (! writer->writeFromAudioSampleBuffer (buffer, 0, n))
+            {
+                result.error = "write failed for " + job.output.getFullPathName();
+                return result;
+            }
+        }
+
+        writer.reset();
+
+        result.renderSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+        result.audioSeconds = static_cast<double> (numSamples) / sampleRate;
+        result.ok = true;
+        return result;
+    }
+
+    //==============================================================================
+    bool readBatchFile (const juce::File& file, std::vector<RenderJob>& jobs)
+    {
+        std::ifstream stream (file.getFullPathName().toStdString());
+
+        if (! stream)
+            return false;
+
+        const auto directory = file.getParentDirectory();
+        std::string line;
+
+        while (std::getline (stream, line))
+        {
+            std::istringstream fields (line);
+            std::string input, trajectory, output;
+
+            if (! (fields >> input) || input[0] == '#')
+                continue;
+
+            if (! (fields >> trajectory >> output))
+                return false;
+
+            // Relative paths are relative to the batch file
+            jobs.push_back ({ directory.getChildFile (input),
+                              directory.getChildFile (trajectory),
+                              directory.getChildFile (output) });
+        }
+
+        return true;
+    }
+
+    void printUsage()
+    {
+        std::printf ("usage: binaural_render [-j threads] [-b blockSize] [--hrir file] [--brir file] [--interpolation kind] input trajectory output\n"
+                     "       binaural_render [-j threads] [-b blockSize] [--hrir file] [--brir file] [--interpolation kind] --batch jobs.txt\n");
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    int numThreads = juce::SystemStats::getNumCpus();
+    int blockSize = 512;
+    juce::StringArray positional;
+    juce::String batchFile;
+    juce::String hrirFile, brirFile;
+    auto interpolation = Interpolation::Kind::linear;
+
+    const auto cwd = juce::File::getCurrentWorkingDirectory();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg (argv[i]);
+
+        if (arg == "-j" && i + 1 < argc)            numThreads = juce::jmax (1, juce::String (argv[++i]).getIntValue());
+        else if (arg == "-b" && i + 1 < argc)       blockSize = juce::jmax (1, juce::String (argv[++i]).getIntValue());
+        else if (arg == "--batch" && i + 1 < argc)  batchFile = argv[++i];
+        else if (arg == "--hrir" && i + 1 < argc)   hrirFile = argv[++i];
+        else if (arg == "--brir" && i + 1 < argc)   brirFile = argv[++i];
+        else if (arg == "--interpolation" && i + 1 < argc)
+        {
+            if (! Interpolation::fromName (argv[++i], interpolation))
+            {
+                std::fprintf (stderr, "unknown interpolation %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (arg == "-h" || arg == "--help")    { printUsage(); return 0; }
+        else                                        positional.add (arg);
+    }
+
+    // One set for all jobs, each resamples it to its own rate
+    std::shared_ptr<const HrirSet> hrirs, brirs;
+
+    for (auto* set : { &hrirs, &brirs })
+    {
+        const auto& file = set == &hrirs ? hrirFile : brirFile;
+
+        if (file.isEmpty())
+            continue;
+
+        std::string error;
+        *set = HrirSet::load (cwd.getChildFile (file).getFullPathName().toStdString(), error);
+
+        if (*set == nullptr)
+        {
+            std::fprintf (stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<RenderJob> jobs;
+
+    if (batchFile.isNotEmpty())
+    {
+        if (! readBatchFile (cwd.getChildFile (batchFile), jobs))
+        {
+            std::fprintf (stderr, "cannot read batch file %s\n", batchFile.toRawUTF8());
+            return 1;
+        }
+    }
+    else if (positional.size() == 3)
+    {
+        jobs.push_back ({ cwd.getChildFile (positional[0]), cwd.getChildFile (positional[1]), cwd.getChildFile (positional[2]) });
+    }
+    else
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::mutex printLock;
+    std::atomic<int> remaining { static_cast<int> (jobs.size()) };
+    std::atomic<int> numFailed { 0 };
+    juce::WaitableEvent allDone;
+
+    const double startTime = juce::Time::getMillisecondCounterHiRes();
+    double totalAudioSeconds = 0;
+
+    {
+        juce::ThreadPool pool (juce::jmin (numThreads, static_cast<int> (jobs.size())));
+
+        for (auto& job : jobs)
+        {
+            pool.addJob ([&, job]
+            {
+                const auto result = renderFile (job, blockSize, hrirs, brirs, interpolation);
+
+                {
+                    std::lock_guard<std::mutex> guard (printLock);
+
+                    if (result.ok)
+                    {
+                        totalAudioSeconds += result.audioSeconds;
+                        std::printf ("%s: %.1f s of audio in %.2f s, %.1fx realtime\n",
+                                     job.output.getFileName().toRawUTF8(), result.audioSeconds, result.renderSeconds,
+                                     result.audioSeconds / juce::jmax (1e-9, result.renderSeconds));
+                    }
+                    else
+                    {
+                        ++numFailed;
+                        std::fprintf (stderr, "%s: %s\n", job.input.getFileName().toRawUTF8(), result.error.toRawUTF8());
+                    }
+
+                    std::fflush (stdout);
+                }
+
+                if (--remaining == 0)
+                    allDone.signal();
+            });
+        }
+
+        allDone.wait();
+    }
+
+    const double wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    std::printf ("%d file(s), %d failed, %.1f s of audio in %.2f s wall clock, %.1fx realtime overall\n",
+                 static_cast<int> (jobs.size()), numFailed.load(), totalAudioSeconds, wallSeconds,
+                 totalAudioSeconds / juce::jmax (1e-9, wallSeconds));
+
+    return numFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    Trajectory.cpp
+
+  ==============================================================================
+*/
+
+#include "Trajectory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+//==============================================================================
+bool Trajectory::load (const std::string& path, std::string& error)
+{
+    std::ifstream stream (path);
+
+    if (! stream)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    return parse (stream, error);
+}
+
+bool Trajectory::parse (std::istream& stream, std::string& error)
+{
+    keyframes.clear();
+
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline (stream, line))
+    {
+        ++lineNumber;
+
+        const auto comment = line.find ('#');
+        if (comment != std::string::npos)
+            line.erase (comment);
+
+        std::istringstream fields (line);
+        Keyframe key;
+
+        if (! (fields >> key.time))
+        {
+            // Blank or comment-only line
+            if (line.find_first_not_of (" \t\r") == std::string::npos)
+                continue;
+
+            error = "line " + std::to_string (lineNumber) + ": expected a time";
+            return false;
+        }
+
+        if (! (fields >> key.azimuth >> key.elevation))
+        {
+            error = "line " + std::to_string (lineNumber) + ": expected azimuth and elevation";
+            return false;
+        }
+
+        if (! (fields >> key.gain))
+        {
+            // Only a missing gain defaults, not one that is not a number
+            if (! fields.eof())
+            {
+                error = "line " + std::to_string (lineNumber) + ": expected a gain in dB";
+                return false;
+            }
+
+            key.gain = 0;
+        }
+        else
+        {
+            std::string extra;
+
+            if (fields >> extra)
+            {
+                error = "line " + std::to_string (lineNumber) + ": unexpected \"" + extra + "\"";
+                return false;
+            }
+        }
+
+        if (key.time < 0)
+        {
+            error = "line " + std::to_string (lineNumber) + ": time must not be negative";
+            return false;
+        }
+
+        if (std::abs (key.azimuth) > maxAzimuth || std::abs (key.elevation) > maxElevation)
+        {
+            error = "line " + std::to_string (lineNumber) + ": azimuth must lie in [-90, 90] and elevation in [-180, 180] degrees";
+            return false;
+        }
+
+        if (! keyframes.empty() && key.time < keyframes.back().time)
+        {
+            error = "line " + std::to_string (lineNumber) + ": keyframes must be sorted by time";
+            return false;
+        }
+
+        keyframes.push_back (key);
+    }
+
+    return true;
+}
+
+//==============================================================================
+Trajectory::Keyframe Trajectory::evaluate (double time) const
+{
+    if (keyframes.empty())
+        return {};
+
+    if (time <= keyframes.front().time)
+        return keyframes.front();
+
+    if (time >= keyframes.back().time)
+        return keyframes.back();
+
+    const auto next = std::upper_bound (keyframes.begin(), keyframes.end(), time,
+                                        [] (double t, const Keyframe& key) { return t < key.time; });
+    const auto& k1 = *next;
+    const auto& k0 = *(next - 1);
+
+    const float frac = static_cast<float> ((time - k0.time) / (k1.time - k0.time));
+
+    Keyframe key;
+    key.time = time;
+    key.azimuth = k0.azimuth + frac * (k1.azimuth - k0.azimuth);
+    key.elevation = k0.elevation + frac * (k1.elevation - k0.elevation);
+    key.gain = k0.gain + frac * (k1.gain - k0.gain);
+    return key;
+}
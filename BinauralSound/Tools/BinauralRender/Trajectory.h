@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    Trajectory.h
+
+    Position automation for offline rendering: timestamped azimuth,
+    elevation and gain keyframes, interpolated linearly.
+
+    File format, one keyframe per line, sorted by time:
+
+        # time [s]   azimuth [deg]   elevation [deg]   gain [dB]
+        0.0          -60             0                 0
+        2.5           60             20               -3
+
+    Blank lines and everything after a '#' are ignored. The gain column is
+    optional and defaults to 0 dB. Times must not be negative, azimuths lie
+    in [-90, 90] and elevations in [-180, 180], the ranges of the model's
+    interaural-polar angles; a line outside them is an error rather than
+    being wrapped or clamped.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <istream>
+#include <string>
+#include <vector>
+
+//==============================================================================
+/**
+*/
+struct Trajectory
+{
+    static constexpr float maxAzimuth = 90.0f; // [deg]
+    static constexpr float maxElevation = 180.0f; // [deg]
+
+    struct Keyframe
+    {
+        double time = 0;
+        float azimuth = 0;
+        float elevation = 0;
+        float gain = 0; // dB
+    };
+
+    /** Reads a trajectory file. Returns false and fills error on failure. */
+    bool load (const std::string& path, std::string& error);
+    bool parse (std::istream& stream, std::string& error);
+
+    /** Position at the given time. Holds the first and last keyframes
+        outside their range; an empty trajectory stays at the origin.
+    */
+    Keyframe evaluate (double time) const;
+
+    std::vector<Keyframe> keyframes;
+};
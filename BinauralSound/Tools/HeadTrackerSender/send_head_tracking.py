@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+"""
+Sends a synthetic head tracker stream to the BinauralSound plugin.
+
+The head turns back and forth (yaw) and nods slowly (pitch). Every packet
+carries time.monotonic() as its send time, so the plugin can measure the
+motion-to-sound latency; it shows the statistics in its editor.
+
+usage: send_head_tracking.py [--port 9000] [--rate 100] [--duration 30]
+                             [--format osc|binary] [--yaw 60] [--period 4]
+"""
+
+import argparse
+import math
+import socket
+import struct
+import time
+
+
+def osc_string(text):
+    data = text.encode() + b"\0"
+    return data + b"\0" * (-len(data) % 4)
+
+
+def osc_packet(yaw, pitch, roll, sent):
+    return (osc_string("/head/ypr") + osc_string(",fffd")
+            + struct.pack(">fffd", yaw, pitch, roll, sent))
+
+
+def binary_packet(yaw, pitch, roll, sent):
+    return b"HTRK" + struct.pack("<fffd", yaw, pitch, roll, sent)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=9000)
+    parser.add_argument("--rate", type=float, default=100, help="packets per second")
+    parser.add_argument("--duration", type=float, default=30, help="seconds, 0 runs until interrupted")
+    parser.add_argument("--format", choices=["osc", "binary"], default="osc")
+    parser.add_argument("--yaw", type=float, default=60, help="yaw amplitude in degrees")
+    parser.add_argument("--period", type=float, default=4, help="seconds per head turn")
+    args = parser.parse_args()
+
+    make_packet = osc_packet if args.format == "osc" else binary_packet
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+
+    start = time.monotonic()
+    interval = 1.0 / args.rate
+    count = 0
+
+    try:
+        while args.duration <= 0 or time.monotonic() - start < args.duration:
+            t = time.monotonic() - start
+            yaw = args.yaw * math.sin(2 * math.pi * t / args.period)
+            pitch = 15 * math.sin(2 * math.pi * t / (3 * args.period))
+
+            sock.sendto(make_packet(yaw, pitch, 0.0, time.monotonic()), (args.host, args.port))
+            count += 1
+
+            time.sleep(max(0.0, start + count * interval - time.monotonic()))
+    except KeyboardInterrupt:
+        pass
+
+    print("sent %d packets to %s:%d" % (count, args.host, args.port))
+
+
+if __name__ == "__main__":
+    main()
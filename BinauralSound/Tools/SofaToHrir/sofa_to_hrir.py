@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""
+Converts the HRIRs of a SOFA file (SimpleFreeFieldHRIR) to the binary dump
+the BinauralSound plugin loads in its HRIR rendering mode.
+
+SOFA files are netCDF-4, i.e. HDF5, and are read with h5py and numpy
+(pip install h5py numpy). The output holds the sample rate and, for every
+measurement, its direction in SOFA spherical coordinates and both ears'
+impulse responses; see BinauralSound/Source/Engine/HrirSet.h for the layout.
+Binaural room impulse responses with the same Data.IR layout, one per source
+direction, convert the same way for the BRIR rendering mode.
+
+usage: sofa_to_hrir.py input.sofa output.hrir [--length samples]
+"""
+
+import argparse
+import struct
+import sys
+
+import h5py
+import numpy as np
+
+
+def source_directions(sofa):
+    """Azimuth and elevation in degrees, SOFA convention, one row per measurement."""
+    positions = np.array(sofa["SourcePosition"], dtype=np.float64)
+    kind = sofa["SourcePosition"].attrs.get("Type", b"spherical")
+    kind = kind.decode() if isinstance(kind, bytes) else str(kind)
+
+    if kind == "cartesian":
+        x, y, z = positions[:, 0], positions[:, 1], positions[:, 2]
+        azimuth = np.degrees(np.arctan2(y, x))
+        elevation = np.degrees(np.arctan2(z, np.hypot(x, y)))
+        return azimuth, elevation
+
+    return positions[:, 0], positions[:, 1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input")
+    parser.add_argument("output")
+    parser.add_argument("--length", type=int, default=0, help="truncate the impulse responses to this many samples")
+    args = parser.parse_args()
+
+    with h5py.File(args.input, "r") as sofa:
+        ir = np.array(sofa["Data.IR"], dtype=np.float32)  # measurements x receivers x samples
+        sample_rate = float(np.array(sofa["Data.SamplingRate"]).ravel()[0])
+        azimuth, elevation = source_directions(sofa)
+
+    if ir.ndim != 3 or ir.shape[1] != 2:
+        sys.exit("expected two receivers (ears), got Data.IR of shape %s" % (ir.shape,))
+
+    if args.length > 0:
+        ir = ir[:, :, :args.length]
+
+    num_measurements, _, length = ir.shape
+
+    with open(args.output, "wb") as out:
+        out.write(b"HRIR" + struct.pack("<IfII", 1, sample_rate, num_measurements, length))
+
+        for m in range(num_measurements):
+            out.write(struct.pack("<ff", azimuth[m], elevation[m]))
+            out.write(ir[m].astype("<f4").tobytes())
+
+    print("%s: %d directions, %d samples at %g Hz" % (args.output, num_measurements, length, sample_rate))
+
+
+if __name__ == "__main__":
+    main()